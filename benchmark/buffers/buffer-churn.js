@@ -0,0 +1,38 @@
+'use strict';
+// Buffers allocated and released per second, with the default ArrayBuffer
+// allocator and with --arraybuffer-arenas. Each run keeps a window of
+// `live` Buffers alive and replaces the oldest one on every iteration, so
+// that freed memory is reused while other Buffers are still in use.
+// The allocator can only be chosen at startup, so every run happens in a
+// child process; `n` is large enough for startup to be a small part of it.
+const common = require('../common.js');
+const { spawnSync } = require('child_process');
+
+const bench = common.createBenchmark(main, {
+  allocator: ['default', 'arenas'],
+  size: [512, 4096, 65536, 4 * 1024 * 1024],
+  live: [16, 1024],
+  n: [1e6],
+});
+
+function churn(size, live, n) {
+  const buffers = new Array(live);
+  for (let i = 0; i < n; i++) {
+    const buffer = Buffer.alloc(size);
+    buffer[0] = i;
+    buffers[i % live] = buffer;
+  }
+}
+
+function main({ allocator, size, live, n }) {
+  if (size >= 4 * 1024 * 1024)
+    n = Math.min(n, 2e4);
+  const args = allocator === 'arenas' ? ['--arraybuffer-arenas'] : [];
+  args.push('-e', `(${churn})(${size}, ${live}, ${n})`);
+
+  bench.start();
+  const child = spawnSync(process.execPath, args);
+  if (child.status !== 0)
+    throw new Error(`churn failed: ${child.stderr}`);
+  bench.end(n);
+}
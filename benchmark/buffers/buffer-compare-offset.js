@@ -0,0 +1,27 @@
+'use strict';
+// Calls per second of buf.compare() with ranges, which goes through the
+// compareOffset binding, against comparing slices of the same ranges.
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  method: ['offset', 'slice'],
+  size: [16, 512, 4096],
+  n: [5e6],
+});
+
+function main({ method, size, n }) {
+  const a = Buffer.alloc(size, 'a');
+  const b = Buffer.alloc(size, 'a');
+  const start = size >> 2;
+  const end = size - start;
+
+  bench.start();
+  if (method === 'offset') {
+    for (let i = 0; i < n; i++)
+      a.compare(b, start, end, start, end);
+  } else {
+    for (let i = 0; i < n; i++)
+      a.subarray(start, end).compare(b.subarray(start, end));
+  }
+  bench.end(n);
+}
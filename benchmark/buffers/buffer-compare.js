@@ -0,0 +1,26 @@
+'use strict';
+// Calls per second of Buffer.compare() and buf.equals() on buffers that
+// only differ in their last byte, so that all of them is compared.
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  method: ['compare', 'equals'],
+  size: [16, 512, 4096],
+  n: [5e6],
+});
+
+function main({ method, size, n }) {
+  const a = Buffer.alloc(size, 'a');
+  const b = Buffer.alloc(size, 'a');
+  b[size - 1] = 0x62;
+
+  bench.start();
+  if (method === 'compare') {
+    for (let i = 0; i < n; i++)
+      Buffer.compare(a, b);
+  } else {
+    for (let i = 0; i < n; i++)
+      a.equals(b);
+  }
+  bench.end(n);
+}
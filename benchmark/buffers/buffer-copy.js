@@ -0,0 +1,23 @@
+'use strict';
+// Calls per second of buf.copy(), which optimized code turns into a fast
+// API call. `partial` copies from and to offsets inside the buffers, and
+// `overlap` copies within a single buffer.
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  bytes: [8, 128, 1024],
+  type: ['full', 'partial', 'overlap'],
+  n: [6e6],
+});
+
+function main({ bytes, type, n }) {
+  const source = Buffer.allocUnsafe(bytes);
+  const target = type === 'overlap' ? source : Buffer.allocUnsafe(bytes);
+  const start = type === 'full' ? 0 : 1;
+  const end = type === 'full' ? bytes : bytes - 1;
+
+  bench.start();
+  for (let i = 0; i < n; i++)
+    source.copy(target, start, 0, end);
+  bench.end(n);
+}
@@ -0,0 +1,27 @@
+'use strict';
+// Calls per second of buf.fill() with a number, the only kind of value
+// that the fast API call handles, and with the other kinds for comparison.
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  type: ['number', 'number-range', 'string', 'buffer'],
+  size: [8, 1024, 65536],
+  n: [2e6],
+});
+
+function main({ type, size, n }) {
+  const buffer = Buffer.allocUnsafe(size);
+  const fill = () => {
+    switch (type) {
+      case 'number': return buffer.fill(0x61);
+      case 'number-range': return buffer.fill(0x61, 1, size - 1);
+      case 'string': return buffer.fill('a');
+      case 'buffer': return buffer.fill(Buffer.from('a'));
+    }
+  };
+
+  bench.start();
+  for (let i = 0; i < n; i++)
+    fill();
+  bench.end(n);
+}
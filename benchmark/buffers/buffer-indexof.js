@@ -0,0 +1,32 @@
+'use strict';
+// Calls per second of buf.indexOf() and buf.lastIndexOf() with a Buffer or
+// a byte needle, the two kinds that have fast API calls, including negative
+// byteOffsets.
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  needle: ['buffer', 'byte'],
+  method: ['indexOf', 'lastIndexOf'],
+  byteOffset: [0, -64],
+  size: [128, 16384],
+  n: [2e6],
+});
+
+function main({ needle, method, byteOffset, size, n }) {
+  const haystack = Buffer.alloc(size, 'abcdefgh');
+  // The needle is at neither end, so that both methods search some way.
+  haystack.write('xyz', size >> 1);
+  const value = needle === 'buffer' ? Buffer.from('xyz') : 0x78;
+  const offset = method === 'lastIndexOf' && byteOffset === 0 ?
+    size - 1 : byteOffset;
+
+  bench.start();
+  if (method === 'indexOf') {
+    for (let i = 0; i < n; i++)
+      haystack.indexOf(value, offset);
+  } else {
+    for (let i = 0; i < n; i++)
+      haystack.lastIndexOf(value, offset);
+  }
+  bench.end(n);
+}
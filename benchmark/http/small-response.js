@@ -0,0 +1,38 @@
+'use strict';
+// Requests per second for responses that are written in several small
+// pieces, which is the case that corking HTTP server sockets is meant for:
+// the head and every chunk are separate writes to the socket.
+const common = require('../common.js');
+const http = require('http');
+
+const bench = common.createBenchmark(main, {
+  len: [16, 256, 1024],
+  chunks: [1, 4, 16],
+  chunkedEnc: [1, 0],
+  c: [50, 500],
+  duration: 5,
+});
+
+function main({ len, chunks, chunkedEnc, c, duration }) {
+  const chunk = 'x'.repeat(len);
+  const headers = { 'Content-Type': 'text/plain' };
+  if (!chunkedEnc)
+    headers['Content-Length'] = `${len * chunks}`;
+
+  const server = http.createServer((req, res) => {
+    res.writeHead(200, headers);
+    for (let i = 1; i < chunks; i++)
+      res.write(chunk);
+    res.end(chunk);
+  });
+
+  server.listen(common.PORT, () => {
+    bench.http({
+      path: '/',
+      connections: c,
+      duration,
+    }, () => {
+      server.close();
+    });
+  });
+}
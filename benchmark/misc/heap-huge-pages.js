@@ -0,0 +1,70 @@
+'use strict';
+// Random accesses per second to a large heap and to a large ArrayBuffer,
+// with and without --heap-huge-pages. The accesses are spread over far
+// more memory than the TLB covers with 4 KB pages, so that most of them
+// miss it unless the memory is backed by huge pages.
+// The option can only be set at startup, so every run happens in a child
+// process, which times the accesses only and not setting up the memory.
+const common = require('../common.js');
+const { spawnSync } = require('child_process');
+
+const bench = common.createBenchmark(main, {
+  hugePages: [0, 1],
+  type: ['heap', 'arraybuffer'],
+  mb: [64, 512],
+  n: [2e7],
+});
+
+// Runs in the child. Prints how many nanoseconds the accesses took.
+function run(type, mb, n) {
+  let next;
+  let visit;
+  if (type === 'heap') {
+    // Objects of roughly 64 bytes, linked in a random order.
+    const nodes = new Array(Math.floor(mb * 1024 * 1024 / 64));
+    for (let i = 0; i < nodes.length; i++)
+      nodes[i] = { next: null, value: i, a: 0, b: 0, c: 0, d: 0 };
+    for (let i = nodes.length - 1; i > 0; i--) {
+      const j = Math.floor(Math.random() * (i + 1));
+      [nodes[i], nodes[j]] = [nodes[j], nodes[i]];
+    }
+    for (let i = 0; i < nodes.length; i++)
+      nodes[i].next = nodes[(i + 1) % nodes.length];
+    next = nodes[0];
+    visit = () => {
+      next = next.next;
+      return next.value;
+    };
+  } else {
+    const array = new Uint32Array(new ArrayBuffer(mb * 1024 * 1024));
+    const mask = array.length - 1;
+    for (let i = 0; i < array.length; i += 1024) array[i] = i;
+    let index = 0;
+    visit = () => {
+      // A linear congruential generator, to avoid Math.random() overhead.
+      index = (Math.imul(index, 1664525) + 1013904223) & mask;
+      return array[index];
+    };
+  }
+  let sum = 0;
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < n; i++)
+    sum += visit();
+  const elapsed = process.hrtime.bigint() - start;
+  if (sum < 0) throw new Error('unreachable');
+  process.stdout.write(`${elapsed}`);
+}
+
+function main({ hugePages, type, mb, n }) {
+  const args = [`--max-old-space-size=${mb * 4}`];
+  if (hugePages)
+    args.push('--heap-huge-pages');
+  args.push('-e', `(${run})(${JSON.stringify(type)}, ${mb}, ${n})`);
+
+  const child = spawnSync(process.execPath, args);
+  if (child.status !== 0)
+    throw new Error(`run failed: ${child.stderr}`);
+  const elapsed = Number(child.stdout);
+  bench.report(n / (elapsed / 1e9),
+               [Math.floor(elapsed / 1e9), elapsed % 1e9]);
+}
@@ -0,0 +1,67 @@
+'use strict';
+// Startups per second of an application made of many modules, without the
+// on-disk compile cache, with an empty one that is filled on every start,
+// and with one that was filled by an earlier run.
+const common = require('../common.js');
+const { spawnSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const bench = common.createBenchmark(main, {
+  cache: ['none', 'cold', 'warm'],
+  type: ['cjs', 'esm'],
+  modules: [10, 100],
+  n: [30],
+});
+
+// Every module defines some functions that run at startup, so that they are
+// compiled eagerly enough to end up in the cache.
+function writeApp(dir, type, modules) {
+  const ext = type === 'esm' ? 'mjs' : 'js';
+  const imports = [];
+  for (let i = 0; i < modules; i++) {
+    const fns = [];
+    for (let j = 0; j < 20; j++) {
+      fns.push(`function f${j}(x) {
+  const parts = String(x).split('');
+  return parts.map((c, k) => c.charCodeAt(0) * k).reduce((a, b) => a + b, 0);
+}`);
+    }
+    const body = `${fns.join('\n')}\nconst value = f0(${i}) + f19(${i});\n`;
+    fs.writeFileSync(path.join(dir, `m${i}.${ext}`), type === 'esm' ?
+      `${body}export default value;\n` :
+      `${body}module.exports = value;\n`);
+    imports.push(type === 'esm' ?
+      `import m${i} from './m${i}.mjs';` :
+      `require('./m${i}.js');`);
+  }
+  const main = path.join(dir, `main.${ext}`);
+  fs.writeFileSync(main, `${imports.join('\n')}\n`);
+  return main;
+}
+
+function main({ cache, type, modules, n }) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'bench-compile-cache-'));
+  const entry = writeApp(dir, type, modules);
+  const cacheDir = path.join(dir, 'cache');
+  const args = cache === 'none' ? [entry] :
+    ['--compile-cache-dir', cacheDir, entry];
+
+  const run = () => {
+    const child = spawnSync(process.execPath, args);
+    if (child.status !== 0)
+      throw new Error(`startup failed: ${child.stderr}`);
+  };
+  if (cache === 'warm')
+    run();
+
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    if (cache === 'cold')
+      fs.rmSync(cacheDir, { recursive: true, force: true });
+    run();
+  }
+  bench.end(n);
+  fs.rmSync(dir, { recursive: true });
+}
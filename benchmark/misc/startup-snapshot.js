@@ -0,0 +1,60 @@
+'use strict';
+// Startups per second of an application that does some setup work before it
+// can run, when the setup runs on every start and when it is restored from
+// a snapshot built with --build-snapshot.
+const common = require('../common.js');
+const { spawnSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const bench = common.createBenchmark(main, {
+  mode: ['snapshot', 'no-snapshot'],
+  entries: [1e3, 1e5],
+  n: [30],
+});
+
+// The setup work: builds a lookup table and loads a few built-in modules.
+function setupSource(entries) {
+  return `
+const http = require('http');
+const util = require('util');
+const table = new Map();
+for (let i = 0; i < ${entries}; i++)
+  table.set(\`key\${i}\`, { id: i, name: util.format('entry %d', i) });
+function run(process) {
+  if (table.size !== ${entries} || typeof http.createServer !== 'function')
+    process.exit(1);
+}
+`;
+}
+
+function main({ mode, entries, n }) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'bench-snapshot-'));
+  const source = setupSource(entries);
+  let args;
+  if (mode === 'snapshot') {
+    const entry = path.join(dir, 'entry.js');
+    const blob = path.join(dir, 'snapshot.blob');
+    fs.writeFileSync(entry, `${source}\nreturn run;\n`);
+    const child = spawnSync(process.execPath, [
+      '--snapshot-blob', blob, '--build-snapshot', entry,
+    ]);
+    if (child.status !== 0)
+      throw new Error(`--build-snapshot failed: ${child.stderr}`);
+    args = ['--snapshot-blob', blob];
+  } else {
+    const script = path.join(dir, 'main.js');
+    fs.writeFileSync(script, `${source}\nrun(process);\n`);
+    args = [script];
+  }
+
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    const child = spawnSync(process.execPath, args);
+    if (child.status !== 0)
+      throw new Error(`startup failed: ${child.stderr}`);
+  }
+  bench.end(n);
+  fs.rmSync(dir, { recursive: true });
+}
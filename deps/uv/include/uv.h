@@ -252,7 +252,8 @@ typedef struct uv_statfs_s uv_statfs_t;
 
 typedef enum {
   UV_LOOP_BLOCK_SIGNAL = 0,
-  UV_METRICS_IDLE_TIME
+  UV_METRICS_IDLE_TIME,
+  UV_LOOP_TIMER_WHEEL
 } uv_loop_option;
 
 typedef enum {
@@ -572,10 +573,31 @@ UV_EXTERN int uv_tcp_keepalive(uv_tcp_t* handle,
                                int enable,
                                unsigned int delay);
 UV_EXTERN int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable);
+/* Send writes of at least `threshold` bytes with MSG_ZEROCOPY, so that the
+ * kernel transmits straight from the write buffers instead of copying them.
+ * The write callback is deferred until the kernel has released the buffers,
+ * and so is the close callback of the handle. uv_try_write() returns
+ * UV_EAGAIN for such writes. A threshold of 0 turns zero-copy sends off
+ * again. Linux 4.14+ only; returns UV_ENOTSUP elsewhere.
+ */
+UV_EXTERN int uv_tcp_zerocopy(uv_tcp_t* handle, size_t threshold);
+/* Lets embedders that may link against an older libuv check for it. */
+#define UV_HAVE_TCP_ZEROCOPY 1
 
 enum uv_tcp_flags {
   /* Used with uv_tcp_bind, when an IPv6 address is used. */
-  UV_TCP_IPV6ONLY = 1
+  UV_TCP_IPV6ONLY = 1,
+
+  /* Enable SO_REUSEPORT socket option when binding the handle.
+   * This allows completely duplicate bindings by multiple processes
+   * or threads if they all set SO_REUSEPORT before binding the port.
+   * Incoming connections are distributed across the participating
+   * listener sockets by the kernel.
+   *
+   * This flag is available only on Linux 3.9+, DragonFlyBSD 3.6+ and
+   * FreeBSD 12.0+ for now; uv_tcp_bind() returns UV_ENOTSUP elsewhere.
+   */
+  UV_TCP_REUSEPORT = 2
 };
 
 UV_EXTERN int uv_tcp_bind(uv_tcp_t* handle,
@@ -55,6 +55,272 @@ static int timer_less_than(const struct heap_node* ha,
 }
 
 
+/* Hierarchical timing wheel, enabled with uv_loop_configure(loop,
+ * UV_LOOP_TIMER_WHEEL, resolution). Starting and stopping a timer that is
+ * in the wheel only links or unlinks it from a slot, instead of moving it up
+ * or down the heap, which makes frequently refreshed timeouts cheap.
+ *
+ * Time is divided into ticks of `resolution` milliseconds. Level 0 has a slot
+ * for each of the next 256 ticks, and each of the three levels above it has
+ * 64 slots, each covering the range of the whole level below. Whenever the
+ * current tick enters a new level 0 range, the timers of the matching level 1
+ * slot are redistributed to level 0, and so on up the levels (Varghese and
+ * Lauck's scheme 6, as used by older Linux kernels). Timers that are too far
+ * out even for level 3 are kept on an overflow list that is redistributed
+ * whenever level 3 wraps around.
+ *
+ * The wheel only decides when timers are due. Due timers are moved to the
+ * timer heap, which runs them in the same order as when the wheel is not
+ * used, and timers that are already due when they are started are put on the
+ * heap directly. Timers are rounded up to the next tick, so with a resolution
+ * above 1 ms they may fire up to resolution - 1 ms late.
+ *
+ * While a timer is in the wheel, it has UV_HANDLE_TIMER_IN_WHEEL set and its
+ * heap_node field holds a queue node and the number of its slot.
+ */
+
+#define WHEEL_L0_BITS 8
+#define WHEEL_LN_BITS 6
+#define WHEEL_LEVELS 4
+#define WHEEL_L0_SIZE (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1 << WHEEL_LN_BITS)
+#define WHEEL_SLOTS (WHEEL_L0_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LN_SIZE)
+#define WHEEL_OVERFLOW_SLOT WHEEL_SLOTS
+
+struct uv__timer_wheel_s {
+  uint64_t resolution;
+  /* The next tick whose level 0 slot has not been expired yet. */
+  uint64_t tick;
+  /* Number of timers above level 0, including the overflow list. */
+  unsigned int far_count;
+  /* Non-empty level 0 slots. */
+  uint64_t level0_bitmap[WHEEL_L0_SIZE / 64];
+  QUEUE slots[WHEEL_SLOTS + 1];
+};
+
+
+static struct uv__timer_wheel_s* timer_wheel(const uv_loop_t* loop) {
+  return uv__get_internal_fields(loop)->timer_wheel;
+}
+
+
+static QUEUE* wheel_node(uv_timer_t* handle) {
+  return (QUEUE*) &handle->heap_node;
+}
+
+
+static uint64_t wheel_expiry_tick(const struct uv__timer_wheel_s* wheel,
+                                  uint64_t timeout) {
+  return timeout / wheel->resolution +
+         (timeout % wheel->resolution != 0 ? 1 : 0);
+}
+
+
+static unsigned int wheel_slot(const struct uv__timer_wheel_s* wheel,
+                               uint64_t expires) {
+  uint64_t delta;
+  unsigned int level;
+  unsigned int shift;
+
+  assert(expires >= wheel->tick);
+  delta = expires - wheel->tick;
+  if (delta < WHEEL_L0_SIZE)
+    return expires & (WHEEL_L0_SIZE - 1);
+
+  for (level = 1; level < WHEEL_LEVELS; level++) {
+    shift = WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+    if (delta < ((uint64_t) 1 << (shift + WHEEL_LN_BITS)))
+      return WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE +
+             ((expires >> shift) & (WHEEL_LN_SIZE - 1));
+  }
+
+  return WHEEL_OVERFLOW_SLOT;
+}
+
+
+static void wheel_insert(struct uv__timer_wheel_s* wheel,
+                         uv_timer_t* handle) {
+  unsigned int slot;
+
+  slot = wheel_slot(wheel, wheel_expiry_tick(wheel, handle->timeout));
+  QUEUE_INSERT_TAIL(&wheel->slots[slot], wheel_node(handle));
+  handle->heap_node[2] = (void*) (uintptr_t) slot;
+  handle->flags |= UV_HANDLE_TIMER_IN_WHEEL;
+
+  if (slot < WHEEL_L0_SIZE)
+    wheel->level0_bitmap[slot / 64] |= (uint64_t) 1 << (slot % 64);
+  else
+    wheel->far_count++;
+}
+
+
+static void wheel_remove(struct uv__timer_wheel_s* wheel,
+                         uv_timer_t* handle) {
+  unsigned int slot;
+
+  slot = (unsigned int) (uintptr_t) handle->heap_node[2];
+  QUEUE_REMOVE(wheel_node(handle));
+  handle->flags &= ~UV_HANDLE_TIMER_IN_WHEEL;
+
+  if (slot >= WHEEL_L0_SIZE)
+    wheel->far_count--;
+  else if (QUEUE_EMPTY(&wheel->slots[slot]))
+    wheel->level0_bitmap[slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+}
+
+
+/* Returns the first non-empty level 0 slot at or after `from`, or
+ * WHEEL_L0_SIZE if there is none.
+ */
+static unsigned int wheel_find_slot(const struct uv__timer_wheel_s* wheel,
+                                    unsigned int from) {
+  unsigned int index;
+  uint64_t bits;
+
+  for (index = from; index < WHEEL_L0_SIZE; index = (index | 63) + 1) {
+    bits = wheel->level0_bitmap[index / 64] >> (index % 64);
+    if (bits == 0)
+      continue;
+    while ((bits & 1) == 0) {
+      bits >>= 1;
+      index++;
+    }
+    return index;
+  }
+
+  return WHEEL_L0_SIZE;
+}
+
+
+/* Redistributes the timers of `slot` relative to the current tick. */
+static void wheel_cascade(struct uv__timer_wheel_s* wheel, unsigned int slot) {
+  QUEUE queue;
+  QUEUE* q;
+  uv_timer_t* handle;
+
+  if (QUEUE_EMPTY(&wheel->slots[slot]))
+    return;
+
+  QUEUE_MOVE(&wheel->slots[slot], &queue);
+  while (!QUEUE_EMPTY(&queue)) {
+    q = QUEUE_HEAD(&queue);
+    handle = QUEUE_DATA(q, uv_timer_t, heap_node);
+    QUEUE_REMOVE(q);
+    wheel->far_count--;
+    wheel_insert(wheel, handle);
+  }
+}
+
+
+/* Moves the timers of all ticks up to the current time to the heap. */
+static void wheel_expire(uv_loop_t* loop, struct uv__timer_wheel_s* wheel) {
+  uint64_t now;
+  uint64_t next;
+  unsigned int index;
+  unsigned int level;
+  unsigned int shift;
+  uv_timer_t* handle;
+
+  now = loop->time / wheel->resolution;
+  while (wheel->tick <= now) {
+    index = wheel->tick & (WHEEL_L0_SIZE - 1);
+
+    if (index == 0) {
+      for (level = 1; level < WHEEL_LEVELS; level++) {
+        shift = WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+        wheel_cascade(wheel,
+                      WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE +
+                      ((wheel->tick >> shift) & (WHEEL_LN_SIZE - 1)));
+        if (((wheel->tick >> shift) & (WHEEL_LN_SIZE - 1)) != 0)
+          break;
+      }
+      if (level == WHEEL_LEVELS)
+        wheel_cascade(wheel, WHEEL_OVERFLOW_SLOT);
+    }
+
+    while (!QUEUE_EMPTY(&wheel->slots[index])) {
+      handle = QUEUE_DATA(QUEUE_HEAD(&wheel->slots[index]),
+                          uv_timer_t,
+                          heap_node);
+      wheel_remove(wheel, handle);
+      heap_insert(timer_heap(loop),
+                  (struct heap_node*) &handle->heap_node,
+                  timer_less_than);
+    }
+
+    /* Skip ahead to the next non-empty slot, or to the end of the level 0
+     * range, where the next cascade is due.
+     */
+    next = wheel->tick - index + wheel_find_slot(wheel, index + 1);
+    if (next > now + 1)
+      next = now + 1;
+    wheel->tick = next;
+  }
+}
+
+
+/* Returns the next tick at which the wheel has work to do, or UINT64_MAX. */
+static uint64_t wheel_next_tick(const struct uv__timer_wheel_s* wheel) {
+  uint64_t next;
+  unsigned int index;
+  unsigned int slot;
+
+  /* Timers above level 0 are cascaded at the start of the next level 0
+   * range, which is the current tick if it has not been expired yet.
+   */
+  next = (uint64_t) -1;
+  if (wheel->far_count > 0)
+    next = (wheel->tick + WHEEL_L0_SIZE - 1) & ~(uint64_t) (WHEEL_L0_SIZE - 1);
+
+  /* Level 0 slots before the current one hold timers of the next range. */
+  index = wheel->tick & (WHEEL_L0_SIZE - 1);
+  slot = wheel_find_slot(wheel, index);
+  if (slot < WHEEL_L0_SIZE && wheel->tick + (slot - index) < next)
+    return wheel->tick + (slot - index);
+
+  slot = wheel_find_slot(wheel, 0);
+  if (slot < index && wheel->tick + (WHEEL_L0_SIZE - index) + slot < next)
+    next = wheel->tick + (WHEEL_L0_SIZE - index) + slot;
+
+  return next;
+}
+
+
+int uv__timer_wheel_init(uv_loop_t* loop, unsigned int resolution) {
+  uv__loop_internal_fields_t* lfields;
+  struct uv__timer_wheel_s* wheel;
+  unsigned int i;
+
+  if (resolution == 0)
+    return UV_EINVAL;
+
+  lfields = uv__get_internal_fields(loop);
+  if (lfields->timer_wheel != NULL || heap_min(timer_heap(loop)) != NULL)
+    return UV_EBUSY;
+
+  wheel = uv__calloc(1, sizeof(*wheel));
+  if (wheel == NULL)
+    return UV_ENOMEM;
+
+  wheel->resolution = resolution;
+  wheel->tick = loop->time / resolution;
+  for (i = 0; i < ARRAY_SIZE(wheel->slots); i++)
+    QUEUE_INIT(&wheel->slots[i]);
+
+  lfields->timer_wheel = wheel;
+  return 0;
+}
+
+
+void uv__timer_wheel_free(uv_loop_t* loop) {
+  uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  uv__free(lfields->timer_wheel);
+  lfields->timer_wheel = NULL;
+}
+
+
 int uv_timer_init(uv_loop_t* loop, uv_timer_t* handle) {
   uv__handle_init(loop, (uv_handle_t*)handle, UV_TIMER);
   handle->timer_cb = NULL;
@@ -68,6 +334,7 @@ int uv_timer_start(uv_timer_t* handle,
                    uv_timer_cb cb,
                    uint64_t timeout,
                    uint64_t repeat) {
+  struct uv__timer_wheel_s* wheel;
   uint64_t clamped_timeout;
 
   if (uv__is_closing(handle) || cb == NULL)
@@ -86,9 +353,15 @@ int uv_timer_start(uv_timer_t* handle,
   /* start_id is the second index to be compared in timer_less_than() */
   handle->start_id = handle->loop->timer_counter++;
 
-  heap_insert(timer_heap(handle->loop),
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+  wheel = timer_wheel(handle->loop);
+  if (wheel != NULL &&
+      wheel_expiry_tick(wheel, clamped_timeout) >= wheel->tick) {
+    wheel_insert(wheel, handle);
+  } else {
+    heap_insert(timer_heap(handle->loop),
+                (struct heap_node*) &handle->heap_node,
+                timer_less_than);
+  }
   uv__handle_start(handle);
 
   return 0;
@@ -99,9 +372,13 @@ int uv_timer_stop(uv_timer_t* handle) {
   if (!uv__is_active(handle))
     return 0;
 
-  heap_remove(timer_heap(handle->loop),
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+  if (handle->flags & UV_HANDLE_TIMER_IN_WHEEL) {
+    wheel_remove(timer_wheel(handle->loop), handle);
+  } else {
+    heap_remove(timer_heap(handle->loop),
+                (struct heap_node*) &handle->heap_node,
+                timer_less_than);
+  }
   uv__handle_stop(handle);
 
   return 0;
@@ -142,17 +419,32 @@ uint64_t uv_timer_get_due_in(const uv_timer_t* handle) {
 int uv__next_timeout(const uv_loop_t* loop) {
   const struct heap_node* heap_node;
   const uv_timer_t* handle;
+  const struct uv__timer_wheel_s* wheel;
+  uint64_t timeout;
+  uint64_t tick;
   uint64_t diff;
 
+  timeout = (uint64_t) -1;
   heap_node = heap_min(timer_heap(loop));
-  if (heap_node == NULL)
+  if (heap_node != NULL) {
+    handle = container_of(heap_node, uv_timer_t, heap_node);
+    timeout = handle->timeout;
+  }
+
+  wheel = timer_wheel(loop);
+  if (wheel != NULL) {
+    tick = wheel_next_tick(wheel);
+    if (tick != (uint64_t) -1 && tick * wheel->resolution < timeout)
+      timeout = tick * wheel->resolution;
+  }
+
+  if (heap_node == NULL && timeout == (uint64_t) -1)
     return -1; /* block indefinitely */
 
-  handle = container_of(heap_node, uv_timer_t, heap_node);
-  if (handle->timeout <= loop->time)
+  if (timeout <= loop->time)
     return 0;
 
-  diff = handle->timeout - loop->time;
+  diff = timeout - loop->time;
   if (diff > INT_MAX)
     diff = INT_MAX;
 
@@ -162,8 +454,13 @@ int uv__next_timeout(const uv_loop_t* loop) {
 
 void uv__run_timers(uv_loop_t* loop) {
   struct heap_node* heap_node;
+  struct uv__timer_wheel_s* wheel;
   uv_timer_t* handle;
 
+  wheel = timer_wheel(loop);
+  if (wheel != NULL)
+    wheel_expire(loop, wheel);
+
   for (;;) {
     heap_node = heap_min(timer_heap(loop));
     if (heap_node == NULL)
@@ -125,7 +125,11 @@ void uv_close(uv_handle_t* handle, uv_close_cb close_cb) {
     break;
 
   case UV_TCP:
-    uv__tcp_close((uv_tcp_t*)handle);
+    if (uv__tcp_close((uv_tcp_t*)handle))
+      /* The kernel still holds on to the buffers of zero-copy writes. The
+       * stream code will call uv__make_close_pending() for us once it lets
+       * go of them. */
+      return;
     break;
 
   case UV_UDP:
@@ -889,7 +893,8 @@ void uv__io_init(uv__io_t* w, uv__io_cb cb, int fd) {
 
 
 void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
-  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI)));
+  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI |
+                          UV__POLLERR)));
   assert(0 != events);
   assert(w->fd >= 0);
   assert(w->fd < INT_MAX);
@@ -917,7 +922,8 @@ void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 
 void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
-  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI)));
+  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI |
+                          UV__POLLERR)));
   assert(0 != events);
 
   if (w->fd == -1)
@@ -948,7 +954,9 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 
 void uv__io_close(uv_loop_t* loop, uv__io_t* w) {
-  uv__io_stop(loop, w, POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI);
+  uv__io_stop(loop,
+              w,
+              POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI | UV__POLLERR);
   QUEUE_REMOVE(&w->pending_queue);
 
   /* Remove stale events for this file descriptor */
@@ -964,7 +972,8 @@ void uv__io_feed(uv_loop_t* loop, uv__io_t* w) {
 
 
 int uv__io_active(const uv__io_t* w, unsigned int events) {
-  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI)));
+  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI |
+                          UV__POLLERR)));
   assert(0 != events);
   return 0 != (w->pevents & events);
 }
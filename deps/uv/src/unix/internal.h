@@ -133,6 +133,47 @@ int uv__pthread_sigmask(int how, const sigset_t* set, sigset_t* oset);
 # define UV__POLLPRI 0
 #endif
 
+/* Only used to wait for the socket error queue of zero-copy sends. */
+#if defined(__linux__)
+# define UV__POLLERR POLLERR
+#else
+# define UV__POLLERR 0
+#endif
+
+#if defined(__linux__)
+/* From the kernel headers; older libcs don't define them. */
+# define UV__SO_ZEROCOPY 60
+# define UV__MSG_ZEROCOPY 0x4000000
+# define UV__SO_EE_ORIGIN_ZEROCOPY 5
+
+/* Mirrors struct sock_extended_err from <linux/errqueue.h>, which clashes
+ * with the libc headers on some systems.
+ */
+struct uv__sock_extended_err {
+  uint32_t ee_errno;
+  uint8_t ee_origin;
+  uint8_t ee_type;
+  uint8_t ee_code;
+  uint8_t ee_pad;
+  uint32_t ee_info;
+  uint32_t ee_data;
+};
+
+/* Zero-copy send state of a TCP handle, allocated by uv_tcp_zerocopy(). It
+ * hangs off handle->u.reserved[0], which is unused for TCP handles on Unix,
+ * so that the public structs keep their layout.
+ */
+typedef struct {
+  size_t threshold;
+  unsigned int next_id;
+  QUEUE writes;  /* Sends not released by the kernel yet, in send order. */
+  QUEUE parked;  /* Write requests sent in full, waiting for the kernel. */
+} uv__tcp_zerocopy_t;
+
+# define uv__tcp_zerocopy(handle)                                             \
+  ((uv__tcp_zerocopy_t*) (handle)->u.reserved[0])
+#endif
+
 #if !defined(O_CLOEXEC) && defined(__FreeBSD__)
 /*
  * It may be that we are just missing `__POSIX_VISIBLE >= 200809`.
@@ -274,7 +315,10 @@ void uv__poll_close(uv_poll_t* handle);
 void uv__prepare_close(uv_prepare_t* handle);
 void uv__process_close(uv_process_t* handle);
 void uv__stream_close(uv_stream_t* handle);
-void uv__tcp_close(uv_tcp_t* handle);
+#if defined(__linux__)
+int uv__stream_zerocopy_linger(uv_tcp_t* tcp);
+#endif
+int uv__tcp_close(uv_tcp_t* handle);
 size_t uv__thread_stack_size(void);
 void uv__udp_close(uv_udp_t* handle);
 void uv__udp_finish_close(uv_udp_t* handle);
@@ -35,6 +35,10 @@
 #include <unistd.h>
 #include <limits.h> /* IOV_MAX */
 
+#if defined(__linux__)
+# include <netinet/in.h> /* IP_RECVERR, IPV6_RECVERR */
+#endif
+
 #if defined(__APPLE__)
 # include <sys/event.h>
 # include <sys/time.h>
@@ -80,6 +84,9 @@ static void uv__read(uv_stream_t* stream);
 static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 static void uv__write_callbacks(uv_stream_t* stream);
 static size_t uv__write_req_size(uv_write_t* req);
+#if defined(__linux__)
+static void uv__stream_zerocopy_free(uv_tcp_t* tcp);
+#endif
 
 
 void uv__stream_init(uv_loop_t* loop,
@@ -467,6 +474,10 @@ void uv__stream_destroy(uv_stream_t* stream) {
 
   uv__stream_flush_write_queue(stream, UV_ECANCELED);
   uv__write_callbacks(stream);
+#if defined(__linux__)
+  if (stream->type == UV_TCP)
+    uv__stream_zerocopy_free((uv_tcp_t*) stream);
+#endif
 
   if (stream->shutdown_req) {
     /* The ECANCELED error code is a lie, the shutdown(2) syscall is a
@@ -882,6 +893,356 @@ static int uv__try_write(uv_stream_t* stream,
   return UV__ERR(errno);
 }
 
+
+#if defined(__linux__)
+/* The zero-copy sends of a write request that the kernel hasn't released
+ * yet. Every successful MSG_ZEROCOPY send takes the next notification id,
+ * and the sends of a request are consecutive, so their ids are too.
+ */
+typedef struct {
+  uv_write_t* req;
+  unsigned int id;
+  unsigned int sends;
+  unsigned int pending;
+  QUEUE queue;
+} uv__zerocopy_write_t;
+
+
+static int uv__write_use_zerocopy(uv_stream_t* stream, uv_write_t* req) {
+  uv__tcp_zerocopy_t* zc;
+
+  if (stream->type != UV_TCP)
+    return 0;
+
+  zc = uv__tcp_zerocopy((uv_tcp_t*) stream);
+  if (zc == NULL || zc->threshold == 0)
+    return 0;
+
+  /* Only the tail of a large write that is sent in pieces is copied. */
+  return uv__write_req_size(req) >= zc->threshold;
+}
+
+
+static ssize_t uv__try_write_zerocopy(uv_stream_t* stream, uv_write_t* req) {
+  uv__zerocopy_write_t* w;
+  uv__tcp_zerocopy_t* zc;
+  struct msghdr msg;
+  int iovmax;
+  int iovcnt;
+  ssize_t n;
+
+  zc = uv__tcp_zerocopy((uv_tcp_t*) stream);
+
+  w = NULL;
+  if (!QUEUE_EMPTY(&zc->writes)) {
+    w = QUEUE_DATA(QUEUE_PREV(&zc->writes), uv__zerocopy_write_t, queue);
+    if (w->req != req)
+      w = NULL;
+  }
+
+  if (w == NULL) {
+    w = uv__malloc(sizeof(*w));
+    if (w == NULL)
+      goto copy;
+
+    w->req = req;
+    w->id = zc->next_id;
+    w->sends = 0;
+    w->pending = 0;
+    QUEUE_INSERT_TAIL(&zc->writes, &w->queue);
+  }
+
+  iovcnt = req->nbufs - req->write_index;
+  iovmax = uv__getiovmax();
+  if (iovcnt > iovmax)
+    iovcnt = iovmax;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = (struct iovec*) &req->bufs[req->write_index];
+  msg.msg_iovlen = iovcnt;
+
+  do
+    n = sendmsg(uv__stream_fd(stream), &msg, UV__MSG_ZEROCOPY);
+  while (n == -1 && RETRY_ON_WRITE_ERROR(errno));
+
+  if (n >= 0) {
+    w->sends++;
+    w->pending++;
+    zc->next_id++;
+
+    /* The kernel reports that it's done with the buffers on the socket error
+     * queue, which epoll signals with POLLERR.
+     */
+    uv__io_start(stream->loop, &stream->io_watcher, UV__POLLERR);
+    return n;
+  }
+
+  if (w->sends == 0) {
+    QUEUE_REMOVE(&w->queue);
+    uv__free(w);
+  }
+
+  /* ENOBUFS means that the socket has run out of memory for pinning pages;
+   * waiting for POLLOUT won't fix that, so send a copy instead.
+   */
+  if (errno == ENOBUFS)
+    goto copy;
+
+  if (IS_TRANSIENT_WRITE_ERROR(errno, NULL))
+    return UV_EAGAIN;
+  return UV__ERR(errno);
+
+copy:
+  return uv__try_write(stream,
+                       &req->bufs[req->write_index],
+                       req->nbufs - req->write_index,
+                       NULL);
+}
+
+
+/* Notifications cover a range of ids, possibly spanning several requests,
+ * and may wrap around. Arithmetic is modulo 2^32 relative to the first id
+ * of each request.
+ */
+static void uv__write_zerocopy_done(uv__zerocopy_write_t* w,
+                                    unsigned int lo,
+                                    unsigned int hi) {
+  unsigned int start;
+  unsigned int count;
+  unsigned int done;
+
+  start = lo - w->id;
+  count = hi - lo + 1;
+
+  if (start < w->sends) {
+    done = w->sends - start;
+    if (done > count)
+      done = count;
+  } else if (start + count < start) {
+    done = start + count;
+    if (done > w->sends)
+      done = w->sends;
+  } else {
+    return;
+  }
+
+  assert(done <= w->pending);
+  w->pending -= done;
+}
+
+
+/* POLLERR also reports a pending socket error, over and over again until it
+ * is picked up. uv__read() and uv__write() do that while the stream reads or
+ * writes; otherwise, take it here and fail the parked requests with it.
+ */
+static void uv__stream_zerocopy_take_error(uv_tcp_t* tcp) {
+  uv__tcp_zerocopy_t* zc;
+  uv_write_t* req;
+  socklen_t errorsize;
+  QUEUE* q;
+  int error;
+
+  if ((tcp->flags & UV_HANDLE_READING) || !QUEUE_EMPTY(&tcp->write_queue))
+    return;
+
+  error = 0;
+  errorsize = sizeof(error);
+  getsockopt(uv__stream_fd(tcp), SOL_SOCKET, SO_ERROR, &error, &errorsize);
+  if (error == 0)
+    return;
+
+  zc = uv__tcp_zerocopy(tcp);
+  QUEUE_FOREACH(q, &zc->parked) {
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    if (req->error == 0)
+      req->error = UV__ERR(error);
+  }
+}
+
+
+/* Reads the completion notifications off the socket's error queue. Once the
+ * kernel has released every buffer of a parked request, the request is done.
+ */
+static void uv__stream_zerocopy_reap(uv_tcp_t* tcp) {
+  struct uv__sock_extended_err* serr;
+  uv__zerocopy_write_t* w;
+  uv__tcp_zerocopy_t* zc;
+  struct cmsghdr* cmsg;
+  struct msghdr msg;
+  uv_write_t* req;
+  QUEUE* q;
+  QUEUE* next;
+  ssize_t n;
+  int notified;
+  union {
+    char data[128];
+    struct cmsghdr alias;
+  } scratch;
+
+  zc = uv__tcp_zerocopy(tcp);
+  if (zc == NULL || QUEUE_EMPTY(&zc->writes))
+    return;
+
+  notified = 0;
+  for (;;) {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = &scratch.alias;
+    msg.msg_controllen = sizeof(scratch);
+
+    do
+      n = recvmsg(uv__stream_fd(tcp), &msg, MSG_ERRQUEUE);
+    while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+      break;  /* EAGAIN, the error queue is empty. */
+
+    for (cmsg = CMSG_FIRSTHDR(&msg);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == IPPROTO_IP &&
+            cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == IPPROTO_IPV6 &&
+            cmsg->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+
+      serr = (struct uv__sock_extended_err*) CMSG_DATA(cmsg);
+      if (serr->ee_errno != 0 ||
+          serr->ee_origin != UV__SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+
+      notified = 1;
+      QUEUE_FOREACH(q, &zc->writes) {
+        w = QUEUE_DATA(q, uv__zerocopy_write_t, queue);
+        uv__write_zerocopy_done(w, serr->ee_info, serr->ee_data);
+      }
+    }
+  }
+
+  if (!notified)
+    uv__stream_zerocopy_take_error(tcp);
+
+  for (q = QUEUE_HEAD(&zc->writes); q != &zc->writes; q = next) {
+    next = QUEUE_NEXT(q);
+    w = QUEUE_DATA(q, uv__zerocopy_write_t, queue);
+    if (w->pending == 0) {
+      QUEUE_REMOVE(q);
+      uv__free(w);
+    }
+  }
+
+  /* Complete requests in order. The sends of the parked requests come before
+   * those of the request that is still being written, so a parked request is
+   * done once the oldest sends left belong to a later request.
+   */
+  while (!QUEUE_EMPTY(&zc->parked)) {
+    q = QUEUE_HEAD(&zc->parked);
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    if (!QUEUE_EMPTY(&zc->writes)) {
+      w = QUEUE_DATA(QUEUE_HEAD(&zc->writes), uv__zerocopy_write_t, queue);
+      if (w->req == req)
+        break;
+    }
+    uv__write_req_finish(req);
+  }
+
+  if (QUEUE_EMPTY(&zc->writes))
+    uv__io_stop(tcp->loop, &tcp->io_watcher, UV__POLLERR);
+}
+
+
+/* Parks a request that has been sent in full until the kernel is done with
+ * its buffers. Requests complete in order, so the ones that follow a parked
+ * request are parked too. Returns 1 if the request was parked.
+ */
+static int uv__write_zerocopy_wait(uv_stream_t* stream, uv_write_t* req) {
+  uv__tcp_zerocopy_t* zc;
+
+  if (stream->type != UV_TCP)
+    return 0;
+
+  /* Parked requests always wait for sends that haven't been released. */
+  zc = uv__tcp_zerocopy((uv_tcp_t*) stream);
+  if (zc == NULL || QUEUE_EMPTY(&zc->writes))
+    return 0;
+
+  QUEUE_REMOVE(&req->queue);
+  QUEUE_INSERT_TAIL(&zc->parked, &req->queue);
+  return 1;
+}
+
+
+static void uv__stream_zerocopy_linger_io(uv_loop_t* loop,
+                                          uv__io_t* w,
+                                          unsigned int events) {
+  uv_tcp_t* tcp;
+
+  tcp = container_of(w, uv_tcp_t, io_watcher);
+  assert(tcp->flags & UV_HANDLE_CLOSING);
+
+  uv__stream_zerocopy_reap(tcp);
+  uv__write_callbacks((uv_stream_t*) tcp);
+
+  if (QUEUE_EMPTY(&uv__tcp_zerocopy(tcp)->writes)) {
+    uv__stream_close((uv_stream_t*) tcp);
+    uv__make_close_pending((uv_handle_t*) tcp);
+  }
+}
+
+
+/* The kernel may still be sending from the buffers of zero-copy writes, and
+ * once the socket is closed there is no way to find out when it's done with
+ * them. Keep the socket open until then, with everything else stopped and
+ * the writes that are still queued cancelled, and only close it afterwards.
+ * Returns 1 if closing the socket is deferred.
+ */
+int uv__stream_zerocopy_linger(uv_tcp_t* tcp) {
+  uv__tcp_zerocopy_t* zc;
+  uv_write_t* req;
+  QUEUE* q;
+
+  zc = uv__tcp_zerocopy(tcp);
+  if (zc == NULL || QUEUE_EMPTY(&zc->writes))
+    return 0;
+
+  uv_read_stop((uv_stream_t*) tcp);
+  uv__io_stop(tcp->loop,
+              &tcp->io_watcher,
+              POLLIN | POLLOUT | UV__POLLRDHUP | UV__POLLPRI);
+  tcp->flags &= ~(UV_HANDLE_READABLE | UV_HANDLE_WRITABLE);
+
+  /* Requests complete in order, so they wait behind the parked ones. */
+  while (!QUEUE_EMPTY(&tcp->write_queue)) {
+    q = QUEUE_HEAD(&tcp->write_queue);
+    QUEUE_REMOVE(q);
+
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    req->error = UV_ECANCELED;
+
+    QUEUE_INSERT_TAIL(&zc->parked, &req->queue);
+  }
+
+  tcp->io_watcher.cb = uv__stream_zerocopy_linger_io;
+  return 1;
+}
+
+
+static void uv__stream_zerocopy_free(uv_tcp_t* tcp) {
+  uv__tcp_zerocopy_t* zc;
+
+  zc = uv__tcp_zerocopy(tcp);
+  if (zc == NULL)
+    return;
+
+  assert(QUEUE_EMPTY(&zc->writes));
+  assert(QUEUE_EMPTY(&zc->parked));
+  uv__free(zc);
+  tcp->u.reserved[0] = NULL;
+}
+#endif /* defined(__linux__) */
+
+
 static void uv__write(uv_stream_t* stream) {
   QUEUE* q;
   uv_write_t* req;
@@ -897,6 +1258,11 @@ static void uv__write(uv_stream_t* stream) {
     req = QUEUE_DATA(q, uv_write_t, queue);
     assert(req->handle == stream);
 
+#if defined(__linux__)
+    if (uv__write_use_zerocopy(stream, req))
+      n = uv__try_write_zerocopy(stream, req);
+    else
+#endif
     n = uv__try_write(stream,
                       &(req->bufs[req->write_index]),
                       req->nbufs - req->write_index,
@@ -906,6 +1272,10 @@ static void uv__write(uv_stream_t* stream) {
     if (n >= 0) {
       req->send_handle = NULL;
       if (uv__write_req_update(stream, req, n)) {
+#if defined(__linux__)
+        if (uv__write_zerocopy_wait(stream, req))
+          return;
+#endif
         uv__write_req_finish(req);
         return;  /* TODO(bnoordhuis) Start trying to write the next request. */
       }
@@ -1310,6 +1680,11 @@ static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
   assert(uv__stream_fd(stream) >= 0);
 
+#if defined(__linux__)
+  if ((events & POLLERR) && stream->type == UV_TCP)
+    uv__stream_zerocopy_reap((uv_tcp_t*) stream);
+#endif
+
   /* Ignore POLLHUP here. Even if it's set, there may still be data to read. */
   if (events & (POLLIN | POLLERR | POLLHUP))
     uv__read(stream);
@@ -1539,6 +1914,18 @@ int uv_try_write2(uv_stream_t* stream,
   if (err < 0)
     return err;
 
+#if defined(__linux__)
+  /* Zero-copy sends need a request to track when the buffers are free. */
+  if (stream->type == UV_TCP) {
+    uv__tcp_zerocopy_t* zc = uv__tcp_zerocopy((uv_tcp_t*) stream);
+    if (zc != NULL &&
+        zc->threshold != 0 &&
+        uv__count_bufs(bufs, nbufs) >= zc->threshold) {
+      return UV_EAGAIN;
+    }
+  }
+#endif
+
   return uv__try_write(stream, bufs, nbufs, send_handle);
 }
 
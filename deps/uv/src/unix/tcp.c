@@ -64,6 +64,27 @@ static int new_socket(uv_tcp_t* handle, int domain, unsigned long flags) {
 }
 
 
+static int uv__tcp_reuseport(int fd) {
+  int on;
+
+  on = 1;
+#if defined(__FreeBSD__) && defined(SO_REUSEPORT_LB)
+  /* Plain SO_REUSEPORT does not balance connections on FreeBSD. */
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT_LB, &on, sizeof(on)))
+    return UV__ERR(errno);
+#elif (defined(__linux__) || defined(__DragonFly__)) && defined(SO_REUSEPORT)
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)))
+    return UV__ERR(errno);
+#else
+  (void) fd;
+  (void) on;
+  return UV_ENOTSUP;
+#endif
+
+  return 0;
+}
+
+
 static int maybe_new_socket(uv_tcp_t* handle, int domain, unsigned long flags) {
   struct sockaddr_storage saddr;
   socklen_t slen;
@@ -123,6 +144,9 @@ int uv_tcp_init_ex(uv_loop_t* loop, uv_tcp_t* tcp, unsigned int flags) {
     return UV_EINVAL;
 
   uv__stream_init(loop, (uv_stream_t*)tcp, UV_TCP);
+#if defined(__linux__)
+  tcp->u.reserved[0] = NULL;
+#endif
 
   /* If anything fails beyond this point we need to remove the handle from
    * the handle queue, since it was added by uv__handle_init in uv_stream_init.
@@ -164,6 +188,12 @@ int uv__tcp_bind(uv_tcp_t* tcp,
   if (setsockopt(tcp->io_watcher.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)))
     return UV__ERR(errno);
 
+  if (flags & UV_TCP_REUSEPORT) {
+    err = uv__tcp_reuseport(tcp->io_watcher.fd);
+    if (err)
+      return err;
+  }
+
 #ifndef __OpenBSD__
 #ifdef IPV6_V6ONLY
   if (addr->sa_family == AF_INET6) {
@@ -459,8 +489,61 @@ int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
 }
 
 
-void uv__tcp_close(uv_tcp_t* handle) {
+int uv_tcp_zerocopy(uv_tcp_t* handle, size_t threshold) {
+#if defined(__linux__)
+  uv__tcp_zerocopy_t* zc;
+  int on;
+
+  zc = uv__tcp_zerocopy(handle);
+  if (threshold == 0) {
+    if (zc != NULL)
+      zc->threshold = 0;
+    return 0;
+  }
+
+  if (uv__stream_fd(handle) == -1)
+    return UV_EBADF;
+
+  /* Leave SO_ZEROCOPY alone once it's on, even if zero-copy sends are turned
+   * off again; the kernel only uses it to accept MSG_ZEROCOPY. The state is
+   * kept as well, sends may still be in flight.
+   */
+  if (zc == NULL) {
+    zc = uv__malloc(sizeof(*zc));
+    if (zc == NULL)
+      return UV_ENOMEM;
+
+    on = 1;
+    if (setsockopt(uv__stream_fd(handle),
+                   SOL_SOCKET,
+                   UV__SO_ZEROCOPY,
+                   &on,
+                   sizeof(on))) {
+      uv__free(zc);
+      return errno == ENOPROTOOPT ? UV_ENOTSUP : UV__ERR(errno);
+    }
+
+    zc->next_id = 0;
+    QUEUE_INIT(&zc->writes);
+    QUEUE_INIT(&zc->parked);
+    handle->u.reserved[0] = zc;
+  }
+
+  zc->threshold = threshold;
+  return 0;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+
+int uv__tcp_close(uv_tcp_t* handle) {
+#if defined(__linux__)
+  if (uv__stream_zerocopy_linger(handle))
+    return 1;
+#endif
   uv__stream_close((uv_stream_t*)handle);
+  return 0;
 }
 
 
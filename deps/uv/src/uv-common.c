@@ -763,7 +763,10 @@ int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...) {
 
   va_start(ap, option);
   /* Any platform-agnostic options should be handled here. */
-  err = uv__loop_configure(loop, option, ap);
+  if (option == UV_LOOP_TIMER_WHEEL)
+    err = uv__timer_wheel_init(loop, va_arg(ap, unsigned int));
+  else
+    err = uv__loop_configure(loop, option, ap);
   va_end(ap);
 
   return err;
@@ -818,6 +821,7 @@ int uv_loop_close(uv_loop_t* loop) {
       return UV_EBUSY;
   }
 
+  uv__timer_wheel_free(loop);
   uv__loop_close(loop);
 
 #ifndef NDEBUG
@@ -130,7 +130,10 @@ enum {
   UV_SIGNAL_ONE_SHOT                    = 0x02000000,
 
   /* Only used by uv_poll_t handles. */
-  UV_HANDLE_POLL_SLOW                   = 0x01000000
+  UV_HANDLE_POLL_SLOW                   = 0x01000000,
+
+  /* Only used by uv_timer_t handles. */
+  UV_HANDLE_TIMER_IN_WHEEL              = 0x01000000
 };
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap);
@@ -218,6 +221,8 @@ uv_dirent_type_t uv__fs_get_dirent_type(uv__dirent_t* dent);
 int uv__next_timeout(const uv_loop_t* loop);
 void uv__run_timers(uv_loop_t* loop);
 void uv__timer_close(uv_timer_t* handle);
+int uv__timer_wheel_init(uv_loop_t* loop, unsigned int resolution);
+void uv__timer_wheel_free(uv_loop_t* loop);
 
 void uv__process_title_cleanup(void);
 void uv__signal_cleanup(void);
@@ -365,9 +370,13 @@ struct uv__loop_metrics_s {
 void uv__metrics_update_idle_time(uv_loop_t* loop);
 void uv__metrics_set_provider_entry_time(uv_loop_t* loop);
 
+struct uv__timer_wheel_s;
+
 struct uv__loop_internal_fields_s {
   unsigned int flags;
   uv__loop_metrics_t loop_metrics;
+  /* Set if the loop was configured with UV_LOOP_TIMER_WHEEL. */
+  struct uv__timer_wheel_s* timer_wheel;
 };
 
 #endif /* UV_COMMON_H_ */
@@ -1404,6 +1404,11 @@ int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
 }
 
 
+int uv_tcp_zerocopy(uv_tcp_t* handle, size_t threshold) {
+  return UV_ENOTSUP;
+}
+
+
 static void uv_tcp_try_cancel_reqs(uv_tcp_t* tcp) {
   SOCKET socket;
   int non_ifs_lsp;
@@ -1555,6 +1560,10 @@ int uv__tcp_bind(uv_tcp_t* handle,
                  unsigned int flags) {
   int err;
 
+  /* SO_REUSEPORT is not supported on Windows. */
+  if (flags & UV_TCP_REUSEPORT)
+    return UV_ENOTSUP;
+
   err = uv_tcp_try_bind(handle, addr, addrlen, flags);
   if (err)
     return uv_translate_sys_error(err);
@@ -25,6 +25,8 @@ BENCHMARK_DECLARE (loop_count_timed)
 BENCHMARK_DECLARE (ping_pongs)
 BENCHMARK_DECLARE (ping_udp)
 BENCHMARK_DECLARE (tcp_write_batch)
+BENCHMARK_DECLARE (tcp_write_large)
+BENCHMARK_DECLARE (tcp_write_large_zerocopy)
 BENCHMARK_DECLARE (tcp4_pound_100)
 BENCHMARK_DECLARE (tcp4_pound_1000)
 BENCHMARK_DECLARE (pipe_pound_100)
@@ -37,6 +39,9 @@ BENCHMARK_DECLARE (pipe_pump1_client)
 BENCHMARK_DECLARE (tcp_multi_accept2)
 BENCHMARK_DECLARE (tcp_multi_accept4)
 BENCHMARK_DECLARE (tcp_multi_accept8)
+BENCHMARK_DECLARE (tcp_multi_accept2_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept4_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept8_reuseport)
 
 /* Run until X packets have been sent/received. */
 BENCHMARK_DECLARE (udp_pummel_1v1)
@@ -76,6 +81,8 @@ BENCHMARK_DECLARE (spawn)
 BENCHMARK_DECLARE (thread_create)
 BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
+BENCHMARK_DECLARE (million_timers_refresh_heap)
+BENCHMARK_DECLARE (million_timers_refresh_wheel)
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
 HELPER_DECLARE    (pipe_pump_server)
@@ -93,6 +100,12 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_write_batch)
   BENCHMARK_HELPER (tcp_write_batch, tcp4_blackhole_server)
 
+  BENCHMARK_ENTRY  (tcp_write_large)
+  BENCHMARK_HELPER (tcp_write_large, tcp4_blackhole_server)
+
+  BENCHMARK_ENTRY  (tcp_write_large_zerocopy)
+  BENCHMARK_HELPER (tcp_write_large_zerocopy, tcp4_blackhole_server)
+
   BENCHMARK_ENTRY  (tcp_pump100_client)
   BENCHMARK_HELPER (tcp_pump100_client, tcp_pump_server)
 
@@ -120,6 +133,9 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_multi_accept2)
   BENCHMARK_ENTRY  (tcp_multi_accept4)
   BENCHMARK_ENTRY  (tcp_multi_accept8)
+  BENCHMARK_ENTRY  (tcp_multi_accept2_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept4_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept8_reuseport)
 
   BENCHMARK_ENTRY  (udp_pummel_1v1)
   BENCHMARK_ENTRY  (udp_pummel_1v10)
@@ -160,4 +176,6 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (thread_create)
   BENCHMARK_ENTRY  (million_async)
   BENCHMARK_ENTRY  (million_timers)
+  BENCHMARK_ENTRY  (million_timers_refresh_heap)
+  BENCHMARK_ENTRY  (million_timers_refresh_wheel)
 TASK_LIST_END
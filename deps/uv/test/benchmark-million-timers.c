@@ -84,3 +84,79 @@ BENCHMARK_IMPL(million_timers) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+#define NUM_REFRESH_TIMERS (1000 * 1000)
+#define NUM_REFRESH_ROUNDS 10
+
+/* Models idle timeouts on a large number of connections: every timer is
+ * pushed back a number of times before the loop finally runs them.
+ */
+static int timers_refresh(unsigned int wheel_resolution) {
+  uv_timer_t* timers;
+  uv_loop_t loop;
+  uint64_t before_start;
+  uint64_t before_refresh;
+  uint64_t before_stop;
+  uint64_t after_stop;
+  unsigned int i;
+  int round;
+
+  timers = malloc(NUM_REFRESH_TIMERS * sizeof(timers[0]));
+  ASSERT_NOT_NULL(timers);
+
+  ASSERT(0 == uv_loop_init(&loop));
+  if (wheel_resolution != 0)
+    ASSERT(0 == uv_loop_configure(&loop,
+                                  UV_LOOP_TIMER_WHEEL,
+                                  wheel_resolution));
+
+  before_start = uv_hrtime();
+  for (i = 0; i < NUM_REFRESH_TIMERS; i++) {
+    ASSERT(0 == uv_timer_init(&loop, timers + i));
+    ASSERT(0 == uv_timer_start(timers + i,
+                               timer_cb,
+                               60 * 1000 + i % 1000,
+                               60 * 1000));
+  }
+
+  before_refresh = uv_hrtime();
+  for (round = 0; round < NUM_REFRESH_ROUNDS; round++) {
+    /* Advance the clock a little so that the refreshed timers go to the
+     * back of the queue, like they would on a busy loop.
+     */
+    uv_update_time(&loop);
+    for (i = 0; i < NUM_REFRESH_TIMERS; i++)
+      ASSERT(0 == uv_timer_again(timers + (i * 7919u) % NUM_REFRESH_TIMERS));
+  }
+
+  before_stop = uv_hrtime();
+  for (i = 0; i < NUM_REFRESH_TIMERS; i++)
+    uv_close((uv_handle_t*) (timers + i), NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  after_stop = uv_hrtime();
+
+  ASSERT(0 == uv_loop_close(&loop));
+  free(timers);
+
+  fprintf(stderr, "%.2f seconds start\n",
+          (before_refresh - before_start) / 1e9);
+  fprintf(stderr, "%.2f seconds refresh (%d rounds)\n",
+          (before_stop - before_refresh) / 1e9,
+          NUM_REFRESH_ROUNDS);
+  fprintf(stderr, "%.2f seconds stop\n", (after_stop - before_stop) / 1e9);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(million_timers_refresh_heap) {
+  return timers_refresh(0);
+}
+
+
+BENCHMARK_IMPL(million_timers_refresh_wheel) {
+  return timers_refresh(1);
+}
@@ -77,6 +77,9 @@ struct client_ctx {
   unsigned int num_connects;
   uv_connect_t connect_req;
   uv_idle_t idle_handle;
+  uint64_t connect_start;
+  uint64_t connect_time;
+  uint64_t max_connect_time;
 };
 
 static void ipc_connection_cb(uv_stream_t* ipc_pipe, int status);
@@ -102,6 +105,11 @@ static void cl_idle_cb(uv_idle_t* handle);
 static void cl_close_cb(uv_handle_t* handle);
 
 static struct sockaddr_in listen_addr;
+/* If set, every server thread binds its own listen socket with
+ * UV_TCP_REUSEPORT and the kernel distributes the connections, instead of
+ * all threads sharing a single listen socket.
+ */
+static int use_reuseport;
 
 
 static void ipc_connection_cb(uv_stream_t* ipc_pipe, int status) {
@@ -264,15 +272,29 @@ static void server_cb(void *arg) {
   ASSERT(0 == uv_async_init(&loop, &ctx->async_handle, sv_async_cb));
   uv_unref((uv_handle_t*) &ctx->async_handle);
 
-  /* Wait until the main thread is ready. */
-  uv_sem_wait(&ctx->semaphore);
-  get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
-  uv_sem_post(&ctx->semaphore);
-
-  /* Now start the actual benchmark. */
-  ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
-                        128,
-                        sv_connection_cb));
+  if (use_reuseport) {
+    ASSERT(0 == uv_tcp_init(&loop, (uv_tcp_t*) &ctx->server_handle));
+    ASSERT(0 == uv_tcp_bind((uv_tcp_t*) &ctx->server_handle,
+                            (const struct sockaddr*) &listen_addr,
+                            UV_TCP_REUSEPORT));
+    /* Only listening sockets take part in the distribution of connections,
+     * so listen before the clients are started.
+     */
+    ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
+                          128,
+                          sv_connection_cb));
+    uv_sem_post(&ctx->semaphore);
+  } else {
+    /* Wait until the main thread is ready. */
+    uv_sem_wait(&ctx->semaphore);
+    get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
+    uv_sem_post(&ctx->semaphore);
+
+    /* Now start the actual benchmark. */
+    ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
+                          128,
+                          sv_connection_cb));
+  }
   ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
 
   uv_loop_close(&loop);
@@ -329,6 +351,13 @@ static void sv_read_cb(uv_stream_t* handle,
 
 static void cl_connect_cb(uv_connect_t* req, int status) {
   struct client_ctx* ctx = container_of(req, struct client_ctx, connect_req);
+  uint64_t connect_time;
+
+  connect_time = uv_hrtime() - ctx->connect_start;
+  ctx->connect_time += connect_time;
+  if (connect_time > ctx->max_connect_time)
+    ctx->max_connect_time = connect_time;
+
   uv_idle_start(&ctx->idle_handle, cl_idle_cb);
   ASSERT(0 == status);
 }
@@ -352,6 +381,7 @@ static void cl_close_cb(uv_handle_t* handle) {
   }
 
   ASSERT(0 == uv_tcp_init(handle->loop, (uv_tcp_t*) &ctx->client_handle));
+  ctx->connect_start = uv_hrtime();
   ASSERT(0 == uv_tcp_connect(&ctx->connect_req,
                              (uv_tcp_t*) &ctx->client_handle,
                              (const struct sockaddr*) &listen_addr,
@@ -359,17 +389,37 @@ static void cl_close_cb(uv_handle_t* handle) {
 }
 
 
-static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
+static int test_tcp(unsigned int num_servers,
+                    unsigned int num_clients,
+                    int reuseport) {
   struct server_ctx* servers;
   struct client_ctx* clients;
   uv_loop_t* loop;
   uv_tcp_t* handle;
+  uint64_t connect_time;
+  uint64_t max_connect_time;
   unsigned int i;
   double time;
 
   ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &listen_addr));
   loop = uv_default_loop();
 
+  use_reuseport = reuseport;
+  if (use_reuseport) {
+    uv_tcp_t probe;
+    int err;
+
+    ASSERT(0 == uv_tcp_init(loop, &probe));
+    err = uv_tcp_bind(&probe,
+                      (const struct sockaddr*) &listen_addr,
+                      UV_TCP_REUSEPORT);
+    uv_close((uv_handle_t*) &probe, NULL);
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    if (err == UV_ENOTSUP)
+      RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+    ASSERT(err == 0);
+  }
+
   servers = calloc(num_servers, sizeof(servers[0]));
   clients = calloc(num_clients, sizeof(clients[0]));
   ASSERT_NOT_NULL(servers);
@@ -385,7 +435,13 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     ASSERT(0 == uv_thread_create(&ctx->thread_id, server_cb, ctx));
   }
 
-  send_listen_handles(UV_TCP, num_servers, servers);
+  if (use_reuseport) {
+    /* Wait until all threads are listening. */
+    for (i = 0; i < num_servers; i++)
+      uv_sem_wait(&servers[i].semaphore);
+  } else {
+    send_listen_handles(UV_TCP, num_servers, servers);
+  }
 
   for (i = 0; i < num_clients; i++) {
     struct client_ctx* ctx = clients + i;
@@ -393,6 +449,7 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     handle = (uv_tcp_t*) &ctx->client_handle;
     handle->data = "client handle";
     ASSERT(0 == uv_tcp_init(loop, handle));
+    ctx->connect_start = uv_hrtime();
     ASSERT(0 == uv_tcp_connect(&ctx->connect_req,
                                handle,
                                (const struct sockaddr*) &listen_addr,
@@ -414,10 +471,22 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     uv_sem_destroy(&ctx->semaphore);
   }
 
-  printf("accept%u: %.0f accepts/sec (%u total)\n",
+  connect_time = 0;
+  max_connect_time = 0;
+  for (i = 0; i < num_clients; i++) {
+    connect_time += clients[i].connect_time;
+    if (clients[i].max_connect_time > max_connect_time)
+      max_connect_time = clients[i].max_connect_time;
+  }
+
+  printf("accept%u%s: %.0f accepts/sec (%u total)\n",
          num_servers,
+         use_reuseport ? " (reuseport)" : "",
          NUM_CONNECTS / time,
          NUM_CONNECTS);
+  printf("  connect latency: %.1f us average, %.1f us max\n",
+         connect_time / 1e3 / NUM_CONNECTS,
+         max_connect_time / 1e3);
 
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
@@ -437,15 +506,30 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
 
 
 BENCHMARK_IMPL(tcp_multi_accept2) {
-  return test_tcp(2, 40);
+  return test_tcp(2, 40, 0);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept4) {
-  return test_tcp(4, 40);
+  return test_tcp(4, 40, 0);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept8) {
-  return test_tcp(8, 40);
+  return test_tcp(8, 40, 0);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept2_reuseport) {
+  return test_tcp(2, 40, 1);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept4_reuseport) {
+  return test_tcp(4, 40, 1);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept8_reuseport) {
+  return test_tcp(8, 40, 1);
 }
@@ -0,0 +1,160 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITE_SIZE      (4 * 1024 * 1024)
+#define NUM_WRITE_REQS  256
+#define MAX_IN_FLIGHT   8
+
+static uv_tcp_t tcp_client;
+static uv_connect_t connect_req;
+static uv_shutdown_t shutdown_req;
+static uv_write_t write_reqs[MAX_IN_FLIGHT];
+static char* write_buffer;
+
+static int writes_started;
+static int write_cb_called;
+static int shutdown_cb_called;
+static int close_cb_called;
+
+
+static void write_cb(uv_write_t* req, int status);
+
+
+static void start_write(uv_write_t* req) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(write_buffer, WRITE_SIZE);
+  ASSERT(0 == uv_write(req, (uv_stream_t*) &tcp_client, &buf, 1, write_cb));
+  writes_started++;
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  ASSERT(handle == (uv_handle_t*) &tcp_client);
+  close_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+  uv_close((uv_handle_t*) req->handle, close_cb);
+  shutdown_cb_called++;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+
+  if (writes_started < NUM_WRITE_REQS)
+    start_write(req);
+  else if (write_cb_called == NUM_WRITE_REQS)
+    ASSERT(0 == uv_shutdown(&shutdown_req,
+                            (uv_stream_t*) &tcp_client,
+                            shutdown_cb));
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  int i;
+
+  ASSERT(status == 0);
+
+  for (i = 0; i < MAX_IN_FLIGHT; i++)
+    start_write(&write_reqs[i]);
+}
+
+
+/* Keeps MAX_IN_FLIGHT writes of WRITE_SIZE bytes queued. Over loopback the
+ * kernel copies zero-copy sends anyway; run the blackhole server on another
+ * host to see the difference.
+ */
+static int tcp_write_large(size_t zerocopy_threshold) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  uint64_t start;
+  uint64_t stop;
+  int r;
+
+  write_buffer = malloc(WRITE_SIZE);
+  ASSERT_NOT_NULL(write_buffer);
+  memset(write_buffer, 'x', WRITE_SIZE);
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init_ex(loop, &tcp_client, AF_INET));
+
+  if (zerocopy_threshold != 0) {
+    r = uv_tcp_zerocopy(&tcp_client, zerocopy_threshold);
+    if (r == UV_ENOTSUP) {
+      uv_close((uv_handle_t*) &tcp_client, NULL);
+      uv_run(loop, UV_RUN_DEFAULT);
+      free(write_buffer);
+      MAKE_VALGRIND_HAPPY();
+      RETURN_SKIP("MSG_ZEROCOPY is not supported on this platform.");
+    }
+    ASSERT(r == 0);
+  }
+
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &tcp_client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  start = uv_hrtime();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  stop = uv_hrtime();
+
+  ASSERT(write_cb_called == NUM_WRITE_REQS);
+  ASSERT(shutdown_cb_called == 1);
+  ASSERT(close_cb_called == 1);
+
+  fprintf(stderr,
+          "tcp_write_large%s: %d MB in %.2fs, %.1f MB/s\n",
+          zerocopy_threshold != 0 ? "_zerocopy" : "",
+          NUM_WRITE_REQS * (WRITE_SIZE / (1024 * 1024)),
+          (stop - start) / 1e9,
+          NUM_WRITE_REQS * (WRITE_SIZE / (1024.0 * 1024)) /
+              ((stop - start) / 1e9));
+  fflush(stderr);
+
+  free(write_buffer);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_write_large) {
+  return tcp_write_large(0);
+}
+
+
+BENCHMARK_IMPL(tcp_write_large_zerocopy) {
+  return tcp_write_large(64 * 1024);
+}
@@ -111,6 +111,9 @@ TEST_DECLARE   (tcp_write_fail)
 TEST_DECLARE   (tcp_try_write)
 TEST_DECLARE   (tcp_try_write_error)
 TEST_DECLARE   (tcp_write_queue_order)
+TEST_DECLARE   (tcp_zerocopy)
+TEST_DECLARE   (tcp_zerocopy_close)
+TEST_DECLARE   (tcp_zerocopy_error)
 TEST_DECLARE   (tcp_open)
 TEST_DECLARE   (tcp_open_twice)
 TEST_DECLARE   (tcp_open_bound)
@@ -119,6 +122,7 @@ TEST_DECLARE   (tcp_connect_error_after_write)
 TEST_DECLARE   (tcp_shutdown_after_write)
 TEST_DECLARE   (tcp_bind_error_addrinuse_connect)
 TEST_DECLARE   (tcp_bind_error_addrinuse_listen)
+TEST_DECLARE   (tcp_bind_reuseport)
 TEST_DECLARE   (tcp_bind_error_addrnotavail_1)
 TEST_DECLARE   (tcp_bind_error_addrnotavail_2)
 TEST_DECLARE   (tcp_bind_error_fault)
@@ -226,6 +230,11 @@ TEST_DECLARE   (timer_from_check)
 TEST_DECLARE   (timer_is_closing)
 TEST_DECLARE   (timer_null_callback)
 TEST_DECLARE   (timer_early_check)
+TEST_DECLARE   (timer_wheel_configure)
+TEST_DECLARE   (timer_wheel_order)
+TEST_DECLARE   (timer_wheel_cascade)
+TEST_DECLARE   (timer_wheel_refresh)
+TEST_DECLARE   (timer_wheel_resolution)
 TEST_DECLARE   (idle_starvation)
 TEST_DECLARE   (loop_handles)
 TEST_DECLARE   (get_loadavg)
@@ -673,6 +682,10 @@ TASK_LIST_START
 
   TEST_ENTRY  (tcp_write_queue_order)
 
+  TEST_ENTRY  (tcp_zerocopy)
+  TEST_ENTRY  (tcp_zerocopy_close)
+  TEST_ENTRY  (tcp_zerocopy_error)
+
   TEST_ENTRY  (tcp_open)
   TEST_HELPER (tcp_open, tcp4_echo_server)
   TEST_ENTRY  (tcp_open_twice)
@@ -693,6 +706,7 @@ TASK_LIST_START
    */
   TEST_HELPER (tcp_bind_error_addrinuse_connect, tcp4_echo_server)
   TEST_ENTRY  (tcp_bind_error_addrinuse_listen)
+  TEST_ENTRY  (tcp_bind_reuseport)
   TEST_ENTRY  (tcp_bind_error_addrnotavail_1)
   TEST_ENTRY  (tcp_bind_error_addrnotavail_2)
   TEST_ENTRY  (tcp_bind_error_fault)
@@ -817,6 +831,11 @@ TASK_LIST_START
   TEST_ENTRY  (timer_is_closing)
   TEST_ENTRY  (timer_null_callback)
   TEST_ENTRY  (timer_early_check)
+  TEST_ENTRY  (timer_wheel_configure)
+  TEST_ENTRY  (timer_wheel_order)
+  TEST_ENTRY  (timer_wheel_cascade)
+  TEST_ENTRY  (timer_wheel_refresh)
+  TEST_ENTRY  (timer_wheel_resolution)
 
   TEST_ENTRY  (idle_starvation)
 
@@ -110,6 +110,45 @@ TEST_IMPL(tcp_bind_error_addrinuse_listen) {
 }
 
 
+TEST_IMPL(tcp_bind_reuseport) {
+  struct sockaddr_in addr;
+  uv_tcp_t server1, server2;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+  r = uv_tcp_init(uv_default_loop(), &server1);
+  ASSERT(r == 0);
+  r = uv_tcp_bind(&server1, (const struct sockaddr*) &addr, UV_TCP_REUSEPORT);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &server1, NULL);
+    MAKE_VALGRIND_HAPPY();
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  r = uv_tcp_init(uv_default_loop(), &server2);
+  ASSERT(r == 0);
+  r = uv_tcp_bind(&server2, (const struct sockaddr*) &addr, UV_TCP_REUSEPORT);
+  ASSERT(r == 0);
+
+  /* Unlike in tcp_bind_error_addrinuse_listen, both sockets can listen. */
+  r = uv_listen((uv_stream_t*)&server1, 128, NULL);
+  ASSERT(r == 0);
+  r = uv_listen((uv_stream_t*)&server2, 128, NULL);
+  ASSERT(r == 0);
+
+  uv_close((uv_handle_t*)&server1, close_cb);
+  uv_close((uv_handle_t*)&server2, close_cb);
+
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
 TEST_IMPL(tcp_bind_error_addrnotavail_1) {
   struct sockaddr_in addr;
   uv_tcp_t server;
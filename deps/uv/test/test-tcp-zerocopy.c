@@ -0,0 +1,286 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define THRESHOLD (64 * 1024)
+#define BIG_WRITE (4 * 1024 * 1024)
+#define SMALL_WRITE 1024
+#define NUM_WRITES 3
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_connect_t connect_req;
+static uv_write_t write_reqs[NUM_WRITES];
+static char* send_buffer;
+static size_t send_offsets[NUM_WRITES + 1];
+static size_t bytes_read;
+static int write_cb_called;
+static int close_cb_called;
+static int connect_cb_called;
+static int connection_cb_called;
+
+
+static char pattern(size_t offset) {
+  return (char) ((offset * 7 + offset / 251) & 0xff);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char base[64 * 1024];
+
+  buf->base = base;
+  buf->len = sizeof(base);
+}
+
+
+static void read_cb(uv_stream_t* tcp, ssize_t nread, const uv_buf_t* buf) {
+  ssize_t i;
+
+  if (nread < 0) {
+    ASSERT(nread == UV_EOF);
+    uv_close((uv_handle_t*) tcp, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    return;
+  }
+
+  for (i = 0; i < nread; i++)
+    ASSERT(buf->base[i] == pattern(bytes_read + i));
+
+  bytes_read += nread;
+}
+
+
+static void connection_cb(uv_stream_t* tcp, int status) {
+  ASSERT(status == 0);
+
+  ASSERT(0 == uv_tcp_init(tcp->loop, &incoming));
+  ASSERT(0 == uv_accept(tcp, (uv_stream_t*) &incoming));
+
+  connection_cb_called++;
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  /* Callbacks run in order, even though the small write in the middle
+   * doesn't wait for the kernel to release its buffer.
+   */
+  ASSERT(req == &write_reqs[write_cb_called]);
+  write_cb_called++;
+
+  if (write_cb_called == NUM_WRITES)
+    uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+  int i;
+
+  ASSERT(status == 0);
+  connect_cb_called++;
+
+  /* Writes at or above the threshold need a write request. */
+  buf = uv_buf_init(send_buffer, THRESHOLD);
+  ASSERT(UV_EAGAIN == uv_try_write((uv_stream_t*) &client, &buf, 1));
+
+  for (i = 0; i < NUM_WRITES; i++) {
+    buf = uv_buf_init(send_buffer + send_offsets[i],
+                      send_offsets[i + 1] - send_offsets[i]);
+    ASSERT(0 == uv_write(&write_reqs[i],
+                         (uv_stream_t*) &client,
+                         &buf,
+                         1,
+                         write_cb));
+  }
+}
+
+
+TEST_IMPL(tcp_zerocopy) {
+  struct sockaddr_in addr;
+  size_t i;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init_ex(uv_default_loop(), &client, AF_INET));
+
+  r = uv_tcp_zerocopy(&client, THRESHOLD);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &client, NULL);
+    uv_close((uv_handle_t*) &server, NULL);
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    MAKE_VALGRIND_HAPPY();
+    RETURN_SKIP("MSG_ZEROCOPY is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  send_offsets[0] = 0;
+  send_offsets[1] = BIG_WRITE;
+  send_offsets[2] = BIG_WRITE + SMALL_WRITE;
+  send_offsets[3] = 2 * BIG_WRITE + SMALL_WRITE;
+  send_buffer = malloc(send_offsets[NUM_WRITES]);
+  ASSERT_NOT_NULL(send_buffer);
+  for (i = 0; i < send_offsets[NUM_WRITES]; i++)
+    send_buffer[i] = pattern(i);
+
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connection_cb_called == 1);
+  ASSERT(write_cb_called == NUM_WRITES);
+  ASSERT(close_cb_called == 3);
+  ASSERT(bytes_read == send_offsets[NUM_WRITES]);
+
+  free(send_buffer);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static int close_write_status[2];
+
+
+static void close_write_cb(uv_write_t* req, int status) {
+  /* The client is closed before the kernel can have released the buffers,
+   * so the close callback waits for these.
+   */
+  ASSERT(close_cb_called == 0);
+  ASSERT(status == 0 || status == UV_ECANCELED);
+  close_write_status[write_cb_called++] = status;
+}
+
+
+static void close_connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+  int i;
+
+  ASSERT(status == 0);
+  connect_cb_called++;
+
+  for (i = 0; i < 2; i++) {
+    buf = uv_buf_init(send_buffer + i * BIG_WRITE, BIG_WRITE);
+    ASSERT(0 == uv_write(&write_reqs[i],
+                         (uv_stream_t*) &client,
+                         &buf,
+                         1,
+                         close_write_cb));
+  }
+
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+TEST_IMPL(tcp_zerocopy_close) {
+  struct sockaddr_in addr;
+  size_t i;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init_ex(uv_default_loop(), &client, AF_INET));
+
+  r = uv_tcp_zerocopy(&client, THRESHOLD);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &client, NULL);
+    uv_close((uv_handle_t*) &server, NULL);
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    MAKE_VALGRIND_HAPPY();
+    RETURN_SKIP("MSG_ZEROCOPY is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  send_buffer = malloc(2 * BIG_WRITE);
+  ASSERT_NOT_NULL(send_buffer);
+  for (i = 0; i < 2 * BIG_WRITE; i++)
+    send_buffer[i] = pattern(i);
+
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (struct sockaddr*) &addr,
+                             close_connect_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connection_cb_called == 1);
+  ASSERT(write_cb_called == 2);
+  ASSERT(close_cb_called == 3);
+  /* The kernel keeps sending what it has accepted, whether or not the
+   * request that it belongs to was cancelled.
+   */
+  for (i = 0; i < 2; i++)
+    if (close_write_status[i] == 0)
+      ASSERT(bytes_read >= (i + 1) * BIG_WRITE);
+
+  free(send_buffer);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_zerocopy_error) {
+  uv_tcp_t tcp;
+  int r;
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &tcp));
+
+  r = uv_tcp_zerocopy(&tcp, THRESHOLD);
+  if (r != UV_ENOTSUP) {
+    /* There is no socket yet to enable MSG_ZEROCOPY on. */
+    ASSERT(r == UV_EBADF);
+    /* Turning it off always works. */
+    ASSERT(0 == uv_tcp_zerocopy(&tcp, 0));
+  }
+
+  uv_close((uv_handle_t*) &tcp, NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,220 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+
+static uv_loop_t loop;
+static int fired[8];
+static int fired_count;
+static uint64_t fired_time[8];
+static uint64_t refresh_time;
+static int refresh_count;
+
+
+static void noop_cb(uv_timer_t* handle) {
+}
+
+
+static void record_cb(uv_timer_t* handle) {
+  int index;
+
+  index = (int) (intptr_t) handle->data;
+  ASSERT(fired_count < (int) ARRAY_SIZE(fired));
+  fired_time[fired_count] = uv_now(handle->loop);
+  fired[fired_count++] = index;
+}
+
+
+static void init_loop(unsigned int resolution) {
+  fired_count = 0;
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL, resolution));
+}
+
+
+static void close_wheel_loop(void) {
+  close_loop(&loop);
+  ASSERT(0 == uv_loop_close(&loop));
+}
+
+
+TEST_IMPL(timer_wheel_configure) {
+  uv_timer_t timer;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL, 0u));
+
+  /* The wheel can only be enabled while no timers are running. */
+  ASSERT(0 == uv_timer_init(&loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, noop_cb, 1000, 0));
+  ASSERT(UV_EBUSY == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL, 1u));
+  ASSERT(0 == uv_timer_stop(&timer));
+
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL, 1u));
+  ASSERT(UV_EBUSY == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL, 1u));
+
+  /* Timers that are too far out for the wheel can still be stopped. */
+  ASSERT(0 == uv_timer_start(&timer, noop_cb, (uint64_t) -1, 0));
+  ASSERT(0 == uv_timer_stop(&timer));
+
+  close_wheel_loop();
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(timer_wheel_order) {
+  uv_timer_t timers[6];
+  int i;
+
+  init_loop(1);
+  for (i = 0; i < 6; i++) {
+    ASSERT(0 == uv_timer_init(&loop, &timers[i]));
+    timers[i].data = (void*) (intptr_t) i;
+  }
+
+  /* Timers with the same timeout fire in the order they were started, and
+   * before timers with a later timeout.
+   */
+  ASSERT(0 == uv_timer_start(&timers[3], record_cb, 20, 0));
+  ASSERT(0 == uv_timer_start(&timers[0], record_cb, 10, 0));
+  ASSERT(0 == uv_timer_start(&timers[1], record_cb, 10, 0));
+  ASSERT(0 == uv_timer_start(&timers[4], record_cb, 20, 0));
+  ASSERT(0 == uv_timer_start(&timers[2], record_cb, 10, 0));
+  /* Already due, so it goes straight to the heap. */
+  ASSERT(0 == uv_timer_start(&timers[5], record_cb, 0, 0));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(6 == fired_count);
+  ASSERT(5 == fired[0]);
+  for (i = 1; i < 6; i++)
+    ASSERT(i - 1 == fired[i]);
+
+  close_wheel_loop();
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static uv_timer_t cascaded_timer;
+static uv_timer_t direct_timer;
+
+
+static void start_direct_cb(uv_timer_t* handle) {
+  /* Due at the same time as cascaded_timer, but close enough to be put on
+   * level 0 directly, ahead of the cascade of cascaded_timer.
+   */
+  ASSERT(0 == uv_timer_start(&direct_timer,
+                             record_cb,
+                             uv_timer_get_due_in(&cascaded_timer),
+                             0));
+}
+
+
+TEST_IMPL(timer_wheel_cascade) {
+  uv_timer_t starter;
+  uint64_t start;
+
+  init_loop(1);
+  ASSERT(0 == uv_timer_init(&loop, &cascaded_timer));
+  ASSERT(0 == uv_timer_init(&loop, &direct_timer));
+  ASSERT(0 == uv_timer_init(&loop, &starter));
+  cascaded_timer.data = (void*) 0;
+  direct_timer.data = (void*) 1;
+
+  start = uv_now(&loop);
+  /* Beyond level 0, so it has to be cascaded before it fires. */
+  ASSERT(0 == uv_timer_start(&cascaded_timer, record_cb, 300, 0));
+  ASSERT(0 == uv_timer_start(&starter, start_direct_cb, 100, 0));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(2 == fired_count);
+  ASSERT(0 == fired[0]);
+  ASSERT(1 == fired[1]);
+  ASSERT(fired_time[0] >= start + 300);
+
+  close_wheel_loop();
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void refresh_cb(uv_timer_t* handle) {
+  uv_timer_t* idle_timer;
+
+  idle_timer = handle->data;
+  refresh_time = uv_now(handle->loop);
+  ASSERT(0 == uv_timer_again(idle_timer));
+  if (++refresh_count == 10)
+    uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+TEST_IMPL(timer_wheel_refresh) {
+  uv_timer_t idle_timer;
+  uv_timer_t refresher;
+
+  init_loop(1);
+  ASSERT(0 == uv_timer_init(&loop, &idle_timer));
+  ASSERT(0 == uv_timer_init(&loop, &refresher));
+  idle_timer.data = (void*) 0;
+  refresher.data = &idle_timer;
+
+  /* An idle timeout that keeps being pushed back only fires once the
+   * refreshes stop.
+   */
+  ASSERT(0 == uv_timer_start(&idle_timer, record_cb, 50, 50));
+  ASSERT(0 == uv_timer_start(&refresher, refresh_cb, 10, 10));
+  while (fired_count == 0)
+    ASSERT(0 != uv_run(&loop, UV_RUN_ONCE));
+
+  ASSERT(10 == refresh_count);
+  ASSERT(1 == fired_count);
+  ASSERT(fired_time[0] >= refresh_time + 50);
+
+  close_wheel_loop();
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(timer_wheel_resolution) {
+  uv_timer_t timer;
+  uint64_t start;
+
+  /* Timers are rounded up to the next tick, but never fire early. */
+  init_loop(16);
+  ASSERT(0 == uv_timer_init(&loop, &timer));
+  timer.data = (void*) 0;
+  start = uv_now(&loop);
+  ASSERT(0 == uv_timer_start(&timer, record_cb, 1, 0));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(1 == fired_count);
+  ASSERT(fired_time[0] >= start + 1);
+  ASSERT(fired_time[0] >= (start + 1 + 15) / 16 * 16);
+
+  close_wheel_loop();
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
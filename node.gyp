@@ -453,16 +453,21 @@
         'src/api/exceptions.cc',
         'src/api/hooks.cc',
         'src/api/utils.cc',
+        'src/arena_allocator.cc',
         'src/async_wrap.cc',
         'src/cares_wrap.cc',
+        'src/compile_cache.cc',
         'src/connect_wrap.cc',
         'src/connection_wrap.cc',
         'src/debug_utils.cc',
         'src/env.cc',
         'src/fs_event_wrap.cc',
+        'src/fs_tree.cc',
         'src/handle_wrap.cc',
+        'src/heap_snapshot_writer.cc',
         'src/heap_utils.cc',
         'src/histogram.cc',
+        'src/inotify_tree.cc',
         'src/js_native_api.h',
         'src/js_native_api_types.h',
         'src/js_native_api_v8.cc',
@@ -471,6 +476,7 @@
         'src/js_stream.cc',
         'src/json_utils.cc',
         'src/js_udp_wrap.cc',
+        'src/module_stat_cache.cc',
         'src/module_wrap.cc',
         'src/node.cc',
         'src/node_api.cc',
@@ -496,6 +502,7 @@
         'src/node_native_module_env.cc',
         'src/node_options.cc',
         'src/node_os.cc',
+        'src/node_page_allocator.cc',
         'src/node_perf.cc',
         'src/node_platform.cc',
         'src/node_postmortem_metadata.cc',
@@ -522,9 +529,11 @@
         'src/node_worker.cc',
         'src/node_zlib.cc',
         'src/pipe_wrap.cc',
+        'src/pprof_utils.cc',
         'src/process_wrap.cc',
         'src/signal_wrap.cc',
         'src/spawn_sync.cc',
+        'src/stat_poller.cc',
         'src/stream_base.cc',
         'src/stream_pipe.cc',
         'src/stream_wrap.cc',
@@ -556,21 +565,26 @@
         'src/base64-inl.h',
         'src/callback_queue.h',
         'src/callback_queue-inl.h',
+        'src/compile_cache.h',
         'src/connect_wrap.h',
         'src/connection_wrap.h',
         'src/debug_utils.h',
         'src/debug_utils-inl.h',
         'src/env.h',
         'src/env-inl.h',
+        'src/fs_tree.h',
         'src/handle_wrap.h',
+        'src/heap_snapshot_writer.h',
         'src/histogram.h',
         'src/histogram-inl.h',
+        'src/inotify_tree.h',
         'src/js_stream.h',
         'src/json_utils.h',
         'src/large_pages/node_large_page.cc',
         'src/large_pages/node_large_page.h',
         'src/memory_tracker.h',
         'src/memory_tracker-inl.h',
+        'src/module_stat_cache.h',
         'src/module_wrap.h',
         'src/node.h',
         'src/node_api.h',
@@ -588,6 +602,7 @@
         'src/node_file-inl.h',
         'src/node_http_common.h',
         'src/node_http_common-inl.h',
+        'src/node_http_parser.h',
         'src/node_http2.h',
         'src/node_http2_state.h',
         'src/node_i18n.h',
@@ -603,6 +618,7 @@
         'src/node_object_wrap.h',
         'src/node_options.h',
         'src/node_options-inl.h',
+        'src/node_page_allocator.h',
         'src/node_perf.h',
         'src/node_perf_common.h',
         'src/node_platform.h',
@@ -624,9 +640,11 @@
         'src/node_watchdog.h',
         'src/node_worker.h',
         'src/pipe_wrap.h',
+        'src/pprof_utils.h',
         'src/req_wrap.h',
         'src/req_wrap-inl.h',
         'src/spawn_sync.h',
+        'src/stat_poller.h',
         'src/stream_base.h',
         'src/stream_base-inl.h',
         'src/stream_pipe.h',
@@ -1199,17 +1217,36 @@
         'test/cctest/node_test_fixture.cc',
         'test/cctest/node_test_fixture.h',
         'test/cctest/test_aliased_buffer.cc',
+        'test/cctest/test_arena_allocator.cc',
         'test/cctest/test_base64.cc',
+        'test/cctest/test_background_module_compiler.cc',
         'test/cctest/test_base_object_ptr.cc',
+        'test/cctest/test_buffer_fast_api.cc',
+        'test/cctest/test_compile_cache.cc',
+        'test/cctest/test_connection_wrap.cc',
         'test/cctest/test_node_postmortem_metadata.cc',
         'test/cctest/test_environment.cc',
+        'test/cctest/test_fs_tree.cc',
+        'test/cctest/test_heap_snapshot_writer.cc',
+        'test/cctest/test_inotify_tree.cc',
         'test/cctest/test_js_native_api_v8.cc',
         'test/cctest/test_linked_binding.cc',
+        'test/cctest/test_module_stat_cache.cc',
         'test/cctest/test_node_api.cc',
+        'test/cctest/test_node_dir.cc',
+        'test/cctest/test_page_allocator.cc',
         'test/cctest/test_per_process.cc',
         'test/cctest/test_platform.cc',
+        'test/cctest/test_pprof_utils.cc',
         'test/cctest/test_json_utils.cc',
+        'test/cctest/test_sampling_heap_profiler.cc',
+        'test/cctest/test_snapshot_blob.cc',
         'test/cctest/test_sockaddr.cc',
+        'test/cctest/test_stat_poller.cc',
+        'test/cctest/test_stream_cork.cc',
+        'test/cctest/test_stream_idle_timeout.cc',
+        'test/cctest/test_stream_writev.cc',
+        'test/cctest/test_string_search.cc',
         'test/cctest/test_traced_value.cc',
         'test/cctest/test_util.cc',
         'test/cctest/test_url.cc',
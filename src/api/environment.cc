@@ -3,6 +3,7 @@
 #include "node_errors.h"
 #include "node_internals.h"
 #include "node_native_module_env.h"
+#include "node_page_allocator.h"
 #include "node_platform.h"
 #include "node_v8_platform-inl.h"
 #include "uv.h"
@@ -80,9 +81,14 @@ MaybeLocal<Value> PrepareStackTraceCallback(Local<Context> context,
   return result;
 }
 
+NodeArrayBufferAllocator::NodeArrayBufferAllocator()
+    : huge_pages_(per_process::cli_options->heap_huge_pages) {}
+
 void* NodeArrayBufferAllocator::Allocate(size_t size) {
   void* ret;
-  if (zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers)
+  if (UsesHugePages(size))
+    ret = MapAnonymousMemory(size, true);  // Always zero-filled.
+  else if (zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers)
     ret = UncheckedCalloc(size);
   else
     ret = UncheckedMalloc(size);
@@ -92,7 +98,11 @@ void* NodeArrayBufferAllocator::Allocate(size_t size) {
 }
 
 void* NodeArrayBufferAllocator::AllocateUninitialized(size_t size) {
-  void* ret = node::UncheckedMalloc(size);
+  void* ret;
+  if (UsesHugePages(size))
+    ret = MapAnonymousMemory(size, true);
+  else
+    ret = node::UncheckedMalloc(size);
   if (LIKELY(ret != nullptr))
     total_mem_usage_.fetch_add(size, std::memory_order_relaxed);
   return ret;
@@ -100,6 +110,19 @@ void* NodeArrayBufferAllocator::AllocateUninitialized(size_t size) {
 
 void* NodeArrayBufferAllocator::Reallocate(
     void* data, size_t old_size, size_t size) {
+  if (UsesHugePages(old_size) || UsesHugePages(size)) {
+    // The calls are qualified because subclasses may hold a lock while
+    // calling this method.
+    void* ret = nullptr;
+    if (size > 0) {
+      ret = NodeArrayBufferAllocator::AllocateUninitialized(size);
+      if (UNLIKELY(ret == nullptr)) return nullptr;
+      memcpy(ret, data, std::min(old_size, size));
+    }
+    NodeArrayBufferAllocator::Free(data, old_size);
+    return ret;
+  }
+
   void* ret = UncheckedRealloc<char>(static_cast<char*>(data), size);
   if (LIKELY(ret != nullptr) || UNLIKELY(size == 0))
     total_mem_usage_.fetch_add(size - old_size, std::memory_order_relaxed);
@@ -108,7 +131,10 @@ void* NodeArrayBufferAllocator::Reallocate(
 
 void NodeArrayBufferAllocator::Free(void* data, size_t size) {
   total_mem_usage_.fetch_sub(size, std::memory_order_relaxed);
-  free(data);
+  if (UsesHugePages(size))
+    UnmapAnonymousMemory(data, size);
+  else
+    free(data);
 }
 
 DebuggingArrayBufferAllocator::~DebuggingArrayBufferAllocator() {
@@ -191,10 +217,16 @@ void DebuggingArrayBufferAllocator::RegisterPointerInternal(void* data,
 std::unique_ptr<ArrayBufferAllocator> ArrayBufferAllocator::Create(bool debug) {
   if (debug || per_process::cli_options->debug_arraybuffer_allocations)
     return std::make_unique<DebuggingArrayBufferAllocator>();
+  else if (per_process::cli_options->arraybuffer_arenas)
+    return std::make_unique<ArenaArrayBufferAllocator>();
   else
     return std::make_unique<NodeArrayBufferAllocator>();
 }
 
+std::unique_ptr<ArrayBufferAllocator> ArrayBufferAllocator::CreateWithArenas() {
+  return std::make_unique<ArenaArrayBufferAllocator>();
+}
+
 ArrayBufferAllocator* CreateArrayBufferAllocator() {
   return ArrayBufferAllocator::Create().release();
 }
@@ -405,6 +437,7 @@ MaybeLocal<Value> LoadEnvironment(
     StartExecutionCallback cb) {
   env->InitializeLibuv();
   env->InitializeDiagnostics();
+  env->InitializeCompileCache();
 
   return StartExecution(env, cb);
 }
@@ -0,0 +1,294 @@
+#include "memory_tracker-inl.h"
+#include "node_internals.h"
+#include "node_mutex.h"
+#include "node_page_allocator.h"
+#include "util-inl.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef __POSIX__
+#include <sys/mman.h>
+#endif
+
+namespace node {
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+// Size classes are carved out of slabs of the size of a huge page.
+constexpr size_t kSlabSize = kHugePageSize;
+// Slabs of size classes at least this large are backed by huge pages when
+// possible. Smaller size classes are not, so that a process that only uses
+// a handful of small Buffers does not pay for a whole huge page per class.
+constexpr size_t kMinHugePageClassSize = 64 * 1024;
+// Allocations at least this large bypass malloc() and are mapped directly.
+constexpr size_t kMinMappedSize = kSlabSize;
+// Bounds on the free blocks a thread keeps for itself in each size class.
+constexpr size_t kMaxThreadCacheBytes = 256 * 1024;
+constexpr size_t kMaxThreadCacheBlocks = 64;
+// Free blocks in excess of this many bytes per size class have their pages
+// returned to the OS.
+constexpr size_t kMaxRetainedBytes = 4 * 1024 * 1024;
+
+static_assert(ArenaArrayBufferAllocator::kMaxArenaSize <= kSlabSize / 2,
+              "each slab must hold at least two blocks");
+
+// Four size classes per power of two, so that no more than 25% of a block
+// is wasted: 256, 320, 384, 448, 512, 640, ... 1 MB.
+class SizeClasses {
+ public:
+  SizeClasses() {
+    for (size_t base = ArenaArrayBufferAllocator::kMinArenaSize;
+         base < ArenaArrayBufferAllocator::kMaxArenaSize;
+         base *= 2) {
+      for (size_t i = 0; i < 4; i++) sizes_.push_back(base + base / 4 * i);
+    }
+    sizes_.push_back(ArenaArrayBufferAllocator::kMaxArenaSize);
+    CHECK_LE(sizes_.size(), ArenaArrayBufferAllocator::kMaxSizeClasses);
+    for (size_t size : sizes_)
+      names_.push_back("size_class_" + std::to_string(size));
+  }
+
+  size_t count() const { return sizes_.size(); }
+  size_t size(size_t index) const { return sizes_[index]; }
+  // Heap snapshot edge names must outlive the snapshot.
+  const char* name(size_t index) const { return names_[index].c_str(); }
+
+  size_t IndexFor(size_t size) const {
+    return std::lower_bound(sizes_.begin(), sizes_.end(), size) -
+           sizes_.begin();
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  std::vector<std::string> names_;
+};
+
+const SizeClasses& GetSizeClasses() {
+  static const SizeClasses* size_classes = new SizeClasses();
+  return *size_classes;
+}
+
+// Tells the OS that the pages of a free block can be reclaimed. The block
+// stays mapped and reads back as zeroes once it is touched again.
+bool PurgeBlock(void* data, size_t size) {
+#if defined(__POSIX__) && defined(MADV_DONTNEED)
+  // Only the pages that lie entirely within the block can be reclaimed.
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t end = (start + size) & ~(kPageSize - 1);
+  start = (start + kPageSize - 1) & ~(kPageSize - 1);
+  if (end <= start) return false;
+  void* pages = reinterpret_cast<void*>(start);
+  return madvise(pages, end - start, MADV_DONTNEED) == 0;
+#else
+  return false;
+#endif
+}
+
+size_t RoundUpToPageSize(size_t size) {
+  return (size + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+// The process-wide arenas, one per size class. They are shared by all
+// ArenaArrayBufferAllocator instances and never freed, so that free
+// blocks can be cached per thread regardless of which isolate released
+// them, and so that thread caches can be flushed at thread exit.
+class SizeClassArena {
+ public:
+  // Moves up to `count` free blocks of the given class into `out`, carving
+  // new ones out of a slab if necessary. Returns false if there is no
+  // memory left.
+  bool AllocateBatch(size_t index, size_t count, std::vector<void*>* out) {
+    FreeList& list = lists_[index];
+    const size_t block_size = GetSizeClasses().size(index);
+    Mutex::ScopedLock lock(list.mutex);
+    while (count > 0 && !list.warm.empty()) {
+      out->push_back(list.warm.back());
+      list.warm.pop_back();
+      count--;
+    }
+    while (count > 0 && !list.purged.empty()) {
+      out->push_back(list.purged.back());
+      list.purged.pop_back();
+      count--;
+    }
+    while (count > 0) {
+      if (list.bump == list.bump_end) {
+        char* slab = static_cast<char*>(
+            MapAnonymousMemory(kSlabSize,
+                               block_size >= kMinHugePageClassSize));
+        if (slab == nullptr) break;
+        list.bump = slab;
+        list.bump_end = slab + kSlabSize / block_size * block_size;
+      }
+      out->push_back(list.bump);
+      list.bump += block_size;
+      count--;
+    }
+    return !out->empty();
+  }
+
+  void FreeBatch(size_t index, std::vector<void*>* blocks, size_t count) {
+    FreeList& list = lists_[index];
+    const size_t block_size = GetSizeClasses().size(index);
+    Mutex::ScopedLock lock(list.mutex);
+    for (; count > 0 && !blocks->empty(); count--) {
+      void* block = blocks->back();
+      blocks->pop_back();
+      if ((list.warm.size() + 1) * block_size > kMaxRetainedBytes &&
+          PurgeBlock(block, block_size)) {
+        list.purged.push_back(block);
+      } else {
+        list.warm.push_back(block);
+      }
+    }
+  }
+
+ private:
+  struct FreeList {
+    Mutex mutex;
+    // Free blocks whose pages are still resident.
+    std::vector<void*> warm;
+    // Free blocks whose pages have been returned to the OS.
+    std::vector<void*> purged;
+    // The part of the current slab that has not been handed out yet.
+    char* bump = nullptr;
+    char* bump_end = nullptr;
+  };
+
+  FreeList lists_[ArenaArrayBufferAllocator::kMaxSizeClasses];
+};
+
+SizeClassArena* GetArena() {
+  static SizeClassArena* arena = new SizeClassArena();
+  return arena;
+}
+
+// Free blocks cached by the current thread, so that allocating and
+// releasing a Buffer of a given size does not need to take a lock in the
+// common case.
+class ThreadCache {
+ public:
+  ~ThreadCache() {
+    for (size_t i = 0; i < GetSizeClasses().count(); i++) {
+      GetArena()->FreeBatch(i, &blocks_[i], blocks_[i].size());
+    }
+  }
+
+  void* Allocate(size_t index) {
+    std::vector<void*>& blocks = blocks_[index];
+    if (blocks.empty() &&
+        !GetArena()->AllocateBatch(index, Capacity(index) / 2, &blocks)) {
+      return nullptr;
+    }
+    void* ret = blocks.back();
+    blocks.pop_back();
+    return ret;
+  }
+
+  void Free(size_t index, void* data) {
+    std::vector<void*>& blocks = blocks_[index];
+    blocks.push_back(data);
+    if (blocks.size() > Capacity(index))
+      GetArena()->FreeBatch(index, &blocks, blocks.size() / 2);
+  }
+
+ private:
+  static size_t Capacity(size_t index) {
+    size_t capacity = kMaxThreadCacheBytes / GetSizeClasses().size(index);
+    return std::max<size_t>(2, std::min(capacity, kMaxThreadCacheBlocks));
+  }
+
+  std::vector<void*> blocks_[ArenaArrayBufferAllocator::kMaxSizeClasses];
+};
+
+thread_local ThreadCache thread_cache;
+
+}  // anonymous namespace
+
+void* ArenaArrayBufferAllocator::AllocateImpl(size_t size, bool zero_fill) {
+  void* ret;
+  if (size >= kMinArenaSize && size <= kMaxArenaSize) {
+    size_t index = GetSizeClasses().IndexFor(size);
+    ret = thread_cache.Allocate(index);
+    if (UNLIKELY(ret == nullptr)) return nullptr;
+    if (zero_fill) memset(ret, 0, size);
+    blocks_in_use_[index].fetch_add(1, std::memory_order_relaxed);
+  } else if (size >= kMinMappedSize) {
+    // Fresh mappings are always zero-filled.
+    ret = MapAnonymousMemory(RoundUpToPageSize(size), true);
+    if (UNLIKELY(ret == nullptr)) return nullptr;
+    mapped_bytes_.fetch_add(size, std::memory_order_relaxed);
+  } else {
+    return zero_fill ? NodeArrayBufferAllocator::Allocate(size)
+                     : NodeArrayBufferAllocator::AllocateUninitialized(size);
+  }
+  total_mem_usage_.fetch_add(size, std::memory_order_relaxed);
+  return ret;
+}
+
+void* ArenaArrayBufferAllocator::Allocate(size_t size) {
+  bool zero_fill =
+      zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers;
+  return AllocateImpl(size, zero_fill);
+}
+
+void* ArenaArrayBufferAllocator::AllocateUninitialized(size_t size) {
+  return AllocateImpl(size, false);
+}
+
+void ArenaArrayBufferAllocator::Free(void* data, size_t size) {
+  if (size >= kMinArenaSize && size <= kMaxArenaSize) {
+    size_t index = GetSizeClasses().IndexFor(size);
+    thread_cache.Free(index, data);
+    blocks_in_use_[index].fetch_sub(1, std::memory_order_relaxed);
+  } else if (size >= kMinMappedSize) {
+    UnmapAnonymousMemory(data, RoundUpToPageSize(size));
+    mapped_bytes_.fetch_sub(size, std::memory_order_relaxed);
+  } else {
+    return NodeArrayBufferAllocator::Free(data, size);
+  }
+  total_mem_usage_.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void* ArenaArrayBufferAllocator::Reallocate(
+    void* data, size_t old_size, size_t size) {
+  auto uses_malloc = [](size_t size) {
+    return size < kMinArenaSize ||
+           (size > kMaxArenaSize && size < kMinMappedSize);
+  };
+  if (uses_malloc(old_size) && uses_malloc(size))
+    return NodeArrayBufferAllocator::Reallocate(data, old_size, size);
+  // Blocks in the same size class can be resized in place.
+  if (old_size >= kMinArenaSize && old_size <= kMaxArenaSize &&
+      size >= kMinArenaSize && size <= kMaxArenaSize &&
+      GetSizeClasses().IndexFor(old_size) == GetSizeClasses().IndexFor(size)) {
+    total_mem_usage_.fetch_add(size - old_size, std::memory_order_relaxed);
+    return data;
+  }
+
+  void* ret = AllocateImpl(size, false);
+  if (UNLIKELY(ret == nullptr) && size > 0) return nullptr;
+  if (ret != nullptr) memcpy(ret, data, std::min(old_size, size));
+  Free(data, old_size);
+  return ret;
+}
+
+void ArenaArrayBufferAllocator::MemoryInfo(MemoryTracker* tracker) const {
+  const SizeClasses& size_classes = GetSizeClasses();
+  for (size_t i = 0; i < size_classes.count(); i++) {
+    size_t in_use = blocks_in_use_[i].load(std::memory_order_relaxed);
+    if (in_use == 0) continue;
+    tracker->TrackFieldWithSize(size_classes.name(i),
+                                in_use * size_classes.size(i),
+                                "ArenaSizeClass");
+  }
+  tracker->TrackFieldWithSize(
+      "mapped_allocations",
+      mapped_bytes_.load(std::memory_order_relaxed),
+      "MappedArrayBufferMemory");
+}
+
+}  // namespace node
@@ -0,0 +1,306 @@
+#include "compile_cache.h"
+#include "debug_utils-inl.h"
+#include "env-inl.h"
+#include "node_file.h"
+#include "node_internals.h"
+#include "node_version.h"
+#include "util-inl.h"
+#include "zlib.h"
+
+#include <cinttypes>
+
+namespace node {
+
+using v8::Function;
+using v8::HandleScope;
+using v8::Isolate;
+using v8::Local;
+using v8::Module;
+using v8::ScriptCompiler;
+using v8::String;
+
+namespace {
+
+constexpr uint32_t kCacheMagicNumber = 0x8adfdbb3;
+
+// The header that precedes the key and the cache data in each entry.
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t type;
+  uint32_t key_length;
+  uint32_t data_hash;
+  uint32_t data_length;
+};
+
+uint32_t GetHash(const char* data, size_t size) {
+  uLong crc = crc32(0L, Z_NULL, 0);
+  return static_cast<uint32_t>(
+      crc32(crc, reinterpret_cast<const Bytef*>(data), size));
+}
+
+// 64-bit FNV-1a. CRC32 is fine for spotting corruption, but too short to
+// tell every edit of a source file apart.
+uint64_t GetSourceHash(const char* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+std::string GetHashString(uint32_t hash) {
+  char buf[9];
+  snprintf(buf, sizeof(buf), "%08x", hash);
+  return buf;
+}
+
+}  // anonymous namespace
+
+ScriptCompiler::CachedData* CompileCacheEntry::CopyCache() const {
+  if (data == nullptr) return nullptr;
+  return new ScriptCompiler::CachedData(
+      reinterpret_cast<const uint8_t*>(data.get()),
+      static_cast<int>(data_length),
+      ScriptCompiler::CachedData::BufferNotOwned);
+}
+
+CompileCacheHandler::CompileCacheHandler(Environment* env) : env_(env) {}
+
+bool CompileCacheHandler::InitializeDirectory(const std::string& dir) {
+  std::string tag = std::string(NODE_VERSION) + "-" +
+                    std::to_string(ScriptCompiler::CachedDataVersionTag());
+  std::string cache_dir =
+      dir + kPathSeparator + GetHashString(GetHash(tag.data(), tag.size()));
+
+  uv_fs_t req;
+  int err = fs::MKDirpSync(nullptr, &req, cache_dir, 0777, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (err != 0 && err != UV_EEXIST) {
+    Debug(env_,
+          DebugCategory::COMPILE_CACHE,
+          "[compile cache] cannot create %s: %s\n",
+          cache_dir,
+          uv_strerror(err));
+    return false;
+  }
+
+  Debug(env_,
+        DebugCategory::COMPILE_CACHE,
+        "[compile cache] using %s\n",
+        cache_dir);
+  cache_dir_ = cache_dir;
+  return true;
+}
+
+CompileCacheEntry* CompileCacheHandler::GetOrInsert(Local<String> code,
+                                                    const std::string& key,
+                                                    CachedCodeType type) {
+  uint64_t start = uv_hrtime();
+  std::string name = std::to_string(static_cast<uint32_t>(type)) + ":" + key;
+  Utf8Value source(env_->isolate(), code);
+  char source_key[64];
+  snprintf(source_key,
+           sizeof(source_key),
+           "#%016" PRIx64 ":%zu:%08x",
+           GetSourceHash(*source, source.length()),
+           source.length(),
+           ScriptCompiler::CachedDataVersionTag());
+  std::string full_key = name + source_key;
+
+  // The same module may be compiled more than once, e.g. after its
+  // entry in require.cache has been deleted.
+  auto it = entries_.find(full_key);
+  if (it != entries_.end()) return it->second.get();
+
+  auto entry = std::make_unique<CompileCacheEntry>();
+  entry->key = full_key;
+  entry->cache_filename = cache_dir_ + kPathSeparator +
+                          GetHashString(GetHash(name.data(), name.size())) +
+                          ".cache";
+  entry->type = type;
+
+  if (ReadCacheFile(entry.get())) {
+    hits_++;
+    bytes_read_ += entry->data_length;
+  } else {
+    misses_++;
+    entry->refresh = true;
+  }
+  read_time_ns_ += uv_hrtime() - start;
+
+  CompileCacheEntry* result = entry.get();
+  entries_[full_key] = std::move(entry);
+  return result;
+}
+
+bool CompileCacheHandler::ReadCacheFile(CompileCacheEntry* entry) {
+  std::string contents;
+  if (ReadFileSync(&contents, entry->cache_filename.c_str()) != 0)
+    return false;
+
+  CacheHeader header;
+  if (contents.size() < sizeof(header)) return false;
+  memcpy(&header, contents.data(), sizeof(header));
+
+  size_t key_offset = sizeof(header);
+  size_t data_offset = key_offset + header.key_length;
+  if (header.magic != kCacheMagicNumber ||
+      header.type != static_cast<uint32_t>(entry->type) ||
+      header.key_length > contents.size() - key_offset ||
+      header.data_length != contents.size() - data_offset) {
+    Debug(env_,
+          DebugCategory::COMPILE_CACHE,
+          "[compile cache] %s: invalid entry for %s\n",
+          entry->cache_filename,
+          entry->key);
+    return false;
+  }
+
+  // A different source, different V8 flags, or, rarely, another module
+  // whose name has the same hash.
+  if (contents.compare(key_offset, header.key_length, entry->key) != 0) {
+    Debug(env_,
+          DebugCategory::COMPILE_CACHE,
+          "[compile cache] %s: stale entry for %s\n",
+          entry->cache_filename,
+          entry->key);
+    return false;
+  }
+
+  const char* data = contents.data() + data_offset;
+  if (header.data_hash != GetHash(data, header.data_length)) {
+    Debug(env_,
+          DebugCategory::COMPILE_CACHE,
+          "[compile cache] %s: corrupted entry for %s\n",
+          entry->cache_filename,
+          entry->key);
+    return false;
+  }
+
+  entry->data.reset(new char[header.data_length]);
+  memcpy(entry->data.get(), data, header.data_length);
+  entry->data_length = header.data_length;
+  return true;
+}
+
+void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
+                                    Local<Function> fn,
+                                    bool rejected) {
+  if (rejected) {
+    rejected_++;
+    entry->refresh = true;
+  }
+  if (!entry->refresh) return;
+  entry->function.Reset(env_->isolate(), fn);
+}
+
+void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
+                                    Local<Module> mod,
+                                    bool rejected) {
+  if (rejected) {
+    rejected_++;
+    entry->refresh = true;
+  }
+  if (!entry->refresh) return;
+  entry->module_script.Reset(env_->isolate(), mod->GetUnboundModuleScript());
+}
+
+void CompileCacheHandler::Persist() {
+  Isolate* isolate = env_->isolate();
+  HandleScope handle_scope(isolate);
+  uint64_t start = uv_hrtime();
+
+  for (auto& it : entries_) {
+    CompileCacheEntry* entry = it.second.get();
+    if (!entry->refresh) continue;
+
+    std::unique_ptr<ScriptCompiler::CachedData> cache;
+    if (!entry->function.IsEmpty()) {
+      cache.reset(ScriptCompiler::CreateCodeCacheForFunction(
+          entry->function.Get(isolate)));
+    } else if (!entry->module_script.IsEmpty()) {
+      cache.reset(ScriptCompiler::CreateCodeCache(
+          entry->module_script.Get(isolate)));
+    }
+    entry->function.Reset();
+    entry->module_script.Reset();
+    entry->refresh = false;
+
+    if (cache && cache->length > 0) WriteCacheFile(entry, cache.get());
+  }
+
+  persist_time_ns_ += uv_hrtime() - start;
+  Debug(env_,
+        DebugCategory::COMPILE_CACHE,
+        "[compile cache] %d hits, %d misses, %d rejected, "
+        "read %d bytes in %d us, wrote %d bytes in %d us\n",
+        hits_,
+        misses_,
+        rejected_,
+        bytes_read_,
+        read_time_ns_ / 1000,
+        bytes_written_,
+        persist_time_ns_ / 1000);
+}
+
+void CompileCacheHandler::WriteCacheFile(
+    const CompileCacheEntry* entry, const ScriptCompiler::CachedData* cache) {
+  CacheHeader header;
+  header.magic = kCacheMagicNumber;
+  header.type = static_cast<uint32_t>(entry->type);
+  header.key_length = static_cast<uint32_t>(entry->key.size());
+  header.data_hash = GetHash(reinterpret_cast<const char*>(cache->data),
+                             cache->length);
+  header.data_length = static_cast<uint32_t>(cache->length);
+
+  std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+  contents += entry->key;
+  contents.append(reinterpret_cast<const char*>(cache->data), cache->length);
+
+  // Write to a temporary file first and rename it into place, so that
+  // other processes reading the cache never see a partially written entry.
+  // Worker threads of the same process may write the same entry at the same
+  // time, so every write gets its own temporary file.
+  std::string tmp_filename = entry->cache_filename + ".XXXXXX";
+  uv_fs_t req;
+  int err = uv_fs_mkstemp(nullptr, &req, tmp_filename.c_str(), nullptr);
+  if (err >= 0)
+    tmp_filename = req.path;
+  uv_fs_req_cleanup(&req);
+  if (err >= 0) {
+    uv_file fd = err;
+    uv_buf_t buf = uv_buf_init(&contents[0], contents.size());
+    err = uv_fs_write(nullptr, &req, fd, &buf, 1, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (err >= 0)
+      err = static_cast<size_t>(err) == contents.size() ? 0 : UV_EIO;
+    int close_err = uv_fs_close(nullptr, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (err == 0)
+      err = close_err;
+    if (err == 0) {
+      err = uv_fs_rename(nullptr,
+                         &req,
+                         tmp_filename.c_str(),
+                         entry->cache_filename.c_str(),
+                         nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+    if (err != 0) {
+      uv_fs_unlink(nullptr, &req, tmp_filename.c_str(), nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+  }
+  if (err != 0) {
+    Debug(env_,
+          DebugCategory::COMPILE_CACHE,
+          "[compile cache] cannot write %s: %s\n",
+          entry->cache_filename,
+          uv_strerror(err));
+    return;
+  }
+  bytes_written_ += cache->length;
+}
+
+}  // namespace node
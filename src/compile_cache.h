@@ -0,0 +1,106 @@
+#ifndef SRC_COMPILE_CACHE_H_
+#define SRC_COMPILE_CACHE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "v8.h"
+
+namespace node {
+class Environment;
+
+enum class CachedCodeType : uint32_t {
+  kCommonJS = 0,
+  kESM = 1,
+};
+
+struct CompileCacheEntry {
+  // The module type and name, the hash and length of the source, and V8's
+  // cached data version tag. A cache on disk is only used if it was produced
+  // under the same key.
+  std::string key;
+  // Only depends on the module type and name, so that the cache of a module
+  // that changed replaces the old one.
+  std::string cache_filename;
+  CachedCodeType type;
+  // Code cache read from disk, if there was a valid one.
+  std::unique_ptr<char[]> data;
+  size_t data_length = 0;
+  // Set when there was no usable cache on disk, in which case the compiled
+  // code is kept around so that a new cache can be produced at exit.
+  bool refresh = false;
+  v8::Global<v8::Function> function;
+  v8::Global<v8::UnboundModuleScript> module_script;
+
+  // Returns a view into `data` for V8 to consume, or nullptr if there
+  // is no cache. The caller owns the returned object.
+  v8::ScriptCompiler::CachedData* CopyCache() const;
+};
+
+// Persists the V8 code cache of user-land CommonJS and ES modules on disk
+// (see --compile-cache-dir), so that later processes can skip parsing and
+// eager compilation of modules whose source has not changed.
+//
+// Entries live in <dir>/<tag>/<name>.cache. <tag> is derived from the Node.js
+// version and V8's cached data version tag, which covers the V8 version and
+// the flags that affect code generation. <name> is a hash of the module type
+// and filename (plus the wrapper parameters for CommonJS). Each entry starts
+// with a header recording the full key it was produced under: besides the
+// module, that is a 64-bit hash and the length of the source, and the
+// version tag at the time, which changes if V8 flags are set at runtime.
+// V8 itself only checks the length of the source, so stale entries are
+// detected here and replaced instead of being handed to V8. New entries are
+// written to a temporary file and renamed into place, so concurrent
+// processes never observe partially written caches.
+class CompileCacheHandler {
+ public:
+  explicit CompileCacheHandler(Environment* env);
+
+  // Returns false if the cache directory cannot be created.
+  bool InitializeDirectory(const std::string& dir);
+
+  // Returns the entry for the given module. The entry is owned by the
+  // handler; its `data` is only set if a valid cache was found on disk.
+  CompileCacheEntry* GetOrInsert(v8::Local<v8::String> code,
+                                 const std::string& key,
+                                 CachedCodeType type);
+  void MaybeSave(CompileCacheEntry* entry,
+                 v8::Local<v8::Function> fn,
+                 bool rejected);
+  void MaybeSave(CompileCacheEntry* entry,
+                 v8::Local<v8::Module> mod,
+                 bool rejected);
+
+  // Writes out all new or refreshed entries. Called at exit, so that the
+  // caches include the functions that were lazily compiled while running.
+  void Persist();
+
+ private:
+  bool ReadCacheFile(CompileCacheEntry* entry);
+  void WriteCacheFile(const CompileCacheEntry* entry,
+                      const v8::ScriptCompiler::CachedData* cache);
+
+  Environment* env_;
+  std::string cache_dir_;
+  std::unordered_map<std::string, std::unique_ptr<CompileCacheEntry>>
+      entries_;
+
+  // Startup time accounting, reported through NODE_DEBUG_NATIVE. See
+  // benchmark/misc/startup-compile-cache.js for the effect on startup.
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t rejected_ = 0;
+  uint64_t read_time_ns_ = 0;
+  uint64_t persist_time_ns_ = 0;
+  size_t bytes_read_ = 0;
+  size_t bytes_written_ = 0;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_COMPILE_CACHE_H_
@@ -10,12 +10,17 @@
 
 namespace node {
 
+using v8::Array;
 using v8::Boolean;
 using v8::Context;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::Global;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
 using v8::Object;
+using v8::Uint32;
 using v8::Value;
 
 
@@ -63,9 +68,29 @@ void ConnectionWrap<WrapType, UVType>::OnConnection(uv_stream_t* handle,
     if (uv_accept(handle, client))
       return;
 
+    if (wrap_data->accept_batch_size_ > 1) {
+      // libuv keeps accepting connections until there are no more pending
+      // ones, so collect them and pass them to JavaScript land together
+      // once that is done, or once the batch is full.
+      wrap_data->accept_batch_.emplace_back(env->isolate(), client_obj);
+      if (wrap_data->accept_batch_.size() >= wrap_data->accept_batch_size_) {
+        wrap_data->FlushAcceptBatch();
+      } else if (!wrap_data->accept_batch_flush_scheduled_) {
+        wrap_data->accept_batch_flush_scheduled_ = true;
+        env->SetImmediate(
+            [wrap = BaseObjectPtr<WrapType>(wrap_data)](Environment* env) {
+              wrap->accept_batch_flush_scheduled_ = false;
+              wrap->FlushAcceptBatch();
+            });
+      }
+      return;
+    }
+
     // Successful accept. Call the onconnection callback in JavaScript land.
     client_handle = client_obj;
   } else {
+    // Keep the order in which connections and errors occurred.
+    wrap_data->FlushAcceptBatch();
     client_handle = Undefined(env->isolate());
   }
 
@@ -74,6 +99,70 @@ void ConnectionWrap<WrapType, UVType>::OnConnection(uv_stream_t* handle,
 }
 
 
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::FlushAcceptBatch() {
+  if (accept_batch_.empty()) return;
+
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  std::vector<Local<Value>> handles;
+  handles.reserve(accept_batch_.size());
+  for (const Global<Object>& client : accept_batch_)
+    handles.push_back(client.Get(env->isolate()));
+  accept_batch_.clear();
+
+  auto close_client = [](Local<Value> client) {
+    HandleWrap* wrap = Unwrap<HandleWrap>(client.As<Object>());
+    if (wrap != nullptr) wrap->Close();
+  };
+
+  // The server may have been closed since the connections were accepted.
+  if (!IsAlive()) {
+    for (Local<Value> client : handles) close_client(client);
+    return;
+  }
+
+  Local<Value> onconnectionbatch;
+  if (!object()
+           ->Get(env->context(), env->onconnectionbatch_string())
+           .ToLocal(&onconnectionbatch)) {
+    for (Local<Value> client : handles) close_client(client);
+    return;
+  }
+  if (onconnectionbatch->IsFunction()) {
+    Local<Value> argv[] = {
+      Array::New(env->isolate(), handles.data(), handles.size())
+    };
+    MakeCallback(onconnectionbatch.As<Function>(), arraysize(argv), argv);
+    return;
+  }
+
+  // JavaScript land has not opted into batches, so hand the connections
+  // over one at a time, as if they had not been batched.
+  for (Local<Value> client : handles) {
+    if (!IsAlive()) {
+      close_client(client);
+      continue;
+    }
+    Local<Value> argv[] = { Integer::New(env->isolate(), 0), client };
+    MakeCallback(env->onconnection_string(), arraysize(argv), argv);
+  }
+}
+
+
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args) {
+  WrapType* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  CHECK(args[0]->IsUint32());
+  wrap->accept_batch_size_ = args[0].As<Uint32>()->Value();
+  if (wrap->accept_batch_size_ <= 1) wrap->FlushAcceptBatch();
+}
+
+
 template <typename WrapType, typename UVType>
 void ConnectionWrap<WrapType, UVType>::AfterConnect(uv_connect_t* req,
                                                     int status) {
@@ -133,5 +222,11 @@ template void ConnectionWrap<PipeWrap, uv_pipe_t>::AfterConnect(
 template void ConnectionWrap<TCPWrap, uv_tcp_t>::AfterConnect(
     uv_connect_t* handle, int status);
 
+template void ConnectionWrap<PipeWrap, uv_pipe_t>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args);
+
+template void ConnectionWrap<TCPWrap, uv_tcp_t>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args);
+
 
 }  // namespace node
@@ -3,6 +3,7 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <vector>
 #include "stream_wrap.h"
 
 namespace node {
@@ -15,12 +16,26 @@ class ConnectionWrap : public LibuvStreamWrap {
   static void OnConnection(uv_stream_t* handle, int status);
   static void AfterConnect(uv_connect_t* req, int status);
 
+  // setAcceptBatchSize(n): If n > 1, connections that are accepted in one go
+  // are passed to onconnectionbatch(handles) in arrays of up to n handles
+  // instead of to onconnection(status, handle) one by one. Errors are still
+  // reported through onconnection().
+  static void SetAcceptBatchSize(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
  protected:
   ConnectionWrap(Environment* env,
                  v8::Local<v8::Object> object,
                  ProviderType provider);
 
   UVType handle_;
+
+ private:
+  void FlushAcceptBatch();
+
+  uint32_t accept_batch_size_ = 0;
+  std::vector<v8::Global<v8::Object>> accept_batch_;
+  bool accept_batch_flush_scheduled_ = false;
 };
 
 }  // namespace node
@@ -581,6 +581,11 @@ inline AliasedInt32Array& Environment::stream_base_state() {
   return stream_base_state_;
 }
 
+inline std::unique_ptr<v8::BackingStore>&
+Environment::stream_write_storage() {
+  return stream_write_storage_;
+}
+
 inline uint32_t Environment::get_next_module_id() {
   return module_id_counter_++;
 }
@@ -732,6 +737,17 @@ inline const std::string& Environment::cpu_prof_dir() const {
   return cpu_prof_dir_;
 }
 
+inline void Environment::set_continuous_cpu_profiler(
+    std::unique_ptr<profiler::ContinuousCpuProfiler> profiler) {
+  CHECK_NULL(continuous_cpu_profiler_);
+  std::swap(continuous_cpu_profiler_, profiler);
+}
+
+inline profiler::ContinuousCpuProfiler*
+Environment::continuous_cpu_profiler() {
+  return continuous_cpu_profiler_.get();
+}
+
 inline void Environment::set_heap_profiler_connection(
     std::unique_ptr<profiler::V8HeapProfilerConnection> connection) {
   CHECK_NULL(heap_profiler_connection_);
@@ -852,6 +868,15 @@ inline bool Environment::is_main_thread() const {
   return worker_context() == nullptr;
 }
 
+inline CompileCacheHandler* Environment::compile_cache_handler() {
+  return compile_cache_handler_.get();
+}
+
+inline loader::BackgroundModuleCompiler*
+Environment::background_module_compiler() {
+  return background_module_compiler_.get();
+}
+
 inline bool Environment::no_native_addons() const {
   return (flags_ & EnvironmentFlags::kNoNativeAddons) ||
           !options_->allow_native_addons;
@@ -907,6 +932,14 @@ bool Environment::source_maps_enabled() const {
   return source_maps_enabled_;
 }
 
+void Environment::set_owns_sampling_heap_profiler(bool on) {
+  owns_sampling_heap_profiler_ = on;
+}
+
+bool Environment::owns_sampling_heap_profiler() const {
+  return owns_sampling_heap_profiler_;
+}
+
 inline uint64_t Environment::thread_id() const {
   return thread_id_;
 }
@@ -1074,6 +1107,26 @@ inline void Environment::SetFastMethod(v8::Local<v8::Object> that,
                                        v8::FunctionCallback slow_callback,
                                        const v8::CFunction* c_function) {
   v8::Local<v8::Context> context = isolate()->GetCurrentContext();
+  v8::Local<v8::Function> function =
+      NewFunctionTemplate(slow_callback,
+                          v8::Local<v8::Signature>(),
+                          v8::ConstructorBehavior::kThrow,
+                          v8::SideEffectType::kHasSideEffect,
+                          c_function)
+          ->GetFunction(context)
+          .ToLocalChecked();
+  const v8::NewStringType type = v8::NewStringType::kInternalized;
+  v8::Local<v8::String> name_string =
+      v8::String::NewFromUtf8(isolate(), name, type).ToLocalChecked();
+  that->Set(context, name_string, function).Check();
+}
+
+inline void Environment::SetFastMethodNoSideEffect(
+    v8::Local<v8::Object> that,
+    const char* name,
+    v8::FunctionCallback slow_callback,
+    const v8::CFunction* c_function) {
+  v8::Local<v8::Context> context = isolate()->GetCurrentContext();
   v8::Local<v8::Function> function =
       NewFunctionTemplate(slow_callback,
                           v8::Local<v8::Signature>(),
@@ -5,6 +5,7 @@
 #include "debug_utils-inl.h"
 #include "diagnosticfilename-inl.h"
 #include "memory_tracker-inl.h"
+#include "module_wrap.h"
 #include "node_buffer.h"
 #include "node_context_data.h"
 #include "node_errors.h"
@@ -15,6 +16,7 @@
 #include "node_worker.h"
 #include "req_wrap-inl.h"
 #include "stream_base.h"
+#include "stream_wrap.h"
 #include "tracing/agent.h"
 #include "tracing/traced_value.h"
 #include "util-inl.h"
@@ -219,10 +221,8 @@ void IsolateData::MemoryInfo(MemoryTracker* tracker) const {
 
   tracker->TrackField("async_wrap_providers", async_wrap_providers_);
 
-  if (node_allocator_ != nullptr) {
-    tracker->TrackFieldWithSize(
-        "node_allocator", sizeof(*node_allocator_), "NodeArrayBufferAllocator");
-  }
+  tracker->TrackField("node_allocator",
+                      static_cast<const MemoryRetainer*>(node_allocator_));
   tracker->TrackFieldWithSize(
       "platform", sizeof(*platform_), "MultiIsolatePlatform");
   // TODO(joyeecheung): implement MemoryRetainer in the option classes.
@@ -392,6 +392,11 @@ Environment::Environment(IsolateData* isolate_data,
   inspector_agent_ = std::make_unique<inspector::Agent>(this);
 #endif
 
+  if (options_->experimental_esm_background_compile) {
+    background_module_compiler_ =
+        std::make_unique<loader::BackgroundModuleCompiler>(this);
+  }
+
   if (tracing::AgentWriterHandle* writer = GetTracingAgentWriter()) {
     trace_state_observer_ = std::make_unique<TrackingTraceStateObserver>(this);
     if (TracingController* tracing_controller = writer->GetTracingController())
@@ -837,6 +842,12 @@ void Environment::ScheduleTimer(int64_t duration_ms) {
   uv_timer_start(timer_handle(), RunTimers, duration_ms, 0);
 }
 
+StreamIdleTracker* Environment::stream_idle_tracker() {
+  if (!stream_idle_tracker_)
+    stream_idle_tracker_ = std::make_unique<StreamIdleTracker>(this);
+  return stream_idle_tracker_.get();
+}
+
 void Environment::ToggleTimerRef(bool ref) {
   if (started_cleanup_) return;
 
@@ -1689,6 +1700,9 @@ void Environment::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("should_abort_on_uncaught_toggle",
                       should_abort_on_uncaught_toggle_);
   tracker->TrackField("stream_base_state", stream_base_state_);
+  tracker->TrackFieldWithSize(
+      "stream_write_storage",
+      stream_write_storage_ ? stream_write_storage_->ByteLength() : 0);
   tracker->TrackFieldWithSize(
       "cleanup_hooks", cleanup_hooks_.size() * sizeof(CleanupHookCallback));
   tracker->TrackField("async_hooks", async_hooks_);
@@ -30,6 +30,7 @@
 #include "inspector_profiler.h"
 #endif
 #include "callback_queue.h"
+#include "compile_cache.h"
 #include "debug_utils.h"
 #include "handle_wrap.h"
 #include "node.h"
@@ -76,6 +77,7 @@ class AgentWriterHandle;
 namespace profiler {
 class V8CoverageConnection;
 class V8CpuProfilerConnection;
+class ContinuousCpuProfiler;
 class V8HeapProfilerConnection;
 }  // namespace profiler
 
@@ -89,6 +91,7 @@ class Worker;
 }
 
 namespace loader {
+class BackgroundModuleCompiler;
 class ModuleWrap;
 
 struct PackageConfig {
@@ -341,6 +344,7 @@ constexpr size_t kFsStatsBufferLength =
   V(onclienthello_string, "onclienthello")                                     \
   V(oncomplete_string, "oncomplete")                                           \
   V(onconnection_string, "onconnection")                                       \
+  V(onconnectionbatch_string, "onconnectionbatch")                             \
   V(ondone_string, "ondone")                                                   \
   V(onerror_string, "onerror")                                                 \
   V(onexit_string, "onexit")                                                   \
@@ -463,6 +467,7 @@ constexpr size_t kFsStatsBufferLength =
   V(binding_data_ctor_template, v8::FunctionTemplate)                          \
   V(blob_constructor_template, v8::FunctionTemplate)                           \
   V(blocklist_constructor_template, v8::FunctionTemplate)                      \
+  V(buffer_search_pattern_template, v8::ObjectTemplate)                        \
   V(compiled_fn_entry_template, v8::ObjectTemplate)                            \
   V(dir_instance_template, v8::ObjectTemplate)                                 \
   V(fd_constructor_template, v8::ObjectTemplate)                               \
@@ -545,6 +550,7 @@ constexpr size_t kFsStatsBufferLength =
   V(promise_hook_handler, v8::Function)                                        \
   V(promise_reject_callback, v8::Function)                                     \
   V(script_data_constructor_function, v8::Function)                            \
+  V(snapshot_deserialize_main, v8::Function)                                   \
   V(source_map_cache_getter, v8::Function)                                     \
   V(tick_callback_function, v8::Function)                                      \
   V(timers_callback_function, v8::Function)                                    \
@@ -555,6 +561,7 @@ constexpr size_t kFsStatsBufferLength =
 
 class Environment;
 struct AllocatedBuffer;
+class StreamIdleTracker;
 
 typedef size_t SnapshotIndex;
 class IsolateData : public MemoryRetainer {
@@ -976,6 +983,12 @@ struct SnapshotData {
   v8::StartupData blob;
   std::vector<size_t> isolate_data_indices;
   EnvSerializeInfo env_info;
+
+  // Write the snapshot into a standalone blob file that can be passed
+  // to --snapshot-blob, or read it back. Reading fails if the blob was
+  // generated by a different Node.js version or for a different platform.
+  bool ToBlob(FILE* out) const;
+  static bool FromBlob(SnapshotData* out, FILE* in);
 };
 
 class Environment : public MemoryRetainer {
@@ -1005,6 +1018,8 @@ class Environment : public MemoryRetainer {
   void RunDeserializeRequests();
   // Should be called before InitializeInspector()
   void InitializeDiagnostics();
+  // Sets up the on-disk compile cache if --compile-cache-dir is used.
+  void InitializeCompileCache();
 
   std::string GetCwd();
 
@@ -1149,6 +1164,9 @@ class Environment : public MemoryRetainer {
   inline AliasedUint32Array& should_abort_on_uncaught_toggle();
 
   inline AliasedInt32Array& stream_base_state();
+  // Storage that StreamBase::Writev() encodes string chunks into. It is
+  // kept here between writes that complete synchronously.
+  inline std::unique_ptr<v8::BackingStore>& stream_write_storage();
 
   // The necessary API for async_hooks.
   inline double new_async_id();
@@ -1208,6 +1226,10 @@ class Environment : public MemoryRetainer {
   inline void set_has_serialized_options(bool has_serialized_options);
 
   inline bool is_main_thread() const;
+  inline CompileCacheHandler* compile_cache_handler();
+  inline loader::BackgroundModuleCompiler* background_module_compiler();
+  // Created on first use.
+  StreamIdleTracker* stream_idle_tracker();
   inline bool no_native_addons() const;
   inline bool should_not_register_esm_loader() const;
   inline bool owns_process_state() const;
@@ -1237,6 +1259,11 @@ class Environment : public MemoryRetainer {
   inline void set_source_maps_enabled(bool on);
   inline bool source_maps_enabled() const;
 
+  // Whether the sampling heap profiler was started through the heap_utils
+  // binding, as opposed to --heap-prof or the inspector.
+  inline void set_owns_sampling_heap_profiler(bool on);
+  inline bool owns_sampling_heap_profiler() const;
+
   inline void ThrowError(const char* errmsg);
   inline void ThrowTypeError(const char* errmsg);
   inline void ThrowRangeError(const char* errmsg);
@@ -1266,6 +1293,10 @@ class Environment : public MemoryRetainer {
                             const char* name,
                             v8::FunctionCallback slow_callback,
                             const v8::CFunction* c_function);
+  inline void SetFastMethodNoSideEffect(v8::Local<v8::Object> that,
+                                        const char* name,
+                                        v8::FunctionCallback slow_callback,
+                                        const v8::CFunction* c_function);
 
   inline void SetProtoMethod(v8::Local<v8::FunctionTemplate> that,
                              const char* name,
@@ -1431,6 +1462,10 @@ class Environment : public MemoryRetainer {
   inline void set_cpu_prof_dir(const std::string& dir);
   inline const std::string& cpu_prof_dir() const;
 
+  void set_continuous_cpu_profiler(
+      std::unique_ptr<profiler::ContinuousCpuProfiler> profiler);
+  profiler::ContinuousCpuProfiler* continuous_cpu_profiler();
+
   void set_heap_profiler_connection(
       std::unique_ptr<profiler::V8HeapProfilerConnection> connection);
   profiler::V8HeapProfilerConnection* heap_profiler_connection();
@@ -1491,6 +1526,7 @@ class Environment : public MemoryRetainer {
   bool emit_err_name_warning_ = true;
   bool emit_filehandle_warning_ = true;
   bool source_maps_enabled_ = false;
+  bool owns_sampling_heap_profiler_ = false;
 
   size_t async_callback_scope_depth_ = 0;
   std::vector<double> destroy_async_id_list_;
@@ -1502,6 +1538,7 @@ class Environment : public MemoryRetainer {
   std::string cpu_prof_dir_;
   std::string cpu_prof_name_;
   uint64_t cpu_prof_interval_;
+  std::unique_ptr<profiler::ContinuousCpuProfiler> continuous_cpu_profiler_;
   std::unique_ptr<profiler::V8HeapProfilerConnection> heap_profiler_connection_;
   std::string heap_prof_dir_;
   std::string heap_prof_name_;
@@ -1534,6 +1571,7 @@ class Environment : public MemoryRetainer {
   std::unique_ptr<TrackingTraceStateObserver> trace_state_observer_;
 
   AliasedInt32Array stream_base_state_;
+  std::unique_ptr<v8::BackingStore> stream_write_storage_;
 
   uint64_t environment_start_time_;
   std::unique_ptr<performance::PerformanceState> performance_state_;
@@ -1556,6 +1594,11 @@ class Environment : public MemoryRetainer {
 
   std::list<DeserializeRequest> deserialize_requests_;
 
+  std::unique_ptr<CompileCacheHandler> compile_cache_handler_;
+  std::unique_ptr<loader::BackgroundModuleCompiler>
+      background_module_compiler_;
+  std::unique_ptr<StreamIdleTracker> stream_idle_tracker_;
+
   // handle_wrap_queue_ and req_wrap_queue_ needs to be at a fixed offset from
   // the start of the class because it is used by
   // src/node_postmortem_metadata.cc to calculate offsets and generate debug
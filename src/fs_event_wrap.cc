@@ -22,12 +22,17 @@
 #include "async_wrap-inl.h"
 #include "env-inl.h"
 #include "handle_wrap.h"
+#include "inotify_tree.h"
+#include "memory_tracker-inl.h"
 #include "node.h"
 #include "node_external_reference.h"
 #include "string_bytes.h"
 
+#include <memory>
+
 namespace node {
 
+using v8::Array;
 using v8::Context;
 using v8::DontDelete;
 using v8::DontEnum;
@@ -35,6 +40,7 @@ using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Integer;
+using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
 using v8::Object;
@@ -42,6 +48,7 @@ using v8::PropertyAttribute;
 using v8::ReadOnly;
 using v8::Signature;
 using v8::String;
+using v8::Uint32;
 using v8::Value;
 
 namespace {
@@ -57,7 +64,9 @@ class FSEventWrap: public HandleWrap {
   static void Start(const FunctionCallbackInfo<Value>& args);
   static void GetInitialized(const FunctionCallbackInfo<Value>& args);
 
-  SET_NO_MEMORY_INFO()
+  void Close(Local<Value> close_callback = Local<Value>()) override;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(FSEventWrap)
   SET_SELF_SIZE(FSEventWrap)
 
@@ -69,8 +78,30 @@ class FSEventWrap: public HandleWrap {
 
   static void OnEvent(uv_fs_event_t* handle, const char* filename, int events,
     int status);
-
-  uv_fs_event_t handle_;
+  Local<Value> EncodeFilename(const char* filename, Local<Value>* status);
+
+#ifdef __linux__
+  // Recursive watchers on Linux poll an InotifyTree instead of using
+  // uv_fs_event_t, and report events in batches, see Start().
+  int StartTree(const char* path, uint32_t coalesce_ms);
+  static void OnTreeReadable(uv_poll_t* handle, int status, int events);
+  static void OnCoalesceTimeout(uv_timer_t* timer);
+  void EmitTreeEvents();
+  void EmitTreeError(int status);
+
+  std::unique_ptr<fs::InotifyTree> tree_;
+  // Allocated separately, so that it can be closed independently of the
+  // main handle.
+  uv_timer_t* coalesce_timer_ = nullptr;
+  uint32_t coalesce_ms_ = 0;
+#endif
+
+  // The handle that HandleWrap manages: a uv_poll_t on the inotify fd for
+  // tree watchers, or a uv_fs_event_t otherwise.
+  union {
+    uv_fs_event_t handle_;
+    uv_poll_t poll_handle_;
+  };
   enum encoding encoding_ = kDefaultEncoding;
 };
 
@@ -84,6 +115,13 @@ FSEventWrap::FSEventWrap(Environment* env, Local<Object> object)
 }
 
 
+void FSEventWrap::MemoryInfo(MemoryTracker* tracker) const {
+#ifdef __linux__
+  tracker->TrackField("tree", tree_);
+#endif
+}
+
+
 void FSEventWrap::GetInitialized(const FunctionCallbackInfo<Value>& args) {
   FSEventWrap* wrap = Unwrap<FSEventWrap>(args.This());
   CHECK_NOT_NULL(wrap);
@@ -131,7 +169,13 @@ void FSEventWrap::New(const FunctionCallbackInfo<Value>& args) {
   new FSEventWrap(env, args.This());
 }
 
-// wrap.start(filename, persistent, recursive, encoding)
+// wrap.start(filename, persistent, recursive, encoding[, coalesceMs])
+//
+// On Linux, recursive watchers of a directory track the whole tree through a
+// single inotify instance and call onchange(status, eventTypes, filenames)
+// with arrays of events instead. Events are merged per filename for
+// `coalesceMs` milliseconds after the first one, or for as long as it takes
+// to read what the kernel has queued if that is 0.
 void FSEventWrap::Start(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -151,22 +195,40 @@ void FSEventWrap::Start(const FunctionCallbackInfo<Value>& args) {
 
   wrap->encoding_ = ParseEncoding(env->isolate(), args[3], kDefaultEncoding);
 
-  int err = uv_fs_event_init(wrap->env()->event_loop(), &wrap->handle_);
+  int err;
+#ifdef __linux__
+  uint32_t coalesce_ms = 0;
+  if (argc > 4 && args[4]->IsUint32())
+    coalesce_ms = args[4].As<Uint32>()->Value();
+
+  // Recursive watchers of a file are left to libuv.
+  if ((flags & UV_FS_EVENT_RECURSIVE) &&
+      (err = wrap->StartTree(*path, coalesce_ms)) != UV_ENOTDIR) {
+    // StartTree() only sets tree_ once the poll handle is initialized.
+    if (!wrap->tree_)
+      return args.GetReturnValue().Set(err);
+    wrap->MarkAsInitialized();
+  } else {
+#endif
+  err = uv_fs_event_init(wrap->env()->event_loop(), &wrap->handle_);
   if (err != 0) {
     return args.GetReturnValue().Set(err);
   }
 
   err = uv_fs_event_start(&wrap->handle_, OnEvent, *path, flags);
   wrap->MarkAsInitialized();
+#ifdef __linux__
+  }
+#endif
 
   if (err != 0) {
-    FSEventWrap::Close(args);
+    HandleWrap::Close(args);
     return args.GetReturnValue().Set(err);
   }
 
   // Check for persistent argument
   if (!args[1]->IsTrue()) {
-    uv_unref(reinterpret_cast<uv_handle_t*>(&wrap->handle_));
+    uv_unref(wrap->GetHandle());
   }
 
   args.GetReturnValue().Set(err);
@@ -211,27 +273,131 @@ void FSEventWrap::OnEvent(uv_fs_event_t* handle, const char* filename,
     Null(env->isolate())
   };
 
-  if (filename != nullptr) {
-    Local<Value> error;
-    MaybeLocal<Value> fn = StringBytes::Encode(env->isolate(),
-                                               filename,
-                                               wrap->encoding_,
-                                               &error);
-    if (fn.IsEmpty()) {
-      argv[0] = Integer::New(env->isolate(), UV_EINVAL);
-      argv[2] = StringBytes::Encode(env->isolate(),
-                                    filename,
-                                    strlen(filename),
-                                    BUFFER,
-                                    &error).ToLocalChecked();
-    } else {
-      argv[2] = fn.ToLocalChecked();
-    }
-  }
+  if (filename != nullptr)
+    argv[2] = wrap->EncodeFilename(filename, &argv[0]);
 
   wrap->MakeCallback(env->onchange_string(), arraysize(argv), argv);
 }
 
+// Falls back to a Buffer and sets `status` to UV_EINVAL if the filename
+// cannot be decoded.
+Local<Value> FSEventWrap::EncodeFilename(const char* filename,
+                                         Local<Value>* status) {
+  Local<Value> error;
+  MaybeLocal<Value> fn = StringBytes::Encode(env()->isolate(),
+                                             filename,
+                                             encoding_,
+                                             &error);
+  if (!fn.IsEmpty())
+    return fn.ToLocalChecked();
+  *status = Integer::New(env()->isolate(), UV_EINVAL);
+  return StringBytes::Encode(env()->isolate(),
+                             filename,
+                             strlen(filename),
+                             BUFFER,
+                             &error).ToLocalChecked();
+}
+
+void FSEventWrap::Close(Local<Value> close_callback) {
+#ifdef __linux__
+  if (coalesce_timer_ != nullptr) {
+    env()->CloseHandle(coalesce_timer_, [](uv_timer_t* timer) {
+      delete timer;
+    });
+    coalesce_timer_ = nullptr;
+  }
+#endif
+  HandleWrap::Close(close_callback);
+}
+
+#ifdef __linux__
+int FSEventWrap::StartTree(const char* path, uint32_t coalesce_ms) {
+  std::unique_ptr<fs::InotifyTree> tree =
+      std::make_unique<fs::InotifyTree>(path);
+  int err = tree->Start();
+  if (err != 0)
+    return err;
+
+  err = uv_poll_init(env()->event_loop(), &poll_handle_, tree->fd());
+  if (err != 0)
+    return err;
+  tree_ = std::move(tree);
+  coalesce_ms_ = coalesce_ms;
+  if (coalesce_ms_ > 0) {
+    coalesce_timer_ = new uv_timer_t();
+    CHECK_EQ(uv_timer_init(env()->event_loop(), coalesce_timer_), 0);
+    coalesce_timer_->data = this;
+    // Only the poll handle keeps the loop alive.
+    uv_unref(reinterpret_cast<uv_handle_t*>(coalesce_timer_));
+  }
+  return uv_poll_start(&poll_handle_, UV_READABLE, OnTreeReadable);
+}
+
+void FSEventWrap::OnTreeReadable(uv_poll_t* handle, int status, int events) {
+  FSEventWrap* wrap = static_cast<FSEventWrap*>(handle->data);
+  if (status == 0)
+    status = wrap->tree_->ReadEvents();
+  if (status != 0)
+    return wrap->EmitTreeError(status);
+  if (!wrap->tree_->has_events())
+    return;
+
+  if (wrap->coalesce_timer_ == nullptr)
+    return wrap->EmitTreeEvents();
+  if (!uv_is_active(reinterpret_cast<uv_handle_t*>(wrap->coalesce_timer_))) {
+    uv_timer_start(
+        wrap->coalesce_timer_, OnCoalesceTimeout, wrap->coalesce_ms_, 0);
+  }
+}
+
+void FSEventWrap::OnCoalesceTimeout(uv_timer_t* timer) {
+  static_cast<FSEventWrap*>(timer->data)->EmitTreeEvents();
+}
+
+void FSEventWrap::EmitTreeEvents() {
+  Environment* env = this->env();
+  Isolate* isolate = env->isolate();
+
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+
+  CHECK_EQ(persistent().IsEmpty(), false);
+
+  std::vector<fs::InotifyTree::Event> events = tree_->TakeEvents();
+  MaybeStackBuffer<Local<Value>, 64> event_strings(events.size());
+  MaybeStackBuffer<Local<Value>, 64> filenames(events.size());
+  Local<Value> status = Integer::New(isolate, 0);
+  for (size_t i = 0; i < events.size(); i++) {
+    // As in OnEvent(), a rename implies a change.
+    if (events[i].events & UV_RENAME)
+      event_strings[i] = env->rename_string();
+    else
+      event_strings[i] = env->change_string();
+    filenames[i] = EncodeFilename(events[i].path.c_str(), &status);
+  }
+
+  Local<Value> argv[] = {
+    status,
+    Array::New(isolate, event_strings.out(), events.size()),
+    Array::New(isolate, filenames.out(), events.size())
+  };
+  MakeCallback(env->onchange_string(), arraysize(argv), argv);
+}
+
+void FSEventWrap::EmitTreeError(int status) {
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  Local<Value> argv[] = {
+    Integer::New(env->isolate(), status),
+    String::Empty(env->isolate()),
+    Null(env->isolate())
+  };
+  MakeCallback(env->onchange_string(), arraysize(argv), argv);
+}
+#endif  // __linux__
+
 }  // anonymous namespace
 }  // namespace node
 
@@ -0,0 +1,729 @@
+#include "fs_tree.h"
+#include "memory_tracker-inl.h"
+#include "util-inl.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <atomic>
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#endif
+
+namespace node {
+namespace fs {
+
+TreeOperation::TreeOperation(Kind kind,
+                             std::string path,
+                             std::string dest,
+                             int copy_flags,
+                             unsigned int concurrency)
+    : kind_(kind),
+      path_(std::move(path)),
+      dest_(std::move(dest)),
+      copy_flags_(copy_flags),
+      concurrency_(std::min(std::max(concurrency, 1u), MaxConcurrency())) {}
+
+unsigned int TreeOperation::MaxConcurrency() {
+  static const unsigned int max_concurrency = []() {
+    // Parsed the same way as by libuv, which defaults to 4 threads.
+    unsigned int threadpool_size = 4;
+    char buf[32];
+    size_t len = sizeof(buf);
+    if (uv_os_getenv("UV_THREADPOOL_SIZE", buf, &len) == 0) {
+      int size = atoi(buf);
+      if (size > 0)
+        threadpool_size = static_cast<unsigned int>(size);
+    }
+    return std::min(std::max(threadpool_size / 2, 1u), kMaxConcurrency);
+  }();
+  return max_concurrency;
+}
+
+void TreeOperation::Begin(const uv_stat_t* root) {
+  Mutex::ScopedLock lock(mutex_);
+  CHECK(!root_pending_);
+  root_pending_ = true;
+  root_mode_ = static_cast<int>(root->st_mode);
+}
+
+int TreeOperation::Work() {
+  while (ProcessNext(false)) {}
+  Mutex::ScopedLock lock(mutex_);
+  return status_;
+}
+
+bool TreeOperation::ProcessNext(bool yield) {
+  Directory* dir = nullptr;
+  {
+    Mutex::ScopedLock lock(mutex_);
+    if (root_pending_) {
+      root_pending_ = false;
+    } else if (!queue_.empty()) {
+      dir = queue_.back();
+      queue_.pop_back();
+    } else {
+      return false;
+    }
+  }
+
+  if (dir == nullptr)
+    ProcessRoot();
+  else
+    ProcessDirectory(dir);
+
+  if (!yield)
+    return true;
+  // With a single queued directory, this thread might as well go on.
+  Mutex::ScopedLock lock(mutex_);
+  return queue_.size() < 2 || running_workers_ >= concurrency_;
+}
+
+int TreeOperation::RunAsync(uv_loop_t* loop, uv_fs_t* req, uv_fs_cb cb) {
+  CHECK_EQ(running_workers_, 0);
+  loop_ = loop;
+  req_ = req;
+  done_cb_ = cb;
+  int err = StartWorkers();
+  if (running_workers_ == 0) {
+    CHECK_NE(err, 0);
+    return err;
+  }
+  return 0;
+}
+
+int TreeOperation::StartWorkers() {
+  Mutex::ScopedLock lock(mutex_);
+  size_t waiting = queue_.size() + (root_pending_ ? 1 : 0);
+  while (waiting > 0 && running_workers_ < concurrency_) {
+    if (idle_workers_.empty()) {
+      workers_.emplace_back(std::make_unique<Worker>());
+      workers_.back()->operation = this;
+      idle_workers_.push_back(workers_.back().get());
+    }
+    Worker* worker = idle_workers_.back();
+    int err = uv_queue_work(loop_, &worker->req, WorkerThread, AfterWorker);
+    if (err != 0)
+      return err;
+    idle_workers_.pop_back();
+    running_workers_++;
+    waiting--;
+  }
+  return 0;
+}
+
+void TreeOperation::WorkerThread(uv_work_t* req) {
+  Worker* worker = ContainerOf(&Worker::req, req);
+  while (worker->operation->ProcessNext(true)) {}
+}
+
+void TreeOperation::AfterWorker(uv_work_t* req, int status) {
+  Worker* worker = ContainerOf(&Worker::req, req);
+  TreeOperation* operation = worker->operation;
+  {
+    Mutex::ScopedLock lock(operation->mutex_);
+    CHECK_GT(operation->running_workers_, 0);
+    operation->running_workers_--;
+    operation->idle_workers_.push_back(worker);
+  }
+  int err = operation->StartWorkers();
+  if (operation->running_workers_ > 0)
+    return;
+  if (err == 0) {
+    Mutex::ScopedLock lock(operation->mutex_);
+    err = operation->status_;
+  }
+  // Nothing is queued and no worker is left that could queue more, unless
+  // starting a worker failed. This may delete the operation.
+  operation->req_->result = err;
+  operation->done_cb_(operation->req_);
+}
+
+void TreeOperation::AddDirectories(
+    std::vector<std::unique_ptr<Directory>>* subdirs, Directory* parent) {
+  if (subdirs->empty())
+    return;
+  Mutex::ScopedLock lock(mutex_);
+  if (parent != nullptr)
+    parent->pending += subdirs->size();
+  for (std::unique_ptr<Directory>& subdir : *subdirs) {
+    queue_.push_back(subdir.get());
+    directories_.emplace_back(std::move(subdir));
+  }
+  subdirs->clear();
+}
+
+void TreeOperation::AddEntries(size_t count) {
+  if (count == 0)
+    return;
+  Mutex::ScopedLock lock(mutex_);
+  entries_ += count;
+}
+
+void TreeOperation::AddScanned(std::vector<ScanEntry>* scanned) {
+  if (scanned->empty())
+    return;
+  Mutex::ScopedLock lock(mutex_);
+  entries_ += scanned->size();
+  if (scanned_.empty()) {
+    scanned_ = std::move(*scanned);
+  } else {
+    scanned_.insert(scanned_.end(),
+                    std::make_move_iterator(scanned->begin()),
+                    std::make_move_iterator(scanned->end()));
+  }
+  scanned->clear();
+}
+
+void TreeOperation::AddError(int code,
+                             const char* syscall,
+                             const std::string& path,
+                             const std::string& dest) {
+  Mutex::ScopedLock lock(mutex_);
+  error_count_++;
+  if (errors_.size() < kMaxErrors)
+    errors_.push_back(Error { code, syscall, path, dest });
+}
+
+void TreeOperation::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("directories",
+                              directories_.size() * sizeof(Directory));
+  tracker->TrackFieldWithSize("errors", errors_.size() * sizeof(Error));
+  tracker->TrackFieldWithSize("scanned",
+                              scanned_.size() * sizeof(ScanEntry));
+}
+
+#ifndef _WIN32
+
+namespace {
+
+inline int LastError() {
+  return uv_translate_sys_error(errno);
+}
+
+// Like uv_fs_lstat(), but relative to `dirfd`.
+int StatAt(int dirfd, const char* name, uv_stat_t* buf) {
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+  static std::atomic<bool> no_statx { false };
+  if (!no_statx.load(std::memory_order_relaxed)) {
+    struct statx s;
+    if (statx(dirfd, name, AT_SYMLINK_NOFOLLOW,
+              STATX_BASIC_STATS | STATX_BTIME, &s) == 0) {
+      buf->st_dev = makedev(s.stx_dev_major, s.stx_dev_minor);
+      buf->st_mode = s.stx_mode;
+      buf->st_nlink = s.stx_nlink;
+      buf->st_uid = s.stx_uid;
+      buf->st_gid = s.stx_gid;
+      buf->st_rdev = makedev(s.stx_rdev_major, s.stx_rdev_minor);
+      buf->st_ino = s.stx_ino;
+      buf->st_size = s.stx_size;
+      buf->st_blksize = s.stx_blksize;
+      buf->st_blocks = s.stx_blocks;
+      buf->st_atim.tv_sec = s.stx_atime.tv_sec;
+      buf->st_atim.tv_nsec = s.stx_atime.tv_nsec;
+      buf->st_mtim.tv_sec = s.stx_mtime.tv_sec;
+      buf->st_mtim.tv_nsec = s.stx_mtime.tv_nsec;
+      buf->st_ctim.tv_sec = s.stx_ctime.tv_sec;
+      buf->st_ctim.tv_nsec = s.stx_ctime.tv_nsec;
+      buf->st_birthtim.tv_sec = s.stx_btime.tv_sec;
+      buf->st_birthtim.tv_nsec = s.stx_btime.tv_nsec;
+      buf->st_flags = 0;
+      buf->st_gen = 0;
+      return 0;
+    }
+    // The same errors that make libuv fall back to stat().
+    if (errno != EINVAL && errno != EPERM && errno != ENOSYS &&
+        errno != EOPNOTSUPP) {
+      return LastError();
+    }
+    no_statx.store(true, std::memory_order_relaxed);
+  }
+#endif
+
+  struct stat s;
+  if (fstatat(dirfd, name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+    return LastError();
+
+  buf->st_dev = s.st_dev;
+  buf->st_mode = s.st_mode;
+  buf->st_nlink = s.st_nlink;
+  buf->st_uid = s.st_uid;
+  buf->st_gid = s.st_gid;
+  buf->st_rdev = s.st_rdev;
+  buf->st_ino = s.st_ino;
+  buf->st_size = s.st_size;
+  buf->st_blksize = s.st_blksize;
+  buf->st_blocks = s.st_blocks;
+  buf->st_flags = 0;
+  buf->st_gen = 0;
+#if defined(__APPLE__)
+  buf->st_atim.tv_sec = s.st_atimespec.tv_sec;
+  buf->st_atim.tv_nsec = s.st_atimespec.tv_nsec;
+  buf->st_mtim.tv_sec = s.st_mtimespec.tv_sec;
+  buf->st_mtim.tv_nsec = s.st_mtimespec.tv_nsec;
+  buf->st_ctim.tv_sec = s.st_ctimespec.tv_sec;
+  buf->st_ctim.tv_nsec = s.st_ctimespec.tv_nsec;
+  buf->st_birthtim.tv_sec = s.st_birthtimespec.tv_sec;
+  buf->st_birthtim.tv_nsec = s.st_birthtimespec.tv_nsec;
+#else
+  buf->st_atim.tv_sec = s.st_atim.tv_sec;
+  buf->st_atim.tv_nsec = s.st_atim.tv_nsec;
+  buf->st_mtim.tv_sec = s.st_mtim.tv_sec;
+  buf->st_mtim.tv_nsec = s.st_mtim.tv_nsec;
+  buf->st_ctim.tv_sec = s.st_ctim.tv_sec;
+  buf->st_ctim.tv_nsec = s.st_ctim.tv_nsec;
+  buf->st_birthtim.tv_sec = s.st_ctim.tv_sec;
+  buf->st_birthtim.tv_nsec = s.st_ctim.tv_nsec;
+#endif
+  return 0;
+}
+
+// Resolves `path` like realpath(). A path that does not exist yet, like the
+// destination of a copy, is resolved through its parent directory.
+bool ResolvePath(const std::string& path, std::string* resolved) {
+  char buf[PATH_MAX];
+  if (realpath(path.c_str(), buf) != nullptr) {
+    *resolved = buf;
+    return true;
+  }
+  if (errno != ENOENT)
+    return false;
+
+  size_t end = path.find_last_not_of('/');
+  if (end == std::string::npos)
+    return false;
+  size_t slash = path.rfind('/', end);
+  std::string base = path.substr(slash + 1, end - slash);
+  if (base == "." || base == "..")
+    return false;
+  std::string parent = ".";
+  if (slash != std::string::npos)
+    parent = slash == 0 ? "/" : path.substr(0, slash);
+  if (realpath(parent.c_str(), buf) == nullptr)
+    return false;
+
+  *resolved = buf;
+  if (resolved->back() != '/')
+    *resolved += '/';
+  *resolved += base;
+  return true;
+}
+
+// Like uv_fs_copyfile(), but relative to directory fds, and without
+// following a symbolic link at `dest_name`.
+int CopyFileAt(int dirfd,
+               const char* name,
+               int dest_dirfd,
+               const char* dest_name,
+               int flags) {
+  int src = openat(dirfd, name, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (src == -1)
+    return LastError();
+
+  int dest = -1;
+  int err = 0;
+  struct stat src_stat;
+  if (fstat(src, &src_stat) != 0) {
+    err = LastError();
+  } else {
+    int dest_flags = O_WRONLY | O_CREAT | O_CLOEXEC | O_NOFOLLOW;
+    if (flags & UV_FS_COPYFILE_EXCL)
+      dest_flags |= O_EXCL;
+    dest = openat(dest_dirfd, dest_name, dest_flags, src_stat.st_mode);
+    if (dest == -1)
+      err = LastError();
+  }
+
+  if (err == 0 && !(flags & UV_FS_COPYFILE_EXCL)) {
+    struct stat dest_stat;
+    if (fstat(dest, &dest_stat) != 0) {
+      err = LastError();
+    } else if (dest_stat.st_dev == src_stat.st_dev &&
+               dest_stat.st_ino == src_stat.st_ino) {
+      // Copying a file onto itself leaves it as it is.
+      close(dest);
+      close(src);
+      return 0;
+    } else if (ftruncate(dest, 0) != 0) {
+      err = LastError();
+    }
+  }
+
+  if (err == 0 && fchmod(dest, src_stat.st_mode) != 0)
+    err = LastError();
+
+  bool cloned = false;
+  if (err == 0 && (flags & (UV_FS_COPYFILE_FICLONE |
+                            UV_FS_COPYFILE_FICLONE_FORCE))) {
+#ifdef FICLONE
+    if (ioctl(dest, FICLONE, src) == 0)
+      cloned = true;
+    else if (flags & UV_FS_COPYFILE_FICLONE_FORCE)
+      err = LastError();
+#else
+    if (flags & UV_FS_COPYFILE_FICLONE_FORCE)
+      err = UV_ENOSYS;
+#endif
+  }
+
+  // uv_fs_sendfile() uses copy_file_range() where it can.
+  int64_t offset = 0;
+  while (err == 0 && !cloned && offset < src_stat.st_size) {
+    uv_fs_t req;
+    size_t chunk = static_cast<size_t>(
+        std::min<int64_t>(src_stat.st_size - offset, SSIZE_MAX));
+    int64_t written =
+        uv_fs_sendfile(nullptr, &req, dest, src, offset, chunk, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (written < 0)
+      err = static_cast<int>(written);
+    else if (written == 0)
+      break;  // The file was truncated while it was copied.
+    offset += written;
+  }
+
+  if (dest != -1 && close(dest) != 0 && err == 0)
+    err = LastError();
+  close(src);
+  return err;
+}
+
+}  // anonymous namespace
+
+int TreeOperation::CheckDestination() const {
+  std::string src;
+  std::string dest;
+  // If either path cannot be resolved, the copy fails on its own.
+  if (!ResolvePath(path_, &src) || !ResolvePath(dest_, &dest))
+    return 0;
+  if (dest.compare(0, src.size(), src) != 0)
+    return 0;
+  if (dest.size() == src.size() || src.back() == '/' || dest[src.size()] == '/')
+    return UV_EINVAL;
+  return 0;
+}
+
+void TreeOperation::ProcessRoot() {
+  int mode = root_mode_ & 07777;
+  std::vector<std::unique_ptr<Directory>> root;
+
+  if (kind_ == Kind::kScan) {
+    CHECK(S_ISDIR(root_mode_));
+    root.emplace_back(
+        new Directory { path_, std::string(), nullptr, mode, path_ });
+    return AddDirectories(&root, nullptr);
+  }
+
+  if (S_ISDIR(root_mode_)) {
+    if (kind_ == Kind::kCopy) {
+      int err = CheckDestination();
+      if (err != 0) {
+        Mutex::ScopedLock lock(mutex_);
+        status_ = err;
+        return;
+      }
+      // Keep the directory writable until its contents have been copied.
+      if (mkdir(dest_.c_str(), mode | S_IRWXU) != 0 && errno != EEXIST)
+        return AddError(LastError(), "mkdir", dest_);
+      AddEntries(1);
+    }
+    root.emplace_back(new Directory { path_, dest_, nullptr, mode, path_ });
+    return AddDirectories(&root, nullptr);
+  }
+
+  if (kind_ == Kind::kRemove) {
+    if (unlink(path_.c_str()) != 0)
+      return AddError(LastError(), "unlink", path_);
+    return AddEntries(1);
+  }
+
+  const char* syscall;
+  int err = CopyEntry(AT_FDCWD, path_.c_str(), AT_FDCWD, dest_.c_str(),
+                      root_mode_ & S_IFMT, &syscall);
+  if (err != 0)
+    return AddError(err, syscall, path_, dest_);
+  AddEntries(1);
+}
+
+void TreeOperation::ProcessDirectory(Directory* dir) {
+  // The root of a scan was stat()ed, so it may be a symlink.
+  int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+  if (kind_ != Kind::kScan || dir->parent != nullptr)
+    flags |= O_NOFOLLOW;
+  int parent_fd = dir->parent != nullptr ? dir->parent->fd : AT_FDCWD;
+  int fd = openat(parent_fd, dir->name.c_str(), flags);
+  if (fd == -1) {
+    AddError(LastError(), "opendir", dir->path);
+    return FinishDirectory(dir, true);
+  }
+  // The listing gets a descriptor of its own, since closedir() closes it and
+  // `fd` has to stay open for the subdirectories.
+  int stream_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  DIR* stream = stream_fd == -1 ? nullptr : fdopendir(stream_fd);
+  if (stream == nullptr) {
+    AddError(LastError(), "opendir", dir->path);
+    if (stream_fd != -1)
+      close(stream_fd);
+    close(fd);
+    return FinishDirectory(dir, true);
+  }
+  dir->fd = fd;
+
+  if (kind_ == Kind::kCopy) {
+    // The root of the copy may be reached through a symbolic link, just like
+    // the root of the source.
+    if (dir->parent != nullptr) {
+      dir->dest_fd = openat(dir->parent->dest_fd, dir->name.c_str(),
+                            O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+    } else {
+      dir->dest_fd = open(dir->dest.c_str(),
+                          O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (dir->dest_fd == -1) {
+      AddError(LastError(), "opendir", dir->path, dir->dest);
+      closedir(stream);
+      return FinishDirectory(dir, true);
+    }
+  }
+
+  std::vector<std::unique_ptr<Directory>> subdirs;
+  std::vector<ScanEntry> scanned;
+  size_t entries = 0;
+  bool failed = false;
+
+  for (;;) {
+    errno = 0;
+    struct dirent* ent = readdir(stream);
+    if (ent == nullptr) {
+      if (errno != 0) {
+        AddError(LastError(), "readdir", dir->path);
+        failed = true;
+      }
+      break;
+    }
+
+    const char* name = ent->d_name;
+    if (name[0] == '.' &&
+        (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+      continue;
+    }
+
+    // Only needed for errors and subdirectories.
+    auto path = [&]() { return dir->path + '/' + name; };
+    auto dest = [&]() { return dir->dest + '/' + name; };
+
+    if (kind_ == Kind::kScan) {
+      ScanEntry entry;
+      int err = StatAt(dirfd(stream), name, &entry.stat);
+      if (err != 0) {
+        AddError(err, "lstat", path());
+        continue;
+      }
+      entry.name = dir->dest.empty() ? name : dest();
+      if (S_ISDIR(entry.stat.st_mode) && dir->depth < max_depth_) {
+        subdirs.emplace_back(
+            new Directory { path(), entry.name, dir, 0, name });
+        subdirs.back()->depth = dir->depth + 1;
+      }
+      scanned.emplace_back(std::move(entry));
+      if (subdirs.size() >= 64)
+        AddDirectories(&subdirs, dir);
+      continue;
+    }
+
+    // The mode of directories is only needed for copying.
+    int type = 0;
+    int mode = 0;
+#ifdef _DIRENT_HAVE_D_TYPE
+    switch (ent->d_type) {
+      case DT_DIR: type = S_IFDIR; break;
+      case DT_REG: type = S_IFREG; break;
+      case DT_LNK: type = S_IFLNK; break;
+      case DT_UNKNOWN: break;
+      default: type = S_IFIFO; break;
+    }
+#endif
+    if (type == 0 || (type == S_IFDIR && kind_ == Kind::kCopy)) {
+      struct stat s;
+      if (fstatat(dirfd(stream), name, &s, AT_SYMLINK_NOFOLLOW) != 0) {
+        AddError(LastError(), "lstat", path());
+        failed = true;
+        continue;
+      }
+      type = s.st_mode & S_IFMT;
+      mode = s.st_mode & 07777;
+    }
+
+    if (kind_ == Kind::kRemove) {
+      if (type == S_IFDIR) {
+        subdirs.emplace_back(
+            new Directory { path(), std::string(), dir, mode, name });
+      } else if (unlinkat(dirfd(stream), name, 0) != 0) {
+        AddError(LastError(), "unlink", path());
+        failed = true;
+      } else {
+        entries++;
+      }
+      continue;
+    }
+
+    if (type == S_IFDIR) {
+      if (mkdirat(dir->dest_fd, name, mode | S_IRWXU) != 0 &&
+          errno != EEXIST) {
+        AddError(LastError(), "mkdir", path(), dest());
+        failed = true;
+        continue;
+      }
+      entries++;
+      subdirs.emplace_back(new Directory { path(), dest(), dir, mode, name });
+    } else {
+      const char* syscall;
+      int err =
+          CopyEntry(dirfd(stream), name, dir->dest_fd, name, type, &syscall);
+      if (err != 0) {
+        AddError(err, syscall, path(), dest());
+        failed = true;
+      } else {
+        entries++;
+      }
+    }
+
+    // Let other threads start on subdirectories while this one is still
+    // working through a large directory.
+    if (subdirs.size() >= 64)
+      AddDirectories(&subdirs, dir);
+  }
+
+  closedir(stream);
+
+  AddScanned(&scanned);
+  AddEntries(entries);
+  AddDirectories(&subdirs, dir);
+  FinishDirectory(dir, failed);
+}
+
+int TreeOperation::CopyEntry(int dirfd,
+                             const char* name,
+                             int dest_dirfd,
+                             const char* dest_name,
+                             int type,
+                             const char** syscall) {
+  if (type == S_IFREG) {
+    *syscall = "copyfile";
+    return CopyFileAt(dirfd, name, dest_dirfd, dest_name, copy_flags_);
+  }
+
+  if (type == S_IFLNK) {
+    char target[PATH_MAX + 1];
+    ssize_t len = readlinkat(dirfd, name, target, PATH_MAX);
+    if (len == -1) {
+      *syscall = "readlink";
+      return LastError();
+    }
+    target[len] = '\0';
+
+    *syscall = "symlink";
+    int r = symlinkat(target, dest_dirfd, dest_name);
+    if (r != 0 && errno == EEXIST && !(copy_flags_ & UV_FS_COPYFILE_EXCL)) {
+      r = unlinkat(dest_dirfd, dest_name, 0);
+      if (r == 0)
+        r = symlinkat(target, dest_dirfd, dest_name);
+    }
+    return r != 0 ? LastError() : 0;
+  }
+
+  // Sockets, FIFOs and device files are not copied.
+  *syscall = "copyfile";
+  return UV_ENOTSUP;
+}
+
+void TreeOperation::FinishDirectory(Directory* dir, bool failed) {
+  while (dir != nullptr) {
+    {
+      Mutex::ScopedLock lock(mutex_);
+      if (failed)
+        dir->failed = true;
+      CHECK_GT(dir->pending, 0);
+      if (--dir->pending > 0)
+        return;
+      failed = dir->failed;
+    }
+
+    if (dir->fd != -1) {
+      close(dir->fd);
+      dir->fd = -1;
+    }
+    int dest_fd = dir->dest_fd;
+    dir->dest_fd = -1;
+
+    // The parent's fd is still open, since it waits for this directory.
+    int parent_fd = dir->parent != nullptr ? dir->parent->fd : AT_FDCWD;
+    if (kind_ == Kind::kRemove) {
+      // After a failure inside, the directory is kept and the failure
+      // propagates to the parent.
+      if (!failed) {
+        if (unlinkat(parent_fd, dir->name.c_str(), AT_REMOVEDIR) != 0) {
+          AddError(LastError(), "rmdir", dir->path);
+          failed = true;
+        } else {
+          AddEntries(1);
+        }
+      }
+    } else if (kind_ == Kind::kCopy && (dir->mode & S_IRWXU) != S_IRWXU) {
+      // The copy was made writable for its contents. Restore its mode even if
+      // some of them failed, rather than leave it more permissive than the
+      // source. If it could not be opened, it is changed by name.
+      int r;
+      if (dest_fd != -1)
+        r = fchmod(dest_fd, dir->mode);
+      else if (dir->parent != nullptr)
+        r = fchmodat(dir->parent->dest_fd, dir->name.c_str(), dir->mode, 0);
+      else
+        r = chmod(dir->dest.c_str(), dir->mode);
+      if (r != 0) {
+        AddError(LastError(), "chmod", dir->path, dir->dest);
+        failed = true;
+      }
+    }
+    if (dest_fd != -1)
+      close(dest_fd);
+
+    dir = dir->parent;
+  }
+}
+
+#else  // _WIN32
+
+void TreeOperation::ProcessRoot() {
+  const char* syscall = "readdirstats";
+  if (kind_ == Kind::kRemove)
+    syscall = "rmtree";
+  else if (kind_ == Kind::kCopy)
+    syscall = "copytree";
+  AddError(UV_ENOSYS, syscall, path_);
+}
+
+void TreeOperation::ProcessDirectory(Directory* dir) {
+  UNREACHABLE();
+}
+
+#endif  // _WIN32
+
+}  // namespace fs
+}  // namespace node
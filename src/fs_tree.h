@@ -0,0 +1,201 @@
+#ifndef SRC_FS_TREE_H_
+#define SRC_FS_TREE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory_tracker.h"
+#include "node_mutex.h"
+#include "uv.h"
+
+namespace node {
+namespace fs {
+
+// Removes, copies or lists a whole directory tree natively, for rmTree(),
+// copyTree() and readdirStats(). Directories are the unit of work: each one
+// is listed through an open directory fd, and its entries are removed with
+// unlinkat() or stat()ed relative to it. A copy keeps the directory it
+// copies into open as well, and creates its entries relative to that, using
+// copy_file_range() or, with UV_FS_COPYFILE_FICLONE, reflinks for files.
+// Subdirectories are queued, so that several threads can walk the tree at
+// the same time.
+//
+// The fds of a directory stay open until all of its subdirectories are
+// done, and they are opened and removed relative to them with O_NOFOLLOW,
+// so a directory that is replaced by a symbolic link while the operation
+// runs cannot redirect it to somewhere outside the tree. Subdirectories are
+// processed depth first, which keeps the number of open fds close to the
+// depth of the tree.
+//
+// Failures do not stop the operation. They are collected, and the parts of
+// the tree that could be processed are. Symbolic links are never followed.
+// The exception is a copy into the directory being copied, or below it,
+// which would never end: it fails with UV_EINVAL before anything is copied.
+// Not supported on Windows, where the operation fails with UV_ENOSYS.
+class TreeOperation : public MemoryRetainer {
+ public:
+  enum class Kind { kRemove, kCopy, kScan };
+
+  struct Error {
+    int code;
+    const char* syscall;
+    std::string path;
+    std::string dest;
+  };
+
+  // An entry found by kScan. `name` is relative to the root.
+  struct ScanEntry {
+    std::string name;
+    uv_stat_t stat;
+  };
+
+  // For kCopy, `copy_flags` are the UV_FS_COPYFILE_* flags for every file.
+  TreeOperation(Kind kind,
+                std::string path,
+                std::string dest = std::string(),
+                int copy_flags = 0,
+                unsigned int concurrency = 1);
+
+  // Queues the tree at `path`, given the result of lstat()ing it, or, for
+  // kScan, stat()ing it.
+  void Begin(const uv_stat_t* root);
+
+  // For kScan, how many levels of subdirectories to descend into. The
+  // default of 0 only lists the root.
+  void set_max_depth(unsigned int max_depth) { max_depth_ = max_depth; }
+
+  // Processes the whole tree on the calling thread. Returns an error if the
+  // operation could not be started at all.
+  int Work();
+
+  // Processes the tree on up to `concurrency` threadpool threads, then sets
+  // req->result and calls `cb(req)` on the loop thread. Threads never wait
+  // for each other: one that runs out of queued directories returns, and
+  // one that finds more directories queued than there are threads working
+  // on them returns so that more can be started from the loop thread.
+  // req->result is an error if the operation could not be started at all,
+  // as for Work(). Returns an error if no work could be queued, in which
+  // case `cb` is not called.
+  int RunAsync(uv_loop_t* loop, uv_fs_t* req, uv_fs_cb cb);
+
+  Kind kind() const { return kind_; }
+  // Number of files and directories that were removed, copied or scanned.
+  size_t entries() const { return entries_; }
+  // The entries found by kScan, in no particular order.
+  const std::vector<ScanEntry>& scanned() const { return scanned_; }
+  // Number of failures. Only the first kMaxErrors are kept in errors().
+  size_t error_count() const { return error_count_; }
+  const std::vector<Error>& errors() const { return errors_; }
+
+  // Upper bound for `concurrency`: half of the threadpool, so that other
+  // requests are not starved while a large tree is processed, and no more
+  // than kMaxConcurrency.
+  static unsigned int MaxConcurrency();
+
+  static constexpr unsigned int kMaxConcurrency = 16;
+  static constexpr size_t kMaxErrors = 100;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(TreeOperation)
+  SET_SELF_SIZE(TreeOperation)
+
+ private:
+  struct Directory {
+    std::string path;
+    // For kScan, the path relative to the root.
+    std::string dest;
+    Directory* parent;
+    int mode;
+    // The name to open the directory by, relative to the fd of `parent`, or
+    // to the working directory for the root.
+    std::string name;
+    // Open from the time the directory is listed until it is finished.
+    int fd = -1;
+    // For kCopy, the fd of the copy, open for as long as `fd`.
+    int dest_fd = -1;
+    // The listing of this directory itself plus its unfinished
+    // subdirectories. The directory is finished when this drops to zero.
+    size_t pending = 1;
+    // Something inside failed, so the directory cannot be removed.
+    bool failed = false;
+    unsigned int depth = 0;
+  };
+
+  struct Worker {
+    uv_work_t req;
+    TreeOperation* operation;
+  };
+
+  // Processes the root or the most recently queued directory. Returns false
+  // if there was nothing to do, or, if `yield` is set, when more workers
+  // should be started for the directories that are waiting.
+  bool ProcessNext(bool yield);
+  void ProcessRoot();
+  void ProcessDirectory(Directory* dir);
+  // For kCopy, returns UV_EINVAL if `dest_` is the source directory or lies
+  // inside it.
+  int CheckDestination() const;
+  // Copies a non-directory entry, given its type as a S_IF* constant, from
+  // `name` relative to `dirfd` to `dest_name` relative to `dest_dirfd`.
+  // Returns an error and sets `syscall` on failure.
+  int CopyEntry(int dirfd,
+                const char* name,
+                int dest_dirfd,
+                const char* dest_name,
+                int type,
+                const char** syscall);
+  // Called once all of a directory's entries are done, and then for every
+  // parent that becomes finished as a result.
+  void FinishDirectory(Directory* dir, bool failed);
+  // Queues `subdirs` as children of `parent`.
+  void AddDirectories(std::vector<std::unique_ptr<Directory>>* subdirs,
+                      Directory* parent);
+  void AddEntries(size_t count);
+  void AddScanned(std::vector<ScanEntry>* scanned);
+  void AddError(int code,
+                const char* syscall,
+                const std::string& path,
+                const std::string& dest = std::string());
+
+  // Queues workers for the waiting directories, up to `concurrency_`
+  // running in total. Must be called on the loop thread.
+  int StartWorkers();
+  static void WorkerThread(uv_work_t* req);
+  static void AfterWorker(uv_work_t* req, int status);
+
+  const Kind kind_;
+  const std::string path_;
+  const std::string dest_;
+  const int copy_flags_;
+  const unsigned int concurrency_;
+  unsigned int max_depth_ = 0;
+
+  Mutex mutex_;
+  bool root_pending_ = false;
+  int root_mode_ = 0;
+  // Set if the root could not be processed at all.
+  int status_ = 0;
+  std::vector<Directory*> queue_;
+  std::vector<std::unique_ptr<Directory>> directories_;
+  size_t entries_ = 0;
+  size_t error_count_ = 0;
+  std::vector<Error> errors_;
+  std::vector<ScanEntry> scanned_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<Worker*> idle_workers_;
+  // Only changed on the loop thread, and read by workers under `mutex_`.
+  size_t running_workers_ = 0;
+  uv_loop_t* loop_ = nullptr;
+  uv_fs_t* req_ = nullptr;
+  uv_fs_cb done_cb_ = nullptr;
+};
+
+}  // namespace fs
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_FS_TREE_H_
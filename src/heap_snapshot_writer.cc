@@ -0,0 +1,137 @@
+#include "heap_snapshot_writer.h"
+#include "util-inl.h"
+
+namespace node {
+namespace heap {
+
+HeapSnapshotFileWriter::HeapSnapshotFileWriter(uv_file fd,
+                                               bool compress,
+                                               std::function<void()> on_done)
+    : fd_(fd), compress_(compress), on_done_(std::move(on_done)) {}
+
+HeapSnapshotFileWriter::~HeapSnapshotFileWriter() {
+  if (started_) Join();
+}
+
+int HeapSnapshotFileWriter::Start(const char** syscall) {
+  if (compress_ &&
+      deflateInit2(&zstream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    *syscall = "deflateInit2";
+    return UV_ENOMEM;
+  }
+  int err = uv_thread_create(&thread_, Run, this);
+  if (err != 0) {
+    if (compress_) deflateEnd(&zstream_);
+    *syscall = "uv_thread_create";
+    return err;
+  }
+  started_ = true;
+  return 0;
+}
+
+v8::OutputStream::WriteResult HeapSnapshotFileWriter::WriteAsciiChunk(
+    char* data, int size) {
+  Mutex::ScopedLock lock(mutex_);
+  while (pending_bytes_ >= kMaxPendingBytes && error_ == 0)
+    cond_.Wait(lock);
+  if (error_ != 0) return kAbort;
+  chunks_.emplace_back(data, data + size);
+  pending_bytes_ += size;
+  cond_.Broadcast(lock);
+  return kContinue;
+}
+
+void HeapSnapshotFileWriter::Close() {
+  Mutex::ScopedLock lock(mutex_);
+  closed_ = true;
+  cond_.Broadcast(lock);
+}
+
+int HeapSnapshotFileWriter::Join() {
+  if (started_) {
+    CHECK_EQ(uv_thread_join(&thread_), 0);
+    started_ = false;
+  }
+  Mutex::ScopedLock lock(mutex_);
+  return error_;
+}
+
+void HeapSnapshotFileWriter::Run(void* arg) {
+  static_cast<HeapSnapshotFileWriter*>(arg)->WriteChunks();
+}
+
+void HeapSnapshotFileWriter::WriteChunks() {
+  int err = 0;
+  for (;;) {
+    std::vector<char> chunk;
+    {
+      Mutex::ScopedLock lock(mutex_);
+      while (chunks_.empty() && !closed_)
+        cond_.Wait(lock);
+      if (chunks_.empty()) break;
+      chunk = std::move(chunks_.front());
+      chunks_.pop_front();
+      pending_bytes_ -= chunk.size();
+      cond_.Broadcast(lock);
+    }
+    // Keep draining after an error, so that the main thread never waits
+    // for a writer that has given up.
+    if (err == 0) {
+      err = compress_ ? Deflate(chunk.data(), chunk.size(), Z_NO_FLUSH)
+                      : WriteToFile(chunk.data(), chunk.size());
+      if (err != 0) {
+        Mutex::ScopedLock lock(mutex_);
+        error_ = err;
+        cond_.Broadcast(lock);
+      }
+    }
+  }
+
+  if (compress_) {
+    if (err == 0) err = Deflate(nullptr, 0, Z_FINISH);
+    deflateEnd(&zstream_);
+  }
+
+  uv_fs_t req;
+  int close_err = uv_fs_close(nullptr, &req, fd_, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (err == 0) err = close_err;
+
+  {
+    Mutex::ScopedLock lock(mutex_);
+    error_ = err;
+  }
+  on_done_();
+}
+
+int HeapSnapshotFileWriter::WriteToFile(const char* data, size_t len) {
+  while (len > 0) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init(const_cast<char*>(data), len);
+    int ret = uv_fs_write(nullptr, &req, fd_, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (ret < 0) return ret;
+    data += ret;
+    len -= ret;
+  }
+  return 0;
+}
+
+int HeapSnapshotFileWriter::Deflate(const char* data, size_t len, int flush) {
+  zstream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  zstream_.avail_in = len;
+  int ret;
+  do {
+    zstream_.next_out = reinterpret_cast<Bytef*>(out_);
+    zstream_.avail_out = sizeof(out_);
+    ret = deflate(&zstream_, flush);
+    if (ret == Z_STREAM_ERROR) return UV_EIO;
+    int err = WriteToFile(out_, sizeof(out_) - zstream_.avail_out);
+    if (err != 0) return err;
+  } while (zstream_.avail_out == 0 || (flush == Z_FINISH && ret == Z_OK));
+  return 0;
+}
+
+}  // namespace heap
+}  // namespace node
@@ -0,0 +1,79 @@
+#ifndef SRC_HEAP_SNAPSHOT_WRITER_H_
+#define SRC_HEAP_SNAPSHOT_WRITER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <deque>
+#include <functional>
+#include <vector>
+#include "node_mutex.h"
+#include "uv.h"
+#include "v8-profiler.h"
+#include "zlib.h"
+
+namespace node {
+namespace heap {
+
+// Receives the JSON chunks produced by V8 on the main thread and hands them
+// over to a dedicated thread that optionally gzips them and writes them to
+// `fd`. Buffering is bounded: once kMaxPendingBytes are queued, the main
+// thread waits for the writer to catch up.
+class HeapSnapshotFileWriter final : public v8::OutputStream {
+ public:
+  static constexpr size_t kMaxPendingBytes = 16 * 1024 * 1024;
+
+  // `on_done` is called on the writer thread once `fd` is closed. `fd` is
+  // only closed if Start() succeeds.
+  HeapSnapshotFileWriter(uv_file fd,
+                         bool compress,
+                         std::function<void()> on_done);
+  ~HeapSnapshotFileWriter() override;
+
+  HeapSnapshotFileWriter(const HeapSnapshotFileWriter&) = delete;
+  HeapSnapshotFileWriter& operator=(const HeapSnapshotFileWriter&) = delete;
+
+  // On failure, `*syscall` is set to the name of the call that failed.
+  int Start(const char** syscall);
+
+  int GetChunkSize() override {
+    return 65536;  // big chunks == faster
+  }
+
+  void EndOfStream() override { Close(); }
+  WriteResult WriteAsciiChunk(char* data, int size) override;
+
+  // Signal that no more chunks are coming. V8 does not call EndOfStream()
+  // if the serialization is aborted, so this is also called explicitly.
+  void Close();
+
+  // Wait for the writer thread and return the first error it encountered.
+  int Join();
+
+ private:
+  static void Run(void* arg);
+  void WriteChunks();
+  int WriteToFile(const char* data, size_t len);
+  int Deflate(const char* data, size_t len, int flush);
+
+  uv_file fd_;
+  bool compress_;
+  std::function<void()> on_done_;
+  uv_thread_t thread_;
+  bool started_ = false;
+  z_stream zstream_ = {};
+  char out_[65536];
+
+  Mutex mutex_;
+  ConditionVariable cond_;
+  std::deque<std::vector<char>> chunks_;
+  size_t pending_bytes_ = 0;
+  bool closed_ = false;
+  int error_ = 0;
+};
+
+}  // namespace heap
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_HEAP_SNAPSHOT_WRITER_H_
@@ -1,10 +1,16 @@
 #include "diagnosticfilename-inl.h"
 #include "env-inl.h"
+#include "heap_snapshot_writer.h"
 #include "memory_tracker-inl.h"
+#include "node_errors.h"
 #include "node_external_reference.h"
 #include "stream_base-inl.h"
 #include "util-inl.h"
 
+#include <algorithm>
+#include <map>
+
+using v8::AllocationProfile;
 using v8::Array;
 using v8::Boolean;
 using v8::Context;
@@ -15,6 +21,7 @@ using v8::FunctionTemplate;
 using v8::Global;
 using v8::HandleScope;
 using v8::HeapSnapshot;
+using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
@@ -308,6 +315,93 @@ class HeapSnapshotStream : public AsyncWrap,
   HeapSnapshotPointer snapshot_;
 };
 
+// Tracks a heap snapshot that is being written to disk in the background.
+// `oncomplete(status, filename)` is called on the JS object once the file
+// has been fully written and closed.
+class HeapSnapshotWriteWrap final : public AsyncWrap {
+ public:
+  HeapSnapshotWriteWrap(Environment* env, Local<Object> obj)
+      : AsyncWrap(env, obj, AsyncWrap::PROVIDER_HEAPSNAPSHOT) {}
+
+  ~HeapSnapshotWriteWrap() override {
+    // Wait for the writer when the Environment is torn down mid-write, the
+    // async handle must outlive the thread that signals it.
+    writer_.reset();
+    if (async_ != nullptr) {
+      env()->CloseHandle(async_, [](uv_async_t* handle) { delete handle; });
+    }
+  }
+
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    CHECK(args.IsConstructCall());
+    Environment* env = Environment::GetCurrent(args);
+    new HeapSnapshotWriteWrap(env, args.This());
+  }
+
+  // On failure, `*syscall` is set to the name of the call that failed and
+  // `fd` is left open.
+  int Start(uv_file fd,
+            bool compress,
+            const std::string& filename,
+            const char** syscall) {
+    CHECK_NULL(writer_);
+    filename_ = filename;
+    async_ = new uv_async_t;
+    int err = uv_async_init(env()->event_loop(), async_, AfterWrite);
+    if (err != 0) {
+      delete async_;
+      async_ = nullptr;
+      *syscall = "uv_async_init";
+      return err;
+    }
+    async_->data = this;
+    uv_async_t* async = async_;
+    writer_ = std::make_unique<HeapSnapshotFileWriter>(
+        fd, compress, [async]() { uv_async_send(async); });
+    err = writer_->Start(syscall);
+    if (err != 0) {
+      writer_.reset();
+      env()->CloseHandle(async_, [](uv_async_t* handle) { delete handle; });
+      async_ = nullptr;
+    }
+    return err;
+  }
+
+  HeapSnapshotFileWriter* writer() const { return writer_.get(); }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackField("filename", filename_);
+  }
+
+  SET_MEMORY_INFO_NAME(HeapSnapshotWriteWrap)
+  SET_SELF_SIZE(HeapSnapshotWriteWrap)
+
+ private:
+  static void AfterWrite(uv_async_t* handle) {
+    std::unique_ptr<HeapSnapshotWriteWrap> self(
+        static_cast<HeapSnapshotWriteWrap*>(handle->data));
+    Environment* env = self->env();
+    int status = self->writer_->Join();
+    self->writer_.reset();
+
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+    Local<Value> argv[] = {
+      Integer::New(env->isolate(), status),
+      Undefined(env->isolate())
+    };
+    if (!String::NewFromUtf8(env->isolate(), self->filename_.c_str())
+             .ToLocal(&argv[1])) {
+      return;
+    }
+    self->MakeCallback(env->oncomplete_string(), arraysize(argv), argv);
+  }
+
+  std::unique_ptr<HeapSnapshotFileWriter> writer_;
+  uv_async_t* async_ = nullptr;
+  std::string filename_;
+};
+
 inline void TakeSnapshot(Environment* env, v8::OutputStream* out) {
   HeapSnapshotPointer snapshot {
       env->isolate()->GetHeapProfiler()->TakeHeapSnapshot() };
@@ -394,6 +488,165 @@ void TriggerHeapSnapshot(const FunctionCallbackInfo<Value>& args) {
   return args.GetReturnValue().Set(filename_v);
 }
 
+// triggerHeapSnapshotAsync(req, filename, compress) takes the snapshot
+// synchronously, but leaves compressing and writing it to a background thread,
+// calling req.oncomplete(status, filename) when done. Returns the filename.
+void TriggerHeapSnapshotAsync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = args.GetIsolate();
+
+  CHECK(args[0]->IsObject());
+  HeapSnapshotWriteWrap* req_wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&req_wrap, args[0].As<Object>());
+  bool compress = args[2]->IsTrue();
+
+  std::string filename;
+  if (args[1]->IsUndefined()) {
+    DiagnosticFilename name(
+        env, "Heap", compress ? "heapsnapshot.gz" : "heapsnapshot");
+    filename = *name;
+  } else {
+    BufferValue path(isolate, args[1]);
+    CHECK_NOT_NULL(*path);
+    filename = *path;
+  }
+
+  uv_fs_t req;
+  int fd = uv_fs_open(nullptr,
+                      &req,
+                      filename.c_str(),
+                      O_WRONLY | O_CREAT | O_TRUNC,
+                      0644,
+                      nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0) {
+    return env->ThrowUVException(fd, "open", nullptr, filename.c_str());
+  }
+
+  const char* syscall = nullptr;
+  int err = req_wrap->Start(fd, compress, filename, &syscall);
+  if (err != 0) {
+    uv_fs_close(nullptr, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    // Nothing is going to call oncomplete, so nothing else frees it.
+    delete req_wrap;
+    return env->ThrowUVException(err, syscall);
+  }
+
+  TakeSnapshot(env, req_wrap->writer());
+  req_wrap->writer()->Close();
+
+  Local<Value> ret;
+  if (String::NewFromUtf8(isolate, filename.c_str()).ToLocal(&ret))
+    args.GetReturnValue().Set(ret);
+}
+
+// startSamplingHeapProfiler(interval, depth) returns false if sampling was
+// already running, whoever started it. stopSamplingHeapProfiler() only stops
+// a session that was started here, so that it doesn't cut short --heap-prof.
+void StartSamplingHeapProfiler(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[1]->IsInt32());
+  if (!IsSafeJsInt(args[0]) || args[0].As<Number>()->Value() <= 0) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "The sampling interval must be a positive integer");
+  }
+  uint64_t sample_interval =
+      static_cast<uint64_t>(args[0].As<Number>()->Value());
+  int stack_depth = args[1].As<v8::Int32>()->Value();
+  bool started = env->isolate()->GetHeapProfiler()->StartSamplingHeapProfiler(
+      sample_interval, stack_depth);
+  if (started) env->set_owns_sampling_heap_profiler(true);
+  args.GetReturnValue().Set(started);
+}
+
+void StopSamplingHeapProfiler(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (!env->owns_sampling_heap_profiler())
+    return args.GetReturnValue().Set(false);
+  env->isolate()->GetHeapProfiler()->StopSamplingHeapProfiler();
+  env->set_owns_sampling_heap_profiler(false);
+  args.GetReturnValue().Set(true);
+}
+
+namespace {
+struct AllocationSite {
+  const AllocationProfile::Node* node;
+  double self_size;
+  double self_count;
+};
+}  // namespace
+
+// getAllocationSites(limit) returns the `limit` allocation sites with the
+// most live sampled bytes as a flat array of
+// [name, scriptName, line, column, selfSize, selfCount, ...] tuples.
+// Sites that show up under several call paths are merged, so unlike the
+// inspector's profile, no tree is materialized in JS.
+void GetAllocationSites(const FunctionCallbackInfo<Value>& args) {
+  static constexpr size_t kFieldsPerSite = 6;
+  Isolate* isolate = args.GetIsolate();
+  CHECK(args[0]->IsUint32());
+  size_t limit = args[0].As<v8::Uint32>()->Value();
+
+  std::unique_ptr<AllocationProfile> profile(
+      isolate->GetHeapProfiler()->GetAllocationProfile());
+  if (!profile) return;  // The sampling heap profiler is not running.
+
+  // JS functions are identified by their position in the script, builtins
+  // and other synthetic nodes by their name.
+  std::map<std::pair<int, int>, AllocationSite> script_sites;
+  std::map<std::string, AllocationSite> native_sites;
+  std::vector<const AllocationProfile::Node*> stack = {profile->GetRootNode()};
+  while (!stack.empty()) {
+    const AllocationProfile::Node* node = stack.back();
+    stack.pop_back();
+    for (const AllocationProfile::Node* child : node->children)
+      stack.push_back(child);
+    if (node->allocations.empty()) continue;
+
+    AllocationSite* site;
+    if (node->script_id != v8::UnboundScript::kNoScriptId) {
+      auto key = std::make_pair(node->script_id, node->start_position);
+      site = &script_sites.emplace(key, AllocationSite{node, 0, 0})
+                  .first->second;
+    } else {
+      Utf8Value name(isolate, node->name);
+      site = &native_sites.emplace(*name, AllocationSite{node, 0, 0})
+                  .first->second;
+    }
+    for (const AllocationProfile::Allocation& allocation : node->allocations) {
+      site->self_size +=
+          static_cast<double>(allocation.size) * allocation.count;
+      site->self_count += allocation.count;
+    }
+  }
+
+  std::vector<AllocationSite> sites;
+  sites.reserve(script_sites.size() + native_sites.size());
+  for (const auto& it : script_sites) sites.push_back(it.second);
+  for (const auto& it : native_sites) sites.push_back(it.second);
+  limit = std::min(limit, sites.size());
+  std::partial_sort(sites.begin(),
+                    sites.begin() + limit,
+                    sites.end(),
+                    [](const AllocationSite& a, const AllocationSite& b) {
+                      return a.self_size > b.self_size;
+                    });
+
+  std::vector<Local<Value>> result;
+  result.reserve(limit * kFieldsPerSite);
+  for (size_t i = 0; i < limit; i++) {
+    const AllocationSite& site = sites[i];
+    result.push_back(site.node->name);
+    result.push_back(site.node->script_name);
+    result.push_back(Integer::New(isolate, site.node->line_number));
+    result.push_back(Integer::New(isolate, site.node->column_number));
+    result.push_back(Number::New(isolate, site.self_size));
+    result.push_back(Number::New(isolate, site.self_count));
+  }
+  args.GetReturnValue().Set(Array::New(isolate, result.data(), result.size()));
+}
+
 void Initialize(Local<Object> target,
                 Local<Value> unused,
                 Local<Context> context,
@@ -402,13 +655,30 @@ void Initialize(Local<Object> target,
 
   env->SetMethod(target, "buildEmbedderGraph", BuildEmbedderGraph);
   env->SetMethod(target, "triggerHeapSnapshot", TriggerHeapSnapshot);
+  env->SetMethod(target, "triggerHeapSnapshotAsync", TriggerHeapSnapshotAsync);
   env->SetMethod(target, "createHeapSnapshotStream", CreateHeapSnapshotStream);
+  env->SetMethod(
+      target, "startSamplingHeapProfiler", StartSamplingHeapProfiler);
+  env->SetMethod(target, "stopSamplingHeapProfiler", StopSamplingHeapProfiler);
+  env->SetMethod(target, "getAllocationSites", GetAllocationSites);
+
+  Local<FunctionTemplate> hswt =
+      env->NewFunctionTemplate(HeapSnapshotWriteWrap::New);
+  hswt->InstanceTemplate()->SetInternalFieldCount(
+      HeapSnapshotWriteWrap::kInternalFieldCount);
+  hswt->Inherit(AsyncWrap::GetConstructorTemplate(env));
+  env->SetConstructorFunction(target, "HeapSnapshotWriteWrap", hswt);
 }
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(BuildEmbedderGraph);
   registry->Register(TriggerHeapSnapshot);
+  registry->Register(TriggerHeapSnapshotAsync);
   registry->Register(CreateHeapSnapshotStream);
+  registry->Register(StartSamplingHeapProfiler);
+  registry->Register(StopSamplingHeapProfiler);
+  registry->Register(GetAllocationSites);
+  registry->Register(HeapSnapshotWriteWrap::New);
 }
 
 }  // namespace heap
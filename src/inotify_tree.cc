@@ -0,0 +1,226 @@
+#include "inotify_tree.h"
+
+#ifdef __linux__
+
+#include "memory_tracker-inl.h"
+#include "util-inl.h"
+
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace node {
+namespace fs {
+
+namespace {
+
+// The same events that libuv watches for.
+constexpr uint32_t kWatchMask = IN_ATTRIB | IN_CREATE | IN_MODIFY |
+                                IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+constexpr uint32_t kChangeMask = IN_ATTRIB | IN_MODIFY;
+constexpr uint32_t kRenameMask = IN_CREATE | IN_DELETE | IN_DELETE_SELF |
+                                 IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO;
+
+// Errors for a directory below the root that may have been removed or
+// replaced by something else after it was found, or that may not be
+// readable. The directory is skipped. Anything else, like running out of
+// watches (ENOSPC) or memory, fails the whole operation.
+bool IsSkippableError(int err) {
+  return err == ENOENT || err == ENOTDIR || err == EACCES;
+}
+
+std::string JoinPath(const std::string& dir, const char* name) {
+  if (dir.empty())
+    return name;
+  return dir + "/" + name;
+}
+
+}  // anonymous namespace
+
+InotifyTree::InotifyTree(std::string root) : root_(std::move(root)) {}
+
+InotifyTree::~InotifyTree() {
+  if (fd_ != -1)
+    CHECK_EQ(close(fd_), 0);
+}
+
+int InotifyTree::Start() {
+  CHECK_EQ(fd_, -1);
+  fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd_ == -1)
+    return uv_translate_sys_error(errno);
+  return AddWatches(std::string(), false);
+}
+
+std::string InotifyTree::FullPath(const std::string& path) const {
+  if (path.empty())
+    return root_;
+  return root_ + "/" + path;
+}
+
+int InotifyTree::AddWatches(const std::string& path, bool report) {
+  std::vector<std::string> pending { path };
+  while (!pending.empty()) {
+    std::string dir = std::move(pending.back());
+    pending.pop_back();
+
+    const std::string full_path = FullPath(dir);
+    uint32_t mask = kWatchMask;
+    if (!dir.empty())
+      mask |= IN_DONT_FOLLOW;
+    int wd = inotify_add_watch(fd_, full_path.c_str(), mask);
+    if (wd == -1) {
+      if (dir.empty() || !IsSkippableError(errno))
+        return uv_translate_sys_error(errno);
+      continue;
+    }
+    // The same directory may come back under a different path after it
+    // was moved, in which case the kernel returns the same descriptor.
+    auto it = watches_.find(wd);
+    if (it != watches_.end())
+      watch_descriptors_.erase(it->second);
+    watches_[wd] = dir;
+    watch_descriptors_[dir] = wd;
+
+    DIR* stream = opendir(full_path.c_str());
+    if (stream == nullptr) {
+      if (!IsSkippableError(errno))
+        return uv_translate_sys_error(errno);
+      continue;
+    }
+    while (const struct dirent* ent = readdir(stream)) {
+      if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+        continue;
+      std::string child = JoinPath(dir, ent->d_name);
+      bool is_dir = ent->d_type == DT_DIR;
+      if (ent->d_type == DT_UNKNOWN) {
+        struct stat s;
+        is_dir = lstat(FullPath(child).c_str(), &s) == 0 && S_ISDIR(s.st_mode);
+      }
+      if (report)
+        AddEvent(child, UV_RENAME);
+      if (is_dir)
+        pending.emplace_back(std::move(child));
+    }
+    closedir(stream);
+  }
+  return 0;
+}
+
+void InotifyTree::RemoveWatches(const std::string& path) {
+  const std::string prefix = path + "/";
+  std::vector<int> removed;
+  for (const auto& entry : watch_descriptors_) {
+    if (entry.first == path ||
+        entry.first.compare(0, prefix.size(), prefix) == 0) {
+      removed.push_back(entry.second);
+    }
+  }
+  for (int wd : removed) {
+    inotify_rm_watch(fd_, wd);
+    ForgetWatch(wd);
+  }
+}
+
+void InotifyTree::ForgetWatch(int wd) {
+  auto it = watches_.find(wd);
+  if (it == watches_.end())
+    return;
+  auto path_it = watch_descriptors_.find(it->second);
+  if (path_it != watch_descriptors_.end() && path_it->second == wd)
+    watch_descriptors_.erase(path_it);
+  watches_.erase(it);
+}
+
+void InotifyTree::AddEvent(const std::string& path, int events) {
+  auto it = event_index_.find(path);
+  if (it != event_index_.end()) {
+    events_[it->second].events |= events;
+    return;
+  }
+  event_index_.emplace(path, events_.size());
+  events_.push_back(Event { path, events });
+}
+
+int InotifyTree::ReadEvents() {
+  alignas(struct inotify_event) char buf[16 * 1024];
+  int watch_err = 0;
+  for (;;) {
+    ssize_t nread = read(fd_, buf, sizeof(buf));
+    if (nread == -1) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return watch_err;
+      return uv_translate_sys_error(errno);
+    }
+
+    const char* p = buf;
+    while (p < buf + nread) {
+      const struct inotify_event* ev =
+          reinterpret_cast<const struct inotify_event*>(p);
+      p += sizeof(*ev) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {
+        AddEvent(std::string(), UV_RENAME);
+        continue;
+      }
+      auto it = watches_.find(ev->wd);
+      if (it == watches_.end())
+        continue;
+      if (ev->mask & IN_IGNORED) {
+        ForgetWatch(ev->wd);
+        continue;
+      }
+
+      const std::string path =
+          ev->len > 0 ? JoinPath(it->second, ev->name) : it->second;
+      int events = 0;
+      if (ev->mask & kChangeMask)
+        events |= UV_CHANGE;
+      if (ev->mask & kRenameMask)
+        events |= UV_RENAME;
+      if (events != 0)
+        AddEvent(path, events);
+
+      // A directory's own IN_DELETE_SELF and IN_IGNORED take care of its
+      // watch when it is deleted, but one that is moved away keeps it.
+      if ((ev->mask & IN_ISDIR) && ev->len > 0) {
+        if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+          int err = AddWatches(path, true);
+          if (err != 0 && watch_err == 0)
+            watch_err = err;
+        } else if (ev->mask & IN_MOVED_FROM) {
+          RemoveWatches(path);
+        }
+      }
+    }
+
+    // Whatever else was read is merged, but the tree is no longer fully
+    // watched.
+    if (watch_err != 0)
+      return watch_err;
+  }
+}
+
+std::vector<InotifyTree::Event> InotifyTree::TakeEvents() {
+  std::vector<Event> events;
+  events.swap(events_);
+  event_index_.clear();
+  return events;
+}
+
+void InotifyTree::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize(
+      "watches", watches_.size() * 2 * (sizeof(int) + sizeof(std::string)));
+  tracker->TrackFieldWithSize("events", events_.size() * sizeof(Event));
+}
+
+}  // namespace fs
+}  // namespace node
+
+#endif  // __linux__
@@ -0,0 +1,107 @@
+#ifndef SRC_INOTIFY_TREE_H_
+#define SRC_INOTIFY_TREE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#ifdef __linux__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memory_tracker.h"
+#include "uv.h"
+
+namespace node {
+namespace fs {
+
+// Watches a whole directory tree through a single inotify instance, for
+// recursive fs.watch() on Linux, where libuv only watches one directory per
+// uv_fs_event_t. Every directory in the tree gets a watch descriptor.
+// Directories that are created or moved into the tree are watched as they
+// appear, and their contents are reported, since they may have been written
+// before the watch was in place. Watches of directories that are deleted or
+// moved out of the tree are dropped. Symbolic links are not followed, except
+// for the root.
+//
+// Events are merged per path until they are taken, so a burst of writes to a
+// file turns into a single UV_CHANGE. Paths are relative to the root; events
+// on the root itself, and the one reported when the kernel queue overflowed,
+// have an empty path.
+//
+// The owner polls fd() for readability and calls ReadEvents() when it is.
+//
+// Directories are watched and listed synchronously, on the thread that calls
+// Start() or ReadEvents(), which for fs.watch() is the loop thread. That is
+// one inotify_add_watch() plus a full readdir() per directory, so starting to
+// watch a tree of many thousands of directories, or one of that size being
+// moved into the watched tree, blocks the loop for as long as the walk takes.
+// Doing the walk elsewhere would not help much: the watches have to be in
+// place before events are read, or events that happen in between are lost.
+class InotifyTree : public MemoryRetainer {
+ public:
+  struct Event {
+    std::string path;
+    // UV_RENAME and/or UV_CHANGE.
+    int events;
+  };
+
+  explicit InotifyTree(std::string root);
+  ~InotifyTree() override;
+
+  // Creates the inotify instance and watches the tree. Fails with
+  // UV_ENOTDIR if the root is not a directory, and with UV_ENOSPC if the
+  // tree needs more watches than the inotify limits allow. Directories below
+  // the root that disappear or cannot be read during the walk are skipped.
+  int Start();
+
+  // Non-blocking. Only valid after a successful Start().
+  int fd() const { return fd_; }
+
+  // Reads everything that is queued on fd() and merges it into the pending
+  // events. Fails like Start() if a directory that appeared in the tree
+  // cannot be watched, after which the tree is only partially watched.
+  int ReadEvents();
+
+  bool has_events() const { return !events_.empty(); }
+  // Returns the pending events in the order in which their paths were first
+  // seen.
+  std::vector<Event> TakeEvents();
+
+  size_t watch_count() const { return watches_.size(); }
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(InotifyTree)
+  SET_SELF_SIZE(InotifyTree)
+
+  InotifyTree(const InotifyTree&) = delete;
+  InotifyTree& operator=(const InotifyTree&) = delete;
+
+ private:
+  // Watches the directory at `path` and everything below it. With `report`,
+  // every entry found is also reported as UV_RENAME. Stops at the first
+  // error that is not caused by a directory going away or being unreadable.
+  int AddWatches(const std::string& path, bool report);
+  // Drops the watches of `path` and everything below it.
+  void RemoveWatches(const std::string& path);
+  void ForgetWatch(int wd);
+  void AddEvent(const std::string& path, int events);
+  std::string FullPath(const std::string& path) const;
+
+  const std::string root_;
+  int fd_ = -1;
+  // Watch descriptor to the directory's path, and back.
+  std::unordered_map<int, std::string> watches_;
+  std::unordered_map<std::string, int> watch_descriptors_;
+  std::vector<Event> events_;
+  // Index into events_ by path.
+  std::unordered_map<std::string, size_t> event_index_;
+};
+
+}  // namespace fs
+}  // namespace node
+
+#endif  // __linux__
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_INOTIFY_TREE_H_
@@ -7,6 +7,9 @@
 #include "node_external_reference.h"
 #include "node_file.h"
 #include "node_internals.h"
+#include "pprof_utils.h"
+#include "threadpoolwork-inl.h"
+#include "timer_wrap-inl.h"
 #include "util-inl.h"
 #include "v8-inspector.h"
 
@@ -18,6 +21,10 @@ namespace profiler {
 
 using errors::TryCatchScope;
 using v8::Context;
+using v8::CpuProfile;
+using v8::CpuProfileNode;
+using v8::CpuProfilingOptions;
+using v8::CpuProfilingStatus;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::HandleScope;
@@ -349,6 +356,230 @@ void V8CpuProfilerConnection::End() {
   DispatchMessage("Profiler.stop", nullptr, true);
 }
 
+// Add one pprof sample per node of the profile tree that has been hit,
+// using the path from the root as the call stack.
+static void AddCpuProfileSamples(const CpuProfileNode* node,
+                                 int64_t period_ns,
+                                 std::vector<uint64_t>* stack,
+                                 pprof::ProfileBuilder* builder) {
+  const char* name = node->GetFunctionNameStr();
+  uint64_t function_id = builder->AddFunction(
+      name[0] == '\0' ? "(anonymous)" : name,
+      node->GetScriptResourceNameStr(),
+      node->GetLineNumber());
+  stack->push_back(builder->AddLocation(function_id, node->GetLineNumber()));
+
+  unsigned hit_count = node->GetHitCount();
+  if (hit_count > 0) {
+    // pprof expects the leaf first.
+    std::vector<uint64_t> locations(stack->rbegin(), stack->rend());
+    unsigned line_count = node->GetHitLineCount();
+    std::vector<CpuProfileNode::LineTick> ticks(line_count);
+    if (line_count > 0 && node->GetLineTicks(ticks.data(), line_count)) {
+      // Attribute the self samples to the lines that were executing.
+      for (const CpuProfileNode::LineTick& tick : ticks) {
+        locations[0] = builder->AddLocation(function_id, tick.line);
+        int64_t count = tick.hit_count;
+        builder->AddSample(locations, {count, count * period_ns});
+      }
+    } else {
+      int64_t count = hit_count;
+      builder->AddSample(locations, {count, count * period_ns});
+    }
+  }
+
+  int children = node->GetChildrenCount();
+  for (int i = 0; i < children; i++)
+    AddCpuProfileSamples(node->GetChild(i), period_ns, stack, builder);
+  stack->pop_back();
+}
+
+static bool WritePprofProfile(const pprof::ProfileBuilder& builder,
+                              const std::string& directory,
+                              const std::string& path) {
+  std::string compressed;
+  if (!pprof::GzipCompress(builder.Serialize(), &compressed)) {
+    fprintf(stderr, "Failed to compress CPU profile %s\n", path.c_str());
+    return false;
+  }
+  if (!EnsureDirectory(directory, "CPU")) {
+    return false;
+  }
+  uv_buf_t buf = uv_buf_init(&compressed[0], compressed.size());
+  int ret = WriteFileSync(path.c_str(), buf);
+  if (ret != 0) {
+    char err_buf[128];
+    uv_err_name_r(ret, err_buf, sizeof(err_buf));
+    fprintf(stderr, "%s: Failed to write file %s\n", err_buf, path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Serializes, compresses and writes a profile on the thread pool, and
+// removes the profile that fell out of the retention window, if any.
+class CpuProfileWriteJob final : public ThreadPoolWork {
+ public:
+  CpuProfileWriteJob(Environment* env,
+                     std::unique_ptr<pprof::ProfileBuilder> builder,
+                     std::string directory,
+                     std::string path,
+                     std::string stale_path)
+      : ThreadPoolWork(env),
+        builder_(std::move(builder)),
+        directory_(std::move(directory)),
+        path_(std::move(path)),
+        stale_path_(std::move(stale_path)) {}
+
+  void DoThreadPoolWork() override {
+    written_ = WritePprofProfile(*builder_, directory_, path_);
+    if (!stale_path_.empty()) {
+      uv_fs_t req;
+      uv_fs_unlink(nullptr, &req, stale_path_.c_str(), nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<CpuProfileWriteJob> self(this);
+    if (written_) {
+      Debug(env(),
+            DebugCategory::INSPECTOR_PROFILER,
+            "Written continuous CPU profile to %s\n",
+            path_);
+    }
+  }
+
+ private:
+  std::unique_ptr<pprof::ProfileBuilder> builder_;
+  std::string directory_;
+  std::string path_;
+  std::string stale_path_;
+  bool written_ = false;
+};
+
+ContinuousCpuProfiler::ContinuousCpuProfiler(Environment* env) : env_(env) {}
+
+ContinuousCpuProfiler::~ContinuousCpuProfiler() {
+  // Disposing the profiler also deletes any profile still being recorded.
+  if (profiler_ != nullptr) {
+    profiler_->Dispose();
+  }
+}
+
+void ContinuousCpuProfiler::Start() {
+  CHECK_NULL(profiler_);
+  profiler_ = v8::CpuProfiler::New(env_->isolate());
+  profiler_->SetSamplingInterval(env_->cpu_prof_interval());
+  StartProfile();
+
+  uint64_t period_ms = env_->options()->cpu_prof_continuous_period * 1000;
+  timer_ = std::make_unique<TimerWrapHandle>(env_, [this]() {
+    Rotate(false);
+  });
+  timer_->Update(period_ms, period_ms);
+  // Profiling should not keep the process alive.
+  timer_->Unref();
+}
+
+void ContinuousCpuProfiler::StartProfile() {
+  Isolate* isolate = env_->isolate();
+  HandleScope handle_scope(isolate);
+  profile_title_ = SPrintF("continuous-cpu-profile-%s", ++profile_count_);
+  CpuProfilingStatus status = profiler_->StartProfiling(
+      OneByteString(isolate, profile_title_.c_str()),
+      CpuProfilingOptions(v8::kLeafNodeLineNumbers));
+  if (status != CpuProfilingStatus::kStarted) {
+    fprintf(stderr,
+            "Failed to start continuous CPU profile %s\n",
+            profile_title_.c_str());
+  }
+  profile_start_us_ = GetCurrentTimeInMicroseconds();
+}
+
+void ContinuousCpuProfiler::Rotate(bool ending) {
+  Isolate* isolate = env_->isolate();
+  HandleScope handle_scope(isolate);
+  std::string title = profile_title_;
+  double start_us = profile_start_us_;
+  if (!ending) {
+    StartProfile();
+  }
+
+  CpuProfile* profile =
+      profiler_->StopProfiling(OneByteString(isolate, title.c_str()));
+  if (profile == nullptr) {
+    return;
+  }
+  double end_us = GetCurrentTimeInMicroseconds();
+
+  int64_t period_ns = static_cast<int64_t>(env_->cpu_prof_interval()) * 1000;
+  auto builder = std::make_unique<pprof::ProfileBuilder>();
+  builder->AddSampleType("samples", "count");
+  builder->AddSampleType("cpu", "nanoseconds");
+  builder->SetPeriodType("cpu", "nanoseconds");
+  builder->set_period(period_ns);
+  builder->set_time_nanos(static_cast<int64_t>(start_us * 1000));
+  builder->set_duration_nanos(static_cast<int64_t>((end_us - start_us) * 1000));
+
+  // The root node is synthetic and does not belong in the stacks.
+  const CpuProfileNode* root = profile->GetTopDownRoot();
+  std::vector<uint64_t> stack;
+  for (int i = 0; i < root->GetChildrenCount(); i++)
+    AddCpuProfileSamples(root->GetChild(i), period_ns, &stack, builder.get());
+  profile->Delete();
+
+  if (builder->sample_count() == 0) {
+    Debug(env_,
+          DebugCategory::INSPECTOR_PROFILER,
+          "Skipping empty continuous CPU profile %s\n",
+          title.c_str());
+    return;
+  }
+
+  std::string directory = env_->cpu_prof_dir();
+  DiagnosticFilename filename(env_, "CPU", "pb.gz");
+  std::string path = directory + kPathSeparator + *filename;
+
+  std::string stale_path;
+  written_files_.push_back(path);
+  uint64_t max_files = env_->options()->cpu_prof_continuous_max_files;
+  if (max_files > 0 && written_files_.size() > max_files) {
+    stale_path = std::move(written_files_.front());
+    written_files_.pop_front();
+  }
+
+  if (ending) {
+    // The event loop is not going to run anymore.
+    WritePprofProfile(*builder, directory, path);
+    if (!stale_path.empty()) {
+      uv_fs_t req;
+      uv_fs_unlink(nullptr, &req, stale_path.c_str(), nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+    return;
+  }
+
+  CpuProfileWriteJob* job = new CpuProfileWriteJob(env_,
+                                                   std::move(builder),
+                                                   std::move(directory),
+                                                   std::move(path),
+                                                   std::move(stale_path));
+  job->ScheduleWork();
+}
+
+void ContinuousCpuProfiler::End() {
+  Debug(env_,
+        DebugCategory::INSPECTOR_PROFILER,
+        "ContinuousCpuProfiler::End(), ending = %d\n", ending_);
+  if (ending_ || profiler_ == nullptr) {
+    return;
+  }
+  ending_ = true;
+  timer_.reset();
+  Rotate(true);
+}
+
 std::string V8HeapProfilerConnection::GetDirectory() const {
   return env()->heap_prof_dir();
 }
@@ -411,6 +642,11 @@ static void EndStartedProfilers(Environment* env) {
   if (connection != nullptr) {
     connection->End();
   }
+
+  ContinuousCpuProfiler* continuous_profiler = env->continuous_cpu_profiler();
+  if (continuous_profiler != nullptr) {
+    continuous_profiler->End();
+  }
 }
 
 void StartProfilers(Environment* env) {
@@ -442,6 +678,15 @@ void StartProfilers(Environment* env) {
         std::make_unique<V8CpuProfilerConnection>(env));
     env->cpu_profiler_connection()->Start();
   }
+  if (env->options()->cpu_prof_continuous) {
+    const std::string& dir = env->options()->cpu_prof_dir;
+    env->set_cpu_prof_interval(env->options()->cpu_prof_interval);
+    env->set_cpu_prof_dir(dir.empty() ? env->GetCwd() : dir);
+    CHECK_NULL(env->continuous_cpu_profiler());
+    env->set_continuous_cpu_profiler(
+        std::make_unique<ContinuousCpuProfiler>(env));
+    env->continuous_cpu_profiler()->Start();
+  }
   if (env->options()->heap_prof) {
     const std::string& dir = env->options()->heap_prof_dir;
     env->set_heap_prof_interval(env->options()->heap_prof_interval);
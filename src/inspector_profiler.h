@@ -7,12 +7,15 @@
 #error("This header can only be used when inspector is enabled")
 #endif
 
+#include <deque>
 #include <unordered_set>
 #include "inspector_agent.h"
+#include "v8-profiler.h"
 
 namespace node {
 // Forward declaration to break recursive dependency chain with src/env.h.
 class Environment;
+class TimerWrapHandle;
 
 namespace profiler {
 
@@ -122,6 +125,43 @@ class V8CpuProfilerConnection : public V8ProfilerConnection {
   bool ending_ = false;
 };
 
+// Drives v8::CpuProfiler directly instead of going through an inspector
+// session, so that no JSON is produced. Every `period` seconds, the samples
+// collected so far are aggregated natively and written to disk as a gzipped
+// pprof profile off the main thread, and only the most recent `max_files`
+// profiles are kept.
+class ContinuousCpuProfiler {
+ public:
+  explicit ContinuousCpuProfiler(Environment* env);
+  ~ContinuousCpuProfiler();
+
+  ContinuousCpuProfiler(const ContinuousCpuProfiler&) = delete;
+  ContinuousCpuProfiler& operator=(const ContinuousCpuProfiler&) = delete;
+
+  void Start();
+  // Stop profiling and synchronously write the last profile.
+  void End();
+
+  Environment* env() const { return env_; }
+  bool ending() const { return ending_; }
+
+ private:
+  void StartProfile();
+  // Stop the current profile and write it out. Unless `ending` is set, a new
+  // profile is started before the current one is stopped so that no samples
+  // are lost between the two.
+  void Rotate(bool ending);
+
+  Environment* env_;
+  v8::CpuProfiler* profiler_ = nullptr;
+  std::unique_ptr<TimerWrapHandle> timer_;
+  std::string profile_title_;
+  double profile_start_us_ = 0;
+  uint32_t profile_count_ = 0;
+  std::deque<std::string> written_files_;
+  bool ending_ = false;
+};
+
 class V8HeapProfilerConnection : public V8ProfilerConnection {
  public:
   explicit V8HeapProfilerConnection(Environment* env)
@@ -1,7 +1,156 @@
 #include "json_utils.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace node {
 
+namespace {
+
+// Returns the first byte in [p, end) that is one of kChars, or end. Most of
+// a package.json is string contents and nested values, which are skipped
+// 16 bytes at a time where SIMD is available.
+template <char... kChars>
+inline const char* FindFirstOf(const char* p, const char* end) {
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i match = _mm_setzero_si128();
+    ((match = _mm_or_si128(match,
+                           _mm_cmpeq_epi8(chunk, _mm_set1_epi8(kChars)))),
+     ...);
+    int mask = _mm_movemask_epi8(match);
+    if (mask != 0) return p + __builtin_ctz(mask);
+    p += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (end - p >= 16) {
+    uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t match = vdupq_n_u8(0);
+    ((match = vorrq_u8(match, vceqq_u8(chunk, vdupq_n_u8(kChars)))), ...);
+    // Let the scalar loop find the exact position within this block.
+    if (vmaxvq_u8(match) != 0) break;
+    p += 16;
+  }
+#endif
+  for (; p < end; p++) {
+    if (((*p == kChars) || ...)) return p;
+  }
+  return end;
+}
+
+inline bool IsJSONWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline const char* SkipWhitespace(const char* p, const char* end) {
+  while (p < end && IsJSONWhitespace(*p)) p++;
+  return p;
+}
+
+// `p` points after the opening quote. Returns the position after the
+// closing quote, or nullptr if the string is unterminated.
+const char* SkipString(const char* p, const char* end) {
+  for (;;) {
+    p = FindFirstOf<'"', '\\'>(p, end);
+    if (p == end) return nullptr;
+    if (*p == '"') return p + 1;
+    p += 2;  // Skip the escaped character.
+    if (p >= end) return nullptr;
+  }
+}
+
+// Returns the position after the value starting at `p`, or nullptr if
+// the value is malformed.
+const char* SkipValue(const char* p, const char* end) {
+  if (p == end) return nullptr;
+  if (*p == '"') return SkipString(p + 1, end);
+
+  if (*p == '{' || *p == '[') {
+    size_t depth = 0;
+    for (;;) {
+      p = FindFirstOf<'"', '{', '}', '[', ']'>(p, end);
+      if (p == end) return nullptr;
+      switch (*p) {
+        case '"':
+          p = SkipString(p + 1, end);
+          if (p == nullptr) return nullptr;
+          continue;
+        case '{':
+        case '[':
+          depth++;
+          break;
+        default:
+          depth--;
+          break;
+      }
+      p++;
+      if (depth == 0) return p;
+    }
+  }
+
+  // A number, true, false or null.
+  const char* start = p;
+  while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+         !IsJSONWhitespace(*p)) {
+    p++;
+  }
+  return p == start ? nullptr : p;
+}
+
+}  // anonymous namespace
+
+bool ExtractJSONFields(std::string_view json,
+                       const std::vector<std::string_view>& keys,
+                       std::vector<std::string_view>* values) {
+  values->assign(keys.size(), std::string_view());
+
+  const char* p = json.data();
+  const char* const end = p + json.size();
+
+  p = SkipWhitespace(p, end);
+  if (p == end || *p++ != '{') return false;
+  p = SkipWhitespace(p, end);
+  if (p < end && *p == '}') {
+    p++;
+  } else {
+    for (;;) {
+      if (p == end || *p++ != '"') return false;
+      const char* key_start = p;
+      p = SkipString(p, end);
+      if (p == nullptr) return false;
+      std::string_view key(key_start, p - 1 - key_start);
+      if (key.find('\\') != std::string_view::npos) return false;
+
+      p = SkipWhitespace(p, end);
+      if (p == end || *p++ != ':') return false;
+      p = SkipWhitespace(p, end);
+      const char* value_start = p;
+      p = SkipValue(p, end);
+      if (p == nullptr) return false;
+
+      for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key)
+          (*values)[i] = std::string_view(value_start, p - value_start);
+      }
+
+      p = SkipWhitespace(p, end);
+      if (p == end) return false;
+      if (*p == '}') {
+        p++;
+        break;
+      }
+      if (*p++ != ',') return false;
+      p = SkipWhitespace(p, end);
+    }
+  }
+
+  return SkipWhitespace(p, end) == end;
+}
+
 std::string EscapeJsonChars(const std::string& str) {
   const std::string control_symbols[0x20] = {
       "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005",
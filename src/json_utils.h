@@ -7,12 +7,29 @@
 #include <ostream>
 #include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace node {
 
 std::string EscapeJsonChars(const std::string& str);
 std::string Reindent(const std::string& str, int indentation);
 
+// Extracts the raw JSON text of the given top-level members of the object
+// in `json` without parsing their values. (*values)[i] is set to the value
+// of keys[i], with surrounding whitespace removed, or to an empty view
+// (with a null data pointer) if there is no such member. If a key occurs
+// more than once, the last occurrence wins, as with JSON.parse().
+//
+// Only the top-level structure is validated; nested values are skipped by
+// matching brackets and quotes, so the extracted text still has to go
+// through JSON.parse(). Returns false if the input is not an object the
+// scanner understands, including objects whose keys contain escape
+// sequences, in which case the caller should fall back to a full parse.
+bool ExtractJSONFields(std::string_view json,
+                       const std::vector<std::string_view>& keys,
+                       std::vector<std::string_view>* values);
+
 // JSON compiler definitions.
 class JSONWriter {
  public:
@@ -0,0 +1,165 @@
+#include "module_stat_cache.h"
+#include "env-inl.h"
+#include "memory_tracker-inl.h"
+#include "util-inl.h"
+
+#include <vector>
+
+namespace node {
+namespace fs {
+
+namespace {
+
+std::string Dirname(const std::string& path) {
+#ifdef _WIN32
+  size_t pos = path.find_last_of("\\/");
+#else
+  size_t pos = path.find_last_of('/');
+#endif
+  if (pos == std::string::npos) return std::string();
+  if (pos == 0) return path.substr(0, 1);
+  return path.substr(0, pos);
+}
+
+}  // anonymous namespace
+
+ModuleStatCache::ModuleStatCache(Environment* env) : env_(env) {
+  env->AddCleanupHook(CleanupHook, this);
+}
+
+ModuleStatCache::~ModuleStatCache() {
+  env_->RemoveCleanupHook(CleanupHook, this);
+  Clear();
+}
+
+void ModuleStatCache::CleanupHook(void* data) {
+  static_cast<ModuleStatCache*>(data)->Clear();
+}
+
+const ModuleStatCache::Entry* ModuleStatCache::Lookup(
+    const std::string& path) const {
+  auto it = paths_.find(path);
+  if (it == paths_.end()) return nullptr;
+  auto entry = it->second->entries.find(path);
+  CHECK(entry != it->second->entries.end());
+  return &entry->second;
+}
+
+const int* ModuleStatCache::LookupStat(const std::string& path) const {
+  const Entry* entry = Lookup(path);
+  if (entry == nullptr || !entry->has_stat) return nullptr;
+  return &entry->stat;
+}
+
+const PackageJSONEntry* ModuleStatCache::LookupPackageJSON(
+    const std::string& path) const {
+  const Entry* entry = Lookup(path);
+  if (entry == nullptr || !entry->has_package_json) return nullptr;
+  return &entry->package_json;
+}
+
+void ModuleStatCache::InsertStat(const std::string& path, int result) {
+  Entry* entry = GetOrInsert(path);
+  if (entry == nullptr) return;
+  entry->has_stat = true;
+  entry->stat = result;
+}
+
+void ModuleStatCache::InsertPackageJSON(const std::string& path,
+                                        PackageJSONEntry&& package_json) {
+  Entry* entry = GetOrInsert(path);
+  if (entry == nullptr) return;
+  entry->has_package_json = true;
+  entry->package_json = std::move(package_json);
+}
+
+ModuleStatCache::Entry* ModuleStatCache::GetOrInsert(const std::string& path) {
+  auto it = paths_.find(path);
+  if (it != paths_.end()) return &it->second->entries[path];
+
+  DirectoryWatcher* watcher = GetOrStartWatcher(path);
+  if (watcher == nullptr) return nullptr;
+  paths_[path] = watcher;
+  return &watcher->entries[path];
+}
+
+ModuleStatCache::DirectoryWatcher* ModuleStatCache::GetOrStartWatcher(
+    const std::string& path) {
+  std::string directory = Dirname(path);
+  while (!directory.empty()) {
+    auto it = watchers_.find(directory);
+    if (it != watchers_.end()) return it->second;
+    if (watchers_.size() >= kMaxWatchers) return nullptr;
+
+    DirectoryWatcher* watcher = new DirectoryWatcher();
+    watcher->cache = this;
+    watcher->directory = directory;
+    CHECK_EQ(0, uv_fs_event_init(env_->event_loop(), &watcher->handle));
+    int err = uv_fs_event_start(
+        &watcher->handle, OnEvent, directory.c_str(), 0);
+    if (err == 0) {
+      // The cache must not keep the process alive.
+      uv_unref(reinterpret_cast<uv_handle_t*>(&watcher->handle));
+      watchers_[directory] = watcher;
+      return watcher;
+    }
+
+    CloseWatcher(watcher);
+    if (err != UV_ENOENT && err != UV_ENOTDIR) return nullptr;
+
+    // Watch the nearest existing ancestor instead, whose events cover the
+    // creation of the missing directories.
+    std::string parent = Dirname(directory);
+    if (parent == directory) return nullptr;
+    directory = std::move(parent);
+  }
+  return nullptr;
+}
+
+void ModuleStatCache::StopWatcher(DirectoryWatcher* watcher) {
+  for (const auto& it : watcher->entries) paths_.erase(it.first);
+  watcher->entries.clear();
+  watchers_.erase(watcher->directory);
+  CloseWatcher(watcher);
+}
+
+void ModuleStatCache::CloseWatcher(DirectoryWatcher* watcher) {
+  env_->CloseHandle(&watcher->handle, [](uv_fs_event_t* handle) {
+    DirectoryWatcher* watcher =
+        ContainerOf(&DirectoryWatcher::handle, handle);
+    delete watcher;
+  });
+}
+
+void ModuleStatCache::OnEvent(uv_fs_event_t* handle,
+                              const char* filename,
+                              int events,
+                              int status) {
+  DirectoryWatcher* watcher = ContainerOf(&DirectoryWatcher::handle, handle);
+  // Errors are handled the same way as changes: the entries can no longer
+  // be trusted.
+  watcher->cache->StopWatcher(watcher);
+}
+
+void ModuleStatCache::Clear() {
+  std::vector<DirectoryWatcher*> watchers;
+  watchers.reserve(watchers_.size());
+  for (const auto& it : watchers_) watchers.push_back(it.second);
+  for (DirectoryWatcher* watcher : watchers) StopWatcher(watcher);
+  CHECK(paths_.empty());
+}
+
+void ModuleStatCache::MemoryInfo(MemoryTracker* tracker) const {
+  size_t size = 0;
+  for (const auto& watcher : watchers_) {
+    size += sizeof(DirectoryWatcher) + watcher.first.size();
+    for (const auto& entry : watcher.second->entries) {
+      size += sizeof(Entry) + entry.first.size() +
+              entry.second.package_json.contents.size();
+    }
+  }
+  tracker->TrackFieldWithSize("entries", size);
+}
+
+}  // namespace fs
+}  // namespace node
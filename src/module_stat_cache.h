@@ -0,0 +1,101 @@
+#ifndef SRC_MODULE_STAT_CACHE_H_
+#define SRC_MODULE_STAT_CACHE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <string>
+#include <unordered_map>
+#include "memory_tracker.h"
+#include "uv.h"
+
+namespace node {
+class Environment;
+
+namespace fs {
+
+// The cached result of internalModuleReadJSON().
+struct PackageJSONEntry {
+  bool found = false;
+  std::string contents;
+  bool contains_keys = false;
+};
+
+// Caches the results of internalModuleStat() and internalModuleReadJSON()
+// for the lifetime of an Environment (see --experimental-module-stat-cache).
+// CommonJS resolution probes the same candidate paths over and over again,
+// most of which do not exist, so the cache stores negative results as well.
+//
+// Every entry is attached to a uv_fs_event_t watching its parent directory,
+// or, if that does not exist, the nearest existing ancestor. Any event on a
+// watched directory drops all entries attached to it and stops the watcher;
+// it is re-established by the next insertion. Paths for which no watcher can
+// be started are not cached. Notifications are delivered by the event loop,
+// so changes made synchronously by the current thread may only be observed
+// on the next turn of the loop; the loader can use Clear() if it needs to
+// see them earlier. Changes behind symbolic links are not tracked.
+class ModuleStatCache : public MemoryRetainer {
+ public:
+  explicit ModuleStatCache(Environment* env);
+  ~ModuleStatCache() override;
+
+  // Return nullptr if the path is not cached.
+  const int* LookupStat(const std::string& path) const;
+  const PackageJSONEntry* LookupPackageJSON(const std::string& path) const;
+
+  void InsertStat(const std::string& path, int result);
+  void InsertPackageJSON(const std::string& path, PackageJSONEntry&& entry);
+
+  // Drops all entries and stops all watchers.
+  void Clear();
+
+  size_t watcher_count() const { return watchers_.size(); }
+
+  // Upper bound on the number of watchers, to stay well within the
+  // per-user inotify limits on Linux.
+  static constexpr size_t kMaxWatchers = 1024;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(ModuleStatCache)
+  SET_SELF_SIZE(ModuleStatCache)
+
+ private:
+  struct Entry {
+    bool has_stat = false;
+    int stat = 0;
+    bool has_package_json = false;
+    PackageJSONEntry package_json;
+  };
+
+  struct DirectoryWatcher {
+    uv_fs_event_t handle;
+    ModuleStatCache* cache;
+    std::string directory;
+    // Entries attached to this watcher, keyed by their full path.
+    std::unordered_map<std::string, Entry> entries;
+  };
+
+  const Entry* Lookup(const std::string& path) const;
+  // Returns nullptr if the entry cannot be cached.
+  Entry* GetOrInsert(const std::string& path);
+  DirectoryWatcher* GetOrStartWatcher(const std::string& path);
+  void StopWatcher(DirectoryWatcher* watcher);
+  void CloseWatcher(DirectoryWatcher* watcher);
+
+  static void OnEvent(uv_fs_event_t* handle,
+                      const char* filename,
+                      int events,
+                      int status);
+  static void CleanupHook(void* data);
+
+  Environment* env_;
+  std::unordered_map<std::string, DirectoryWatcher*> watchers_;
+  // Maps each cached path to the watcher that owns its entry.
+  std::unordered_map<std::string, DirectoryWatcher*> paths_;
+};
+
+}  // namespace fs
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_MODULE_STAT_CACHE_H_
@@ -5,6 +5,7 @@
 #include "node_contextify.h"
 #include "node_errors.h"
 #include "node_internals.h"
+#include "node_mutex.h"
 #include "node_process-inl.h"
 #include "node_url.h"
 #include "node_watchdog.h"
@@ -51,6 +52,264 @@ using v8::UnboundModuleScript;
 using v8::Undefined;
 using v8::Value;
 
+// Owns the V8 streaming compilation of one module. The task runs on the
+// V8 platform's worker threads, which are meant for CPU-bound work like
+// this, instead of on the libuv thread pool that fs and dns requests share.
+// V8 pulls the source from the stream while running the task, so the file
+// is read on the same thread that parses it.
+class BackgroundModuleCompiler::Job final {
+ public:
+  Job(Environment* env,
+      const std::string& url,
+      const std::string& filename,
+      uint64_t sequence)
+      : url_(url),
+        filename_(filename),
+        sequence_(sequence),
+        state_(std::make_shared<State>()) {
+    streamed_source_ = std::make_unique<ScriptCompiler::StreamedSource>(
+        std::make_unique<SourceStream>(this),
+        ScriptCompiler::StreamedSource::UTF8);
+    task_.reset(ScriptCompiler::StartStreaming(
+        env->isolate(), streamed_source_.get(), v8::ScriptType::kModule));
+    state_->task = task_.get();
+  }
+
+  // The task refers to the job, so a worker thread must not be running it
+  // anymore when the job goes away.
+  ~Job() {
+    if (!TryCancel()) {
+      Mutex::ScopedLock lock(state_->mutex);
+      while (state_->value != State::kDone) state_->cond.Wait(lock);
+    }
+  }
+
+  void Post(v8::Platform* platform) {
+    platform->CallOnWorkerThread(std::make_unique<WorkerTask>(state_));
+  }
+
+  // Runs the streaming task, unless a worker thread already started it,
+  // in which case this waits for it to complete.
+  void Run() {
+    if (state_->Claim()) {
+      task_->Run();
+      state_->Finish();
+      return;
+    }
+    Mutex::ScopedLock lock(state_->mutex);
+    while (state_->value != State::kDone) state_->cond.Wait(lock);
+  }
+
+  // Makes sure that the task never runs. Returns false if a worker thread
+  // is running it at the moment.
+  bool TryCancel() {
+    Mutex::ScopedLock lock(state_->mutex);
+    if (state_->value == State::kPending) state_->value = State::kCancelled;
+    return state_->value != State::kRunning;
+  }
+
+  const std::string& url() const { return url_; }
+  // Jobs with lower numbers were enqueued earlier.
+  uint64_t sequence() const { return sequence_; }
+  const std::string& source() const { return source_; }
+  int read_error() const { return read_error_; }
+  ScriptCompiler::StreamedSource* streamed_source() {
+    return streamed_source_.get();
+  }
+
+ private:
+  // Shared with the task posted to the platform, which may only run after
+  // the job is gone.
+  struct State {
+    enum Value { kPending, kRunning, kDone, kCancelled };
+
+    // Returns true if the caller is the one to run the task.
+    bool Claim() {
+      Mutex::ScopedLock lock(mutex);
+      if (value != kPending) return false;
+      value = kRunning;
+      return true;
+    }
+
+    void Finish() {
+      Mutex::ScopedLock lock(mutex);
+      value = kDone;
+      cond.Broadcast(lock);
+    }
+
+    Mutex mutex;
+    ConditionVariable cond;
+    Value value = kPending;
+    // Only used by whoever claimed the task.
+    ScriptCompiler::ScriptStreamingTask* task = nullptr;
+  };
+
+  class WorkerTask final : public v8::Task {
+   public:
+    explicit WorkerTask(std::shared_ptr<State> state)
+        : state_(std::move(state)) {}
+
+    // Does nothing if the main thread got to the job first.
+    void Run() override {
+      if (!state_->Claim()) return;
+      state_->task->Run();
+      state_->Finish();
+    }
+
+   private:
+    std::shared_ptr<State> state_;
+  };
+
+  class SourceStream final : public ScriptCompiler::ExternalSourceStream {
+   public:
+    explicit SourceStream(Job* job) : job_(job) {}
+
+    size_t GetMoreData(const uint8_t** src) override {
+      if (done_) return 0;
+      done_ = true;
+      job_->read_error_ = ReadFileSync(&job_->source_, job_->filename_.c_str());
+      if (job_->read_error_ != 0 || job_->source_.empty()) return 0;
+      // V8 takes ownership of the chunk; the copy kept in the job is
+      // compared against the source the loader passes to ModuleWrap::New.
+      uint8_t* chunk = new uint8_t[job_->source_.size()];
+      memcpy(chunk, job_->source_.data(), job_->source_.size());
+      *src = chunk;
+      return job_->source_.size();
+    }
+
+   private:
+    Job* job_;
+    bool done_ = false;
+  };
+
+  std::string url_;
+  std::string filename_;
+  uint64_t sequence_;
+  std::string source_;
+  int read_error_ = 0;
+  std::unique_ptr<ScriptCompiler::StreamedSource> streamed_source_;
+  std::unique_ptr<ScriptCompiler::ScriptStreamingTask> task_;
+  std::shared_ptr<State> state_;
+};
+
+BackgroundModuleCompiler::BackgroundModuleCompiler(Environment* env)
+    : env_(env) {}
+
+// Deleting the jobs waits for the ones that are still being compiled.
+BackgroundModuleCompiler::~BackgroundModuleCompiler() = default;
+
+void BackgroundModuleCompiler::Enqueue(const std::string& url) {
+  if (jobs_.count(url) > 0 || compiled_urls_.count(url) > 0) return;
+  FreeRetiredJobs();
+
+  std::string filename = URL(url).ToFilePath();
+  if (filename.empty()) return;
+  // Other extensions are either not JavaScript or are loaded as CommonJS.
+  auto ends_with = [&](const char* suffix) {
+    size_t length = strlen(suffix);
+    return filename.size() >= length &&
+           filename.compare(filename.size() - length, length, suffix) == 0;
+  };
+  if (!ends_with(".mjs") && !ends_with(".js")) return;
+
+  if (jobs_.size() >= kMaxJobs) {
+    auto oldest = std::min_element(
+        jobs_.begin(), jobs_.end(), [](const auto& a, const auto& b) {
+          return a.second->sequence() < b.second->sequence();
+        });
+    std::unique_ptr<Job> job = std::move(oldest->second);
+    jobs_.erase(oldest);
+    DropJob(std::move(job));
+  }
+
+  auto job = std::make_unique<Job>(env_, url, filename, next_job_sequence_++);
+  job->Post(env_->isolate_data()->platform());
+  jobs_.emplace(url, std::move(job));
+}
+
+void BackgroundModuleCompiler::DropJob(std::unique_ptr<Job> job) {
+  // Try not to waste a thread on it. A job that is already running is kept
+  // until it is done, rather than waiting for it here.
+  if (!job->TryCancel()) retired_jobs_.emplace_back(std::move(job));
+}
+
+void BackgroundModuleCompiler::FreeRetiredJobs() {
+  retired_jobs_.erase(
+      std::remove_if(retired_jobs_.begin(),
+                     retired_jobs_.end(),
+                     [](const std::unique_ptr<Job>& job) {
+                       return job->TryCancel();
+                     }),
+      retired_jobs_.end());
+}
+
+void BackgroundModuleCompiler::EnqueueDependencies(Local<Module> module,
+                                                   const std::string& url) {
+  Isolate* isolate = env_->isolate();
+  Local<Context> context = env_->context();
+  Local<FixedArray> module_requests = module->GetModuleRequests();
+  URL base(url);
+
+  for (int i = 0; i < module_requests->Length(); i++) {
+    Local<ModuleRequest> module_request =
+        module_requests->Get(context, i).As<ModuleRequest>();
+    // Modules imported with assertions (e.g. JSON) are not JavaScript.
+    if (module_request->GetImportAssertions()->Length() > 0) continue;
+
+    Utf8Value specifier(isolate, module_request->GetSpecifier());
+    // Bare specifiers need the JS resolver (node_modules lookup, package
+    // exports, loader hooks, ...), leave them to the loader.
+    if (strncmp(*specifier, "./", 2) != 0 &&
+        strncmp(*specifier, "../", 3) != 0 &&
+        strncmp(*specifier, "/", 1) != 0 &&
+        strncmp(*specifier, "file:", 5) != 0) {
+      continue;
+    }
+
+    URL resolved(*specifier, base);
+    if ((resolved.flags() & URL_FLAGS_FAILED) ||
+        resolved.protocol() != "file:") {
+      continue;
+    }
+    Enqueue(resolved.href());
+  }
+}
+
+bool BackgroundModuleCompiler::Finish(const std::string& url,
+                                      Local<String> source_text,
+                                      const ScriptOrigin& origin,
+                                      MaybeLocal<Module>* module) {
+  FreeRetiredJobs();
+  if (compiled_urls_.size() >= kMaxCompiledUrls) compiled_urls_.clear();
+  compiled_urls_.insert(url);
+
+  auto it = jobs_.find(url);
+  if (it == jobs_.end()) return false;
+  std::unique_ptr<Job> job = std::move(it->second);
+  jobs_.erase(it);
+
+  if (module == nullptr) {
+    DropJob(std::move(job));
+    return false;
+  }
+
+  // Compiles on this thread if the thread pool has not picked it up yet.
+  job->Run();
+
+  Utf8Value source(env_->isolate(), source_text);
+  if (job->read_error() != 0 || job->source().size() != source.length() ||
+      memcmp(job->source().data(), *source, source.length()) != 0) {
+    // The loader may have transformed the source, e.g. through hooks.
+    return false;
+  }
+
+  *module = ScriptCompiler::CompileModule(env_->isolate()->GetCurrentContext(),
+                                          job->streamed_source(),
+                                          source_text,
+                                          origin);
+  return true;
+}
+
 ModuleWrap::ModuleWrap(Environment* env,
                        Local<Object> object,
                        Local<Module> module,
@@ -175,6 +434,8 @@ void ModuleWrap::New(const FunctionCallbackInfo<Value>& args) {
         SyntheticModuleEvaluationStepsCallback);
     } else {
       ScriptCompiler::CachedData* cached_data = nullptr;
+      CompileCacheHandler* cache_handler = env->compile_cache_handler();
+      CompileCacheEntry* cache_entry = nullptr;
       if (!args[5]->IsUndefined()) {
         CHECK(args[5]->IsArrayBufferView());
         Local<ArrayBufferView> cached_data_buf = args[5].As<ArrayBufferView>();
@@ -186,6 +447,23 @@ void ModuleWrap::New(const FunctionCallbackInfo<Value>& args) {
       }
 
       Local<String> source_text = args[2].As<String>();
+
+      // The on-disk compile cache and background compilation only apply
+      // to modules loaded from files into the main context.
+      BackgroundModuleCompiler* background_compiler =
+          env->background_module_compiler();
+      std::string file_url;
+      if ((cache_handler != nullptr || background_compiler != nullptr) &&
+          cached_data == nullptr && contextify_context == nullptr) {
+        Utf8Value url_value(isolate, url);
+        if (strncmp(*url_value, "file:", 5) == 0) file_url = *url_value;
+      }
+      if (!file_url.empty() && cache_handler != nullptr) {
+        cache_entry = cache_handler->GetOrInsert(
+            source_text, file_url, CachedCodeType::kESM);
+        cached_data = cache_entry->CopyCache();
+      }
+
       ScriptOrigin origin(isolate,
                           url,
                           line_offset,
@@ -204,8 +482,20 @@ void ModuleWrap::New(const FunctionCallbackInfo<Value>& args) {
       } else {
         options = ScriptCompiler::kConsumeCodeCache;
       }
-      if (!ScriptCompiler::CompileModule(isolate, &source, options)
-               .ToLocal(&module)) {
+      MaybeLocal<Module> maybe_module;
+      bool compiled_in_background = false;
+      if (!file_url.empty() && background_compiler != nullptr) {
+        // A valid code cache is cheaper to consume than the streamed
+        // compilation result, so the latter is discarded in that case.
+        compiled_in_background = background_compiler->Finish(
+            file_url,
+            source_text,
+            origin,
+            cached_data == nullptr ? &maybe_module : nullptr);
+      }
+      if (!compiled_in_background)
+        maybe_module = ScriptCompiler::CompileModule(isolate, &source, options);
+      if (!maybe_module.ToLocal(&module)) {
         if (try_catch.HasCaught() && !try_catch.HasTerminated()) {
           CHECK(!try_catch.Message().IsEmpty());
           CHECK(!try_catch.Exception().IsEmpty());
@@ -215,8 +505,16 @@ void ModuleWrap::New(const FunctionCallbackInfo<Value>& args) {
         }
         return;
       }
-      if (options == ScriptCompiler::kConsumeCodeCache &&
-          source.GetCachedData()->rejected) {
+      if (!file_url.empty() && background_compiler != nullptr)
+        background_compiler->EnqueueDependencies(module, file_url);
+      if (cache_entry != nullptr) {
+        cache_handler->MaybeSave(
+            cache_entry,
+            module,
+            options == ScriptCompiler::kConsumeCodeCache &&
+                source.GetCachedData()->rejected);
+      } else if (options == ScriptCompiler::kConsumeCodeCache &&
+                 source.GetCachedData()->rejected) {
         THROW_ERR_VM_MODULE_CACHED_DATA_REJECTED(
             env, "cachedData buffer was rejected");
         try_catch.ReThrow();
@@ -766,6 +1064,20 @@ void ModuleWrap::CreateCachedData(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// compileInBackground(url) lets the loader hand over URLs it resolved
+// itself, e.g. for bare specifiers. This is a no-op unless
+// --experimental-esm-background-compile is used.
+void ModuleWrap::CompileInBackground(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsString());
+  BackgroundModuleCompiler* background_compiler =
+      env->background_module_compiler();
+  if (background_compiler == nullptr) return;
+
+  Utf8Value url(env->isolate(), args[0]);
+  if (strncmp(*url, "file:", 5) == 0) background_compiler->Enqueue(*url);
+}
+
 void ModuleWrap::Initialize(Local<Object> target,
                             Local<Value> unused,
                             Local<Context> context,
@@ -790,6 +1102,7 @@ void ModuleWrap::Initialize(Local<Object> target,
 
   env->SetConstructorFunction(target, "ModuleWrap", tpl);
 
+  env->SetMethod(target, "compileInBackground", CompileInBackground);
   env->SetMethod(target,
                  "setImportModuleDynamicallyCallback",
                  SetImportModuleDynamicallyCallback);
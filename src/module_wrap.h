@@ -3,7 +3,9 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <vector>
 #include "base_object.h"
@@ -30,6 +32,63 @@ enum HostDefinedOptions : int {
   kLength = 10,
 };
 
+// Reads and compiles ES modules on V8's worker threads ahead of the loader
+// (--experimental-esm-background-compile). Whenever a module is compiled,
+// its static dependencies whose URLs can be resolved without the JS loader
+// (relative and absolute paths, file: URLs) are handed to V8's streaming
+// compiler, so that parsing overlaps with the I/O and the compilation of
+// other modules. ModuleWrap::New then picks up the result if the source
+// it is given matches what was read from disk, and falls back to compiling
+// on the main thread otherwise.
+class BackgroundModuleCompiler {
+ public:
+  explicit BackgroundModuleCompiler(Environment* env);
+  ~BackgroundModuleCompiler();
+
+  // Starts compiling the module at the file: URL `url`, unless it is being
+  // compiled already or the loader has compiled it before. At most kMaxJobs
+  // results wait for the loader. Beyond that, the oldest one is dropped: the
+  // loader has most likely resolved that import to something else.
+  void Enqueue(const std::string& url);
+  void EnqueueDependencies(v8::Local<v8::Module> module,
+                           const std::string& url);
+
+  // Called when the loader compiles `url`. Returns false if there is no
+  // usable background compilation for it. Otherwise `module` is set to the
+  // result of the compilation, which is empty if it threw. Passing nullptr
+  // as `module` discards the result. Either way, the job for `url` is freed.
+  bool Finish(const std::string& url,
+              v8::Local<v8::String> source_text,
+              const v8::ScriptOrigin& origin,
+              v8::MaybeLocal<v8::Module>* module);
+
+  // Jobs waiting for the loader, and dropped jobs that a worker thread was
+  // still running at the time.
+  size_t pending_jobs() const { return jobs_.size(); }
+  size_t retired_jobs() const { return retired_jobs_.size(); }
+
+  static constexpr size_t kMaxJobs = 256;
+  static constexpr size_t kMaxCompiledUrls = 4096;
+
+ private:
+  class Job;
+  friend class Job;
+
+  // Frees `job`, or keeps it in retired_jobs_ until a worker thread is done
+  // with it.
+  void DropJob(std::unique_ptr<Job> job);
+  void FreeRetiredJobs();
+
+  Environment* env_;
+  std::unordered_map<std::string, std::unique_ptr<Job>> jobs_;
+  uint64_t next_job_sequence_ = 0;
+  std::vector<std::unique_ptr<Job>> retired_jobs_;
+  // URLs that the loader has compiled, and would not ask for again. This
+  // only avoids redundant work, so it is cleared rather than allowed to grow
+  // beyond kMaxCompiledUrls.
+  std::unordered_set<std::string> compiled_urls_;
+};
+
 class ModuleWrap : public BaseObject {
  public:
   enum InternalFields {
@@ -92,6 +151,8 @@ class ModuleWrap : public BaseObject {
   static void SetSyntheticExport(
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void CreateCachedData(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void CompileInBackground(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static v8::MaybeLocal<v8::Module> ResolveModuleCallback(
       v8::Local<v8::Context> context,
@@ -38,6 +38,7 @@
 #include "node_process-inl.h"
 #include "node_report.h"
 #include "node_revert.h"
+#include "node_snapshotable.h"
 #include "node_v8_platform-inl.h"
 #include "node_version.h"
 
@@ -295,6 +296,21 @@ void Environment::InitializeDiagnostics() {
 #endif
 }
 
+void Environment::InitializeCompileCache() {
+  const std::string& dir = options_->compile_cache_dir;
+  if (dir.empty() || compile_cache_handler_) return;
+
+  auto handler = std::make_unique<CompileCacheHandler>(this);
+  if (!handler->InitializeDirectory(dir)) return;
+  compile_cache_handler_ = std::move(handler);
+  // Persist at exit rather than right after compilation, so that the caches
+  // include the functions that were compiled lazily while running.
+  AtExit([](void* arg) {
+    Environment* env = static_cast<Environment*>(arg);
+    env->compile_cache_handler()->Persist();
+  }, this);
+}
+
 MaybeLocal<Value> Environment::BootstrapInternalLoaders() {
   EscapableHandleScope scope(isolate_);
 
@@ -486,6 +502,19 @@ MaybeLocal<Value> StartExecution(Environment* env, StartExecutionCallback cb) {
     return StartExecution(env, "internal/main/worker_thread");
   }
 
+  // Booting from a user-land snapshot (see --build-snapshot) whose entry
+  // script returned a main function.
+  Local<Function> deserialize_main = env->snapshot_deserialize_main();
+  if (!deserialize_main.IsEmpty()) {
+    EscapableHandleScope scope(env->isolate());
+    if (StartExecution(env, "internal/bootstrap/environment").IsEmpty())
+      return {};
+    Local<Value> argv[] = {env->process_object(),
+                           env->native_module_require()};
+    return scope.EscapeMaybe(deserialize_main->Call(
+        env->context(), env->process_object(), arraysize(argv), argv));
+  }
+
   std::string first_argv;
   if (env->argv().size() > 1) {
     first_argv = env->argv()[1];
@@ -1147,19 +1176,80 @@ void TearDownOncePerProcess() {
   per_process::v8_platform.Dispose();
 }
 
+static std::string GetSnapshotBlobPath() {
+  const std::string& path = per_process::cli_options->snapshot_blob;
+  return path.empty() ? "snapshot.blob" : path;
+}
+
+static int GenerateAndWriteSnapshotData(const InitializationResult& result) {
+  if (result.args.size() < 2) {
+    fprintf(stderr, "%s: --build-snapshot must be used with an entry point "
+                    "script.\n", result.args[0].c_str());
+    return 9;
+  }
+
+  SnapshotData data;
+  int exit_code = SnapshotBuilder::Generate(&data, result.args,
+                                            result.exec_args);
+  if (exit_code != 0) return exit_code;
+
+  std::string path = GetSnapshotBlobPath();
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (fp == nullptr) {
+    fprintf(stderr, "Cannot open %s for writing\n", path.c_str());
+    exit_code = 1;
+  } else {
+    if (!data.ToBlob(fp)) {
+      fprintf(stderr, "Cannot write snapshot blob to %s\n", path.c_str());
+      exit_code = 1;
+    }
+    fclose(fp);
+  }
+  delete[] data.blob.data;
+  return exit_code;
+}
+
 int Start(int argc, char** argv) {
   InitializationResult result = InitializeOncePerProcess(argc, argv);
   if (result.early_return) {
     return result.exit_code;
   }
 
+  if (per_process::cli_options->build_snapshot) {
+    result.exit_code = GenerateAndWriteSnapshotData(result);
+    TearDownOncePerProcess();
+    return result.exit_code;
+  }
+
   {
     Isolate::CreateParams params;
     const std::vector<size_t>* indices = nullptr;
     const EnvSerializeInfo* env_info = nullptr;
+    // Owns the blob read from --snapshot-blob until the instance is done.
+    SnapshotData custom_snapshot;
+    std::unique_ptr<const char[]> custom_blob_data;
     bool use_node_snapshot =
         per_process::cli_options->per_isolate->node_snapshot;
-    if (use_node_snapshot) {
+    bool use_custom_snapshot =
+        !per_process::cli_options->snapshot_blob.empty();
+    if (use_node_snapshot && use_custom_snapshot) {
+      std::string path = GetSnapshotBlobPath();
+      FILE* fp = fopen(path.c_str(), "rb");
+      bool ok = fp != nullptr &&
+                SnapshotData::FromBlob(&custom_snapshot, fp);
+      if (fp != nullptr) fclose(fp);
+      if (!ok) {
+        fprintf(stderr, "Cannot load snapshot blob from %s, it does not "
+                        "exist or was not generated by this binary\n",
+                path.c_str());
+        TearDownOncePerProcess();
+        return 1;
+      }
+      custom_blob_data.reset(custom_snapshot.blob.data);
+      params.snapshot_blob = &custom_snapshot.blob;
+      indices = &custom_snapshot.isolate_data_indices;
+      env_info = &custom_snapshot.env_info;
+    } else if (use_node_snapshot) {
       v8::StartupData* blob = NodeMainInstance::GetEmbeddedSnapshotBlob();
       if (blob != nullptr) {
         params.snapshot_blob = blob;
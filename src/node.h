@@ -278,6 +278,14 @@ class NODE_EXTERN ArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
   static std::unique_ptr<ArrayBufferAllocator> Create(
       bool always_debug = false);
 
+  // Create an ArrayBuffer::Allocator instance that serves small and
+  // mid-sized allocations from size-class arenas with per-thread caches
+  // rather than calling malloc() and free() for each of them, which helps
+  // when many short-lived Buffers are created. Pass it to NewIsolate() and
+  // CreateIsolateData() like any other allocator. This can also be enabled
+  // for the allocators returned by Create() using --arraybuffer-arenas.
+  static std::unique_ptr<ArrayBufferAllocator> CreateWithArenas();
+
  private:
   virtual NodeArrayBufferAllocator* GetImpl() = 0;
 
@@ -21,6 +21,7 @@
 
 #include "node_buffer.h"
 #include "allocated_buffer-inl.h"
+#include "base_object-inl.h"
 #include "node.h"
 #include "node_blob.h"
 #include "node_errors.h"
@@ -28,11 +29,13 @@
 #include "node_internals.h"
 
 #include "env-inl.h"
+#include "memory_tracker-inl.h"
 #include "string_bytes.h"
 #include "string_search.h"
 #include "util-inl.h"
 #include "v8.h"
 
+#include <cmath>
 #include <cstring>
 #include <climits>
 
@@ -50,15 +53,20 @@
 namespace node {
 namespace Buffer {
 
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::BackingStore;
+using v8::CFunction;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::FastApiCallbackOptions;
 using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
 using v8::Global;
 using v8::HandleScope;
 using v8::Int32;
+using v8::Int32Array;
 using v8::Integer;
 using v8::Isolate;
 using v8::Just;
@@ -229,6 +237,35 @@ inline MUST_USE_RESULT Maybe<bool> ParseArrayIndex(Environment* env,
   return Just(true);
 }
 
+// Counterpart of ParseArrayIndex() for fast API calls, which only receive
+// numbers. Returns false if the index is out of bounds, in which case the
+// fast call falls back to the slow one to throw.
+inline bool ParseFastArrayIndex(double arg, size_t* ret) {
+  if (std::isnan(arg)) {
+    *ret = 0;
+    return true;
+  }
+  double tmp = std::trunc(arg);
+  // Leave anything that is not a safe integer to the slow path.
+  if (tmp < 0 || tmp > static_cast<double>(kMaxSafeJsInteger)) return false;
+  *ret = static_cast<size_t>(tmp);
+  return true;
+}
+
+// Fast API calls must not allocate on the JS heap, so they cannot write to
+// typed arrays whose contents live on it.
+inline bool GetWritableFastContents(Local<Value> value,
+                                    char** data,
+                                    size_t* length) {
+  if (!value->IsArrayBufferView()) return false;
+  Local<ArrayBufferView> view = value.As<ArrayBufferView>();
+  if (!view->HasBuffer()) return false;
+  *data = static_cast<char*>(view->Buffer()->GetBackingStore()->Data()) +
+          view->ByteOffset();
+  *length = view->ByteLength();
+  return true;
+}
+
 }  // anonymous namespace
 
 // Buffer methods
@@ -594,6 +631,51 @@ void Copy(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(to_copy);
 }
 
+uint32_t FastCopy(Local<Value> receiver,
+                  Local<Value> source_obj,
+                  Local<Value> target_obj,
+                  double target_start_arg,
+                  double source_start_arg,
+                  double source_end_arg,
+                  // NOLINTNEXTLINE(runtime/references)
+                  FastApiCallbackOptions& options) {
+  HandleScope scope(Isolate::GetCurrent());
+  char* target_data;
+  size_t target_length;
+  size_t target_start;
+  size_t source_start;
+  size_t source_end;
+  if (!source_obj->IsArrayBufferView() ||
+      !GetWritableFastContents(target_obj, &target_data, &target_length) ||
+      !ParseFastArrayIndex(target_start_arg, &target_start) ||
+      !ParseFastArrayIndex(source_start_arg, &source_start) ||
+      !ParseFastArrayIndex(source_end_arg, &source_end)) {
+    options.fallback = true;
+    return 0;
+  }
+  ArrayBufferViewContents<char> source(source_obj);
+
+  if (target_start >= target_length || source_start >= source_end)
+    return 0;
+
+  if (source_start > source.length()) {
+    options.fallback = true;
+    return 0;
+  }
+
+  if (source_end - source_start > target_length - target_start)
+    source_end = source_start + target_length - target_start;
+
+  uint32_t to_copy = std::min(
+      std::min(source_end - source_start, target_length - target_start),
+      source.length() - source_start);
+
+  memmove(target_data + target_start, source.data() + source_start, to_copy);
+  return to_copy;
+}
+
+CFunction fast_copy(CFunction::Make(FastCopy));
+
 
 void Fill(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -691,6 +773,36 @@ start_fill:
   }
 }
 
+// Only handles filling with a number; anything else takes the slow path.
+void FastFill(Local<Value> receiver,
+              Local<Value> buffer_obj,
+              double value,
+              double start_arg,
+              double end_arg,
+              Local<Value> encoding,
+              // NOLINTNEXTLINE(runtime/references)
+              FastApiCallbackOptions& options) {
+  HandleScope scope(Isolate::GetCurrent());
+  char* ts_obj_data;
+  size_t ts_obj_length;
+  size_t start;
+  size_t end;
+  if (!GetWritableFastContents(buffer_obj, &ts_obj_data, &ts_obj_length) ||
+      !ParseFastArrayIndex(start_arg, &start) ||
+      !ParseFastArrayIndex(end_arg, &end) ||
+      start > end || end > ts_obj_length) {
+    options.fallback = true;
+    return;
+  }
+
+  // Equivalent to ToUint32(value) & 255.
+  double byte = std::isfinite(value) ? std::fmod(std::trunc(value), 256) : 0;
+  if (byte < 0) byte += 256;
+  memset(ts_obj_data + start, static_cast<int>(byte), end - start);
+}
+
+CFunction fast_fill(CFunction::Make(FastFill));
+
 
 template <encoding encoding>
 void StringWrite(const FunctionCallbackInfo<Value>& args) {
@@ -798,6 +910,51 @@ void CompareOffset(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(val);
 }
 
+int32_t FastCompareOffset(Local<Value> receiver,
+                          Local<Value> source_obj,
+                          Local<Value> target_obj,
+                          double target_start_arg,
+                          double source_start_arg,
+                          double target_end_arg,
+                          double source_end_arg,
+                          // NOLINTNEXTLINE(runtime/references)
+                          FastApiCallbackOptions& options) {
+  HandleScope scope(Isolate::GetCurrent());
+  size_t target_start;
+  size_t source_start;
+  size_t source_end;
+  size_t target_end;
+  if (!source_obj->IsArrayBufferView() || !target_obj->IsArrayBufferView() ||
+      !ParseFastArrayIndex(target_start_arg, &target_start) ||
+      !ParseFastArrayIndex(source_start_arg, &source_start) ||
+      !ParseFastArrayIndex(target_end_arg, &target_end) ||
+      !ParseFastArrayIndex(source_end_arg, &source_end) ||
+      source_start > source_end || target_start > target_end) {
+    options.fallback = true;
+    return 0;
+  }
+  ArrayBufferViewContents<char> source(source_obj);
+  ArrayBufferViewContents<char> target(target_obj);
+
+  if (source_start > source.length() || target_start > target.length()) {
+    options.fallback = true;
+    return 0;
+  }
+
+  size_t to_cmp =
+      std::min(std::min(source_end - source_start, target_end - target_start),
+               source.length() - source_start);
+
+  return normalizeCompareVal(to_cmp > 0 ?
+                               memcmp(source.data() + source_start,
+                                      target.data() + target_start,
+                                      to_cmp) : 0,
+                             source_end - source_start,
+                             target_end - target_start);
+}
+
+CFunction fast_compare_offset(CFunction::Make(FastCompareOffset));
+
 void Compare(const FunctionCallbackInfo<Value> &args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -814,6 +971,28 @@ void Compare(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(val);
 }
 
+int32_t FastCompare(Local<Value> receiver,
+                    Local<Value> a_obj,
+                    Local<Value> b_obj,
+                    // NOLINTNEXTLINE(runtime/references)
+                    FastApiCallbackOptions& options) {
+  if (!a_obj->IsArrayBufferView() || !b_obj->IsArrayBufferView()) {
+    options.fallback = true;
+    return 0;
+  }
+  HandleScope scope(Isolate::GetCurrent());
+  ArrayBufferViewContents<char> a(a_obj);
+  ArrayBufferViewContents<char> b(b_obj);
+
+  size_t cmp_length = std::min(a.length(), b.length());
+
+  return normalizeCompareVal(cmp_length > 0 ?
+                               memcmp(a.data(), b.data(), cmp_length) : 0,
+                             a.length(), b.length());
+}
+
+CFunction fast_compare(CFunction::Make(FastCompare));
+
 
 // Computes the offset for starting an indexOf or lastIndexOf search.
 // Returns either a valid offset in [0...<length - 1>], ie inside the Buffer,
@@ -969,26 +1148,14 @@ void IndexOfString(const FunctionCallbackInfo<Value>& args) {
       result == haystack_length ? -1 : static_cast<int>(result));
 }
 
-void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
-  CHECK(args[1]->IsObject());
-  CHECK(args[2]->IsNumber());
-  CHECK(args[3]->IsInt32());
-  CHECK(args[4]->IsBoolean());
-
-  enum encoding enc = static_cast<enum encoding>(args[3].As<Int32>()->Value());
-
-  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[0]);
-  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[1]);
-  ArrayBufferViewContents<char> haystack_contents(args[0]);
-  ArrayBufferViewContents<char> needle_contents(args[1]);
-  int64_t offset_i64 = args[2].As<Integer>()->Value();
-  bool is_forward = args[4]->IsTrue();
-
-  const char* haystack = haystack_contents.data();
-  const size_t haystack_length = haystack_contents.length();
-  const char* needle = needle_contents.data();
-  const size_t needle_length = needle_contents.length();
-
+// Returns the position of `needle` in `haystack`, or -1 if there is none.
+int64_t IndexOfBufferImpl(const char* haystack,
+                          size_t haystack_length,
+                          const char* needle,
+                          size_t needle_length,
+                          int64_t offset_i64,
+                          enum encoding enc,
+                          bool is_forward) {
   int64_t opt_offset = IndexOfOffset(haystack_length,
                                      offset_i64,
                                      needle_length,
@@ -996,29 +1163,28 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
 
   if (needle_length == 0) {
     // Match String#indexOf() and String#lastIndexOf() behavior.
-    args.GetReturnValue().Set(static_cast<double>(opt_offset));
-    return;
+    return opt_offset;
   }
 
   if (haystack_length == 0) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
 
   if (opt_offset <= -1) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
   size_t offset = static_cast<size_t>(opt_offset);
   CHECK_LT(offset, haystack_length);
   if ((is_forward && needle_length + offset > haystack_length) ||
       needle_length > haystack_length) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
 
   size_t result = haystack_length;
 
   if (enc == UCS2) {
     if (haystack_length < 2 || needle_length < 2) {
-      return args.GetReturnValue().Set(-1);
+      return -1;
     }
     result = SearchString(
         reinterpret_cast<const uint16_t*>(haystack),
@@ -1038,8 +1204,101 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
         is_forward);
   }
 
-  args.GetReturnValue().Set(
-      result == haystack_length ? -1 : static_cast<int>(result));
+  return result == haystack_length ? -1 : static_cast<int>(result);
+}
+
+void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[1]->IsObject());
+  CHECK(args[2]->IsNumber());
+  CHECK(args[3]->IsInt32());
+  CHECK(args[4]->IsBoolean());
+
+  enum encoding enc = static_cast<enum encoding>(args[3].As<Int32>()->Value());
+
+  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[1]);
+  ArrayBufferViewContents<char> haystack_contents(args[0]);
+  ArrayBufferViewContents<char> needle_contents(args[1]);
+  int64_t offset_i64 = args[2].As<Integer>()->Value();
+  bool is_forward = args[4]->IsTrue();
+
+  int64_t result = IndexOfBufferImpl(haystack_contents.data(),
+                                     haystack_contents.length(),
+                                     needle_contents.data(),
+                                     needle_contents.length(),
+                                     offset_i64,
+                                     enc,
+                                     is_forward);
+  args.GetReturnValue().Set(static_cast<double>(result));
+}
+
+// Converts the offset argument of the indexOf() functions the way
+// Integer::Value() does, or returns false if it is not a safe integer.
+inline bool ParseFastIndexOfOffset(double arg, int64_t* ret) {
+  if (std::isnan(arg) ||
+      std::abs(arg) > static_cast<double>(kMaxSafeJsInteger)) {
+    return false;
+  }
+  *ret = static_cast<int64_t>(arg);
+  return true;
+}
+
+int32_t FastIndexOfBuffer(Local<Value> receiver,
+                          Local<Value> haystack_obj,
+                          Local<Value> needle_obj,
+                          double offset,
+                          int32_t enc,
+                          bool is_forward,
+                          // NOLINTNEXTLINE(runtime/references)
+                          FastApiCallbackOptions& options) {
+  int64_t offset_i64;
+  if (!haystack_obj->IsArrayBufferView() ||
+      !needle_obj->IsArrayBufferView() ||
+      !ParseFastIndexOfOffset(offset, &offset_i64)) {
+    options.fallback = true;
+    return 0;
+  }
+  HandleScope scope(Isolate::GetCurrent());
+  ArrayBufferViewContents<char> haystack_contents(haystack_obj);
+  ArrayBufferViewContents<char> needle_contents(needle_obj);
+
+  int64_t result = IndexOfBufferImpl(haystack_contents.data(),
+                                     haystack_contents.length(),
+                                     needle_contents.data(),
+                                     needle_contents.length(),
+                                     offset_i64,
+                                     static_cast<enum encoding>(enc),
+                                     is_forward);
+  // An empty needle can match past INT32_MAX in very large buffers.
+  if (result > INT32_MAX) {
+    options.fallback = true;
+    return 0;
+  }
+  return static_cast<int32_t>(result);
+}
+
+CFunction fast_index_of_buffer(CFunction::Make(FastIndexOfBuffer));
+
+int32_t IndexOfNumberImpl(const char* data,
+                          size_t length,
+                          uint32_t needle,
+                          int64_t offset_i64,
+                          bool is_forward) {
+  int64_t opt_offset = IndexOfOffset(length, offset_i64, 1, is_forward);
+  if (opt_offset <= -1 || length == 0) {
+    return -1;
+  }
+  size_t offset = static_cast<size_t>(opt_offset);
+  CHECK_LT(offset, length);
+
+  const void* ptr;
+  if (is_forward) {
+    ptr = memchr(data + offset, needle, length - offset);
+  } else {
+    ptr = node::stringsearch::MemrchrFill(data, needle, offset + 1);
+  }
+  const char* ptr_char = static_cast<const char*>(ptr);
+  return ptr ? static_cast<int>(ptr_char - data) : -1;
 }
 
 void IndexOfNumber(const FunctionCallbackInfo<Value>& args) {
@@ -1054,23 +1313,182 @@ void IndexOfNumber(const FunctionCallbackInfo<Value>& args) {
   int64_t offset_i64 = args[2].As<Integer>()->Value();
   bool is_forward = args[3]->IsTrue();
 
-  int64_t opt_offset =
-      IndexOfOffset(buffer.length(), offset_i64, 1, is_forward);
-  if (opt_offset <= -1 || buffer.length() == 0) {
-    return args.GetReturnValue().Set(-1);
+  args.GetReturnValue().Set(IndexOfNumberImpl(
+      buffer.data(), buffer.length(), needle, offset_i64, is_forward));
+}
+
+int32_t FastIndexOfNumber(Local<Value> receiver,
+                          Local<Value> buffer_obj,
+                          double needle,
+                          double offset,
+                          bool is_forward,
+                          // NOLINTNEXTLINE(runtime/references)
+                          FastApiCallbackOptions& options) {
+  int64_t offset_i64;
+  if (!buffer_obj->IsArrayBufferView() ||
+      !(needle >= 0 && needle <= UINT32_MAX && std::trunc(needle) == needle) ||
+      !ParseFastIndexOfOffset(offset, &offset_i64)) {
+    options.fallback = true;
+    return 0;
   }
+  HandleScope scope(Isolate::GetCurrent());
+  ArrayBufferViewContents<char> buffer(buffer_obj);
+
+  return IndexOfNumberImpl(buffer.data(),
+                           buffer.length(),
+                           static_cast<uint32_t>(needle),
+                           offset_i64,
+                           is_forward);
+}
+
+CFunction fast_index_of_number(CFunction::Make(FastIndexOfNumber));
+
+// One or more needles that are searched for repeatedly, such as a multipart
+// boundary. The search tables for a single needle, or the automaton for a
+// set of needles, are built once and reused by every search, instead of
+// being rebuilt by each indexOf() call.
+class SearchPattern final : public BaseObject {
+ public:
+  static void Create(const FunctionCallbackInfo<Value>& args);
+  static void IndexOf(const FunctionCallbackInfo<Value>& args);
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(SearchPattern)
+  SET_SELF_SIZE(SearchPattern)
+
+ private:
+  SearchPattern(Environment* env,
+                Local<Object> wrap,
+                std::vector<std::vector<uint8_t>>&& needles);
+
+  // Returns the position of the leftmost match at or after `offset`, or -1.
+  int64_t Search(const uint8_t* haystack,
+                 size_t haystack_length,
+                 int64_t offset_i64,
+                 size_t* needle_index);
+
+  // The search objects below point into these.
+  std::vector<std::vector<uint8_t>> needles_;
+  size_t min_needle_length_ = SIZE_MAX;
+  // Set when there is a single needle.
+  std::unique_ptr<stringsearch::StringSearch<uint8_t>> search_;
+  // Set when there are several needles.
+  std::unique_ptr<stringsearch::MultiStringSearch> multi_search_;
+};
+
+SearchPattern::SearchPattern(Environment* env,
+                             Local<Object> wrap,
+                             std::vector<std::vector<uint8_t>>&& needles)
+    : BaseObject(env, wrap), needles_(std::move(needles)) {
+  MakeWeak();
+
+  std::vector<stringsearch::Vector<const uint8_t>> vectors;
+  for (const std::vector<uint8_t>& needle : needles_) {
+    vectors.emplace_back(needle.data(), needle.size(), true);
+    min_needle_length_ = std::min(min_needle_length_, needle.size());
+  }
+  if (vectors.size() == 1) {
+    search_ = std::make_unique<stringsearch::StringSearch<uint8_t>>(
+        vectors[0]);
+  } else {
+    multi_search_ =
+        std::make_unique<stringsearch::MultiStringSearch>(vectors);
+  }
+}
+
+// createSearchPattern(needles)
+// needles: an array of non-empty ArrayBufferViews
+void SearchPattern::Create(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Context> context = env->context();
+
+  CHECK(args[0]->IsArray());
+  Local<Array> array = args[0].As<Array>();
+  CHECK_GT(array->Length(), 0);
+
+  std::vector<std::vector<uint8_t>> needles(array->Length());
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    Local<Value> value;
+    if (!array->Get(context, i).ToLocal(&value)) return;
+    CHECK(value->IsArrayBufferView());
+    ArrayBufferViewContents<uint8_t> needle(value);
+    CHECK_GT(needle.length(), 0);
+    needles[i].assign(needle.data(), needle.data() + needle.length());
+  }
+
+  Local<Object> obj;
+  if (!env->buffer_search_pattern_template()
+           ->NewInstance(context)
+           .ToLocal(&obj)) {
+    return;
+  }
+  new SearchPattern(env, obj, std::move(needles));
+  args.GetReturnValue().Set(obj);
+}
+
+int64_t SearchPattern::Search(const uint8_t* haystack,
+                              size_t haystack_length,
+                              int64_t offset_i64,
+                              size_t* needle_index) {
+  int64_t opt_offset = IndexOfOffset(haystack_length,
+                                     offset_i64,
+                                     min_needle_length_,
+                                     true);
+  if (opt_offset <= -1) return -1;
   size_t offset = static_cast<size_t>(opt_offset);
-  CHECK_LT(offset, buffer.length());
+  if (haystack_length < min_needle_length_ ||
+      offset > haystack_length - min_needle_length_) {
+    return -1;
+  }
 
-  const void* ptr;
-  if (is_forward) {
-    ptr = memchr(buffer.data() + offset, needle, buffer.length() - offset);
+  stringsearch::Vector<const uint8_t> subject(haystack, haystack_length, true);
+  size_t result;
+  if (search_) {
+    result = search_->Search(subject, offset);
+    *needle_index = 0;
   } else {
-    ptr = node::stringsearch::MemrchrFill(buffer.data(), needle, offset + 1);
+    result = multi_search_->Search(subject, offset, needle_index);
+  }
+  return result == haystack_length ? -1 : static_cast<int64_t>(result);
+}
+
+// indexOfPattern(pattern, buffer, byteOffset[, matchInfo])
+// If the pattern has several needles and matchInfo, an Int32Array, is
+// passed, the index of the needle that matched is stored in matchInfo[0].
+void SearchPattern::IndexOf(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[2]->IsNumber());
+
+  SearchPattern* pattern;
+  ASSIGN_OR_RETURN_UNWRAP(&pattern, args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[1]);
+  ArrayBufferViewContents<uint8_t> haystack(args[1]);
+  int64_t offset_i64 = args[2].As<Integer>()->Value();
+
+  size_t needle_index = 0;
+  int64_t result = pattern->Search(
+      haystack.data(), haystack.length(), offset_i64, &needle_index);
+  if (result != -1 && args[3]->IsInt32Array()) {
+    Local<Int32Array> match_info = args[3].As<Int32Array>();
+    CHECK_GE(match_info->Length(), 1);
+    Local<Value> index =
+        Integer::New(env->isolate(), static_cast<int32_t>(needle_index));
+    match_info->Set(env->context(), 0, index).Check();
+  }
+  args.GetReturnValue().Set(static_cast<double>(result));
+}
+
+void SearchPattern::MemoryInfo(MemoryTracker* tracker) const {
+  size_t needles_size = 0;
+  for (const std::vector<uint8_t>& needle : needles_)
+    needles_size += needle.size();
+  tracker->TrackFieldWithSize("needles", needles_size);
+  if (search_) {
+    tracker->TrackFieldWithSize(
+        "search", sizeof(stringsearch::StringSearch<uint8_t>));
+  } else {
+    tracker->TrackFieldWithSize("search", multi_search_->memory_size());
   }
-  const char* ptr_char = static_cast<const char*>(ptr);
-  args.GetReturnValue().Set(ptr ? static_cast<int>(ptr_char - buffer.data())
-                                : -1);
 }
 
 
@@ -1269,14 +1687,28 @@ void Initialize(Local<Object> target,
   env->SetMethodNoSideEffect(target, "createFromString", CreateFromString);
 
   env->SetMethodNoSideEffect(target, "byteLengthUtf8", ByteLengthUtf8);
-  env->SetMethod(target, "copy", Copy);
-  env->SetMethodNoSideEffect(target, "compare", Compare);
-  env->SetMethodNoSideEffect(target, "compareOffset", CompareOffset);
-  env->SetMethod(target, "fill", Fill);
-  env->SetMethodNoSideEffect(target, "indexOfBuffer", IndexOfBuffer);
-  env->SetMethodNoSideEffect(target, "indexOfNumber", IndexOfNumber);
+  env->SetFastMethod(target, "copy", Copy, &fast_copy);
+  env->SetFastMethodNoSideEffect(target, "compare", Compare, &fast_compare);
+  env->SetFastMethodNoSideEffect(
+      target, "compareOffset", CompareOffset, &fast_compare_offset);
+  env->SetFastMethod(target, "fill", Fill, &fast_fill);
+  env->SetFastMethodNoSideEffect(
+      target, "indexOfBuffer", IndexOfBuffer, &fast_index_of_buffer);
+  env->SetFastMethodNoSideEffect(
+      target, "indexOfNumber", IndexOfNumber, &fast_index_of_number);
   env->SetMethodNoSideEffect(target, "indexOfString", IndexOfString);
 
+  {
+    Local<FunctionTemplate> t = FunctionTemplate::New(env->isolate());
+    t->Inherit(BaseObject::GetConstructorTemplate(env));
+    t->InstanceTemplate()->SetInternalFieldCount(
+        SearchPattern::kInternalFieldCount);
+    t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "SearchPattern"));
+    env->set_buffer_search_pattern_template(t->InstanceTemplate());
+  }
+  env->SetMethod(target, "createSearchPattern", SearchPattern::Create);
+  env->SetMethod(target, "indexOfPattern", SearchPattern::IndexOf);
+
   env->SetMethod(target, "detachArrayBuffer", DetachArrayBuffer);
   env->SetMethod(target, "copyArrayBuffer", CopyArrayBuffer);
 
@@ -1322,12 +1754,26 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
 
   registry->Register(ByteLengthUtf8);
   registry->Register(Copy);
+  registry->Register(FastCopy);
+  registry->Register(fast_copy.GetTypeInfo());
   registry->Register(Compare);
+  registry->Register(FastCompare);
+  registry->Register(fast_compare.GetTypeInfo());
   registry->Register(CompareOffset);
+  registry->Register(FastCompareOffset);
+  registry->Register(fast_compare_offset.GetTypeInfo());
   registry->Register(Fill);
+  registry->Register(FastFill);
+  registry->Register(fast_fill.GetTypeInfo());
   registry->Register(IndexOfBuffer);
+  registry->Register(FastIndexOfBuffer);
+  registry->Register(fast_index_of_buffer.GetTypeInfo());
   registry->Register(IndexOfNumber);
+  registry->Register(FastIndexOfNumber);
+  registry->Register(fast_index_of_number.GetTypeInfo());
   registry->Register(IndexOfString);
+  registry->Register(SearchPattern::Create);
+  registry->Register(SearchPattern::IndexOf);
 
   registry->Register(Swap16);
   registry->Register(Swap32);
@@ -1116,6 +1116,31 @@ void ContextifyContext::CompileFunction(
       data + cached_data_buf->ByteOffset(), cached_data_buf->ByteLength());
   }
 
+  // Consult the on-disk compile cache, unless the caller manages the cache
+  // itself or compiles into another context. The wrapper parameters are
+  // part of the key as they change the generated code.
+  CompileCacheHandler* cache_handler = env->compile_cache_handler();
+  CompileCacheEntry* cache_entry = nullptr;
+  if (cache_handler != nullptr && cached_data == nullptr &&
+      !produce_cached_data && args[6]->IsUndefined() &&
+      context_extensions_buf.IsEmpty()) {
+    std::string key = *Utf8Value(isolate, filename);
+    bool valid_key = true;
+    if (!params_buf.IsEmpty()) {
+      for (uint32_t n = 0; valid_key && n < params_buf->Length(); n++) {
+        Local<Value> val;
+        valid_key = params_buf->Get(context, n).ToLocal(&val) &&
+                    val->IsString();
+        if (valid_key) key += std::string(",") + *Utf8Value(isolate, val);
+      }
+    }
+    if (valid_key) {
+      cache_entry =
+          cache_handler->GetOrInsert(code, key, CachedCodeType::kCommonJS);
+      cached_data = cache_entry->CopyCache();
+    }
+  }
+
   // Get the function id
   uint32_t id = env->get_next_function_id();
 
@@ -1189,6 +1214,14 @@ void ContextifyContext::CompileFunction(
     return;
   }
 
+  if (cache_entry != nullptr) {
+    cache_handler->MaybeSave(
+        cache_entry,
+        fn,
+        options == ScriptCompiler::kConsumeCodeCache &&
+            source.GetCachedData()->rejected);
+  }
+
   Local<Object> cache_key;
   if (!env->compiled_fn_entry_template()->NewInstance(
            context).ToLocal(&cache_key)) {
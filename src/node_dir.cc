@@ -1,4 +1,5 @@
 #include "node_dir.h"
+#include "node_buffer.h"
 #include "node_external_reference.h"
 #include "node_file-inl.h"
 #include "node_process-inl.h"
@@ -16,8 +17,15 @@
 #include <cerrno>
 #include <climits>
 
+#include <algorithm>
 #include <memory>
 
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace node {
 
 namespace fs_dir {
@@ -28,6 +36,7 @@ using fs::FSReqWrapSync;
 using fs::GetReqWrap;
 
 using v8::Array;
+using v8::ArrayBuffer;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
@@ -40,6 +49,8 @@ using v8::Null;
 using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
+using v8::Uint32Array;
+using v8::Uint8Array;
 using v8::Value;
 
 #define TRACE_NAME(name) "fs_dir.sync." #name
@@ -87,6 +98,10 @@ DirHandle::~DirHandle() {
 
 void DirHandle::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackFieldWithSize("dir", sizeof(*dir_));
+  tracker->TrackField("packed_names", packed_names_);
+  tracker->TrackField("packed_offsets", packed_offsets_);
+  tracker->TrackField("packed_types", packed_types_);
+  tracker->TrackField("getdents_buf", getdents_buf_);
 }
 
 // Close the directory handle if it hasn't already been closed. A process
@@ -129,6 +144,35 @@ inline void DirHandle::GCClose() {
   }, CallbackFlags::kUnrefed);
 }
 
+// Starts `req` from a blank state, so that uv_fs_req_cleanup() has nothing to
+// free and uv_cancel() leaves it alone.
+static void ClearRequest(uv_fs_t* req) {
+  void* data = req->data;
+  memset(req, 0, sizeof(*req));
+  req->data = data;
+}
+
+// An AsyncCall() function that fails the request with `err` without
+// reaching libuv.
+static int FailRequest(uv_loop_t* loop, uv_fs_t* req, int err, uv_fs_cb cb) {
+  ClearRequest(req);
+  return err;
+}
+
+// Puts the error info for a failed synchronous call in ctx, like SyncCall().
+static void SetSyncError(Environment* env,
+                         Local<Value> ctx,
+                         int err,
+                         const char* syscall) {
+  Local<Object> ctx_obj = ctx.As<Object>();
+  ctx_obj->Set(env->context(),
+               env->errno_string(),
+               Integer::New(env->isolate(), err)).Check();
+  ctx_obj->Set(env->context(),
+               env->syscall_string(),
+               OneByteString(env->isolate(), syscall)).Check();
+}
+
 void AfterClose(uv_fs_t* req) {
   FSReqBase* req_wrap = FSReqBase::from_req(req);
   FSReqAfterScope after(req_wrap, req);
@@ -146,6 +190,19 @@ void DirHandle::Close(const FunctionCallbackInfo<Value>& args) {
   DirHandle* dir;
   ASSIGN_OR_RETURN_UNWRAP(&dir, args.Holder());
 
+  // A readPacked() on the threadpool is still reading from the directory.
+  if (dir->packed_req_ != nullptr) {
+    FSReqBase* req_wrap_async = GetReqWrap(args, 0);
+    if (req_wrap_async != nullptr) {
+      AsyncCall(env, req_wrap_async, args, "closedir", UTF8, AfterClose,
+                FailRequest, UV_EBUSY);
+    } else {
+      CHECK_EQ(argc, 2);
+      SetSyncError(env, args[1], UV_EBUSY, "closedir");
+    }
+    return;
+  }
+
   dir->closing_ = false;
   dir->closed_ = true;
 
@@ -248,6 +305,20 @@ void DirHandle::Read(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[1]->IsNumber());
   uint64_t buffer_size = static_cast<uint64_t>(args[1].As<Number>()->Value());
 
+  // Entries that readPacked() has read ahead would be skipped.
+  if (dir->used_getdents_) {
+    FSReqBase* req_wrap_async = GetReqWrap(args, 2);
+    if (req_wrap_async != nullptr) {
+      AsyncCall(env, req_wrap_async, args, "readdir", encoding,
+                AfterDirRead, FailRequest, UV_EINVAL);
+    } else {
+      CHECK_EQ(argc, 4);
+      SetSyncError(env, args[3], UV_EINVAL, "readdir");
+    }
+    return;
+  }
+  dir->used_readdir_ = true;
+
   if (buffer_size != dir->dirents_.size()) {
     dir->dirents_.resize(buffer_size);
     dir->dir_->nentries = buffer_size;
@@ -295,6 +366,274 @@ void DirHandle::Read(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+#ifdef __linux__
+static uv_dirent_type_t DirentTypeFromDType(unsigned char type) {
+  switch (type) {
+    case DT_REG: return UV_DIRENT_FILE;
+    case DT_DIR: return UV_DIRENT_DIR;
+    case DT_LNK: return UV_DIRENT_LINK;
+    case DT_FIFO: return UV_DIRENT_FIFO;
+    case DT_SOCK: return UV_DIRENT_SOCKET;
+    case DT_CHR: return UV_DIRENT_CHAR;
+    case DT_BLK: return UV_DIRENT_BLOCK;
+    default: return UV_DIRENT_UNKNOWN;
+  }
+}
+#endif
+
+void DirHandle::AddPackedEntry(const char* name,
+                               size_t length,
+                               uv_dirent_type_t type) {
+  for (size_t i = 0; i < length && packed_ascii_; i++)
+    packed_ascii_ = static_cast<unsigned char>(name[i]) < 0x80;
+  packed_names_.append(name, length);
+  packed_offsets_.push_back(static_cast<uint32_t>(packed_names_.size()));
+  packed_types_.push_back(static_cast<uint8_t>(type));
+}
+
+int DirHandle::ReadPackedBatch(size_t limit) {
+  packed_names_.clear();
+  packed_offsets_.assign(1, 0);
+  packed_types_.clear();
+  packed_ascii_ = true;
+
+#ifdef __linux__
+  // Read with getdents64() straight into a buffer that is kept across
+  // batches, instead of going through readdir(3) and copying every name
+  // into its own allocation. The buffer grows with the batch size.
+  if (!used_readdir_) {
+    used_getdents_ = true;
+    const int fd = dirfd(dir_->dir);
+    while (packed_types_.size() < limit) {
+      if (getdents_pos_ == getdents_len_) {
+        if (getdents_eof_)
+          break;
+        const size_t size =
+            std::min<size_t>(std::max<size_t>(limit * 64, 32 * 1024),
+                             1024 * 1024);
+        if (getdents_buf_.size() < size)
+          getdents_buf_.resize(size);
+        long nread;  // NOLINT(runtime/int)
+        do {
+          nread = syscall(SYS_getdents64, fd, getdents_buf_.data(),
+                          getdents_buf_.size());
+        } while (nread == -1 && errno == EINTR);
+        if (nread == -1)
+          return uv_translate_sys_error(errno);
+        if (nread == 0) {
+          getdents_eof_ = true;
+          break;
+        }
+        getdents_pos_ = 0;
+        getdents_len_ = static_cast<size_t>(nread);
+      }
+
+      const struct dirent64* ent = reinterpret_cast<const struct dirent64*>(
+          getdents_buf_.data() + getdents_pos_);
+      getdents_pos_ += ent->d_reclen;
+      if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+        continue;
+      AddPackedEntry(ent->d_name,
+                     strlen(ent->d_name),
+                     DirentTypeFromDType(ent->d_type));
+    }
+    return static_cast<int>(packed_types_.size());
+  }
+#endif
+
+  if (limit != dirents_.size()) {
+    dirents_.resize(limit);
+    dir_->nentries = limit;
+    dir_->dirents = dirents_.data();
+  }
+  uv_fs_t req;
+  int nread = uv_fs_readdir(nullptr, &req, dir_, nullptr);
+  for (int i = 0; i < nread; i++) {
+    AddPackedEntry(dir_->dirents[i].name,
+                   strlen(dir_->dirents[i].name),
+                   dir_->dirents[i].type);
+  }
+  uv_fs_req_cleanup(&req);
+  return nread;
+}
+
+MaybeLocal<Array> DirHandle::PackedBatchToArray(enum encoding encoding,
+                                                Local<Value>* err_out) {
+  Isolate* isolate = env()->isolate();
+
+  // The offsets count bytes, so the names can only be returned as a string
+  // when every byte is one character. Otherwise, JS decodes each name from
+  // the buffer.
+  Local<Value> names;
+  if (encoding == LATIN1 ||
+      (packed_ascii_ && (encoding == UTF8 || encoding == ASCII))) {
+    if (!StringBytes::Encode(isolate,
+                             packed_names_.data(),
+                             packed_names_.size(),
+                             LATIN1,
+                             err_out).ToLocal(&names)) {
+      return MaybeLocal<Array>();
+    }
+  } else if (!Buffer::Copy(isolate,
+                           packed_names_.data(),
+                           packed_names_.size()).ToLocal(&names)) {
+    return MaybeLocal<Array>();
+  }
+
+  const size_t offsets_size = packed_offsets_.size() * sizeof(uint32_t);
+  Local<ArrayBuffer> offsets = ArrayBuffer::New(isolate, offsets_size);
+  memcpy(offsets->GetBackingStore()->Data(),
+         packed_offsets_.data(),
+         offsets_size);
+
+  Local<ArrayBuffer> types = ArrayBuffer::New(isolate, packed_types_.size());
+  memcpy(types->GetBackingStore()->Data(),
+         packed_types_.data(),
+         packed_types_.size());
+
+  Local<Value> result[] = {
+    names,
+    Uint32Array::New(offsets, 0, packed_offsets_.size()),
+    Uint8Array::New(types, 0, packed_types_.size())
+  };
+  return Array::New(isolate, result, arraysize(result));
+}
+
+int DirHandle::ReadPackedAsync(uv_loop_t* loop,
+                               uv_fs_t* req,
+                               DirHandle* dir,
+                               uv_fs_cb cb) {
+  ClearRequest(req);
+  req->ptr = dir;
+  req->cb = cb;
+  int err = uv_queue_work(loop,
+                          &dir->packed_work_,
+                          ReadPackedWork,
+                          AfterReadPackedWork);
+  if (err == 0)
+    dir->packed_req_ = req;
+  return err;
+}
+
+void DirHandle::ReadPackedWork(uv_work_t* work) {
+  DirHandle* dir = ContainerOf(&DirHandle::packed_work_, work);
+  dir->packed_result_ = dir->ReadPackedBatch(dir->packed_limit_);
+}
+
+void DirHandle::AfterReadPackedWork(uv_work_t* work, int status) {
+  DirHandle* dir = ContainerOf(&DirHandle::packed_work_, work);
+  uv_fs_t* req = dir->packed_req_;
+  dir->packed_req_ = nullptr;
+  req->result = status < 0 ? status : dir->packed_result_;
+  req->cb(req);
+}
+
+void DirHandle::AfterDirReadPacked(uv_fs_t* req) {
+  DirHandle* dir = static_cast<DirHandle*>(req->ptr);
+  req->ptr = nullptr;
+
+  BaseObjectPtr<FSReqBase> req_wrap { FSReqBase::from_req(req) };
+  FSReqAfterScope after(req_wrap.get(), req);
+
+  if (!after.Proceed()) {
+    return;
+  }
+
+  Isolate* isolate = req_wrap->env()->isolate();
+
+  if (req->result == 0) {
+    // Done
+    Local<Value> done = Null(isolate);
+    after.Clear();
+    req_wrap->Resolve(done);
+    return;
+  }
+
+  Local<Value> error;
+  Local<Array> js_array;
+  if (!dir->PackedBatchToArray(req_wrap->encoding(), &error)
+           .ToLocal(&js_array)) {
+    after.Clear();
+    return req_wrap->Reject(error);
+  }
+
+  after.Clear();
+  req_wrap->Resolve(js_array);
+}
+
+// Like read(), but returns a whole batch of entries as
+// [names, offsets, types], where name i is names[offsets[i]:offsets[i + 1]]
+// and types holds UV_DIRENT_* constants. `names` is a string if its offsets
+// are character offsets for `encoding`, and a Buffer otherwise. Batches
+// start at `bufferSize` entries and double on every call, up to
+// kMaxPackedBatch, so that large directories take few round-trips. Only one
+// call may be in progress at a time, and close() fails while it is.
+void DirHandle::ReadPacked(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 3);
+
+  const enum encoding encoding = ParseEncoding(isolate, args[0], UTF8);
+
+  DirHandle* dir;
+  ASSIGN_OR_RETURN_UNWRAP(&dir, args.Holder());
+
+  CHECK(args[1]->IsNumber());
+  const size_t buffer_size = static_cast<size_t>(std::max<double>(
+      args[1].As<Number>()->Value(), 1));
+
+  // The batch is read into the handle, so a second call has to wait for the
+  // first one to deliver its result.
+  if (dir->packed_req_ != nullptr) {
+    FSReqBase* req_wrap_async = GetReqWrap(args, 2);
+    if (req_wrap_async != nullptr) {
+      AsyncCall(env, req_wrap_async, args, "readdir", encoding,
+                AfterDirReadPacked, FailRequest, UV_EBUSY);
+    } else {
+      CHECK_EQ(argc, 4);
+      SetSyncError(env, args[3], UV_EBUSY, "readdir");
+    }
+    return;
+  }
+
+  if (dir->packed_limit_ == 0)
+    dir->packed_limit_ = std::min(buffer_size, kMaxPackedBatch);
+  else
+    dir->packed_limit_ = std::min(dir->packed_limit_ * 2, kMaxPackedBatch);
+
+  FSReqBase* req_wrap_async = GetReqWrap(args, 2);
+  if (req_wrap_async != nullptr) {  // dir.readPacked(encoding, bufferSize, req)
+    AsyncCall(env, req_wrap_async, args, "readdir", encoding,
+              AfterDirReadPacked, ReadPackedAsync, dir);
+  } else {  // dir.readPacked(encoding, bufferSize, undefined, ctx)
+    CHECK_EQ(argc, 4);
+    FS_DIR_SYNC_TRACE_BEGIN(readdir);
+    int result = dir->ReadPackedBatch(dir->packed_limit_);
+    FS_DIR_SYNC_TRACE_END(readdir);
+    if (result < 0)
+      return SetSyncError(env, args[3], result, "readdir");
+
+    if (result == 0) {
+      // Done
+      Local<Value> done = Null(isolate);
+      args.GetReturnValue().Set(done);
+      return;
+    }
+
+    Local<Value> error;
+    Local<Array> js_array;
+    if (!dir->PackedBatchToArray(encoding, &error).ToLocal(&js_array)) {
+      Local<Object> ctx = args[3].As<Object>();
+      USE(ctx->Set(env->context(), env->error_string(), error));
+      return;
+    }
+
+    args.GetReturnValue().Set(js_array);
+  }
+}
+
 void AfterOpenDir(uv_fs_t* req) {
   FSReqBase* req_wrap = FSReqBase::from_req(req);
   FSReqAfterScope after(req_wrap, req);
@@ -358,6 +697,7 @@ void Initialize(Local<Object> target,
   Local<FunctionTemplate> dir = env->NewFunctionTemplate(DirHandle::New);
   dir->Inherit(AsyncWrap::GetConstructorTemplate(env));
   env->SetProtoMethod(dir, "read", DirHandle::Read);
+  env->SetProtoMethod(dir, "readPacked", DirHandle::ReadPacked);
   env->SetProtoMethod(dir, "close", DirHandle::Close);
   Local<ObjectTemplate> dirt = dir->InstanceTemplate();
   dirt->SetInternalFieldCount(DirHandle::kInternalFieldCount);
@@ -369,6 +709,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(OpenDir);
   registry->Register(DirHandle::New);
   registry->Register(DirHandle::Read);
+  registry->Register(DirHandle::ReadPacked);
   registry->Register(DirHandle::Close);
 }
 
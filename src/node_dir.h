@@ -17,6 +17,7 @@ class DirHandle : public AsyncWrap {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Read(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ReadPacked(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Close(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   inline uv_dir_t* dir() { return dir_; }
@@ -25,6 +26,10 @@ class DirHandle : public AsyncWrap {
   SET_MEMORY_INFO_NAME(DirHandle)
   SET_SELF_SIZE(DirHandle)
 
+  // readPacked() starts with batches of the requested size and doubles them
+  // on every call, up to this many entries.
+  static constexpr size_t kMaxPackedBatch = 16384;
+
   DirHandle(const DirHandle&) = delete;
   DirHandle& operator=(const DirHandle&) = delete;
   DirHandle(const DirHandle&&) = delete;
@@ -36,9 +41,52 @@ class DirHandle : public AsyncWrap {
   // Synchronous close that emits a warning
   void GCClose();
 
+  // Reads up to `limit` entries into packed_names_, packed_offsets_ and
+  // packed_types_. Runs on the threadpool for asynchronous reads. Returns the
+  // number of entries, 0 at the end of the directory, or an error.
+  int ReadPackedBatch(size_t limit);
+  void AddPackedEntry(const char* name, size_t length, uv_dirent_type_t type);
+  // Returns [names, offsets, types] for the last batch.
+  v8::MaybeLocal<v8::Array> PackedBatchToArray(enum encoding encoding,
+                                               v8::Local<v8::Value>* err_out);
+
+  // An AsyncCall() function that runs ReadPackedBatch() on the threadpool
+  // and then calls `cb` like libuv would. The request itself never reaches
+  // libuv; req->ptr carries the handle to AfterDirReadPacked().
+  static int ReadPackedAsync(uv_loop_t* loop,
+                             uv_fs_t* req,
+                             DirHandle* dir,
+                             uv_fs_cb cb);
+  static void ReadPackedWork(uv_work_t* work);
+  static void AfterReadPackedWork(uv_work_t* work, int status);
+  static void AfterDirReadPacked(uv_fs_t* req);
+
   uv_dir_t* dir_;
   // Multiple entries are read through a single libuv call.
   std::vector<uv_dirent_t> dirents_;
+
+  // The batch returned by readPacked(): all names back to back, the offset
+  // of each name plus the end of the last one, and UV_DIRENT_* types.
+  size_t packed_limit_ = 0;
+  std::string packed_names_;
+  std::vector<uint32_t> packed_offsets_;
+  std::vector<uint8_t> packed_types_;
+  bool packed_ascii_ = true;
+  uv_work_t packed_work_;
+  // The request of the readPacked() call in progress, if any.
+  uv_fs_t* packed_req_ = nullptr;
+  int packed_result_ = 0;
+  // On Linux, readPacked() reads the directory with getdents64() into this
+  // buffer, which may hold entries that are left over for the next batch.
+  // read() goes through readdir(3), which buffers entries of its own, so
+  // only the first of the two to be used on a handle may read the fd; read()
+  // fails with UV_EINVAL once readPacked() has.
+  std::vector<char> getdents_buf_;
+  size_t getdents_pos_ = 0;
+  size_t getdents_len_ = 0;
+  bool getdents_eof_ = false;
+  bool used_getdents_ = false;
+  bool used_readdir_ = false;
   bool closing_ = false;
   bool closed_ = false;
 };
@@ -11,6 +11,58 @@
 namespace node {
 
 using CFunctionCallback = void (*)(v8::Local<v8::Value> receiver);
+// Signatures of the fast API callbacks in node_buffer.cc.
+using CFunctionBufferCompare =
+    int32_t (*)(v8::Local<v8::Value> receiver,
+                v8::Local<v8::Value> a,
+                v8::Local<v8::Value> b,
+                // NOLINTNEXTLINE(runtime/references)
+                v8::FastApiCallbackOptions& options);
+using CFunctionBufferCompareOffset =
+    int32_t (*)(v8::Local<v8::Value> receiver,
+                v8::Local<v8::Value> source,
+                v8::Local<v8::Value> target,
+                double target_start,
+                double source_start,
+                double target_end,
+                double source_end,
+                // NOLINTNEXTLINE(runtime/references)
+                v8::FastApiCallbackOptions& options);
+using CFunctionBufferCopy =
+    uint32_t (*)(v8::Local<v8::Value> receiver,
+                 v8::Local<v8::Value> source,
+                 v8::Local<v8::Value> target,
+                 double target_start,
+                 double source_start,
+                 double source_end,
+                 // NOLINTNEXTLINE(runtime/references)
+                 v8::FastApiCallbackOptions& options);
+using CFunctionBufferFill =
+    void (*)(v8::Local<v8::Value> receiver,
+             v8::Local<v8::Value> buffer,
+             double value,
+             double start,
+             double end,
+             v8::Local<v8::Value> encoding,
+             // NOLINTNEXTLINE(runtime/references)
+             v8::FastApiCallbackOptions& options);
+using CFunctionBufferIndexOfBuffer =
+    int32_t (*)(v8::Local<v8::Value> receiver,
+                v8::Local<v8::Value> haystack,
+                v8::Local<v8::Value> needle,
+                double offset,
+                int32_t encoding,
+                bool is_forward,
+                // NOLINTNEXTLINE(runtime/references)
+                v8::FastApiCallbackOptions& options);
+using CFunctionBufferIndexOfNumber =
+    int32_t (*)(v8::Local<v8::Value> receiver,
+                v8::Local<v8::Value> buffer,
+                double needle,
+                double offset,
+                bool is_forward,
+                // NOLINTNEXTLINE(runtime/references)
+                v8::FastApiCallbackOptions& options);
 
 // This class manages the external references from the V8 heap
 // to the C++ addresses in Node.js.
@@ -20,6 +72,12 @@ class ExternalReferenceRegistry {
 
 #define ALLOWED_EXTERNAL_REFERENCE_TYPES(V)                                    \
   V(CFunctionCallback)                                                         \
+  V(CFunctionBufferCompare)                                                    \
+  V(CFunctionBufferCompareOffset)                                              \
+  V(CFunctionBufferCopy)                                                       \
+  V(CFunctionBufferFill)                                                       \
+  V(CFunctionBufferIndexOfBuffer)                                              \
+  V(CFunctionBufferIndexOfNumber)                                              \
   V(const v8::CFunctionInfo*)                                                  \
   V(v8::FunctionCallback)                                                      \
   V(v8::AccessorGetterCallback)                                                \
@@ -65,6 +123,7 @@ class ExternalReferenceRegistry {
   V(fs_event_wrap)                                                             \
   V(handle_wrap)                                                               \
   V(heap_utils)                                                                \
+  V(http_parser)                                                               \
   V(messaging)                                                                 \
   V(native_module)                                                             \
   V(os)                                                                        \
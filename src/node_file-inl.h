@@ -82,13 +82,11 @@ FSReqCallback::FSReqCallback(BindingData* binding_data,
               AsyncWrap::PROVIDER_FSREQCALLBACK,
               use_bigint) {}
 
-template <typename NativeT, typename V8T>
-void FillStatsArray(AliasedBufferBase<NativeT, V8T>* fields,
-                    const uv_stat_t* s,
-                    const size_t offset) {
+template <typename NativeT>
+void FillStatsFields(NativeT* fields, const uv_stat_t* s) {
 #define SET_FIELD_WITH_STAT(stat_offset, stat)                               \
-  fields->SetValue(offset + static_cast<size_t>(FsStatsOffset::stat_offset), \
-                   static_cast<NativeT>(stat))
+  fields[static_cast<size_t>(FsStatsOffset::stat_offset)] =                  \
+      static_cast<NativeT>(stat)
 
 #define SET_FIELD_WITH_TIME_STAT(stat_offset, stat)                          \
   /* NOLINTNEXTLINE(runtime/int) */                                          \
@@ -118,6 +116,18 @@ void FillStatsArray(AliasedBufferBase<NativeT, V8T>* fields,
 #undef SET_FIELD_WITH_STAT
 }
 
+template <typename NativeT, typename V8T>
+void FillStatsArray(AliasedBufferBase<NativeT, V8T>* fields,
+                    const uv_stat_t* s,
+                    const size_t offset) {
+  constexpr size_t kFieldsNumber =
+      static_cast<size_t>(FsStatsOffset::kFsStatsFieldsNumber);
+  NativeT stats[kFieldsNumber];
+  FillStatsFields(stats, s);
+  for (size_t i = 0; i < kFieldsNumber; i++)
+    fields->SetValue(offset + i, stats[i]);
+}
+
 v8::Local<v8::Value> FillGlobalStatsArray(BindingData* binding_data,
                                           const bool use_bigint,
                                           const uv_stat_t* s,
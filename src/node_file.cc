@@ -21,6 +21,7 @@
 #include "node_file.h"  // NOLINT(build/include_inline)
 #include "node_file-inl.h"
 #include "aliased_buffer.h"
+#include "json_utils.h"
 #include "memory_tracker-inl.h"
 #include "node_buffer.h"
 #include "node_external_reference.h"
@@ -52,15 +53,20 @@ namespace node {
 namespace fs {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BigInt;
+using v8::BigUint64Array;
 using v8::Boolean;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Int32;
+using v8::Int32Array;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
@@ -71,6 +77,7 @@ using v8::ObjectTemplate;
 using v8::Promise;
 using v8::String;
 using v8::Symbol;
+using v8::Uint32;
 using v8::Undefined;
 using v8::Value;
 
@@ -140,6 +147,7 @@ FSReqBase::~FSReqBase() = default;
 
 void FSReqBase::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("continuation_data", continuation_data_);
+  tracker->TrackField("tree_operation", tree_operation_);
 }
 
 // The FileHandle object wraps a file descriptor and will close it on garbage
@@ -903,26 +911,18 @@ void Close(const FunctionCallbackInfo<Value>& args) {
 }
 
 
-// Used to speed up module loading. Returns an array [string, boolean]
-static void InternalModuleReadJSON(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  Isolate* isolate = env->isolate();
-  uv_loop_t* loop = env->event_loop();
-
-  CHECK(args[0]->IsString());
-  node::Utf8Value path(isolate, args[0]);
+// Reads a package.json file for internalModuleReadJSON(). `contains_keys`
+// tells whether the file may have any of the top-level fields the module
+// loader is interested in.
+static PackageJSONEntry ReadPackageJSON(uv_loop_t* loop, const char* path) {
+  PackageJSONEntry result;
 
-  if (strlen(*path) != path.length()) {
-    args.GetReturnValue().Set(Array::New(isolate));
-    return;  // Contains a nul byte.
-  }
   uv_fs_t open_req;
-  const int fd = uv_fs_open(loop, &open_req, *path, O_RDONLY, 0, nullptr);
+  const int fd = uv_fs_open(loop, &open_req, path, O_RDONLY, 0, nullptr);
   uv_fs_req_cleanup(&open_req);
 
   if (fd < 0) {
-    args.GetReturnValue().Set(Array::New(isolate));
-    return;
+    return result;
   }
 
   auto defer_close = OnScopeLeave([fd, loop]() {
@@ -948,8 +948,7 @@ static void InternalModuleReadJSON(const FunctionCallbackInfo<Value>& args) {
     uv_fs_req_cleanup(&read_req);
 
     if (numchars < 0) {
-      args.GetReturnValue().Set(Array::New(isolate));
-      return;
+      return result;
     }
     offset += numchars;
   } while (static_cast<size_t>(numchars) == kBlockSize);
@@ -959,64 +958,202 @@ static void InternalModuleReadJSON(const FunctionCallbackInfo<Value>& args) {
     start = 3;  // Skip UTF-8 BOM.
   }
 
-  const size_t size = offset - start;
-  char* p = &chars[start];
-  char* pe = &chars[size];
-  char* pos[2];
-  char** ppos = &pos[0];
-
-  while (p < pe) {
-    char c = *p++;
-    if (c == '\\' && p < pe && *p == '"') p++;
-    if (c != '"') continue;
-    *ppos++ = p;
-    if (ppos < &pos[2]) continue;
-    ppos = &pos[0];
-
-    char* s = &pos[0][0];
-    char* se = &pos[1][-1];  // Exclude quote.
-    size_t n = se - s;
-
-    if (n == 4) {
-      if (0 == memcmp(s, "main", 4)) break;
-      if (0 == memcmp(s, "name", 4)) break;
-      if (0 == memcmp(s, "type", 4)) break;
-    } else if (n == 7) {
-      if (0 == memcmp(s, "exports", 7)) break;
-      if (0 == memcmp(s, "imports", 7)) break;
-    }
+  result.found = true;
+  result.contents.assign(&chars[start], offset - start);
+
+  // Files that cannot be scanned are handed to JSON.parse() anyway, which
+  // reports the syntax error.
+  static const std::vector<std::string_view> kLoaderKeys = {
+      "main", "name", "type", "exports", "imports"};
+  std::vector<std::string_view> values;
+  if (!ExtractJSONFields(result.contents, kLoaderKeys, &values)) {
+    result.contains_keys = true;
+    return result;
+  }
+  for (const std::string_view& value : values) {
+    if (value.data() != nullptr) result.contains_keys = true;
+  }
+  return result;
+}
+
+// Returns the package.json at `path` from the module stat cache, or reads
+// it into `storage` if it is not cached.
+static const PackageJSONEntry* GetPackageJSON(BindingData* binding_data,
+                                              const char* path,
+                                              PackageJSONEntry* storage) {
+  ModuleStatCache* cache = binding_data->module_stat_cache();
+  if (cache != nullptr) {
+    const PackageJSONEntry* entry = cache->LookupPackageJSON(path);
+    if (entry != nullptr) return entry;
+  }
+  *storage = ReadPackageJSON(binding_data->env()->event_loop(), path);
+  if (cache != nullptr)
+    cache->InsertPackageJSON(path, PackageJSONEntry(*storage));
+  return storage;
+}
+
+// Used to speed up module loading. Returns an array [string, boolean]
+static void InternalModuleReadJSON(const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Environment::GetBindingData<BindingData>(args);
+  Environment* env = binding_data->env();
+  Isolate* isolate = env->isolate();
+
+  CHECK(args[0]->IsString());
+  node::Utf8Value path(isolate, args[0]);
+
+  if (strlen(*path) != path.length()) {
+    args.GetReturnValue().Set(Array::New(isolate));
+    return;  // Contains a nul byte.
   }
 
+  PackageJSONEntry uncached;
+  const PackageJSONEntry* entry =
+      GetPackageJSON(binding_data, *path, &uncached);
+  if (!entry->found) {
+    args.GetReturnValue().Set(Array::New(isolate));
+    return;
+  }
 
   Local<Value> return_value[] = {
     String::NewFromUtf8(isolate,
-                        &chars[start],
+                        entry->contents.data(),
                         v8::NewStringType::kNormal,
-                        size).ToLocalChecked(),
-    Boolean::New(isolate, p < pe ? true : false)
+                        entry->contents.size()).ToLocalChecked(),
+    Boolean::New(isolate, entry->contains_keys)
   };
   args.GetReturnValue().Set(
     Array::New(isolate, return_value, arraysize(return_value)));
 }
 
-// Used to speed up module loading.  Returns 0 if the path refers to
-// a file, 1 when it's a directory or < 0 on error (usually -ENOENT.)
-// The speedup comes from not creating thousands of Stat and Error objects.
-static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
+// Like internalModuleReadJSON(), but only extracts the given top-level
+// fields, so that large package.json files do not need to go through
+// JSON.parse() in full. Returns undefined if the file cannot be read, an
+// array with the raw JSON text of each field (or undefined if it is absent)
+// on success, or the whole contents if the file could not be scanned, in
+// which case the caller should parse it as usual.
+static void InternalModuleReadJSONFields(
+    const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Environment::GetBindingData<BindingData>(args);
+  Environment* env = binding_data->env();
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
 
   CHECK(args[0]->IsString());
-  node::Utf8Value path(env->isolate(), args[0]);
+  CHECK(args[1]->IsArray());
+  node::Utf8Value path(isolate, args[0]);
+  if (strlen(*path) != path.length()) return;  // Contains a nul byte.
+
+  Local<Array> fields = args[1].As<Array>();
+  std::vector<std::string> field_names(fields->Length());
+  std::vector<std::string_view> keys(fields->Length());
+  for (uint32_t i = 0; i < fields->Length(); i++) {
+    Local<Value> field;
+    if (!fields->Get(context, i).ToLocal(&field)) return;
+    CHECK(field->IsString());
+    node::Utf8Value field_value(isolate, field);
+    field_names[i] = field_value.ToString();
+    keys[i] = field_names[i];
+  }
+
+  PackageJSONEntry uncached;
+  const PackageJSONEntry* entry =
+      GetPackageJSON(binding_data, *path, &uncached);
+  if (!entry->found) return;
+
+  std::vector<std::string_view> values;
+  if (!ExtractJSONFields(entry->contents, keys, &values)) {
+    args.GetReturnValue().Set(
+        String::NewFromUtf8(isolate,
+                            entry->contents.data(),
+                            v8::NewStringType::kNormal,
+                            entry->contents.size()).ToLocalChecked());
+    return;
+  }
+
+  std::vector<Local<Value>> results(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    if (values[i].data() == nullptr) {
+      results[i] = Undefined(isolate);
+      continue;
+    }
+    if (!String::NewFromUtf8(isolate,
+                             values[i].data(),
+                             v8::NewStringType::kNormal,
+                             values[i].size()).ToLocal(&results[i])) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(
+      Array::New(isolate, results.data(), results.size()));
+}
+
+// Returns 0 if the path refers to a file, 1 when it's a directory or < 0
+// on error, consulting the module stat cache if it is enabled.
+static int ModuleStat(BindingData* binding_data, const char* path) {
+  ModuleStatCache* cache = binding_data->module_stat_cache();
+  if (cache != nullptr) {
+    const int* cached = cache->LookupStat(path);
+    if (cached != nullptr) return *cached;
+  }
 
   uv_fs_t req;
-  int rc = uv_fs_stat(env->event_loop(), &req, *path, nullptr);
+  int rc = uv_fs_stat(binding_data->env()->event_loop(), &req, path, nullptr);
   if (rc == 0) {
     const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
     rc = !!(s->st_mode & S_IFDIR);
   }
   uv_fs_req_cleanup(&req);
 
-  args.GetReturnValue().Set(rc);
+  if (cache != nullptr) cache->InsertStat(path, rc);
+  return rc;
+}
+
+// Used to speed up module loading.  Returns 0 if the path refers to
+// a file, 1 when it's a directory or < 0 on error (usually -ENOENT.)
+// The speedup comes from not creating thousands of Stat and Error objects.
+static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Environment::GetBindingData<BindingData>(args);
+  Environment* env = binding_data->env();
+
+  CHECK(args[0]->IsString());
+  node::Utf8Value path(env->isolate(), args[0]);
+
+  args.GetReturnValue().Set(ModuleStat(binding_data, *path));
+}
+
+// Batched version of internalModuleStat(). Takes an array of candidate
+// paths and returns an Int32Array with the result for each of them, so
+// that the resolver can probe all extensions of a request in one call.
+static void InternalModuleStatBatch(const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Environment::GetBindingData<BindingData>(args);
+  Environment* env = binding_data->env();
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  CHECK(args[0]->IsArray());
+  Local<Array> paths = args[0].As<Array>();
+  const uint32_t length = paths->Length();
+
+  Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, length * sizeof(int32_t));
+  int32_t* results = static_cast<int32_t*>(ab->GetBackingStore()->Data());
+  for (uint32_t i = 0; i < length; i++) {
+    Local<Value> path;
+    if (!paths->Get(context, i).ToLocal(&path)) return;
+    CHECK(path->IsString());
+    node::Utf8Value path_value(isolate, path);
+    results[i] = ModuleStat(binding_data, *path_value);
+  }
+
+  args.GetReturnValue().Set(Int32Array::New(ab, 0, length));
+}
+
+// Drops everything held by the module stat cache. Used by the module
+// loader when it needs to observe file system changes made by the current
+// thread right away.
+static void FlushModuleStatCache(const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Environment::GetBindingData<BindingData>(args);
+  ModuleStatCache* cache = binding_data->module_stat_cache();
+  if (cache != nullptr) cache->Clear();
 }
 
 static void Stat(const FunctionCallbackInfo<Value>& args) {
@@ -1815,6 +1952,365 @@ static void CopyFile(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// Returns [entries, errorCount, errors] for a finished TreeOperation.
+static Local<Value> TreeOperationResult(Environment* env,
+                                        const TreeOperation& operation) {
+  Isolate* isolate = env->isolate();
+  std::vector<Local<Value>> error_v;
+  for (const TreeOperation::Error& error : operation.errors()) {
+    error_v.push_back(UVException(
+        isolate,
+        error.code,
+        error.syscall,
+        nullptr,
+        error.path.c_str(),
+        error.dest.empty() ? nullptr : error.dest.c_str()));
+  }
+
+  Local<Value> result[] = {
+    Number::New(isolate, static_cast<double>(operation.entries())),
+    Number::New(isolate, static_cast<double>(operation.error_count())),
+    Array::New(isolate, error_v.data(), error_v.size())
+  };
+  return Array::New(isolate, result, arraysize(result));
+}
+
+void AfterTreeOperation(uv_fs_t* req) {
+  FSReqBase* req_wrap = FSReqBase::from_req(req);
+  FSReqAfterScope after(req_wrap, req);
+
+  if (after.Proceed()) {
+    req_wrap->Resolve(
+        TreeOperationResult(req_wrap->env(), *req_wrap->tree_operation()));
+  }
+}
+
+// Returns [names, stats, errorCount, errors] for a finished scan. `stats`
+// holds kFsStatsFieldsNumber fields for every name, in the same layout as
+// the statValues array.
+template <typename NativeT, typename V8T>
+static MaybeLocal<Value> TreeScanResult(Environment* env,
+                                        const TreeOperation& operation,
+                                        enum encoding encoding,
+                                        Local<Value>* error) {
+  Isolate* isolate = env->isolate();
+  EscapableHandleScope scope(isolate);
+  const std::vector<TreeOperation::ScanEntry>& scanned = operation.scanned();
+  constexpr size_t kFieldsPerStat =
+      static_cast<size_t>(FsStatsOffset::kFsStatsFieldsNumber);
+
+  std::vector<Local<Value>> name_v;
+  name_v.reserve(scanned.size());
+  const size_t stats_length = scanned.size() * kFieldsPerStat;
+  std::unique_ptr<BackingStore> bs;
+  {
+    // Every field is written below.
+    NoArrayBufferZeroFillScope no_zero_fill_scope(env->isolate_data());
+    bs = ArrayBuffer::NewBackingStore(isolate, stats_length * sizeof(NativeT));
+  }
+  NativeT* stats = static_cast<NativeT*>(bs->Data());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    Local<Value> name;
+    if (!StringBytes::Encode(
+            isolate, scanned[i].name.c_str(), encoding, error).ToLocal(&name)) {
+      return MaybeLocal<Value>();
+    }
+    name_v.push_back(name);
+    FillStatsFields(stats + i * kFieldsPerStat, &scanned[i].stat);
+  }
+
+  std::vector<Local<Value>> error_v;
+  for (const TreeOperation::Error& error : operation.errors()) {
+    error_v.push_back(UVException(
+        isolate, error.code, error.syscall, nullptr, error.path.c_str()));
+  }
+
+  Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, std::move(bs));
+  Local<Value> result[] = {
+    Array::New(isolate, name_v.data(), name_v.size()),
+    V8T::New(ab, 0, stats_length),
+    Number::New(isolate, static_cast<double>(operation.error_count())),
+    Array::New(isolate, error_v.data(), error_v.size())
+  };
+  return scope.Escape(Array::New(isolate, result, arraysize(result)));
+}
+
+static MaybeLocal<Value> TreeScanResult(Environment* env,
+                                        const TreeOperation& operation,
+                                        enum encoding encoding,
+                                        bool use_bigint,
+                                        Local<Value>* error) {
+  if (use_bigint) {
+    return TreeScanResult<uint64_t, BigUint64Array>(
+        env, operation, encoding, error);
+  }
+  return TreeScanResult<double, Float64Array>(
+      env, operation, encoding, error);
+}
+
+void AfterTreeScan(uv_fs_t* req) {
+  FSReqBase* req_wrap = FSReqBase::from_req(req);
+  FSReqAfterScope after(req_wrap, req);
+
+  if (!after.Proceed())
+    return;
+
+  Local<Value> error;
+  Local<Value> result;
+  if (!TreeScanResult(req_wrap->env(),
+                      *req_wrap->tree_operation(),
+                      req_wrap->encoding(),
+                      req_wrap->use_bigint(),
+                      &error).ToLocal(&result)) {
+    return req_wrap->Reject(error);
+  }
+  req_wrap->Resolve(result);
+}
+
+// Takes the place of an uv_fs_* function in AsyncCall(): lstat()s the root
+// of the tree, or stat()s it for a scan, then runs the request's
+// TreeOperation on the threadpool. Only a failure to stat the root rejects
+// the request; everything else ends up in the result.
+static int TreeOperationAsync(uv_loop_t* loop,
+                              uv_fs_t* req,
+                              const char* path,
+                              uv_fs_cb cb) {
+  FSReqBase* req_wrap = FSReqBase::from_req(req);
+  CHECK_NOT_NULL(req_wrap->tree_operation());
+  req_wrap->set_continuation_data(
+      std::make_unique<FSContinuationData>(req, 0, cb));
+
+  auto after_stat = uv_fs_callback_t{[](uv_fs_t* req) {
+    FSReqBase* req_wrap = FSReqBase::from_req(req);
+    int err = static_cast<int>(req->result);
+    if (err == 0 &&
+        req_wrap->tree_operation()->kind() == TreeOperation::Kind::kScan) {
+#ifdef _WIN32
+      // TreeOperation cannot scan on Windows.
+      err = UV_ENOSYS;
+#else
+      if (!S_ISDIR(req->statbuf.st_mode))
+        err = UV_ENOTDIR;
+#endif
+    }
+    if (err < 0)
+      return req_wrap->continuation_data()->Done(err);
+
+    req_wrap->tree_operation()->Begin(&req->statbuf);
+    err = req_wrap->tree_operation()->RunAsync(
+        req_wrap->env()->event_loop(),
+        req,
+        uv_fs_callback_t{[](uv_fs_t* req) {
+          FSReqBase::from_req(req)->continuation_data()->Done(
+              static_cast<int>(req->result));
+        }});
+    if (err < 0)
+      req_wrap->continuation_data()->Done(err);
+  }};
+
+  if (req_wrap->tree_operation()->kind() == TreeOperation::Kind::kScan)
+    return uv_fs_stat(loop, req, path, after_stat);
+  return uv_fs_lstat(loop, req, path, after_stat);
+}
+
+static bool SetTreeOperationError(Environment* env,
+                                  Local<Value> ctx,
+                                  int err,
+                                  const char* syscall) {
+  Local<Object> ctx_obj = ctx.As<Object>();
+  ctx_obj->Set(env->context(),
+               env->errno_string(),
+               Integer::New(env->isolate(), err)).Check();
+  ctx_obj->Set(env->context(),
+               env->syscall_string(),
+               OneByteString(env->isolate(), syscall)).Check();
+  return false;
+}
+
+// The synchronous variant runs the whole operation on the current thread.
+// Returns false if the root could not be stat()ed, or the operation could
+// not be started, in which case the error info is in ctx.
+static bool TreeOperationSync(Environment* env,
+                              Local<Value> ctx,
+                              TreeOperation* operation,
+                              const char* path) {
+  FSReqWrapSync req_wrap_sync;
+  if (operation->kind() == TreeOperation::Kind::kScan) {
+    if (SyncCall(env, ctx, &req_wrap_sync, "scandir", uv_fs_stat, path) < 0)
+      return false;
+#ifdef _WIN32
+    // TreeOperation cannot scan on Windows.
+    int err = UV_ENOSYS;
+    const char* syscall = "readdirstats";
+#else
+    int err = S_ISDIR(req_wrap_sync.req.statbuf.st_mode) ? 0 : UV_ENOTDIR;
+    const char* syscall = "scandir";
+#endif
+    if (err != 0)
+      return SetTreeOperationError(env, ctx, err, syscall);
+  } else if (SyncCall(env, ctx, &req_wrap_sync, "lstat",
+                      uv_fs_lstat, path) < 0) {
+    return false;
+  }
+
+  operation->Begin(&req_wrap_sync.req.statbuf);
+  // Only a copy into its own source is refused at this point.
+  int err = operation->Work();
+  if (err != 0)
+    return SetTreeOperationError(env, ctx, err, "copytree");
+  return true;
+}
+
+// Removes `path` and everything below it. Errors other than for `path`
+// itself do not stop the removal; they are reported in the result.
+//
+// [entries, errorCount, errors] = rmTree(path, concurrency)
+// 0 path         the file or directory to remove
+// 1 concurrency  number of threadpool threads to use
+static void RmTree(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 3);
+
+  BufferValue path(env->isolate(), args[0]);
+  CHECK_NOT_NULL(*path);
+
+  CHECK(args[1]->IsUint32());
+  const uint32_t concurrency = args[1].As<Uint32>()->Value();
+
+  auto operation = std::make_unique<TreeOperation>(
+      TreeOperation::Kind::kRemove, *path, std::string(), 0, concurrency);
+
+  FSReqBase* req_wrap_async = GetReqWrap(args, 2);
+  if (req_wrap_async != nullptr) {  // rmTree(path, concurrency, req)
+    req_wrap_async->set_tree_operation(std::move(operation));
+    AsyncCall(env, req_wrap_async, args, "lstat", UTF8, AfterTreeOperation,
+              TreeOperationAsync, *path);
+  } else {  // rmTree(path, concurrency, undefined, ctx)
+    CHECK_EQ(argc, 4);
+    FS_SYNC_TRACE_BEGIN(rmtree);
+    bool ok = TreeOperationSync(env, args[3], operation.get(), *path);
+    FS_SYNC_TRACE_END(rmtree);
+    if (ok)
+      args.GetReturnValue().Set(TreeOperationResult(env, *operation));
+  }
+}
+
+// Copies `src` and everything below it to `dest`, which must not exist yet
+// unless it is a directory. Symbolic links are copied as links.
+//
+// [entries, errorCount, errors] = copyTree(src, dest, flags, concurrency)
+// 0 src          the file or directory to copy
+// 1 dest         where to copy it to
+// 2 flags        UV_FS_COPYFILE_* flags for every file
+// 3 concurrency  number of threadpool threads to use
+static void CopyTree(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 5);
+
+  BufferValue src(isolate, args[0]);
+  CHECK_NOT_NULL(*src);
+
+  BufferValue dest(isolate, args[1]);
+  CHECK_NOT_NULL(*dest);
+
+  CHECK(args[2]->IsInt32());
+  const int flags = args[2].As<Int32>()->Value();
+
+  CHECK(args[3]->IsUint32());
+  const uint32_t concurrency = args[3].As<Uint32>()->Value();
+
+  auto operation = std::make_unique<TreeOperation>(
+      TreeOperation::Kind::kCopy, *src, *dest, flags, concurrency);
+
+  FSReqBase* req_wrap_async = GetReqWrap(args, 4);
+  if (req_wrap_async != nullptr) {  // copyTree(src, dest, flags, conc., req)
+    req_wrap_async->set_tree_operation(std::move(operation));
+    AsyncDestCall(env, req_wrap_async, args, "lstat",
+                  *dest, dest.length(), UTF8, AfterTreeOperation,
+                  TreeOperationAsync, *src);
+  } else {  // copyTree(src, dest, flags, concurrency, undefined, ctx)
+    CHECK_EQ(argc, 6);
+    FS_SYNC_TRACE_BEGIN(copytree);
+    bool ok = TreeOperationSync(env, args[5], operation.get(), *src);
+    FS_SYNC_TRACE_END(copytree);
+    if (ok)
+      args.GetReturnValue().Set(TreeOperationResult(env, *operation));
+  }
+}
+
+// Lists a directory and stat()s every entry on the threadpool, optionally
+// descending into subdirectories. Symbolic links are not followed, except
+// for `path` itself. Entries that cannot be stat()ed are left out and
+// reported in the result.
+//
+// [names, stats, errorCount, errors] =
+//     readdirStats(path, encoding, maxDepth, concurrency, useBigint)
+// 0 path         the directory to list
+// 1 encoding     the encoding of the returned names
+// 2 maxDepth     levels of subdirectories to list; names below `path` are
+//                joined with '/'
+// 3 concurrency  number of threadpool threads to use
+// 4 useBigint    whether `stats` is a BigUint64Array or a Float64Array
+static void ReadDirStats(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 6);
+
+  BufferValue path(isolate, args[0]);
+  CHECK_NOT_NULL(*path);
+
+  const enum encoding encoding = ParseEncoding(isolate, args[1], UTF8);
+
+  CHECK(args[2]->IsUint32());
+  const uint32_t max_depth = args[2].As<Uint32>()->Value();
+
+  CHECK(args[3]->IsUint32());
+  const uint32_t concurrency = args[3].As<Uint32>()->Value();
+
+  bool use_bigint = args[4]->IsTrue();
+
+  auto operation = std::make_unique<TreeOperation>(
+      TreeOperation::Kind::kScan, *path, std::string(), 0, concurrency);
+  operation->set_max_depth(max_depth);
+
+  FSReqBase* req_wrap_async = GetReqWrap(args, 5, use_bigint);
+  if (req_wrap_async != nullptr) {  // readdirStats(..., useBigint, req)
+#ifdef _WIN32
+    // The scan itself fails with UV_ENOSYS on Windows.
+    const char* syscall = "readdirstats";
+#else
+    const char* syscall = "scandir";
+#endif
+    req_wrap_async->set_tree_operation(std::move(operation));
+    AsyncCall(env, req_wrap_async, args, syscall, encoding, AfterTreeScan,
+              TreeOperationAsync, *path);
+  } else {  // readdirStats(..., useBigint, undefined, ctx)
+    CHECK_EQ(argc, 7);
+    FS_SYNC_TRACE_BEGIN(readdirstats);
+    bool ok = TreeOperationSync(env, args[6], operation.get(), *path);
+    FS_SYNC_TRACE_END(readdirstats);
+    if (!ok)
+      return;
+
+    Local<Value> error;
+    Local<Value> result;
+    if (!TreeScanResult(env, *operation, encoding, use_bigint, &error)
+             .ToLocal(&result)) {
+      Local<Object> ctx = args[6].As<Object>();
+      ctx->Set(env->context(), env->error_string(), error).Check();
+      return;
+    }
+    args.GetReturnValue().Set(result);
+  }
+}
+
 
 // Wrapper for write(2).
 //
@@ -2406,6 +2902,23 @@ void BindingData::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("stats_field_bigint_array", stats_field_bigint_array);
   tracker->TrackField("file_handle_read_wrap_freelist",
                       file_handle_read_wrap_freelist);
+  tracker->TrackField("module_stat_cache", module_stat_cache_);
+  tracker->TrackField("stat_poller", stat_poller_);
+}
+
+ModuleStatCache* BindingData::module_stat_cache() {
+  if (!module_stat_cache_ &&
+      env()->options()->experimental_module_stat_cache &&
+      !per_process::cli_options->build_snapshot) {
+    module_stat_cache_ = std::make_unique<ModuleStatCache>(env());
+  }
+  return module_stat_cache_.get();
+}
+
+StatPoller* BindingData::stat_poller() {
+  if (!stat_poller_)
+    stat_poller_ = std::make_unique<StatPoller>(env());
+  return stat_poller_.get();
 }
 
 BindingData::BindingData(Environment* env, v8::Local<v8::Object> wrap)
@@ -2437,6 +2950,8 @@ void BindingData::Deserialize(Local<Context> context,
 void BindingData::PrepareForSerialization(Local<Context> context,
                                           v8::SnapshotCreator* creator) {
   CHECK(file_handle_read_wrap_freelist.empty());
+  CHECK(!module_stat_cache_);
+  CHECK(!stat_poller_);
   // We'll just re-initialize the buffers in the constructor since their
   // contents can be thrown away once consumed in the previous call.
   stats_field_array.Release();
@@ -2473,7 +2988,12 @@ void Initialize(Local<Object> target,
   env->SetMethod(target, "mkdir", MKDir);
   env->SetMethod(target, "readdir", ReadDir);
   env->SetMethod(target, "internalModuleReadJSON", InternalModuleReadJSON);
+  env->SetMethod(target,
+                 "internalModuleReadJSONFields",
+                 InternalModuleReadJSONFields);
   env->SetMethod(target, "internalModuleStat", InternalModuleStat);
+  env->SetMethod(target, "internalModuleStatBatch", InternalModuleStatBatch);
+  env->SetMethod(target, "flushModuleStatCache", FlushModuleStatCache);
   env->SetMethod(target, "stat", Stat);
   env->SetMethod(target, "lstat", LStat);
   env->SetMethod(target, "fstat", FStat);
@@ -2486,6 +3006,9 @@ void Initialize(Local<Object> target,
   env->SetMethod(target, "writeString", WriteString);
   env->SetMethod(target, "realpath", RealPath);
   env->SetMethod(target, "copyFile", CopyFile);
+  env->SetMethod(target, "rmTree", RmTree);
+  env->SetMethod(target, "copyTree", CopyTree);
+  env->SetMethod(target, "readdirStats", ReadDirStats);
 
   env->SetMethod(target, "chmod", Chmod);
   env->SetMethod(target, "fchmod", FChmod);
@@ -2589,7 +3112,10 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(MKDir);
   registry->Register(ReadDir);
   registry->Register(InternalModuleReadJSON);
+  registry->Register(InternalModuleReadJSONFields);
   registry->Register(InternalModuleStat);
+  registry->Register(InternalModuleStatBatch);
+  registry->Register(FlushModuleStatCache);
   registry->Register(Stat);
   registry->Register(LStat);
   registry->Register(FStat);
@@ -2602,6 +3128,9 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(WriteString);
   registry->Register(RealPath);
   registry->Register(CopyFile);
+  registry->Register(RmTree);
+  registry->Register(CopyTree);
+  registry->Register(ReadDirStats);
 
   registry->Register(Chmod);
   registry->Register(FChmod);
@@ -4,8 +4,11 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "aliased_buffer.h"
+#include "fs_tree.h"
+#include "module_stat_cache.h"
 #include "node_messaging.h"
 #include "node_snapshotable.h"
+#include "stat_poller.h"
 #include "stream_base.h"
 
 namespace node {
@@ -23,6 +26,12 @@ class BindingData : public SnapshotableObject {
   std::vector<BaseObjectPtr<FileHandleReadWrap>>
       file_handle_read_wrap_freelist;
 
+  // Returns nullptr unless --experimental-module-stat-cache is enabled.
+  ModuleStatCache* module_stat_cache();
+
+  // Shared by all StatWatchers started with `shared` set.
+  StatPoller* stat_poller();
+
   SERIALIZABLE_OBJECT_METHODS()
   static constexpr FastStringKey type_name{"node::fs::BindingData"};
   static constexpr EmbedderObjectType type_int =
@@ -31,6 +40,10 @@ class BindingData : public SnapshotableObject {
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_SELF_SIZE(BindingData)
   SET_MEMORY_INFO_NAME(BindingData)
+
+ private:
+  std::unique_ptr<ModuleStatCache> module_stat_cache_;
+  std::unique_ptr<StatPoller> stat_poller_;
 };
 
 // structure used to store state during a complex operation, e.g., mkdirp.
@@ -99,6 +112,12 @@ class FSReqBase : public ReqWrap<uv_fs_t> {
     continuation_data_ = std::move(data);
   }
 
+  // Used by rmTree() and copyTree().
+  TreeOperation* tree_operation() const { return tree_operation_.get(); }
+  void set_tree_operation(std::unique_ptr<TreeOperation> operation) {
+    tree_operation_ = std::move(operation);
+  }
+
   static FSReqBase* from_req(uv_fs_t* req) {
     return static_cast<FSReqBase*>(ReqWrap::from_req(req));
   }
@@ -112,6 +131,7 @@ class FSReqBase : public ReqWrap<uv_fs_t> {
 
  private:
   std::unique_ptr<FSContinuationData> continuation_data_;
+  std::unique_ptr<TreeOperation> tree_operation_;
   enum encoding encoding_ = UTF8;
   bool has_data_ = false;
   bool use_bigint_ = false;
@@ -143,6 +163,10 @@ class FSReqCallback final : public FSReqBase {
   FSReqCallback& operator=(const FSReqCallback&) = delete;
 };
 
+// Writes the kFsStatsFieldsNumber fields of `s` to `fields`.
+template <typename NativeT>
+void FillStatsFields(NativeT* fields, const uv_stat_t* s);
+
 template <typename NativeT, typename V8T>
 void FillStatsArray(AliasedBufferBase<NativeT, V8T>* fields,
                     const uv_stat_t* s,
@@ -19,8 +19,10 @@
 // OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
 // USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "node_http_parser.h"
 #include "node.h"
 #include "node_buffer.h"
+#include "node_external_reference.h"
 #include "util.h"
 
 #include "async_wrap-inl.h"
@@ -69,6 +71,8 @@ using v8::Uint32;
 using v8::Undefined;
 using v8::Value;
 
+using http_parser::BindingData;
+
 const uint32_t kOnMessageBegin = 0;
 const uint32_t kOnHeaders = 1;
 const uint32_t kOnHeadersComplete = 2;
@@ -78,6 +82,10 @@ const uint32_t kOnExecute = 5;
 const uint32_t kOnTimeout = 6;
 // Any more fields than this will be flushed into JS
 const size_t kMaxHeaderFieldsCount = 32;
+// Writes to a socket consumed with corking enabled that are smaller than this
+// are corked, so that the small writes which make up a response leave in a
+// single write.
+const size_t kCorkThreshold = 16 * 1024;
 
 const uint32_t kLenientNone = 0;
 const uint32_t kLenientHeaders = 1 << 0;
@@ -90,23 +98,6 @@ inline bool IsOWS(char c) {
   return c == ' ' || c == '\t';
 }
 
-class BindingData : public BaseObject {
- public:
-  BindingData(Environment* env, Local<Object> obj)
-      : BaseObject(env, obj) {}
-
-  static constexpr FastStringKey type_name { "http_parser" };
-
-  std::vector<char> parser_buffer;
-  bool parser_buffer_in_use = false;
-
-  void MemoryInfo(MemoryTracker* tracker) const override {
-    tracker->TrackField("parser_buffer", parser_buffer);
-  }
-  SET_SELF_SIZE(BindingData)
-  SET_MEMORY_INFO_NAME(BindingData)
-};
-
 // helper class for the Parser
 struct StringPtr {
   StringPtr() {
@@ -610,6 +601,8 @@ class Parser : public AsyncWrap, public StreamListener {
   }
 
 
+  // consume(handle[, cork]): With `cork`, writes to the handle are corked
+  // for as long as the parser consumes it; see StreamBase::SetCorkThreshold().
   static void Consume(const FunctionCallbackInfo<Value>& args) {
     Parser* parser;
     ASSIGN_OR_RETURN_UNWRAP(&parser, args.Holder());
@@ -617,6 +610,11 @@ class Parser : public AsyncWrap, public StreamListener {
     StreamBase* stream = StreamBase::FromObject(args[0].As<Object>());
     CHECK_NOT_NULL(stream);
     stream->PushStreamListener(parser);
+    // Not all streams can be corked; those are left as they are.
+    if (args[1]->IsTrue() && stream->SupportsCork()) {
+      stream->SetCorkThreshold(kCorkThreshold);
+      parser->corked_ = true;
+    }
   }
 
 
@@ -628,6 +626,13 @@ class Parser : public AsyncWrap, public StreamListener {
     if (parser->stream_ == nullptr)
       return;
 
+    // Writes out what is still corked, so that an upgraded connection
+    // starts with the whole response on the wire. Consume() only accepts
+    // StreamBase instances.
+    if (parser->corked_) {
+      static_cast<StreamBase*>(parser->stream_)->SetCorkThreshold(0);
+      parser->corked_ = false;
+    }
     parser->stream_->RemoveStreamListener(parser);
   }
 
@@ -924,6 +929,8 @@ class Parser : public AsyncWrap, public StreamListener {
   const char* current_buffer_data_;
   unsigned int execute_depth_ = 0;
   bool pending_pause_ = false;
+  // Whether Consume() corked the stream.
+  bool corked_ = false;
   uint64_t header_nread_ = 0;
   uint64_t max_http_header_size_;
   uint64_t headers_timeout_;
@@ -1043,6 +1050,59 @@ void InitializeHttpParser(Local<Object> target,
 }
 
 }  // anonymous namespace
+
+namespace http_parser {
+
+BindingData::BindingData(Environment* env, Local<Object> obj)
+    : SnapshotableObject(env, obj, type_int) {}
+
+void BindingData::PrepareForSerialization(Local<Context> context,
+                                          v8::SnapshotCreator* creator) {
+  // The buffer is only used during a single execute() call and is
+  // re-allocated on demand.
+  CHECK(!parser_buffer_in_use);
+  parser_buffer.clear();
+  parser_buffer.shrink_to_fit();
+}
+
+InternalFieldInfo* BindingData::Serialize(int index) {
+  DCHECK_EQ(index, BaseObject::kSlot);
+  InternalFieldInfo* info = InternalFieldInfo::New(type());
+  return info;
+}
+
+void BindingData::Deserialize(Local<Context> context,
+                              Local<Object> holder,
+                              int index,
+                              InternalFieldInfo* info) {
+  DCHECK_EQ(index, BaseObject::kSlot);
+  HandleScope scope(context->GetIsolate());
+  Environment* env = Environment::GetCurrent(context);
+  BindingData* binding = env->AddBindingData<BindingData>(context, holder);
+  CHECK_NOT_NULL(binding);
+}
+
+void BindingData::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("parser_buffer", parser_buffer);
+}
+
+void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  registry->Register(Parser::New);
+  registry->Register(Parser::Close);
+  registry->Register(Parser::Free);
+  registry->Register(Parser::Execute);
+  registry->Register(Parser::Finish);
+  registry->Register(Parser::Initialize);
+  registry->Register(Parser::Pause<true>);
+  registry->Register(Parser::Pause<false>);
+  registry->Register(Parser::Consume);
+  registry->Register(Parser::Unconsume);
+  registry->Register(Parser::GetCurrentBuffer);
+}
+
+}  // namespace http_parser
 }  // namespace node
 
 NODE_MODULE_CONTEXT_AWARE_INTERNAL(http_parser, node::InitializeHttpParser)
+NODE_MODULE_EXTERNAL_REFERENCE(http_parser,
+                               node::http_parser::RegisterExternalReferences)
@@ -0,0 +1,43 @@
+#ifndef SRC_NODE_HTTP_PARSER_H_
+#define SRC_NODE_HTTP_PARSER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <vector>
+#include "base_object.h"
+#include "node_snapshotable.h"
+#include "util.h"
+#include "v8.h"
+
+namespace node {
+class Environment;
+class ExternalReferenceRegistry;
+struct InternalFieldInfo;
+
+namespace http_parser {
+class BindingData : public SnapshotableObject {
+ public:
+  BindingData(Environment* env, v8::Local<v8::Object> obj);
+
+  SERIALIZABLE_OBJECT_METHODS()
+  static constexpr FastStringKey type_name{"node::http_parser::BindingData"};
+  static constexpr EmbedderObjectType type_int =
+      EmbedderObjectType::k_http_parser_binding_data;
+
+  std::vector<char> parser_buffer;
+  bool parser_buffer_in_use = false;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_SELF_SIZE(BindingData)
+  SET_MEMORY_INFO_NAME(BindingData)
+};
+
+void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+}  // namespace http_parser
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_HTTP_PARSER_H_
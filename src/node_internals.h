@@ -95,8 +95,11 @@ std::string GetHumanReadableProcessName();
 v8::Maybe<bool> InitializeContextRuntime(v8::Local<v8::Context> context);
 v8::Maybe<bool> InitializePrimordials(v8::Local<v8::Context> context);
 
-class NodeArrayBufferAllocator : public ArrayBufferAllocator {
+class NodeArrayBufferAllocator : public ArrayBufferAllocator,
+                                 public MemoryRetainer {
  public:
+  NodeArrayBufferAllocator();
+
   inline uint32_t* zero_fill_field() { return &zero_fill_field_; }
 
   void* Allocate(size_t size) override;  // Defined in src/node.cc
@@ -115,9 +118,24 @@ class NodeArrayBufferAllocator : public ArrayBufferAllocator {
     return total_mem_usage_.load(std::memory_order_relaxed);
   }
 
- private:
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(NodeArrayBufferAllocator)
+  SET_SELF_SIZE(NodeArrayBufferAllocator)
+
+ protected:
+  // With --heap-huge-pages, allocations of at least this size are mapped
+  // directly, so that they can be backed by transparent huge pages.
+  static constexpr size_t kMinHugePageAllocationSize = 2 * 1024 * 1024;
+
+  inline bool UsesHugePages(size_t size) const {
+    return huge_pages_ && size >= kMinHugePageAllocationSize;
+  }
+
   uint32_t zero_fill_field_ = 1;  // Boolean but exposed as uint32 to JS land.
   std::atomic<size_t> total_mem_usage_ {0};
+
+ private:
+  const bool huge_pages_;
 };
 
 class DebuggingArrayBufferAllocator final : public NodeArrayBufferAllocator {
@@ -137,6 +155,36 @@ class DebuggingArrayBufferAllocator final : public NodeArrayBufferAllocator {
   std::unordered_map<void*, size_t> allocations_;
 };
 
+// Serves allocations between kMinArenaSize and kMaxArenaSize from
+// process-wide size-class arenas (see src/arena_allocator.cc), with a
+// per-thread cache of free blocks in front of each size class. Very large
+// allocations are mapped directly so that they can use transparent huge
+// pages and are returned to the OS immediately when freed. Everything else
+// goes through malloc() as usual.
+class ArenaArrayBufferAllocator final : public NodeArrayBufferAllocator {
+ public:
+  static constexpr size_t kMinArenaSize = 256;
+  static constexpr size_t kMaxArenaSize = 1024 * 1024;
+  static constexpr size_t kMaxSizeClasses = 64;
+
+  void* Allocate(size_t size) override;
+  void* AllocateUninitialized(size_t size) override;
+  void Free(void* data, size_t size) override;
+  void* Reallocate(void* data, size_t old_size, size_t size) override;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(ArenaArrayBufferAllocator)
+  SET_SELF_SIZE(ArenaArrayBufferAllocator)
+
+ private:
+  void* AllocateImpl(size_t size, bool zero_fill);
+
+  // Per-size-class statistics for this allocator; the arenas themselves
+  // are shared by all instances.
+  std::atomic<size_t> blocks_in_use_[kMaxSizeClasses] = {};
+  std::atomic<size_t> mapped_bytes_ {0};
+};
+
 namespace Buffer {
 v8::MaybeLocal<v8::Object> Copy(Environment* env, const char* data, size_t len);
 v8::MaybeLocal<v8::Object> New(Environment* env, size_t size);
@@ -256,7 +256,7 @@ MaybeLocal<Function> NativeModuleLoader::LookupAndCompile(
       OneByteString(isolate, filename_s.c_str(), filename_s.size());
   ScriptOrigin origin(isolate, filename, 0, 0, true);
 
-  ScriptCompiler::CachedData* cached_data = nullptr;
+  std::unique_ptr<ScriptCompiler::CachedData> cache_entry;
   {
     // Note: The lock here should not extend into the
     // `CompileFunctionInContext()` call below, because this function may
@@ -265,12 +265,25 @@ MaybeLocal<Function> NativeModuleLoader::LookupAndCompile(
     Mutex::ScopedLock lock(code_cache_mutex_);
     auto cache_it = code_cache_.find(id);
     if (cache_it != code_cache_.end()) {
-      // Transfer ownership to ScriptCompiler::Source later.
-      cached_data = cache_it->second.release();
+      // Take the entry out of the map while compiling so that no other
+      // thread can free it in the meantime.
+      cache_entry = std::move(cache_it->second);
       code_cache_.erase(cache_it);
     }
   }
 
+  // ScriptCompiler::Source takes ownership of the CachedData it is given,
+  // so hand it a view of the entry's buffer instead of the entry itself.
+  // The embedded code cache lives in the read-only data of the binary and
+  // is never copied.
+  ScriptCompiler::CachedData* cached_data = nullptr;
+  if (cache_entry) {
+    cached_data = new ScriptCompiler::CachedData(
+        cache_entry->data,
+        cache_entry->length,
+        ScriptCompiler::CachedData::BufferNotOwned);
+  }
+
   const bool has_cache = cached_data != nullptr;
   ScriptCompiler::CompileOptions options =
       has_cache ? ScriptCompiler::kConsumeCodeCache
@@ -304,10 +317,18 @@ MaybeLocal<Function> NativeModuleLoader::LookupAndCompile(
   *result = (has_cache && !script_source.GetCachedData()->rejected)
                 ? Result::kWithCache
                 : Result::kWithoutCache;
-  // Generate new cache for next compilation
-  std::unique_ptr<ScriptCompiler::CachedData> new_cached_data(
-      ScriptCompiler::CreateCodeCacheForFunction(fun));
-  CHECK_NOT_NULL(new_cached_data);
+
+  std::unique_ptr<ScriptCompiler::CachedData> new_cached_data;
+  if (*result == Result::kWithCache) {
+    // The cache was accepted, so it can be reused for the next compilation
+    // as-is. Regenerating it would only cost time and a private copy of
+    // every builtin's code cache in each process.
+    new_cached_data = std::move(cache_entry);
+  } else {
+    // Generate new cache for next compilation
+    new_cached_data.reset(ScriptCompiler::CreateCodeCacheForFunction(fun));
+    CHECK_NOT_NULL(new_cached_data);
+  }
 
   {
     Mutex::ScopedLock lock(code_cache_mutex_);
@@ -90,6 +90,12 @@ void PerProcessOptions::CheckOptions(std::vector<std::string>* errors) {
       use_largepages != "silent") {
     errors->push_back("invalid value for --use-largepages");
   }
+
+  if (!build_snapshot && !snapshot_blob.empty() &&
+      !per_isolate->node_snapshot) {
+    errors->push_back("--snapshot-blob cannot be used with "
+                      "--no-node-snapshot");
+  }
   per_isolate->CheckOptions(errors);
 }
 
@@ -147,17 +153,41 @@ void EnvironmentOptions::CheckOptions(std::vector<std::string>* errors) {
     if (!cpu_prof_name.empty()) {
       errors->push_back("--cpu-prof-name must be used with --cpu-prof");
     }
+  }
+
+  if (!cpu_prof && !cpu_prof_continuous) {
     if (!cpu_prof_dir.empty()) {
-      errors->push_back("--cpu-prof-dir must be used with --cpu-prof");
+      errors->push_back("--cpu-prof-dir must be used with --cpu-prof or "
+                        "--cpu-prof-continuous");
     }
     // We can't catch the case where the value passed is the default value,
     // then the option just becomes a noop which is fine.
     if (cpu_prof_interval != kDefaultCpuProfInterval) {
-      errors->push_back("--cpu-prof-interval must be used with --cpu-prof");
+      errors->push_back("--cpu-prof-interval must be used with --cpu-prof or "
+                        "--cpu-prof-continuous");
     }
   }
 
-  if (cpu_prof && cpu_prof_dir.empty() && !diagnostic_dir.empty()) {
+  if (cpu_prof && cpu_prof_continuous) {
+    errors->push_back("either --cpu-prof or --cpu-prof-continuous can be "
+                      "used, not both");
+  }
+
+  if (!cpu_prof_continuous) {
+    if (cpu_prof_continuous_period != kDefaultCpuProfContinuousPeriod) {
+      errors->push_back("--cpu-prof-continuous-period must be used with "
+                        "--cpu-prof-continuous");
+    }
+    if (cpu_prof_continuous_max_files != kDefaultCpuProfContinuousMaxFiles) {
+      errors->push_back("--cpu-prof-continuous-max-files must be used with "
+                        "--cpu-prof-continuous");
+    }
+  } else if (cpu_prof_continuous_period == 0) {
+    errors->push_back("--cpu-prof-continuous-period must be greater than 0");
+  }
+
+  if ((cpu_prof || cpu_prof_continuous) &&
+      cpu_prof_dir.empty() && !diagnostic_dir.empty()) {
       cpu_prof_dir = diagnostic_dir;
     }
 
@@ -292,6 +322,11 @@ DebugOptionsParser::DebugOptionsParser() {
 }
 
 EnvironmentOptionsParser::EnvironmentOptionsParser() {
+  AddOption("--compile-cache-dir",
+            "persist the V8 code cache of user-land CommonJS and ES modules "
+            "in the given directory and reuse it across runs",
+            &EnvironmentOptions::compile_cache_dir,
+            kAllowedInEnvironment);
   AddOption("--conditions",
             "additional user conditions for conditional exports and imports",
             &EnvironmentOptions::conditions,
@@ -315,6 +350,11 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             kAllowedInEnvironment);
   AddOption("--experimental-abortcontroller", "",
             NoOp{}, kAllowedInEnvironment);
+  AddOption("--experimental-esm-background-compile",
+            "read and compile the static dependencies of ES modules on "
+            "background threads ahead of the module loader",
+            &EnvironmentOptions::experimental_esm_background_compile,
+            kAllowedInEnvironment);
   AddOption("--experimental-fetch",
             "experimental Fetch API",
             &EnvironmentOptions::experimental_fetch,
@@ -331,6 +371,11 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             kAllowedInEnvironment);
   AddAlias("--loader", "--experimental-loader");
   AddOption("--experimental-modules", "", NoOp{}, kAllowedInEnvironment);
+  AddOption("--experimental-module-stat-cache",
+            "cache the file system lookups of the CommonJS resolver for "
+            "the lifetime of the process",
+            &EnvironmentOptions::experimental_module_stat_cache,
+            kAllowedInEnvironment);
   AddOption("--experimental-network-imports",
             "experimental https: support for the ES Module loader",
             &EnvironmentOptions::experimental_https_modules,
@@ -464,12 +509,27 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             &EnvironmentOptions::cpu_prof_name);
   AddOption("--cpu-prof-interval",
             "specified sampling interval in microseconds for the V8 CPU "
-            "profile generated with --cpu-prof. (default: 1000)",
+            "profile generated with --cpu-prof or --cpu-prof-continuous. "
+            "(default: 1000)",
             &EnvironmentOptions::cpu_prof_interval);
   AddOption("--cpu-prof-dir",
-            "Directory where the V8 profiles generated by --cpu-prof will be "
-            "placed. Does not affect --prof.",
+            "Directory where the V8 profiles generated by --cpu-prof or "
+            "--cpu-prof-continuous will be placed. Does not affect --prof.",
             &EnvironmentOptions::cpu_prof_dir);
+  AddOption("--cpu-prof-continuous",
+            "Keep the V8 CPU profiler running for the lifetime of the "
+            "process, and periodically write the samples collected so far "
+            "to disk as gzipped pprof files.",
+            &EnvironmentOptions::cpu_prof_continuous);
+  AddOption("--cpu-prof-continuous-period",
+            "specified interval in seconds between two profiles written by "
+            "--cpu-prof-continuous. (default: 60)",
+            &EnvironmentOptions::cpu_prof_continuous_period);
+  AddOption("--cpu-prof-continuous-max-files",
+            "specified number of profiles written by --cpu-prof-continuous "
+            "to keep on disk, older ones are removed. 0 keeps all of them. "
+            "(default: 10)",
+            &EnvironmentOptions::cpu_prof_continuous_max_files);
   AddOption(
       "--heap-prof",
       "Start the V8 heap profiler on start up, and write the heap profile "
@@ -720,6 +780,11 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "", /* undocumented, only for debugging */
             &PerProcessOptions::debug_arraybuffer_allocations,
             kAllowedInEnvironment);
+  AddOption("--arraybuffer-arenas",
+            "serve ArrayBuffer allocations from size-class arenas with "
+            "per-thread caches",
+            &PerProcessOptions::arraybuffer_arenas,
+            kAllowedInEnvironment);
   AddOption("--disable-proto",
             "disable Object.prototype.__proto__",
             &PerProcessOptions::disable_proto,
@@ -743,6 +808,16 @@ PerProcessOptionsParser::PerProcessOptionsParser(
   AddOption("--v8-options",
             "print V8 command line options",
             &PerProcessOptions::print_v8_help);
+  AddOption("--build-snapshot",
+            "Generate a startup snapshot blob after running the entry "
+            "script and exit. The blob is written to the path given by "
+            "--snapshot-blob (default: snapshot.blob)",
+            &PerProcessOptions::build_snapshot);
+  AddOption("--snapshot-blob",
+            "Path to the startup snapshot blob to generate with "
+            "--build-snapshot, or to boot from otherwise",
+            &PerProcessOptions::snapshot_blob,
+            kAllowedInEnvironment);
   AddOption("--report-compact",
             "output compact single-line JSON",
             &PerProcessOptions::report_compact,
@@ -839,6 +914,11 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "or 'silent' (map and silently ignore failure)",
             &PerProcessOptions::use_largepages,
             kAllowedInEnvironment);
+  AddOption("--heap-huge-pages",
+            "ask the OS to back the V8 heap and large ArrayBuffers with "
+            "transparent huge pages (Linux only)",
+            &PerProcessOptions::heap_huge_pages,
+            kAllowedInEnvironment);
 
   AddOption("--trace-sigint",
             "enable printing JavaScript stacktrace on SIGINT",
@@ -104,12 +104,15 @@ class DebugOptions : public Options {
 class EnvironmentOptions : public Options {
  public:
   bool abort_on_uncaught_exception = false;
+  std::string compile_cache_dir;
   std::vector<std::string> conditions;
   std::string dns_result_order;
   bool enable_source_maps = false;
+  bool experimental_esm_background_compile = false;
   bool experimental_fetch = true;
   bool experimental_global_web_crypto = false;
   bool experimental_https_modules = false;
+  bool experimental_module_stat_cache = false;
   std::string experimental_specifier_resolution;
   bool experimental_wasm_modules = false;
   bool experimental_import_meta_resolve = false;
@@ -140,6 +143,11 @@ class EnvironmentOptions : public Options {
   uint64_t cpu_prof_interval = kDefaultCpuProfInterval;
   std::string cpu_prof_name;
   bool cpu_prof = false;
+  bool cpu_prof_continuous = false;
+  static const uint64_t kDefaultCpuProfContinuousPeriod = 60;
+  uint64_t cpu_prof_continuous_period = kDefaultCpuProfContinuousPeriod;
+  static const uint64_t kDefaultCpuProfContinuousMaxFiles = 10;
+  uint64_t cpu_prof_continuous_max_files = kDefaultCpuProfContinuousMaxFiles;
   std::string heap_prof_dir;
   std::string heap_prof_name;
   static const uint64_t kDefaultHeapProfInterval = 512 * 1024;
@@ -228,6 +236,7 @@ class PerProcessOptions : public Options {
   int64_t v8_thread_pool_size = 4;
   bool zero_fill_all_buffers = false;
   bool debug_arraybuffer_allocations = false;
+  bool arraybuffer_arenas = false;
   std::string disable_proto;
 
   std::vector<std::string> security_reverts;
@@ -235,6 +244,8 @@ class PerProcessOptions : public Options {
   bool print_help = false;
   bool print_v8_help = false;
   bool print_version = false;
+  bool build_snapshot = false;
+  std::string snapshot_blob;
 
 #ifdef NODE_HAVE_I18N_SUPPORT
   std::string icu_data_dir;
@@ -269,6 +280,7 @@ class PerProcessOptions : public Options {
 
   // TODO(addaleax): Some of these could probably be per-Environment.
   std::string use_largepages = "off";
+  bool heap_huge_pages = false;
   bool trace_sigint = false;
   std::vector<std::string> cmdline;
 
@@ -0,0 +1,255 @@
+#include "node_page_allocator.h"
+#include "node_mutex.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+
+#ifdef __POSIX__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace node {
+
+void* MapAnonymousMemory(size_t size, bool huge_pages) {
+#ifdef __POSIX__
+  void* ret = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ret == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+  if (huge_pages) madvise(ret, size, MADV_HUGEPAGE);
+#endif
+  return ret;
+#else
+  return UncheckedCalloc(size);
+#endif
+}
+
+void UnmapAnonymousMemory(void* data, size_t size) {
+#ifdef __POSIX__
+  CHECK_EQ(0, munmap(data, size));
+#else
+  free(data);
+#endif
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+
+namespace {
+
+// A v8::PageAllocator that behaves like V8's built-in one on Linux, except
+// that it marks all memory that V8 reserves for data (as opposed to code) as
+// eligible for transparent huge pages. V8 reserves its heap in large chunks
+// and commits 256 KB pages within them, so the kernel can back every 2 MB
+// range of committed heap pages with a single huge page, reducing the TLB
+// misses of large heaps.
+class HugePageAllocator final : public v8::PageAllocator {
+ public:
+  HugePageAllocator()
+      : page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))),
+        random_state_(uv_hrtime() | 1) {}
+
+  size_t AllocatePageSize() override { return page_size_; }
+  size_t CommitPageSize() override { return page_size_; }
+
+  void SetRandomMmapSeed(int64_t seed) override {
+    if (seed == 0) return;
+    Mutex::ScopedLock lock(mutex_);
+    random_state_ = static_cast<uint64_t>(seed);
+  }
+
+  void* GetRandomMmapAddr() override {
+#if defined(__x86_64__) || defined(__aarch64__)
+    uint64_t raw_addr;
+    {
+      Mutex::ScopedLock lock(mutex_);
+      // xorshift64*
+      random_state_ ^= random_state_ >> 12;
+      random_state_ ^= random_state_ << 25;
+      random_state_ ^= random_state_ >> 27;
+      raw_addr = random_state_ * 0x2545F4914F6CDD1DULL;
+    }
+    // Stay within the 46-bit range that V8 uses for hints on these
+    // architectures, which all supported kernels make available to user
+    // space.
+    raw_addr &= uint64_t{0x3FFFFFFFF000};
+    return reinterpret_cast<void*>(raw_addr);
+#else
+    return nullptr;
+#endif
+  }
+
+  void* AllocatePages(void* hint,
+                      size_t size,
+                      size_t alignment,
+                      Permission access) override {
+    CHECK_EQ(0, size % page_size_);
+    CHECK_EQ(0, alignment % page_size_);
+    hint = reinterpret_cast<void*>(
+        reinterpret_cast<uintptr_t>(hint) & ~(alignment - 1));
+
+    // Over-allocate so that an aligned range can be carved out, then
+    // unmap the excess on both sides.
+    size_t request_size = size + (alignment - page_size_);
+    uint8_t* base = static_cast<uint8_t*>(Map(hint, request_size, access));
+    if (base == nullptr) return nullptr;
+
+    uintptr_t base_addr = reinterpret_cast<uintptr_t>(base);
+    uint8_t* aligned_base = reinterpret_cast<uint8_t*>(
+        (base_addr + alignment - 1) & ~(alignment - 1));
+    if (aligned_base != base) {
+      CHECK_EQ(0, munmap(base, aligned_base - base));
+    }
+    uint8_t* end = base + request_size;
+    uint8_t* aligned_end = aligned_base + size;
+    if (aligned_end != end) {
+      CHECK_EQ(0, munmap(aligned_end, end - aligned_end));
+    }
+
+    if (IsDataPermission(access)) MarkHugePages(aligned_base, size);
+    return aligned_base;
+  }
+
+  bool FreePages(void* address, size_t size) override {
+    if (munmap(address, size) != 0) return false;
+    ForgetHugePages(address, size);
+    return true;
+  }
+
+  bool ReleasePages(void* address, size_t size, size_t new_size) override {
+    CHECK_LT(new_size, size);
+    uint8_t* released = static_cast<uint8_t*>(address) + new_size;
+    if (munmap(released, size - new_size) != 0) return false;
+    ForgetHugePages(released, size - new_size);
+    return true;
+  }
+
+  bool SetPermissions(void* address,
+                      size_t size,
+                      Permission access) override {
+    if (mprotect(address, size, GetProtection(access)) != 0) return false;
+    // Like V8's allocator, return the pages of inaccessible memory to the
+    // OS right away.
+    if (access == kNoAccess) DiscardSystemPages(address, size);
+    return true;
+  }
+
+  bool DiscardSystemPages(void* address, size_t size) override {
+#ifdef MADV_FREE
+    if (madvise(address, size, MADV_FREE) == 0) return true;
+    // MADV_FREE is not supported by kernels older than 4.5.
+    if (errno != EINVAL) return false;
+#endif
+    return madvise(address, size, MADV_DONTNEED) == 0;
+  }
+
+  bool DecommitPages(void* address, size_t size) override {
+    // Replacing the pages with a fresh inaccessible mapping frees them and
+    // makes sure that they read back as zeroes once they are committed
+    // again.
+    void* ret = mmap(address, size, PROT_NONE,
+                     MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ret != address) return false;
+    // The new mapping does not inherit the huge page advice. Within data
+    // allocations that had it, apply it again even to small ranges, so that
+    // the kernel can merge the mapping with its neighbours once the pages
+    // are committed again. Code memory never gets it.
+    if (IsInHugePages(address, size)) madvise(address, size, MADV_HUGEPAGE);
+    return true;
+  }
+
+ private:
+  static int GetProtection(Permission access) {
+    switch (access) {
+      case kNoAccess:
+      case kNoAccessWillJitLater:
+        return PROT_NONE;
+      case kRead:
+        return PROT_READ;
+      case kReadWrite:
+        return PROT_READ | PROT_WRITE;
+      case kReadWriteExecute:
+        return PROT_READ | PROT_WRITE | PROT_EXEC;
+      case kReadExecute:
+        return PROT_READ | PROT_EXEC;
+    }
+    UNREACHABLE();
+  }
+
+  // Memory that V8 maps as executable, or reserves for JIT code, is left
+  // alone: V8 changes the permissions of code pages often, which splits the
+  // mappings and keeps them from using huge pages anyway.
+  static bool IsDataPermission(Permission access) {
+    return access == kNoAccess || access == kRead || access == kReadWrite;
+  }
+
+  void* Map(void* hint, size_t size, Permission access) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    // Reservations are not backed by memory until they are committed.
+    if (access == kNoAccess || access == kNoAccessWillJitLater)
+      flags |= MAP_NORESERVE;
+    void* ret = mmap(hint, size, GetProtection(access), flags, -1, 0);
+    return ret == MAP_FAILED ? nullptr : ret;
+  }
+
+  void MarkHugePages(void* address, size_t size) {
+    // Only whole huge pages can be backed by one; there is no point in
+    // splitting the mapping for smaller ranges.
+    if (size < kHugePageSize) return;
+    if (madvise(address, size, MADV_HUGEPAGE) != 0) return;
+    Mutex::ScopedLock lock(mutex_);
+    huge_page_ranges_[reinterpret_cast<uintptr_t>(address)] = size;
+  }
+
+  // Drops the unmapped range [address, address + size) from the ranges
+  // advised to use huge pages. V8 only ever unmaps whole allocations or
+  // their tails.
+  void ForgetHugePages(void* address, size_t size) {
+    const uintptr_t start = reinterpret_cast<uintptr_t>(address);
+    Mutex::ScopedLock lock(mutex_);
+    auto it = huge_page_ranges_.upper_bound(start);
+    if (it == huge_page_ranges_.begin()) return;
+    --it;
+    if (start >= it->first + it->second) return;
+    if (start == it->first)
+      huge_page_ranges_.erase(it);
+    else
+      it->second = start - it->first;
+  }
+
+  bool IsInHugePages(void* address, size_t size) {
+    const uintptr_t start = reinterpret_cast<uintptr_t>(address);
+    Mutex::ScopedLock lock(mutex_);
+    auto it = huge_page_ranges_.upper_bound(start);
+    if (it == huge_page_ranges_.begin()) return false;
+    --it;
+    return start + size <= it->first + it->second;
+  }
+
+  const size_t page_size_;
+  Mutex mutex_;
+  uint64_t random_state_;
+  // Start and size of the data allocations advised to use huge pages.
+  std::map<uintptr_t, size_t> huge_page_ranges_;
+};
+
+}  // anonymous namespace
+
+v8::PageAllocator* GetHugePageAllocator() {
+  static HugePageAllocator* allocator = new HugePageAllocator();
+  return allocator;
+}
+
+#else  // !(defined(__linux__) && defined(MADV_HUGEPAGE))
+
+v8::PageAllocator* GetHugePageAllocator() {
+  return nullptr;
+}
+
+#endif  // defined(__linux__) && defined(MADV_HUGEPAGE)
+
+}  // namespace node
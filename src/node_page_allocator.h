@@ -0,0 +1,31 @@
+#ifndef SRC_NODE_PAGE_ALLOCATOR_H_
+#define SRC_NODE_PAGE_ALLOCATOR_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include "v8-platform.h"
+
+namespace node {
+
+// The size of a transparent huge page on x64 and arm64 Linux.
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Maps `size` bytes of zero-filled, read-write memory. If `huge_pages` is
+// set, the kernel is asked to back the mapping with transparent huge pages
+// where possible. Returns nullptr on failure. On platforms without mmap(),
+// falls back to calloc().
+void* MapAnonymousMemory(size_t size, bool huge_pages);
+void UnmapAnonymousMemory(void* data, size_t size);
+
+// Returns a page allocator for V8 that asks for transparent huge pages to
+// back the V8 heap (see --heap-huge-pages), or nullptr if that is not
+// supported on this platform. The allocator is created on first use and
+// lives until the process exits, since V8 holds on to it.
+v8::PageAllocator* GetHugePageAllocator();
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_PAGE_ALLOCATOR_H_
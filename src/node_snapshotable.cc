@@ -1,6 +1,7 @@
 
 #include "node_snapshotable.h"
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include "base_object-inl.h"
 #include "debug_utils-inl.h"
@@ -9,22 +10,30 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "node_file.h"
+#include "node_http_parser.h"
 #include "node_internals.h"
 #include "node_main_instance.h"
 #include "node_process.h"
 #include "node_v8.h"
 #include "node_v8_platform-inl.h"
+#include "node_version.h"
 
 namespace node {
 
 using v8::Context;
+using v8::Function;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
+using v8::MaybeLocal;
 using v8::Object;
+using v8::ScriptCompiler;
+using v8::ScriptOrigin;
 using v8::SnapshotCreator;
 using v8::StartupData;
+using v8::String;
 using v8::TryCatch;
+using v8::Undefined;
 using v8::Value;
 
 template <typename T>
@@ -84,9 +93,296 @@ const EnvSerializeInfo* NodeMainInstance::GetEnvSerializeInfo() {
   return ss.str();
 }
 
-void SnapshotBuilder::Generate(SnapshotData* out,
-                               const std::vector<std::string> args,
-                               const std::vector<std::string> exec_args) {
+namespace {
+
+// Blob files written by --build-snapshot start with this magic number,
+// followed by the version, architecture and platform of the binary that
+// generated them. V8 can only deserialize a snapshot from the exact build
+// that created it, so we refuse to load blobs from anywhere else instead of
+// letting V8 abort on a checksum mismatch.
+constexpr uint32_t kSnapshotBlobMagic = 0x4e534e50;  // "NSNP"
+
+class SnapshotBlobWriter {
+ public:
+  void Write(size_t value) { Append(&value, sizeof(value)); }
+
+  void Write(const std::string& str) {
+    Write(str.size());
+    Append(str.data(), str.size());
+  }
+
+  void Write(const PropInfo& info) {
+    Write(info.name);
+    Write(info.id);
+    Write(info.index);
+  }
+
+  template <typename T>
+  void Write(const std::vector<T>& vec) {
+    Write(vec.size());
+    for (const T& item : vec) Write(item);
+  }
+
+  void Append(const void* data, size_t length) {
+    buffer_.append(static_cast<const char*>(data), length);
+  }
+
+  const std::string& buffer() const { return buffer_; }
+
+ private:
+  std::string buffer_;
+};
+
+class SnapshotBlobReader {
+ public:
+  explicit SnapshotBlobReader(const std::string& buffer) : buffer_(buffer) {}
+
+  bool Read(size_t* value) { return Consume(value, sizeof(*value)); }
+
+  bool Read(std::string* str) {
+    size_t length;
+    if (!Read(&length) || length > buffer_.size() - offset_) return false;
+    str->assign(buffer_.data() + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+  bool Read(PropInfo* info) {
+    return Read(&info->name) && Read(&info->id) && Read(&info->index);
+  }
+
+  template <typename T>
+  bool Read(std::vector<T>* vec) {
+    size_t size;
+    if (!Read(&size)) return false;
+    // Every element takes up at least one byte, so this also rejects
+    // corrupted sizes before allocating anything.
+    if (size > buffer_.size() - offset_) return false;
+    vec->resize(size);
+    for (T& item : *vec) {
+      if (!Read(&item)) return false;
+    }
+    return true;
+  }
+
+  bool Consume(void* out, size_t length) {
+    if (length > buffer_.size() - offset_) return false;
+    memcpy(out, buffer_.data() + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+  bool done() const { return offset_ == buffer_.size(); }
+
+ private:
+  const std::string& buffer_;
+  size_t offset_ = 0;
+};
+
+#ifdef _WIN32
+constexpr const char* kPathSeparators = "\\/";
+#else
+constexpr const char* kPathSeparators = "/";
+#endif
+
+// Like path.isAbsolute(). On Windows, that includes paths that are only
+// rooted on the current drive, like \dir\file.
+bool IsAbsoluteFilePath(const std::string& path) {
+  if (path.empty()) return false;
+  if (strchr(kPathSeparators, path[0]) != nullptr) return true;
+#ifdef _WIN32
+  char drive = ToLower(path[0]);
+  return path.size() >= 3 && drive >= 'a' && drive <= 'z' && path[1] == ':' &&
+         strchr(kPathSeparators, path[2]) != nullptr;
+#else
+  return false;
+#endif
+}
+
+std::string GetSnapshotBlobBuildInfo() {
+  return std::string(NODE_VERSION) + "-" + NODE_ARCH + "-" + NODE_PLATFORM;
+}
+
+// Runs the entry script given to --build-snapshot. The script is wrapped
+// in a function taking (require, __filename, __dirname), where `require`
+// only loads built-in modules, so applications are expected to be bundled
+// into a single file. If the script returns a function, that function is
+// called instead of the usual main script when Node.js boots from the
+// snapshot, with (process, require) as arguments.
+int RunSnapshotEntryScript(Environment* env, const std::string& path) {
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  std::string source;
+  int r = ReadFileSync(&source, path.c_str());
+  if (r != 0) {
+    FPrintF(stderr,
+            "Cannot read snapshot entry script %s: %s\n",
+            path,
+            uv_strerror(r));
+    return 1;
+  }
+
+  std::string filename = path;
+  if (!IsAbsoluteFilePath(filename))
+    filename = env->GetCwd() + kPathSeparator + filename;
+  std::string dirname =
+      filename.substr(0, filename.find_last_of(kPathSeparators));
+
+  TryCatch try_catch(isolate);
+  Local<String> filename_string;
+  Local<String> dirname_string;
+  Local<String> source_string;
+  if (!String::NewFromUtf8(isolate, filename.c_str())
+           .ToLocal(&filename_string) ||
+      !String::NewFromUtf8(isolate, dirname.c_str())
+           .ToLocal(&dirname_string) ||
+      !String::NewFromUtf8(isolate,
+                           source.data(),
+                           v8::NewStringType::kNormal,
+                           static_cast<int>(source.size()))
+           .ToLocal(&source_string)) {
+    return 1;
+  }
+
+  Local<String> parameters[] = {
+      env->require_string(),
+      FIXED_ONE_BYTE_STRING(isolate, "__filename"),
+      FIXED_ONE_BYTE_STRING(isolate, "__dirname"),
+  };
+  Local<Value> arguments[] = {
+      env->native_module_require(),
+      filename_string,
+      dirname_string,
+  };
+
+  ScriptOrigin origin(isolate, filename_string);
+  ScriptCompiler::Source script_source(source_string, origin);
+  Local<Function> fn;
+  MaybeLocal<Value> maybe_result;
+  if (ScriptCompiler::CompileFunction(context,
+                                     &script_source,
+                                     arraysize(parameters),
+                                     parameters)
+          .ToLocal(&fn)) {
+    InternalCallbackScope callback_scope(
+        env,
+        Object::New(isolate),
+        {1, 0},
+        InternalCallbackScope::kSkipAsyncHooks);
+    maybe_result = fn->Call(
+        context, Undefined(isolate), arraysize(arguments), arguments);
+  }
+
+  Local<Value> result;
+  if (!maybe_result.ToLocal(&result)) {
+    if (try_catch.HasCaught() && !try_catch.HasTerminated())
+      PrintCaughtException(isolate, context, try_catch);
+    return 1;
+  }
+  if (result->IsFunction())
+    env->set_snapshot_deserialize_main(result.As<Function>());
+
+  // Let pending asynchronous work finish so that its results end up
+  // in the snapshot as well.
+  do {
+    uv_run(env->event_loop(), UV_RUN_DEFAULT);
+    per_process::v8_platform.DrainVMTasks(isolate);
+  } while (uv_loop_alive(env->event_loop()) && !env->is_stopping());
+
+  return env->is_stopping() ? 1 : 0;
+}
+
+}  // anonymous namespace
+
+bool SnapshotData::ToBlob(FILE* out) const {
+  SnapshotBlobWriter writer;
+  uint32_t magic = kSnapshotBlobMagic;
+  writer.Append(&magic, sizeof(magic));
+  writer.Write(GetSnapshotBlobBuildInfo());
+
+  writer.Write(static_cast<size_t>(blob.raw_size));
+  writer.Append(blob.data, blob.raw_size);
+  writer.Write(isolate_data_indices);
+
+  writer.Write(env_info.bindings);
+  writer.Write(env_info.native_modules);
+  writer.Write(env_info.async_hooks.async_ids_stack);
+  writer.Write(env_info.async_hooks.fields);
+  writer.Write(env_info.async_hooks.async_id_fields);
+  writer.Write(env_info.async_hooks.js_execution_async_resources);
+  writer.Write(env_info.async_hooks.native_execution_async_resources);
+  writer.Write(env_info.tick_info.fields);
+  writer.Write(env_info.immediate_info.fields);
+  writer.Write(env_info.performance_state.root);
+  writer.Write(env_info.performance_state.milestones);
+  writer.Write(env_info.performance_state.observers);
+  writer.Write(env_info.stream_base_state);
+  writer.Write(env_info.should_abort_on_uncaught_toggle);
+  writer.Write(env_info.persistent_templates);
+  writer.Write(env_info.persistent_values);
+  writer.Write(env_info.context);
+
+  const std::string& buffer = writer.buffer();
+  return fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size() &&
+         fflush(out) == 0;
+}
+
+bool SnapshotData::FromBlob(SnapshotData* out, FILE* in) {
+  std::string buffer;
+  char chunk[64 * 1024];
+  size_t nread;
+  while ((nread = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    buffer.append(chunk, nread);
+  if (ferror(in)) return false;
+
+  SnapshotBlobReader reader(buffer);
+  uint32_t magic;
+  std::string build_info;
+  if (!reader.Consume(&magic, sizeof(magic)) || magic != kSnapshotBlobMagic ||
+      !reader.Read(&build_info) || build_info != GetSnapshotBlobBuildInfo()) {
+    return false;
+  }
+
+  size_t blob_size;
+  if (!reader.Read(&blob_size) ||
+      blob_size > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    return false;
+  }
+  std::unique_ptr<char[]> blob_data(new char[blob_size]);
+  if (!reader.Consume(blob_data.get(), blob_size)) return false;
+
+  EnvSerializeInfo* info = &out->env_info;
+  bool ok =
+      reader.Read(&out->isolate_data_indices) &&
+      reader.Read(&info->bindings) &&
+      reader.Read(&info->native_modules) &&
+      reader.Read(&info->async_hooks.async_ids_stack) &&
+      reader.Read(&info->async_hooks.fields) &&
+      reader.Read(&info->async_hooks.async_id_fields) &&
+      reader.Read(&info->async_hooks.js_execution_async_resources) &&
+      reader.Read(&info->async_hooks.native_execution_async_resources) &&
+      reader.Read(&info->tick_info.fields) &&
+      reader.Read(&info->immediate_info.fields) &&
+      reader.Read(&info->performance_state.root) &&
+      reader.Read(&info->performance_state.milestones) &&
+      reader.Read(&info->performance_state.observers) &&
+      reader.Read(&info->stream_base_state) &&
+      reader.Read(&info->should_abort_on_uncaught_toggle) &&
+      reader.Read(&info->persistent_templates) &&
+      reader.Read(&info->persistent_values) &&
+      reader.Read(&info->context) &&
+      reader.done();
+  if (!ok) return false;
+
+  out->blob.data = blob_data.release();
+  out->blob.raw_size = static_cast<int>(blob_size);
+  return true;
+}
+
+int SnapshotBuilder::Generate(SnapshotData* out,
+                              const std::vector<std::string> args,
+                              const std::vector<std::string> exec_args) {
   Isolate* isolate = Isolate::Allocate();
   isolate->SetCaptureStackTraceForUncaughtExceptions(
       true, 10, v8::StackTrace::StackTraceOptions::kDetailed);
@@ -94,6 +390,7 @@ void SnapshotBuilder::Generate(SnapshotData* out,
                                                        uv_default_loop());
   std::unique_ptr<NodeMainInstance> main_instance;
   std::string result;
+  int exit_code = 0;
 
   {
     const std::vector<intptr_t>& external_references =
@@ -143,52 +440,92 @@ void SnapshotBuilder::Generate(SnapshotData* out,
         result.ToLocalChecked();
       }
 
-      if (per_process::enabled_debug_list.enabled(DebugCategory::MKSNAPSHOT)) {
-        env->PrintAllBaseObjects();
-        printf("Environment = %p\n", env);
+      // Run the application entry script when building a user-land
+      // snapshot with --build-snapshot.
+      if (per_process::cli_options->build_snapshot) {
+        CHECK_GT(args.size(), 1);
+        // The entry script may use timers and immediates, which need the
+        // environment's libuv handles.
+        env->InitializeLibuv();
+        exit_code = RunSnapshotEntryScript(env, args[1]);
       }
 
-      // Serialize the native states
-      out->env_info = env->Serialize(&creator);
-      // Serialize the context
-      size_t index = creator.AddContext(
-          context, {SerializeNodeContextInternalFields, env});
-      CHECK_EQ(index, NodeMainInstance::kNodeContextIndex);
+      if (exit_code == 0) {
+        if (per_process::enabled_debug_list.enabled(
+                DebugCategory::MKSNAPSHOT)) {
+          env->PrintAllBaseObjects();
+          printf("Environment = %p\n", env);
+        }
+
+        // Serialize the native states
+        out->env_info = env->Serialize(&creator);
+        // Serialize the context
+        size_t index = creator.AddContext(
+            context, {SerializeNodeContextInternalFields, env});
+        CHECK_EQ(index, NodeMainInstance::kNodeContextIndex);
+      }
     }
 
-    // Must be out of HandleScope
-    out->blob =
-        creator.CreateBlob(SnapshotCreator::FunctionCodeHandling::kClear);
-
-    // We must be able to rehash the blob when we restore it or otherwise
-    // the hash seed would be fixed by V8, introducing a vulnerability.
-    CHECK(out->blob.CanBeRehashed());
-
-    // We cannot resurrect the handles from the snapshot, so make sure that
-    // no handles are left open in the environment after the blob is created
-    // (which should trigger a GC and close all handles that can be closed).
-    if (!env->req_wrap_queue()->IsEmpty()
-        || !env->handle_wrap_queue()->IsEmpty()
-        || per_process::enabled_debug_list.enabled(DebugCategory::MKSNAPSHOT)) {
-      PrintLibuvHandleInformation(env->event_loop(), stderr);
+    if (exit_code == 0) {
+      // Must be out of HandleScope
+      out->blob =
+          creator.CreateBlob(SnapshotCreator::FunctionCodeHandling::kClear);
+
+      // We must be able to rehash the blob when we restore it or otherwise
+      // the hash seed would be fixed by V8, introducing a vulnerability.
+      CHECK(out->blob.CanBeRehashed());
+
+      // We cannot resurrect the handles from the snapshot, so make sure that
+      // no handles are left open in the environment after the blob is
+      // created (which should trigger a GC and close all handles that can be
+      // closed).
+      if (!env->req_wrap_queue()->IsEmpty() ||
+          !env->handle_wrap_queue()->IsEmpty() ||
+          per_process::enabled_debug_list.enabled(
+              DebugCategory::MKSNAPSHOT)) {
+        PrintLibuvHandleInformation(env->event_loop(), stderr);
+      }
+      if (per_process::cli_options->build_snapshot &&
+          (!env->req_wrap_queue()->IsEmpty() ||
+           !env->handle_wrap_queue()->IsEmpty())) {
+        FPrintF(stderr,
+                "Cannot build a snapshot while there are active handles or "
+                "requests, they must be closed by the entry script\n");
+        exit_code = 1;
+      } else {
+        CHECK(env->req_wrap_queue()->IsEmpty());
+        CHECK(env->handle_wrap_queue()->IsEmpty());
+      }
     }
-    CHECK(env->req_wrap_queue()->IsEmpty());
-    CHECK(env->handle_wrap_queue()->IsEmpty());
 
     // Must be done while the snapshot creator isolate is entered i.e. the
     // creator is still alive.
     FreeEnvironment(env);
     main_instance->Dispose();
+
+    if (exit_code != 0) {
+      // The SnapshotCreator must have created a blob before it is destroyed.
+      // Without the environment's context, it only contains what IsolateData
+      // serialized, and is discarded.
+      if (out->blob.data == nullptr) {
+        out->blob =
+            creator.CreateBlob(SnapshotCreator::FunctionCodeHandling::kClear);
+      }
+      delete[] out->blob.data;
+      out->blob.data = nullptr;
+      out->blob.raw_size = 0;
+    }
   }
 
   per_process::v8_platform.Platform()->UnregisterIsolate(isolate);
+  return exit_code;
 }
 
 std::string SnapshotBuilder::Generate(
     const std::vector<std::string> args,
     const std::vector<std::string> exec_args) {
   SnapshotData data;
-  Generate(&data, args, exec_args);
+  CHECK_EQ(Generate(&data, args, exec_args), 0);
   std::string result = FormatBlob(&data);
   delete[] data.blob.data;
   return result;
@@ -17,7 +17,8 @@ struct SnapshotData;
   V(fs_binding_data, fs::BindingData)                                          \
   V(v8_binding_data, v8_utils::BindingData)                                    \
   V(blob_binding_data, BlobBindingData)                                        \
-  V(process_binding_data, process::BindingData)
+  V(process_binding_data, process::BindingData)                                \
+  V(http_parser_binding_data, http_parser::BindingData)
 
 enum class EmbedderObjectType : uint8_t {
   k_default = 0,
@@ -127,9 +128,11 @@ class SnapshotBuilder {
  public:
   static std::string Generate(const std::vector<std::string> args,
                               const std::vector<std::string> exec_args);
-  static void Generate(SnapshotData* out,
-                       const std::vector<std::string> args,
-                       const std::vector<std::string> exec_args);
+  // Returns a non-zero exit code if the entry script of a user-land
+  // snapshot (see --build-snapshot) fails.
+  static int Generate(SnapshotData* out,
+                      const std::vector<std::string> args,
+                      const std::vector<std::string> exec_args);
 };
 }  // namespace node
 
@@ -52,6 +52,9 @@ void StatWatcher::Initialize(Environment* env, Local<Object> target) {
   t->Inherit(HandleWrap::GetConstructorTemplate(env));
 
   env->SetProtoMethod(t, "start", StatWatcher::Start);
+  env->SetProtoMethod(t, "ref", StatWatcher::Ref);
+  env->SetProtoMethod(t, "unref", StatWatcher::Unref);
+  env->SetProtoMethod(t, "hasRef", StatWatcher::HasRef);
 
   env->SetConstructorFunction(target, "StatWatcher", t);
 }
@@ -60,6 +63,9 @@ void StatWatcher::RegisterExternalReferences(
     ExternalReferenceRegistry* registry) {
   registry->Register(StatWatcher::New);
   registry->Register(StatWatcher::Start);
+  registry->Register(StatWatcher::Ref);
+  registry->Register(StatWatcher::Unref);
+  registry->Register(StatWatcher::HasRef);
 }
 
 StatWatcher::StatWatcher(fs::BindingData* binding_data,
@@ -80,17 +86,29 @@ void StatWatcher::Callback(uv_fs_poll_t* handle,
                            const uv_stat_t* prev,
                            const uv_stat_t* curr) {
   StatWatcher* wrap = ContainerOf(&StatWatcher::watcher_, handle);
-  Environment* env = wrap->env();
+  wrap->Emit(status, prev, curr);
+}
+
+void StatWatcher::SharedCallback(void* data,
+                                 int status,
+                                 const uv_stat_t* prev,
+                                 const uv_stat_t* curr) {
+  static_cast<StatWatcher*>(data)->Emit(status, prev, curr);
+}
+
+void StatWatcher::Emit(int status,
+                       const uv_stat_t* prev,
+                       const uv_stat_t* curr) {
+  Environment* env = this->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
   Local<Value> arr = fs::FillGlobalStatsArray(
-      wrap->binding_data_.get(), wrap->use_bigint_, curr);
-  USE(fs::FillGlobalStatsArray(
-      wrap->binding_data_.get(), wrap->use_bigint_, prev, true));
+      binding_data_.get(), use_bigint_, curr);
+  USE(fs::FillGlobalStatsArray(binding_data_.get(), use_bigint_, prev, true));
 
   Local<Value> argv[2] = { Integer::New(env->isolate(), status), arr };
-  wrap->MakeCallback(env->onchange_string(), arraysize(argv), argv);
+  MakeCallback(env->onchange_string(), arraysize(argv), argv);
 }
 
 
@@ -101,13 +119,18 @@ void StatWatcher::New(const FunctionCallbackInfo<Value>& args) {
   new StatWatcher(binding_data, args.This(), args[0]->IsTrue());
 }
 
-// wrap.start(filename, interval)
+// wrap.start(filename, interval[, shared])
+//
+// With `shared`, the file is polled by the Environment's StatPoller along
+// with every other shared watcher that uses the same interval, instead of
+// by a uv_fs_poll_t of its own.
 void StatWatcher::Start(const FunctionCallbackInfo<Value>& args) {
-  CHECK_EQ(args.Length(), 2);
+  CHECK_GE(args.Length(), 2);
 
   StatWatcher* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
   CHECK(!uv_is_active(wrap->GetHandle()));
+  CHECK_NULL(wrap->shared_watch_);
 
   node::Utf8Value path(args.GetIsolate(), args[0]);
   CHECK_NOT_NULL(*path);
@@ -115,6 +138,12 @@ void StatWatcher::Start(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[1]->IsUint32());
   const uint32_t interval = args[1].As<Uint32>()->Value();
 
+  if (args.Length() > 2 && args[2]->IsTrue()) {
+    wrap->shared_watch_ = wrap->binding_data_->stat_poller()->Add(
+        *path, interval, SharedCallback, wrap);
+    return;
+  }
+
   // Note that uv_fs_poll_start does not return ENOENT, we are handling
   // mostly memory errors here.
   const int err = uv_fs_poll_start(&wrap->watcher_, Callback, *path, interval);
@@ -123,4 +152,36 @@ void StatWatcher::Start(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+void StatWatcher::Ref(const FunctionCallbackInfo<Value>& args) {
+  StatWatcher* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  if (wrap->shared_watch_ == nullptr)
+    return HandleWrap::Ref(args);
+  wrap->binding_data_->stat_poller()->SetRef(wrap->shared_watch_, true);
+}
+
+void StatWatcher::Unref(const FunctionCallbackInfo<Value>& args) {
+  StatWatcher* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  if (wrap->shared_watch_ == nullptr)
+    return HandleWrap::Unref(args);
+  wrap->binding_data_->stat_poller()->SetRef(wrap->shared_watch_, false);
+}
+
+void StatWatcher::HasRef(const FunctionCallbackInfo<Value>& args) {
+  StatWatcher* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+  if (wrap->shared_watch_ == nullptr)
+    return HandleWrap::HasRef(args);
+  args.GetReturnValue().Set(fs::StatPoller::HasRef(wrap->shared_watch_));
+}
+
+void StatWatcher::Close(Local<Value> close_callback) {
+  if (shared_watch_ != nullptr) {
+    binding_data_->stat_poller()->Remove(shared_watch_);
+    shared_watch_ = nullptr;
+  }
+  HandleWrap::Close(close_callback);
+}
+
 }  // namespace node
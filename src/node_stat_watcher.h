@@ -26,6 +26,7 @@
 
 #include "node.h"
 #include "handle_wrap.h"
+#include "stat_poller.h"
 #include "uv.h"
 #include "v8.h"
 
@@ -49,6 +50,14 @@ class StatWatcher : public HandleWrap {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Start(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // Shared watchers keep the event loop alive through their StatPoller
+  // group rather than through watcher_, which is never started.
+  static void Ref(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Unref(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void HasRef(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void Close(
+      v8::Local<v8::Value> close_callback = v8::Local<v8::Value>()) override;
 
   SET_NO_MEMORY_INFO()
   SET_MEMORY_INFO_NAME(StatWatcher)
@@ -59,8 +68,14 @@ class StatWatcher : public HandleWrap {
                        int status,
                        const uv_stat_t* prev,
                        const uv_stat_t* curr);
+  static void SharedCallback(void* data,
+                             int status,
+                             const uv_stat_t* prev,
+                             const uv_stat_t* curr);
+  void Emit(int status, const uv_stat_t* prev, const uv_stat_t* curr);
 
   uv_fs_poll_t watcher_;
+  fs::StatPoller::Watch* shared_watch_ = nullptr;
   const bool use_bigint_;
   BaseObjectPtr<fs::BindingData> binding_data_;
 };
@@ -10,6 +10,7 @@
 #include "node_metadata.h"
 #include "node_platform.h"
 #include "node_options.h"
+#include "node_page_allocator.h"
 #include "tracing/node_trace_writer.h"
 #include "tracing/trace_event.h"
 #include "tracing/traced_value.h"
@@ -99,8 +100,12 @@ struct V8Platform {
     if (!per_process::cli_options->trace_event_categories.empty()) {
       StartTracingAgent();
     }
+    // V8 uses its own page allocator unless the platform provides one.
+    v8::PageAllocator* page_allocator = nullptr;
+    if (per_process::cli_options->heap_huge_pages)
+      page_allocator = GetHugePageAllocator();
     // Tracing must be initialized before platform threads are created.
-    platform_ = new NodePlatform(thread_pool_size, controller);
+    platform_ = new NodePlatform(thread_pool_size, controller, page_allocator);
     v8::V8::InitializePlatform(platform_);
   }
 
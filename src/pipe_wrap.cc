@@ -76,6 +76,7 @@ void PipeWrap::Initialize(Local<Object> target,
 
   env->SetProtoMethod(t, "bind", Bind);
   env->SetProtoMethod(t, "listen", Listen);
+  env->SetProtoMethod(t, "setAcceptBatchSize", SetAcceptBatchSize);
   env->SetProtoMethod(t, "connect", Connect);
   env->SetProtoMethod(t, "open", Open);
 
@@ -109,6 +110,7 @@ void PipeWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(New);
   registry->Register(Bind);
   registry->Register(Listen);
+  registry->Register(SetAcceptBatchSize);
   registry->Register(Connect);
   registry->Register(Open);
 #ifdef _WIN32
@@ -0,0 +1,197 @@
+#include "pprof_utils.h"
+
+#include "zlib.h"
+
+namespace node {
+namespace pprof {
+
+namespace {
+
+// Field numbers from profile.proto.
+enum ProfileField {
+  kProfileSampleType = 1,
+  kProfileSample = 2,
+  kProfileLocation = 4,
+  kProfileFunction = 5,
+  kProfileStringTable = 6,
+  kProfileTimeNanos = 9,
+  kProfileDurationNanos = 10,
+  kProfilePeriodType = 11,
+  kProfilePeriod = 12,
+};
+
+enum WireType {
+  kVarint = 0,
+  kLengthDelimited = 2,
+};
+
+void WriteVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void WriteTag(std::string* out, int field, WireType type) {
+  WriteVarint(out, (static_cast<uint64_t>(field) << 3) | type);
+}
+
+// proto3 scalars equal to zero are omitted from the wire format.
+void WriteVarintField(std::string* out, int field, uint64_t value) {
+  if (value == 0) return;
+  WriteTag(out, field, kVarint);
+  WriteVarint(out, value);
+}
+
+void WriteBytesField(std::string* out, int field, const std::string& value) {
+  WriteTag(out, field, kLengthDelimited);
+  WriteVarint(out, value.size());
+  out->append(value);
+}
+
+template <typename T>
+void WritePackedField(std::string* out, int field, const std::vector<T>& v) {
+  if (v.empty()) return;
+  std::string packed;
+  for (T value : v) WriteVarint(&packed, static_cast<uint64_t>(value));
+  WriteBytesField(out, field, packed);
+}
+
+std::string EncodeValueType(int64_t type, int64_t unit) {
+  std::string out;
+  WriteVarintField(&out, 1, type);
+  WriteVarintField(&out, 2, unit);
+  return out;
+}
+
+}  // anonymous namespace
+
+ProfileBuilder::ProfileBuilder() {
+  // By definition, the first entry of the string table is the empty string.
+  InternString("");
+}
+
+int64_t ProfileBuilder::InternString(const std::string& str) {
+  auto it = string_ids_.find(str);
+  if (it != string_ids_.end()) return it->second;
+  int64_t id = static_cast<int64_t>(strings_.size());
+  strings_.push_back(str);
+  string_ids_.emplace(str, id);
+  return id;
+}
+
+void ProfileBuilder::AddSampleType(const char* type, const char* unit) {
+  sample_types_.push_back({InternString(type), InternString(unit)});
+}
+
+void ProfileBuilder::SetPeriodType(const char* type, const char* unit) {
+  period_type_ = {InternString(type), InternString(unit)};
+}
+
+uint64_t ProfileBuilder::AddFunction(const std::string& name,
+                                     const std::string& filename,
+                                     int64_t start_line) {
+  auto key = std::make_tuple(
+      InternString(name), InternString(filename), start_line);
+  auto it = function_ids_.find(key);
+  if (it != function_ids_.end()) return it->second;
+  // Ids are 1-based; 0 is reserved by the format.
+  uint64_t id = functions_.size() + 1;
+  functions_.push_back(
+      {id, std::get<0>(key), std::get<1>(key), start_line});
+  function_ids_.emplace(key, id);
+  return id;
+}
+
+uint64_t ProfileBuilder::AddLocation(uint64_t function_id, int64_t line) {
+  auto key = std::make_pair(function_id, line);
+  auto it = location_ids_.find(key);
+  if (it != location_ids_.end()) return it->second;
+  uint64_t id = locations_.size() + 1;
+  locations_.push_back({id, function_id, line});
+  location_ids_.emplace(key, id);
+  return id;
+}
+
+void ProfileBuilder::AddSample(const std::vector<uint64_t>& location_ids,
+                               const std::vector<int64_t>& values) {
+  samples_.push_back({location_ids, values});
+}
+
+std::string ProfileBuilder::Serialize() const {
+  std::string out;
+  std::string message;
+
+  for (const ValueType& type : sample_types_) {
+    WriteBytesField(
+        &out, kProfileSampleType, EncodeValueType(type.type, type.unit));
+  }
+
+  for (const Sample& sample : samples_) {
+    message.clear();
+    WritePackedField(&message, 1, sample.location_ids);
+    WritePackedField(&message, 2, sample.values);
+    WriteBytesField(&out, kProfileSample, message);
+  }
+
+  for (const Location& location : locations_) {
+    std::string line;
+    WriteVarintField(&line, 1, location.function_id);
+    WriteVarintField(&line, 2, location.line);
+    message.clear();
+    WriteVarintField(&message, 1, location.id);
+    WriteBytesField(&message, 4, line);
+    WriteBytesField(&out, kProfileLocation, message);
+  }
+
+  for (const Function& function : functions_) {
+    message.clear();
+    WriteVarintField(&message, 1, function.id);
+    WriteVarintField(&message, 2, function.name);
+    WriteVarintField(&message, 3, function.name);
+    WriteVarintField(&message, 4, function.filename);
+    WriteVarintField(&message, 5, function.start_line);
+    WriteBytesField(&out, kProfileFunction, message);
+  }
+
+  for (const std::string& str : strings_)
+    WriteBytesField(&out, kProfileStringTable, str);
+
+  WriteVarintField(&out, kProfileTimeNanos, time_nanos_);
+  WriteVarintField(&out, kProfileDurationNanos, duration_nanos_);
+  if (period_type_.type != 0) {
+    WriteBytesField(&out,
+                    kProfilePeriodType,
+                    EncodeValueType(period_type_.type, period_type_.unit));
+  }
+  WriteVarintField(&out, kProfilePeriod, period_);
+  return out;
+}
+
+bool GzipCompress(const std::string& input, std::string* output) {
+  z_stream stream = {};
+  // 16 + MAX_WBITS selects the gzip wrapper instead of the zlib one.
+  if (deflateInit2(&stream,
+                   Z_DEFAULT_COMPRESSION,
+                   Z_DEFLATED,
+                   16 + MAX_WBITS,
+                   8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+
+  output->resize(deflateBound(&stream, input.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = output->size();
+  int err = deflate(&stream, Z_FINISH);
+  output->resize(stream.total_out);
+  deflateEnd(&stream);
+  return err == Z_STREAM_END;
+}
+
+}  // namespace pprof
+}  // namespace node
@@ -0,0 +1,97 @@
+#ifndef SRC_PPROF_UTILS_H_
+#define SRC_PPROF_UTILS_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace node {
+namespace pprof {
+
+// Builds a profile in the pprof profile.proto format
+// (https://github.com/google/pprof/blob/main/proto/profile.proto).
+// Only the subset of the format needed for sampled call stacks is
+// supported: mappings, labels and comments are never emitted.
+class ProfileBuilder {
+ public:
+  ProfileBuilder();
+
+  // Returns the index of `str` in the string table, adding it if necessary.
+  int64_t InternString(const std::string& str);
+
+  void AddSampleType(const char* type, const char* unit);
+  void SetPeriodType(const char* type, const char* unit);
+  void set_period(int64_t period) { period_ = period; }
+  void set_time_nanos(int64_t time_nanos) { time_nanos_ = time_nanos; }
+  void set_duration_nanos(int64_t duration_nanos) {
+    duration_nanos_ = duration_nanos;
+  }
+
+  // Functions and locations are deduplicated, so calling these repeatedly
+  // with the same arguments returns the same id.
+  uint64_t AddFunction(const std::string& name,
+                       const std::string& filename,
+                       int64_t start_line);
+  uint64_t AddLocation(uint64_t function_id, int64_t line);
+
+  // `location_ids` lists the stack leaf first, `values` must have one entry
+  // per sample type.
+  void AddSample(const std::vector<uint64_t>& location_ids,
+                 const std::vector<int64_t>& values);
+
+  size_t sample_count() const { return samples_.size(); }
+
+  // Returns the serialized (uncompressed) protobuf message.
+  std::string Serialize() const;
+
+ private:
+  struct ValueType {
+    int64_t type;
+    int64_t unit;
+  };
+  struct Function {
+    uint64_t id;
+    int64_t name;
+    int64_t filename;
+    int64_t start_line;
+  };
+  struct Location {
+    uint64_t id;
+    uint64_t function_id;
+    int64_t line;
+  };
+  struct Sample {
+    std::vector<uint64_t> location_ids;
+    std::vector<int64_t> values;
+  };
+
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, int64_t> string_ids_;
+  std::vector<ValueType> sample_types_;
+  ValueType period_type_ = {0, 0};
+  int64_t period_ = 0;
+  int64_t time_nanos_ = 0;
+  int64_t duration_nanos_ = 0;
+  std::vector<Function> functions_;
+  std::map<std::tuple<int64_t, int64_t, int64_t>, uint64_t> function_ids_;
+  std::vector<Location> locations_;
+  std::map<std::pair<uint64_t, int64_t>, uint64_t> location_ids_;
+  std::vector<Sample> samples_;
+};
+
+// Compresses `input` into a gzip stream, as expected by pprof tools.
+// Returns false if zlib reports an error.
+bool GzipCompress(const std::string& input, std::string* output);
+
+}  // namespace pprof
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_PPROF_UTILS_H_
@@ -0,0 +1,268 @@
+#include "stat_poller.h"
+#include "env-inl.h"
+#include "memory_tracker-inl.h"
+#include "node_internals.h"
+#include "threadpoolwork-inl.h"
+#include "util-inl.h"
+
+#include <algorithm>
+
+namespace node {
+namespace fs {
+
+namespace {
+
+// The fields that uv_fs_poll_t compares.
+bool StatEqual(const uv_stat_t& a, const uv_stat_t& b) {
+  return a.st_ctim.tv_nsec == b.st_ctim.tv_nsec &&
+         a.st_mtim.tv_nsec == b.st_mtim.tv_nsec &&
+         a.st_birthtim.tv_nsec == b.st_birthtim.tv_nsec &&
+         a.st_ctim.tv_sec == b.st_ctim.tv_sec &&
+         a.st_mtim.tv_sec == b.st_mtim.tv_sec &&
+         a.st_birthtim.tv_sec == b.st_birthtim.tv_sec &&
+         a.st_size == b.st_size &&
+         a.st_mode == b.st_mode &&
+         a.st_uid == b.st_uid &&
+         a.st_gid == b.st_gid &&
+         a.st_ino == b.st_ino &&
+         a.st_dev == b.st_dev &&
+         a.st_flags == b.st_flags &&
+         a.st_gen == b.st_gen;
+}
+
+}  // anonymous namespace
+
+struct StatPoller::Watch {
+  Group* group;
+  // Position in group->watches.
+  size_t index;
+  std::string path;
+  Callback callback;
+  void* data;
+  // The tick of the group's interval that polls this watcher.
+  uint32_t slot;
+  bool ref = true;
+  bool removed = false;
+  // 0 before the first stat(), 1 after a successful one, or the error of
+  // the last one that failed.
+  int state = 0;
+  // The result of the last successful stat().
+  uv_stat_t stat {};
+};
+
+struct StatPoller::Group {
+  uv_timer_t timer;
+  StatPoller* poller;
+  uint32_t interval;
+  uint32_t slices;
+  uint32_t tick = 0;
+  uint32_t next_slot = 0;
+  std::vector<std::unique_ptr<Watch>> watches;
+  // Number of referenced watchers.
+  size_t refs = 0;
+  Batch* batch = nullptr;
+  // The group is empty and no longer in groups_.
+  bool closing = false;
+};
+
+class StatPoller::Batch final : public ThreadPoolWork {
+ public:
+  struct Item {
+    Watch* watch;
+    std::string path;
+    int status = 0;
+    uv_stat_t stat {};
+  };
+
+  Batch(Environment* env, Group* group) : ThreadPoolWork(env), group(group) {}
+
+  void DoThreadPoolWork() override {
+    for (Item& item : items) {
+      uv_fs_t req;
+      item.status = uv_fs_stat(nullptr, &req, item.path.c_str(), nullptr);
+      if (item.status == 0)
+        item.stat = req.statbuf;
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<Batch> self { this };
+    group->poller->OnBatchDone(this, status);
+  }
+
+  Group* const group;
+  std::vector<Item> items;
+  // Watchers that were removed while the batch was in flight. They are
+  // kept until it is done, since items still point to them.
+  std::vector<std::unique_ptr<Watch>> removed;
+};
+
+StatPoller::StatPoller(Environment* env) : env_(env) {}
+
+StatPoller::~StatPoller() {
+  // StatWatchers are HandleWraps, which the Environment closes before it
+  // cleans up binding data.
+  CHECK(groups_.empty());
+}
+
+StatPoller::Watch* StatPoller::Add(const std::string& path,
+                                   uint32_t interval,
+                                   Callback callback,
+                                   void* data) {
+  Group* group = GetOrCreateGroup(interval);
+  std::unique_ptr<Watch> watch = std::make_unique<Watch>();
+  watch->group = group;
+  watch->index = group->watches.size();
+  watch->path = path;
+  watch->callback = callback;
+  watch->data = data;
+  watch->slot = group->next_slot++ % group->slices;
+  Watch* result = watch.get();
+  group->watches.emplace_back(std::move(watch));
+  group->refs++;
+  UpdateRef(group);
+  return result;
+}
+
+void StatPoller::Remove(Watch* watch) {
+  Group* group = watch->group;
+  CHECK(!watch->removed);
+  watch->removed = true;
+  if (watch->ref)
+    group->refs--;
+
+  // The order of watchers does not matter, so move the last one into the
+  // gap.
+  std::unique_ptr<Watch> owned = std::move(group->watches[watch->index]);
+  if (watch->index != group->watches.size() - 1) {
+    group->watches[watch->index] = std::move(group->watches.back());
+    group->watches[watch->index]->index = watch->index;
+  }
+  group->watches.pop_back();
+  if (group->batch != nullptr)
+    group->batch->removed.emplace_back(std::move(owned));
+
+  if (group->watches.empty())
+    CloseGroup(group);
+  else
+    UpdateRef(group);
+}
+
+void StatPoller::SetRef(Watch* watch, bool ref) {
+  if (watch->ref == ref)
+    return;
+  watch->ref = ref;
+  if (ref)
+    watch->group->refs++;
+  else
+    watch->group->refs--;
+  UpdateRef(watch->group);
+}
+
+bool StatPoller::HasRef(const Watch* watch) {
+  return watch->ref;
+}
+
+StatPoller::Group* StatPoller::GetOrCreateGroup(uint32_t interval) {
+  auto it = groups_.find(interval);
+  if (it != groups_.end())
+    return it->second;
+
+  Group* group = new Group();
+  group->poller = this;
+  group->interval = interval;
+  group->slices = std::min(std::max(interval / kMinTick, 1u), kMaxSlices);
+  const uint64_t tick = std::max(interval / group->slices, 1u);
+  CHECK_EQ(uv_timer_init(env_->event_loop(), &group->timer), 0);
+  CHECK_EQ(uv_timer_start(&group->timer, OnTick, tick, tick), 0);
+  groups_.emplace(interval, group);
+  return group;
+}
+
+void StatPoller::CloseGroup(Group* group) {
+  if (!group->closing) {
+    group->closing = true;
+    groups_.erase(group->interval);
+    uv_timer_stop(&group->timer);
+  }
+  // Otherwise OnBatchDone() gets back here.
+  if (group->batch != nullptr)
+    return;
+  env_->CloseHandle(&group->timer, [](uv_timer_t* timer) {
+    Group* group = ContainerOf(&Group::timer, timer);
+    delete group;
+  });
+}
+
+void StatPoller::UpdateRef(Group* group) {
+  uv_handle_t* timer = reinterpret_cast<uv_handle_t*>(&group->timer);
+  if (group->refs > 0)
+    uv_ref(timer);
+  else
+    uv_unref(timer);
+}
+
+void StatPoller::OnTick(uv_timer_t* timer) {
+  Group* group = ContainerOf(&Group::timer, timer);
+  const uint32_t slot = group->tick++ % group->slices;
+  // Let a slow batch finish rather than piling up more work.
+  if (group->batch != nullptr)
+    return;
+
+  std::unique_ptr<Batch> batch =
+      std::make_unique<Batch>(group->poller->env_, group);
+  for (const std::unique_ptr<Watch>& watch : group->watches) {
+    // New watchers are picked up right away, whatever their slot.
+    if (watch->slot == slot || watch->state == 0)
+      batch->items.push_back(Batch::Item { watch.get(), watch->path });
+  }
+  if (batch->items.empty())
+    return;
+  group->batch = batch.release();
+  group->batch->ScheduleWork();
+}
+
+void StatPoller::OnBatchDone(Batch* batch, int status) {
+  static const uv_stat_t zero_stat {};
+  Group* group = batch->group;
+
+  // The callbacks may add or remove watchers, including the ones that are
+  // still to be reported.
+  for (Batch::Item& item : batch->items) {
+    Watch* watch = item.watch;
+    if (status != 0 || watch->removed)
+      continue;
+
+    if (item.status != 0) {
+      if (watch->state != item.status) {
+        watch->state = item.status;
+        watch->callback(watch->data, item.status, &watch->stat, &zero_stat);
+      }
+      continue;
+    }
+
+    const bool changed = watch->state < 0 ||
+        (watch->state > 0 && !StatEqual(watch->stat, item.stat));
+    const uv_stat_t prev = watch->stat;
+    watch->stat = item.stat;
+    watch->state = 1;
+    if (changed)
+      watch->callback(watch->data, 0, &prev, &watch->stat);
+  }
+
+  group->batch = nullptr;
+  if (group->closing)
+    CloseGroup(group);
+}
+
+void StatPoller::MemoryInfo(MemoryTracker* tracker) const {
+  size_t watches = 0;
+  for (const auto& it : groups_)
+    watches += it.second->watches.size();
+  tracker->TrackFieldWithSize("groups", groups_.size() * sizeof(Group));
+  tracker->TrackFieldWithSize("watches", watches * sizeof(Watch));
+}
+
+}  // namespace fs
+}  // namespace node
@@ -0,0 +1,87 @@
+#ifndef SRC_STAT_POLLER_H_
+#define SRC_STAT_POLLER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memory_tracker.h"
+#include "uv.h"
+
+namespace node {
+class Environment;
+
+namespace fs {
+
+// Polls files with stat() on behalf of many watchers at once, for shared
+// StatWatchers (fs.watchFile()). A uv_fs_poll_t per file means a timer and a
+// threadpool request per file and interval; here, watchers with the same
+// interval form a group with a single timer. Every group spreads its watchers
+// over up to kMaxSlices ticks per interval and stat()s the watchers of each
+// tick in one batch on one threadpool thread, so that thousands of watchers
+// do not all hit the disk at the same moment.
+//
+// The callback has the semantics of uv_fs_poll_cb: it is called when the
+// result of stat() changes, or when it fails with a different error than
+// the last time, but not for the first successful stat() of a file.
+class StatPoller : public MemoryRetainer {
+ public:
+  typedef void (*Callback)(void* data,
+                           int status,
+                           const uv_stat_t* prev,
+                           const uv_stat_t* curr);
+
+  struct Watch;
+
+  explicit StatPoller(Environment* env);
+  ~StatPoller() override;
+
+  // The new watcher is referenced, and is first polled on the next tick of
+  // its group.
+  Watch* Add(const std::string& path,
+             uint32_t interval,
+             Callback callback,
+             void* data);
+  // `callback` is not called again after this.
+  void Remove(Watch* watch);
+
+  // A group keeps the event loop alive while any of its watchers are
+  // referenced.
+  void SetRef(Watch* watch, bool ref);
+  static bool HasRef(const Watch* watch);
+
+  // Groups use ticks of at least this many milliseconds.
+  static constexpr uint32_t kMinTick = 50;
+  static constexpr uint32_t kMaxSlices = 10;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(StatPoller)
+  SET_SELF_SIZE(StatPoller)
+
+  StatPoller(const StatPoller&) = delete;
+  StatPoller& operator=(const StatPoller&) = delete;
+
+ private:
+  class Batch;
+  struct Group;
+
+  Group* GetOrCreateGroup(uint32_t interval);
+  // Stops the group's timer and closes it, once no batch is in flight.
+  void CloseGroup(Group* group);
+  void UpdateRef(Group* group);
+  void OnBatchDone(Batch* batch, int status);
+
+  static void OnTick(uv_timer_t* timer);
+
+  Environment* env_;
+  std::unordered_map<uint32_t, Group*> groups_;
+};
+
+}  // namespace fs
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_STAT_POLLER_H_
@@ -125,6 +125,11 @@ StreamBase::StreamBase(Environment* env) : env_(env) {
 int StreamBase::Shutdown(v8::Local<v8::Object> req_wrap_obj) {
   Environment* env = stream_env();
 
+  // Corked data has to go out before the write side is shut down.
+  int flush_err = FlushCork();
+  if (flush_err != 0)
+    return flush_err;
+
   v8::HandleScope handle_scope(env->isolate());
 
   if (req_wrap_obj.IsEmpty()) {
@@ -165,14 +170,36 @@ StreamWriteResult StreamBase::Write(
     size_t count,
     uv_stream_t* send_handle,
     v8::Local<v8::Object> req_wrap_obj) {
-  Environment* env = stream_env();
-  int err;
-
   size_t total_bytes = 0;
   for (size_t i = 0; i < count; ++i)
     total_bytes += bufs[i].len;
   bytes_written_ += total_bytes;
 
+  StreamWriteResult res;
+  if (cork_threshold_ != 0 && send_handle == nullptr &&
+      CorkWrite(bufs, count, total_bytes, req_wrap_obj, &res)) {
+    return res;
+  }
+
+  // Corked data goes first.
+  if (cork_size_ != 0) {
+    int err = FlushCork();
+    if (err != 0)
+      return StreamWriteResult { false, err, nullptr, total_bytes, {} };
+  }
+
+  return WriteUncorked(bufs, count, total_bytes, send_handle, req_wrap_obj);
+}
+
+StreamWriteResult StreamBase::WriteUncorked(
+    uv_buf_t* bufs,
+    size_t count,
+    size_t total_bytes,
+    uv_stream_t* send_handle,
+    v8::Local<v8::Object> req_wrap_obj) {
+  Environment* env = stream_env();
+  int err;
+
   if (send_handle == nullptr) {
     err = DoTryWrite(&bufs, &count);
     if (err != 0 || count == 0) {
@@ -278,6 +305,12 @@ void WriteWrap::SetBackingStore(std::unique_ptr<v8::BackingStore> bs) {
   backing_store_ = std::move(bs);
 }
 
+void WriteWrap::SetCorkedWrites(
+    std::vector<BaseObjectPtr<AsyncWrap>>&& writes) {
+  CHECK(corked_writes_.empty());
+  corked_writes_ = std::move(writes);
+}
+
 void StreamReq::Done(int status, const char* error_str) {
   AsyncWrap* async_wrap = GetAsyncWrap();
   Environment* env = async_wrap->env();
@@ -39,6 +39,7 @@ using v8::ReadOnly;
 using v8::SideEffectType;
 using v8::Signature;
 using v8::String;
+using v8::Uint32;
 using v8::Value;
 
 template int StreamBase::WriteString<ASCII>(
@@ -68,6 +69,133 @@ int StreamBase::UseUserBuffer(const FunctionCallbackInfo<Value>& args) {
   return 0;
 }
 
+int StreamBase::SetCorkJS(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());
+  return SetCorkThreshold(args[0].As<Uint32>()->Value());
+}
+
+int StreamBase::SetCorkThreshold(size_t threshold) {
+  if (threshold != 0 && !SupportsCork())
+    return UV_ENOTSUP;
+
+  int err = FlushCork();
+  cork_threshold_ = threshold;
+  // The buffer is sized for the old threshold.
+  cork_data_.reset();
+  return err;
+}
+
+int StreamBase::FlushCork() {
+  if (cork_size_ == 0)
+    return 0;
+
+  Environment* env = stream_env();
+  HandleScope handle_scope(env->isolate());
+
+  uv_buf_t buf =
+      uv_buf_init(static_cast<char*>(cork_data_->Data()), cork_size_);
+  cork_size_ = 0;
+  std::vector<BaseObjectPtr<AsyncWrap>> writes;
+  writes.swap(cork_writes_);
+
+  Local<Object> req_wrap_obj;
+  if (!env->write_wrap_template()
+           ->NewInstance(env->context())
+           .ToLocal(&req_wrap_obj)) {
+    FailCorkedWrites(std::move(writes), UV_EBUSY);
+    return UV_EBUSY;
+  }
+  StreamReq::ResetObject(req_wrap_obj);
+
+  // Skip DoTryWrite(): the corked writes complete with this write, and they
+  // must not complete while the write that triggered the flush is running.
+  AsyncHooks::DefaultTriggerAsyncIdScope trigger_scope(GetAsyncWrap());
+  WriteWrap* req_wrap = CreateWriteWrap(req_wrap_obj);
+  BaseObjectPtr<AsyncWrap> req_wrap_ptr(req_wrap->GetAsyncWrap());
+  int err = DoWrite(req_wrap, &buf, 1, nullptr);
+  ClearError();
+  if (err != 0) {
+    req_wrap->Dispose();
+    FailCorkedWrites(std::move(writes), err);
+    return err;
+  }
+
+  req_wrap->SetBackingStore(std::move(cork_data_));
+  req_wrap->SetCorkedWrites(std::move(writes));
+  return 0;
+}
+
+void StreamBase::FailCorkedWrites(
+    std::vector<BaseObjectPtr<AsyncWrap>>&& writes, int status) {
+  if (writes.empty())
+    return;
+  // Like the writes that DoWrite() accepts, complete them asynchronously.
+  env_->SetImmediate([writes = std::move(writes), status](Environment* env) {
+    for (const BaseObjectPtr<AsyncWrap>& write : writes)
+      WriteWrap::FromObject(write)->Done(status);
+  });
+}
+
+bool StreamBase::CorkWrite(const uv_buf_t* bufs,
+                           size_t count,
+                           size_t total_bytes,
+                           Local<Object> req_wrap_obj,
+                           StreamWriteResult* res) {
+  if (total_bytes >= cork_threshold_)
+    return false;
+
+  if (cork_size_ + total_bytes > cork_threshold_ && FlushCork() != 0)
+    return false;
+
+  Environment* env = stream_env();
+  HandleScope handle_scope(env->isolate());
+
+  if (req_wrap_obj.IsEmpty()) {
+    if (!env->write_wrap_template()
+             ->NewInstance(env->context())
+             .ToLocal(&req_wrap_obj)) {
+      return false;
+    }
+    StreamReq::ResetObject(req_wrap_obj);
+  }
+
+  if (!cork_data_) {
+    NoArrayBufferZeroFillScope no_zero_fill_scope(env->isolate_data());
+    cork_data_ = ArrayBuffer::NewBackingStore(env->isolate(), cork_threshold_);
+  }
+
+  char* data = static_cast<char*>(cork_data_->Data()) + cork_size_;
+  for (size_t i = 0; i < count; i++) {
+    if (bufs[i].len == 0) continue;
+    memcpy(data, bufs[i].base, bufs[i].len);
+    data += bufs[i].len;
+  }
+  cork_size_ += total_bytes;
+
+  AsyncHooks::DefaultTriggerAsyncIdScope trigger_scope(GetAsyncWrap());
+  WriteWrap* req_wrap = CreateWriteWrap(req_wrap_obj);
+  BaseObjectPtr<AsyncWrap> req_wrap_ptr(req_wrap->GetAsyncWrap());
+  cork_writes_.push_back(req_wrap_ptr);
+  *res = StreamWriteResult {
+      true, 0, req_wrap, total_bytes, std::move(req_wrap_ptr) };
+
+  if (!cork_flush_scheduled_) {
+    cork_flush_scheduled_ = true;
+    env->SetImmediate([this, strong_ref = BaseObjectPtr<AsyncWrap>(
+                                 GetAsyncWrap())](Environment* env) {
+      cork_flush_scheduled_ = false;
+      // Closing the stream flushes it.
+      if (!IsAlive() || IsClosing())
+        return;
+      FlushCork();
+      // Don't hold on to the buffer while the stream is idle.
+      cork_data_.reset();
+    });
+  }
+
+  return true;
+}
+
 int StreamBase::Shutdown(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsObject());
   Local<Object> req_wrap_obj = args[0].As<Object>();
@@ -99,20 +227,28 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
     count = chunks->Length() >> 1;
 
   MaybeStackBuffer<uv_buf_t, 16> bufs(count);
+  // Whether bufs[i] still needs to be encoded into storage.
+  MaybeStackBuffer<bool, 16> needs_storage(count);
 
   size_t storage_size = 0;
   size_t offset;
+  bool has_external_strings = false;
 
   if (!all_buffers) {
     // Determine storage size first
     for (size_t i = 0; i < count; i++) {
+      needs_storage[i] = false;
+
       Local<Value> chunk;
       if (!chunks->Get(context, i * 2).ToLocal(&chunk))
         return -1;
 
-      if (Buffer::HasInstance(chunk))
+      // Buffer chunk, no additional storage required
+      if (Buffer::HasInstance(chunk)) {
+        bufs[i].base = Buffer::Data(chunk);
+        bufs[i].len = Buffer::Length(chunk);
         continue;
-        // Buffer chunk, no additional storage required
+      }
 
       // String chunk
       Local<String> string;
@@ -122,6 +258,17 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
       if (!chunks->Get(context, i * 2 + 1).ToLocal(&next_chunk))
         return -1;
       enum encoding encoding = ParseEncoding(isolate, next_chunk);
+
+      // External strings whose contents already are the bytes to write are
+      // written from V8's string memory, which doesn't move.
+      const char* data;
+      size_t length;
+      if (StringBytes::GetExternalBytes(string, encoding, &data, &length)) {
+        bufs[i] = uv_buf_init(const_cast<char*>(data), length);
+        has_external_strings = true;
+        continue;
+      }
+
       size_t chunk_size;
       if ((encoding == UTF8 &&
              string->Length() > 65535 &&
@@ -131,6 +278,7 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
         return -1;
       }
       storage_size += chunk_size;
+      needs_storage[i] = true;
     }
 
     if (storage_size > INT_MAX)
@@ -145,54 +293,84 @@ int StreamBase::Writev(const FunctionCallbackInfo<Value>& args) {
     }
   }
 
+  // Strings are encoded into storage that is reused for as long as writes
+  // complete synchronously, so that a writev() of small strings does not
+  // need to allocate.
   std::unique_ptr<BackingStore> bs;
   if (storage_size > 0) {
-    NoArrayBufferZeroFillScope no_zero_fill_scope(env->isolate_data());
-    bs = ArrayBuffer::NewBackingStore(isolate, storage_size);
+    std::unique_ptr<BackingStore>& pooled = env->stream_write_storage();
+    if (pooled && pooled->ByteLength() >= storage_size) {
+      bs = std::move(pooled);
+    } else {
+      NoArrayBufferZeroFillScope no_zero_fill_scope(env->isolate_data());
+      bs = ArrayBuffer::NewBackingStore(isolate, storage_size);
+    }
   }
 
+  // Hands the storage back for the next write, unless a larger one is
+  // pooled already or it exceeds the limit.
+  auto recycle_storage = [&]() {
+    if (!bs || bs->ByteLength() > kWritevStorageSize) return;
+    std::unique_ptr<BackingStore>& pooled = env->stream_write_storage();
+    if (!pooled || pooled->ByteLength() < bs->ByteLength())
+      pooled = std::move(bs);
+  };
+
   offset = 0;
-  if (!all_buffers) {
-    for (size_t i = 0; i < count; i++) {
-      Local<Value> chunk;
-      if (!chunks->Get(context, i * 2).ToLocal(&chunk))
-        return -1;
+  for (size_t i = 0; i < count && storage_size > 0; i++) {
+    if (!needs_storage[i])
+      continue;
 
-      // Write buffer
-      if (Buffer::HasInstance(chunk)) {
-        bufs[i].base = Buffer::Data(chunk);
-        bufs[i].len = Buffer::Length(chunk);
-        continue;
-      }
+    Local<Value> chunk;
+    if (!chunks->Get(context, i * 2).ToLocal(&chunk)) {
+      recycle_storage();
+      return -1;
+    }
 
-      // Write string
-      CHECK_LE(offset, storage_size);
-      char* str_storage =
-          static_cast<char*>(bs ? bs->Data() : nullptr) + offset;
-      size_t str_size = (bs ? bs->ByteLength() : 0) - offset;
+    // Write string
+    CHECK_LE(offset, storage_size);
+    char* str_storage = static_cast<char*>(bs->Data()) + offset;
+    size_t str_size = storage_size - offset;
 
-      Local<String> string;
-      if (!chunk->ToString(context).ToLocal(&string))
-        return -1;
-      Local<Value> next_chunk;
-      if (!chunks->Get(context, i * 2 + 1).ToLocal(&next_chunk))
-        return -1;
-      enum encoding encoding = ParseEncoding(isolate, next_chunk);
-      str_size = StringBytes::Write(isolate,
-                                    str_storage,
-                                    str_size,
-                                    string,
-                                    encoding);
-      bufs[i].base = str_storage;
-      bufs[i].len = str_size;
-      offset += str_size;
+    Local<String> string;
+    if (!chunk->ToString(context).ToLocal(&string)) {
+      recycle_storage();
+      return -1;
+    }
+    Local<Value> next_chunk;
+    if (!chunks->Get(context, i * 2 + 1).ToLocal(&next_chunk)) {
+      recycle_storage();
+      return -1;
     }
+    enum encoding encoding = ParseEncoding(isolate, next_chunk);
+    str_size = StringBytes::Write(isolate,
+                                  str_storage,
+                                  str_size,
+                                  string,
+                                  encoding);
+    bufs[i].base = str_storage;
+    bufs[i].len = str_size;
+    offset += str_size;
+  }
+
+  // Keep external strings alive until the write is done. This has to happen
+  // before the write is dispatched, since failing afterwards would leave JS
+  // without a way to learn about a write that is already in progress.
+  if (has_external_strings &&
+      req_wrap_obj->Set(context, env->buffer_string(), chunks).IsNothing()) {
+    recycle_storage();
+    return -1;
   }
 
   StreamWriteResult res = Write(*bufs, count, nullptr, req_wrap_obj);
   SetWriteResult(res);
-  if (res.wrap != nullptr && storage_size > 0)
-    res.wrap->SetBackingStore(std::move(bs));
+  if (res.wrap != nullptr) {
+    // The write is still in progress; it owns the storage from now on.
+    if (bs)
+      res.wrap->SetBackingStore(std::move(bs));
+  } else {
+    recycle_storage();
+  }
   return res.err;
 }
 
@@ -281,7 +459,17 @@ int StreamBase::WriteString(const FunctionCallbackInfo<Value>& args) {
 
     uv_buf_t* bufs = &buf;
     size_t count = 1;
-    const int err = DoTryWrite(&bufs, &count);
+    // Corking copies the data, so it may come from the stack, too.
+    StreamWriteResult res;
+    if (cork_threshold_ != 0 &&
+        CorkWrite(&buf, 1, data_size, req_wrap_obj, &res)) {
+      bytes_written_ += data_size;
+      SetWriteResult(res);
+      return 0;
+    }
+    int err = FlushCork();
+    if (err == 0)
+      err = DoTryWrite(&bufs, &count);
     // Keep track of the bytes written here, because we're taking a shortcut
     // by using `DoTryWrite()` directly instead of using the utilities
     // provided by `Write()`.
@@ -429,6 +617,7 @@ void StreamBase::AddMethods(Environment* env, Local<FunctionTemplate> t) {
   env->SetProtoMethod(t,
                       "useUserBuffer",
                       JSMethod<&StreamBase::UseUserBuffer>);
+  env->SetProtoMethod(t, "setCork", JSMethod<&StreamBase::SetCorkJS>);
   env->SetProtoMethod(t, "writev", JSMethod<&StreamBase::Writev>);
   env->SetProtoMethod(t, "writeBuffer", JSMethod<&StreamBase::WriteBuffer>);
   env->SetProtoMethod(
@@ -461,6 +650,7 @@ void StreamBase::RegisterExternalReferences(
   registry->Register(JSMethod<&StreamBase::ReadStopJS>);
   registry->Register(JSMethod<&StreamBase::Shutdown>);
   registry->Register(JSMethod<&StreamBase::UseUserBuffer>);
+  registry->Register(JSMethod<&StreamBase::SetCorkJS>);
   registry->Register(JSMethod<&StreamBase::Writev>);
   registry->Register(JSMethod<&StreamBase::WriteBuffer>);
   registry->Register(JSMethod<&StreamBase::WriteString<ASCII>>);
@@ -639,7 +829,14 @@ void ShutdownWrap::OnDone(int status) {
 }
 
 void WriteWrap::OnDone(int status) {
-  stream()->EmitAfterWrite(this, status);
+  if (corked_writes_.empty()) {
+    stream()->EmitAfterWrite(this, status);
+  } else {
+    // This write is internal to the stream; only the corked writes that it
+    // carried are reported, in order.
+    for (const BaseObjectPtr<AsyncWrap>& write : corked_writes_)
+      WriteWrap::FromObject(write)->Done(status);
+  }
   Dispose();
 }
 
@@ -102,11 +102,16 @@ class WriteWrap : public StreamReq {
   static inline WriteWrap* FromObject(
       const BaseObjectPtrImpl<T, kIsWeak>& base_obj);
 
+  // The corked writes whose data this write carries. They complete with it,
+  // in its place.
+  inline void SetCorkedWrites(std::vector<BaseObjectPtr<AsyncWrap>>&& writes);
+
   // Call stream()->EmitAfterWrite() and dispose of this request wrap.
   void OnDone(int status) override;
 
  private:
   std::unique_ptr<v8::BackingStore> backing_store_;
+  std::vector<BaseObjectPtr<AsyncWrap>> corked_writes_;
 };
 
 
@@ -351,6 +356,22 @@ class StreamBase : public StreamResource {
       uv_stream_t* send_handle = nullptr,
       v8::Local<v8::Object> req_wrap_obj = v8::Local<v8::Object>());
 
+  // Cork the stream: writes smaller than `threshold` bytes are copied into a
+  // buffer. The buffer is written out in one go once the current event loop
+  // iteration is done with JS, when it would overflow `threshold` bytes, or
+  // before any other write, a shutdown or closing the stream. The corked
+  // writes complete when that write does, with its status. A threshold of 0
+  // flushes the buffer and uncorks the stream. Corking is off by default;
+  // returns UV_ENOTSUP if the stream cannot accept a write while another one
+  // is still pending.
+  int SetCorkThreshold(size_t threshold);
+  // Write out corked data now. Returns a libuv error code on failure, which
+  // the corked writes also complete with.
+  int FlushCork();
+  // Whether DoWrite() may be called while earlier writes are in progress,
+  // which corking relies on.
+  virtual bool SupportsCork() const { return false; }
+
   // These can be overridden by subclasses to get more specific wrap instances.
   // For example, a subclass Foo could create a FooWriteWrap or FooShutdownWrap
   // (inheriting from ShutdownWrap/WriteWrap) that has extra fields, like
@@ -376,6 +397,7 @@ class StreamBase : public StreamResource {
   template <enum encoding enc>
   int WriteString(const v8::FunctionCallbackInfo<v8::Value>& args);
   int UseUserBuffer(const v8::FunctionCallbackInfo<v8::Value>& args);
+  int SetCorkJS(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static void GetFD(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetExternal(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -401,6 +423,32 @@ class StreamBase : public StreamResource {
   EmitToJSStreamListener default_listener_;
 
   void SetWriteResult(const StreamWriteResult& res);
+  // The part of Write() that comes after corking.
+  inline StreamWriteResult WriteUncorked(uv_buf_t* bufs,
+                                         size_t count,
+                                         size_t total_bytes,
+                                         uv_stream_t* send_handle,
+                                         v8::Local<v8::Object> req_wrap_obj);
+  // Copies the data into the cork buffer if it fits the cork threshold, and
+  // sets `*res` to the pending result of the write.
+  bool CorkWrite(const uv_buf_t* bufs,
+                 size_t count,
+                 size_t total_bytes,
+                 v8::Local<v8::Object> req_wrap_obj,
+                 StreamWriteResult* res);
+  // Completes corked writes that never made it to DoWrite() with `status`.
+  void FailCorkedWrites(std::vector<BaseObjectPtr<AsyncWrap>>&& writes,
+                        int status);
+
+  // Maximum size of the storage that Writev() keeps around for encoding
+  // strings.
+  static constexpr size_t kWritevStorageSize = 64 * 1024;
+
+  size_t cork_threshold_ = 0;
+  size_t cork_size_ = 0;
+  bool cork_flush_scheduled_ = false;
+  std::unique_ptr<v8::BackingStore> cork_data_;
+  std::vector<BaseObjectPtr<AsyncWrap>> cork_writes_;
   static void AddMethod(Environment* env,
                         v8::Local<v8::Signature> sig,
                         enum v8::PropertyAttribute attributes,
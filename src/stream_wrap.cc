@@ -26,30 +26,37 @@
 #include "handle_wrap.h"
 #include "node_buffer.h"
 #include "node_external_reference.h"
+#include "node_internals.h"
 #include "pipe_wrap.h"
 #include "req_wrap-inl.h"
 #include "tcp_wrap.h"
 #include "udp_wrap.h"
 #include "util-inl.h"
 
+#include <algorithm>
 #include <cstring>  // memcpy()
 #include <climits>  // INT_MAX
+#include <vector>
 
 
 namespace node {
 
+using v8::Array;
 using v8::Context;
 using v8::DontDelete;
 using v8::EscapableHandleScope;
+using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
+using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
 using v8::Object;
 using v8::PropertyAttribute;
 using v8::ReadOnly;
 using v8::Signature;
+using v8::Uint32;
 using v8::Value;
 
 void IsConstructCallCallback(const FunctionCallbackInfo<Value>& args) {
@@ -101,6 +108,7 @@ void LibuvStreamWrap::Initialize(Local<Object> target,
   NODE_DEFINE_CONSTANT(target, kLastWriteWasAsync);
   target->Set(context, FIXED_ONE_BYTE_STRING(env->isolate(), "streamBaseState"),
               env->stream_base_state().GetJSArray()).Check();
+  env->SetMethod(target, "setIdleTimeoutCallback", SetIdleTimeoutCallback);
 }
 
 void LibuvStreamWrap::RegisterExternalReferences(
@@ -108,6 +116,8 @@ void LibuvStreamWrap::RegisterExternalReferences(
   registry->Register(IsConstructCallCallback);
   registry->Register(GetWriteQueueSize);
   registry->Register(SetBlocking);
+  registry->Register(SetIdleTimeout);
+  registry->Register(SetIdleTimeoutCallback);
   // TODO(joyee): StreamBase::RegisterExternalReferences() is called somewhere
   // else but we may want to do it here too and guard it with a static flag.
 }
@@ -147,6 +157,7 @@ Local<FunctionTemplate> LibuvStreamWrap::GetConstructorTemplate(
         Local<FunctionTemplate>(),
         static_cast<PropertyAttribute>(ReadOnly | DontDelete));
     env->SetProtoMethod(tmpl, "setBlocking", SetBlocking);
+    env->SetProtoMethod(tmpl, "setIdleTimeout", SetIdleTimeout);
     StreamBase::AddMethods(env, tmpl);
     env->set_libuv_stream_wrap_ctor_template(tmpl);
   }
@@ -183,6 +194,13 @@ bool LibuvStreamWrap::IsClosing() {
 }
 
 
+void LibuvStreamWrap::Close(Local<Value> close_callback) {
+  if (IsAlive())
+    FlushCork();
+  HandleWrap::Close(close_callback);
+}
+
+
 AsyncWrap* LibuvStreamWrap::GetAsyncWrap() {
   return static_cast<AsyncWrap*>(this);
 }
@@ -255,6 +273,8 @@ void LibuvStreamWrap::OnUvRead(ssize_t nread, const uv_buf_t* buf) {
   // uv_close() on the handle.
   CHECK_EQ(persistent().IsEmpty(), false);
 
+  if (nread != 0) RecordActivity();
+
   if (nread > 0) {
     MaybeLocal<Object> pending_obj;
 
@@ -308,6 +328,35 @@ void LibuvStreamWrap::SetBlocking(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(uv_stream_set_blocking(wrap->stream(), enable));
 }
 
+
+void LibuvStreamWrap::SetIdleTimeout(const FunctionCallbackInfo<Value>& args) {
+  LibuvStreamWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.Holder());
+
+  CHECK(args[0]->IsUint32());
+  if (!wrap->IsAlive())
+    return args.GetReturnValue().Set(UV_EINVAL);
+
+  uint32_t timeout = args[0].As<Uint32>()->Value();
+  wrap->env()->stream_idle_tracker()->SetTimeout(wrap, timeout);
+  args.GetReturnValue().Set(0);
+}
+
+
+void LibuvStreamWrap::SetIdleTimeoutCallback(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsFunction());
+  env->stream_idle_tracker()->set_callback(args[0].As<Function>());
+}
+
+
+void LibuvStreamWrap::RecordActivity() {
+  if (idle_timeout_ == 0) return;
+  last_activity_ = uv_now(env()->event_loop());
+  idle_timed_out_ = false;
+}
+
 typedef SimpleShutdownWrap<ReqWrap<uv_shutdown_t>> LibuvShutdownWrap;
 typedef SimpleWriteWrap<ReqWrap<uv_write_t>> LibuvWriteWrap;
 
@@ -352,6 +401,8 @@ int LibuvStreamWrap::DoTryWrite(uv_buf_t** bufs, size_t* count) {
   if (err < 0)
     return err;
 
+  RecordActivity();
+
   // Slice off the buffers: skip all written buffers and slice the one that
   // was partially written.
   written = err;
@@ -381,6 +432,7 @@ int LibuvStreamWrap::DoWrite(WriteWrap* req_wrap,
                              size_t count,
                              uv_stream_t* send_handle) {
   LibuvWriteWrap* w = static_cast<LibuvWriteWrap*>(req_wrap);
+  RecordActivity();
   return w->Dispatch(uv_write2,
                      stream(),
                      bufs,
@@ -397,9 +449,144 @@ void LibuvStreamWrap::AfterUvWrite(uv_write_t* req, int status) {
   CHECK_NOT_NULL(req_wrap);
   HandleScope scope(req_wrap->env()->isolate());
   Context::Scope context_scope(req_wrap->env()->context());
+  if (status == 0) {
+    static_cast<LibuvStreamWrap*>(req_wrap->stream())->RecordActivity();
+  }
   req_wrap->Done(status);
 }
 
+
+StreamIdleTracker::StreamIdleTracker(Environment* env) : env_(env) {
+  CHECK_EQ(0, uv_timer_init(env->event_loop(), &timer_));
+  // Idle timeouts must not keep the process alive.
+  uv_unref(reinterpret_cast<uv_handle_t*>(&timer_));
+  env->AddCleanupHook(CleanupHook, this);
+}
+
+
+StreamIdleTracker::~StreamIdleTracker() {
+  // The timer is closed by the cleanup hook before the Environment goes
+  // away.
+  CHECK(timer_closed_);
+}
+
+
+void StreamIdleTracker::CleanupHook(void* data) {
+  StreamIdleTracker* tracker = static_cast<StreamIdleTracker*>(data);
+  while (tracker->streams_.PopFront() != nullptr) {}
+  tracker->callback_.Reset();
+  tracker->env_->CloseHandle(&tracker->timer_, [](uv_timer_t* handle) {
+    StreamIdleTracker* tracker =
+        ContainerOf(&StreamIdleTracker::timer_, handle);
+    tracker->timer_closed_ = true;
+  });
+}
+
+
+void StreamIdleTracker::set_callback(Local<Function> callback) {
+  callback_.Reset(env_->isolate(), callback);
+}
+
+
+uint64_t StreamIdleTracker::SweepInterval(uint64_t timeout) {
+  return std::max<uint64_t>(1, std::min(timeout / 4, kMaxSweepInterval));
+}
+
+
+void StreamIdleTracker::SetTimeout(LibuvStreamWrap* stream,
+                                   uint64_t timeout) {
+  stream->idle_timeout_ = timeout;
+  if (timeout == 0) {
+    stream->idle_timeout_node_.Remove();
+    return;
+  }
+
+  stream->RecordActivity();
+  stream->last_write_queue_size_ = 0;
+  if (stream->idle_timeout_node_.IsEmpty()) streams_.PushBack(stream);
+
+  uint64_t interval = SweepInterval(timeout);
+  if (!uv_is_active(reinterpret_cast<uv_handle_t*>(&timer_)) ||
+      interval < interval_) {
+    StartTimer(interval);
+  }
+}
+
+
+void StreamIdleTracker::StartTimer(uint64_t interval) {
+  interval_ = interval;
+  uv_timer_start(&timer_, OnTimer, interval, interval);
+}
+
+
+void StreamIdleTracker::OnTimer(uv_timer_t* handle) {
+  StreamIdleTracker* tracker =
+      ContainerOf(&StreamIdleTracker::timer_, handle);
+  tracker->Sweep();
+}
+
+
+void StreamIdleTracker::Sweep() {
+  const uint64_t now = uv_now(env_->event_loop());
+  uint64_t interval = kMaxSweepInterval;
+  std::vector<LibuvStreamWrap*> timed_out;
+  std::vector<LibuvStreamWrap*> closed;
+
+  for (LibuvStreamWrap* stream : streams_) {
+    if (!stream->IsAlive() || stream->IsClosing()) {
+      closed.push_back(stream);
+      continue;
+    }
+    interval = std::min(interval, SweepInterval(stream->idle_timeout_));
+    if (stream->idle_timed_out_ ||
+        now - stream->last_activity_ < stream->idle_timeout_) {
+      continue;
+    }
+    // Like net.Socket, do not time out while a pending write makes
+    // progress.
+    size_t write_queue_size = stream->stream()->write_queue_size;
+    if (write_queue_size > 0 &&
+        write_queue_size != stream->last_write_queue_size_) {
+      stream->last_write_queue_size_ = write_queue_size;
+      stream->last_activity_ = now;
+      continue;
+    }
+    stream->idle_timed_out_ = true;
+    timed_out.push_back(stream);
+  }
+
+  for (LibuvStreamWrap* stream : closed)
+    stream->idle_timeout_node_.Remove();
+
+  if (streams_.IsEmpty()) {
+    uv_timer_stop(&timer_);
+  } else if (interval != interval_) {
+    StartTimer(interval);
+  }
+
+  if (timed_out.empty() || callback_.IsEmpty() || !env_->can_call_into_js())
+    return;
+
+  Isolate* isolate = env_->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env_->context());
+
+  std::vector<Local<Value>> handles;
+  handles.reserve(timed_out.size());
+  for (LibuvStreamWrap* stream : timed_out)
+    handles.push_back(stream->object());
+
+  Local<Value> arg = Array::New(isolate, handles.data(), handles.size());
+  Local<Object> process = env_->process_object();
+  USE(InternalMakeCallback(env_,
+                           process,
+                           process,
+                           callback_.Get(isolate),
+                           1,
+                           &arg,
+                           {0, 0}));
+}
+
 }  // namespace node
 
 NODE_MODULE_CONTEXT_AWARE_INTERNAL(stream_wrap,
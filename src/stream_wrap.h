@@ -56,6 +56,12 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
               uv_buf_t* bufs,
               size_t count,
               uv_stream_t* send_handle) override;
+  // libuv queues writes.
+  bool SupportsCork() const override { return true; }
+
+  // Writes out corked data before closing the handle.
+  void Close(
+      v8::Local<v8::Value> close_callback = v8::Local<v8::Value>()) override;
 
   inline uv_stream_t* stream() const {
     return stream_;
@@ -102,6 +108,12 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
   static void GetWriteQueueSize(
       const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetBlocking(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetIdleTimeout(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetIdleTimeoutCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Resets the idle timeout, if there is one.
+  void RecordActivity();
 
   // Callbacks for libuv
   void OnUvAlloc(size_t suggested_size, uv_buf_t* buf);
@@ -114,6 +126,14 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
 
   uv_stream_t* const stream_;
 
+  // Idle timeout state, see StreamIdleTracker.
+  friend class StreamIdleTracker;
+  ListNode<LibuvStreamWrap> idle_timeout_node_;
+  uint64_t idle_timeout_ = 0;
+  uint64_t last_activity_ = 0;
+  size_t last_write_queue_size_ = 0;
+  bool idle_timed_out_ = false;
+
 #ifdef _WIN32
   // We don't always have an FD that we could look up on the stream_
   // object itself on Windows. However, for some cases, we open handles
@@ -125,6 +145,49 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
 #endif
 };
 
+// Keeps track of the idle timeouts of all streams of an Environment that
+// have one (see setIdleTimeout()). Reads and writes only record a timestamp
+// on the stream. Instead of a timer per stream, which would need to be
+// rescheduled on every read and write, a single coarse timer periodically
+// sweeps the tracked streams and passes all streams that have been idle for
+// longer than their timeout to the JS callback in one batch.
+//
+// Like net.Socket timeouts, a stream times out once per idle period, and
+// progress on pending writes counts as activity. Because of the sweep
+// interval, a stream may time out up to a quarter of its timeout (but no more
+// than kMaxSweepInterval) late.
+class StreamIdleTracker {
+ public:
+  explicit StreamIdleTracker(Environment* env);
+  ~StreamIdleTracker();
+
+  StreamIdleTracker(const StreamIdleTracker&) = delete;
+  StreamIdleTracker& operator=(const StreamIdleTracker&) = delete;
+
+  // Sets the idle timeout of a stream in milliseconds and resets it. A
+  // timeout of 0 stops tracking the stream.
+  void SetTimeout(LibuvStreamWrap* stream, uint64_t timeout);
+
+  // Called with an array of the timed out stream handles.
+  void set_callback(v8::Local<v8::Function> callback);
+
+  static constexpr uint64_t kMaxSweepInterval = 1000;
+
+ private:
+  static uint64_t SweepInterval(uint64_t timeout);
+  void StartTimer(uint64_t interval);
+  void Sweep();
+
+  static void OnTimer(uv_timer_t* handle);
+  static void CleanupHook(void* data);
+
+  Environment* const env_;
+  uv_timer_t timer_;
+  bool timer_closed_ = false;
+  uint64_t interval_ = 0;
+  ListHead<LibuvStreamWrap, &LibuvStreamWrap::idle_timeout_node_> streams_;
+  v8::Global<v8::Function> callback_;
+};
 
 }  // namespace node
 
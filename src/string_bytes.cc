@@ -538,6 +538,46 @@ static bool contains_non_ascii(const char* src, size_t len) {
 }
 
 
+bool StringBytes::GetExternalBytes(Local<Value> val,
+                                   enum encoding enc,
+                                   const char** data,
+                                   size_t* length) {
+  if (!val->IsString())
+    return false;
+  Local<String> str = val.As<String>();
+
+  switch (enc) {
+    case ASCII:
+    case LATIN1:
+    case UTF8:
+      if (str->IsExternalOneByte()) {
+        auto ext = str->GetExternalOneByteStringResource();
+        // Latin-1 characters above 0x7f take two bytes in UTF-8.
+        if (enc == UTF8 && contains_non_ascii(ext->data(), ext->length()))
+          return false;
+        *data = ext->data();
+        *length = ext->length();
+        return true;
+      }
+      return false;
+
+    case UCS2:
+      // Node's "ucs2" is little-endian, like the string's own storage on
+      // little-endian platforms.
+      if (IsLittleEndian() && str->IsExternalTwoByte()) {
+        auto ext = str->GetExternalStringResource();
+        *data = reinterpret_cast<const char*>(ext->data());
+        *length = ext->length() * sizeof(uint16_t);
+        return true;
+      }
+      return false;
+
+    default:
+      return false;
+  }
+}
+
+
 static void force_ascii_slow(const char* src, char* dst, size_t len) {
   for (size_t i = 0; i < len; ++i) {
     dst[i] = src[i] & 0x7f;
@@ -78,6 +78,15 @@ class StringBytes {
                       enum encoding enc,
                       int* chars_written = nullptr);
 
+  // If the bytes of `val` in encoding `enc` are exactly the contents of an
+  // external string, point `*data` and `*length` at that memory instead of
+  // copying it. V8 does not move external string data, so it stays valid for
+  // as long as the string itself is alive.
+  static bool GetExternalBytes(v8::Local<v8::Value> val,
+                               enum encoding enc,
+                               const char** data,
+                               size_t* length);
+
   // Take the bytes in the src, and turn it into a Buffer or String.
   static v8::MaybeLocal<v8::Value> Encode(v8::Isolate* isolate,
                                           const char* buf,
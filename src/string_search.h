@@ -11,6 +11,13 @@
 
 #include <cstring>
 #include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 namespace node {
 namespace stringsearch {
@@ -285,6 +292,89 @@ inline size_t FindFirstCharacter(Vector<const uint8_t> pattern,
   return subject.forward() ? raw_pos : (subj_len - raw_pos - 1);
 }
 
+// Finds the first occurrence of the whole pattern in `subject`, or returns
+// false if there is no faster way to do so than the generic linear search.
+template <typename Char>
+inline bool FindFirstAndLastCharacter(Vector<const Char> pattern,
+                                      Vector<const Char> subject,
+                                      size_t index,
+                                      size_t* result) {
+  return false;
+}
+
+
+// Forward search for a short one-byte pattern. Compares the first and the
+// last byte of the pattern against 16 candidate positions at once, and only
+// compares the remaining bytes where both of them match. This filters out
+// most candidates even when the first byte of the pattern is common in the
+// subject, as is the case for e.g. "\r\n\r\n".
+template <>
+inline bool FindFirstAndLastCharacter(Vector<const uint8_t> pattern,
+                                      Vector<const uint8_t> subject,
+                                      size_t index,
+                                      size_t* result) {
+  if (!subject.forward() || !pattern.forward()) return false;
+
+  const uint8_t* s = subject.start();
+  const uint8_t* p = pattern.start();
+  const size_t m = pattern.length();
+  // The last position at which the pattern can start.
+  const size_t n = subject.length() - m;
+  DCHECK_GE(m, 2);
+  size_t i = index;
+
+#if defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(static_cast<char>(p[0]));
+  const __m128i last = _mm_set1_epi8(static_cast<char>(p[m - 1]));
+  for (; i + 15 <= n; i += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+    unsigned mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                      _mm_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      const size_t pos = i + __builtin_ctz(mask);
+      if (memcmp(s + pos + 1, p + 1, m - 2) == 0) {
+        *result = pos;
+        return true;
+      }
+      mask &= mask - 1;
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t first = vdupq_n_u8(p[0]);
+  const uint8x16_t last = vdupq_n_u8(p[m - 1]);
+  for (; i + 15 <= n; i += 16) {
+    const uint8x16_t eq = vandq_u8(vceqq_u8(first, vld1q_u8(s + i)),
+                                   vceqq_u8(last, vld1q_u8(s + i + m - 1)));
+    // Narrow the comparison result to four bits per position.
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+    while (mask != 0) {
+      const int bit = __builtin_ctzll(mask);
+      const size_t pos = i + (bit >> 2);
+      if (memcmp(s + pos + 1, p + 1, m - 2) == 0) {
+        *result = pos;
+        return true;
+      }
+      mask &= ~(uint64_t{0xF} << (bit & ~3));
+    }
+  }
+#endif
+
+  for (; i <= n; i++) {
+    if (s[i] == p[0] && s[i + m - 1] == p[m - 1] &&
+        memcmp(s + i + 1, p + 1, m - 2) == 0) {
+      *result = i;
+      return true;
+    }
+  }
+  *result = subject.length();
+  return true;
+}
+
 //---------------------------------------------------------------------
 // Single Character Pattern Search Strategy
 //---------------------------------------------------------------------
@@ -307,6 +397,10 @@ size_t StringSearch<Char>::LinearSearch(
     Vector subject,
     size_t index) {
   CHECK_GT(pattern_.length(), 1);
+  size_t result;
+  if (FindFirstAndLastCharacter(pattern_, subject, index, &result))
+    return result;
+
   const size_t n = subject.length() - pattern_.length();
   for (size_t i = index; i <= n; i++) {
     i = FindFirstCharacter(pattern_, subject, i);
@@ -585,6 +679,137 @@ size_t SearchString(Vector<const Char> subject,
   StringSearch<Char> search(pattern);
   return search.Search(subject, start_index);
 }
+
+//---------------------------------------------------------------------
+// Multiple pattern search
+//---------------------------------------------------------------------
+
+// Searches for any of a set of byte patterns in a single pass over the
+// subject, using an Aho-Corasick automaton. Like StringSearch, the object
+// should be constructed once and reused when searching for the same set of
+// patterns multiple times.
+//
+// To keep the transition table small, bytes are mapped to equivalence
+// classes first: all bytes that do not occur in any of the patterns share a
+// single class. The patterns are not copied and must outlive the object.
+class MultiStringSearch {
+ public:
+  typedef stringsearch::Vector<const uint8_t> Vector;
+
+  explicit MultiStringSearch(const std::vector<Vector>& patterns)
+      : byte_classes_(256, 0), patterns_(patterns) {
+    CHECK_GT(patterns.size(), 0);
+    CHECK_LE(patterns.size(), static_cast<size_t>(INT32_MAX));
+
+    class_count_ = 1;
+    for (const Vector& pattern : patterns) {
+      CHECK(pattern.forward());
+      for (size_t i = 0; i < pattern.length(); i++) {
+        uint16_t& byte_class = byte_classes_[pattern[i]];
+        if (byte_class == 0) byte_class = static_cast<uint16_t>(class_count_++);
+      }
+    }
+
+    // Build the trie. Since no transition leads back to the root, a zero
+    // entry in transitions_ means "no child" until the failure transitions
+    // are filled in below.
+    AddState();
+    for (size_t index = 0; index < patterns.size(); index++) {
+      const Vector& pattern = patterns[index];
+      size_t state = 0;
+      for (size_t i = 0; i < pattern.length(); i++) {
+        const size_t slot = state * class_count_ + byte_classes_[pattern[i]];
+        if (transitions_[slot] == 0) {
+          // AddState() grows transitions_, so no reference into it is held.
+          const uint32_t next = AddState();
+          transitions_[slot] = next;
+        }
+        state = transitions_[slot];
+      }
+      if (outputs_[state] < 0) outputs_[state] = static_cast<int32_t>(index);
+      max_length_ = std::max(max_length_, pattern.length());
+    }
+
+    // Turn the trie into a deterministic automaton, breadth first, so that
+    // the failure state of each state has been completed before it is used.
+    std::vector<uint32_t> failure(outputs_.size(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(outputs_.size());
+    queue.push_back(0);
+    for (size_t head = 0; head < queue.size(); head++) {
+      const uint32_t state = queue[head];
+      for (size_t c = 0; c < class_count_; c++) {
+        uint32_t& next = transitions_[state * class_count_ + c];
+        const uint32_t fallback =
+            state == 0 ? 0 : transitions_[failure[state] * class_count_ + c];
+        if (next == 0) {
+          next = fallback;
+          continue;
+        }
+        failure[next] = fallback;
+        // The longest pattern that ends in a state is either the one that
+        // the state spells out, or the longest one that ends in its failure
+        // state, which spells out a shorter suffix.
+        if (outputs_[next] < 0) outputs_[next] = outputs_[fallback];
+        queue.push_back(next);
+      }
+    }
+  }
+
+  MultiStringSearch(const MultiStringSearch&) = delete;
+  MultiStringSearch& operator=(const MultiStringSearch&) = delete;
+
+  // Returns the position of the leftmost match at or after `index`, and the
+  // index of the matching pattern in `*pattern_index`. If several patterns
+  // match at that position, the longest one is reported. Returns
+  // subject.length() if there is no match.
+  size_t Search(Vector subject, size_t index, size_t* pattern_index) const {
+    CHECK(subject.forward());
+    const uint8_t* s = subject.start();
+    const size_t length = subject.length();
+    size_t best = length;
+    uint32_t state = 0;
+    for (size_t i = index; i < length; i++) {
+      // Matches that end here start too late to beat the best one.
+      if (best != length && i >= best + max_length_) break;
+      state = transitions_[state * class_count_ + byte_classes_[s[i]]];
+      const int32_t output = outputs_[state];
+      if (output < 0) continue;
+      const size_t start = i + 1 - patterns_[output].length();
+      // A match that starts at the same position but ends later is longer.
+      if (start <= best) {
+        best = start;
+        *pattern_index = static_cast<size_t>(output);
+      }
+    }
+    return best;
+  }
+
+  size_t memory_size() const {
+    return transitions_.size() * sizeof(transitions_[0]) +
+           outputs_.size() * sizeof(outputs_[0]) +
+           byte_classes_.size() * sizeof(byte_classes_[0]) +
+           patterns_.size() * sizeof(Vector);
+  }
+
+ private:
+  uint32_t AddState() {
+    CHECK_LT(outputs_.size(), UINT32_MAX);
+    const uint32_t state = static_cast<uint32_t>(outputs_.size());
+    outputs_.push_back(-1);
+    transitions_.resize(transitions_.size() + class_count_, 0);
+    return state;
+  }
+
+  std::vector<uint16_t> byte_classes_;
+  size_t class_count_;
+  std::vector<Vector> patterns_;
+  size_t max_length_ = 0;
+  // transitions_[state * class_count_ + byte_class] is the next state.
+  std::vector<uint32_t> transitions_;
+  // The index of the longest pattern that ends in each state, or -1.
+  std::vector<int32_t> outputs_;
+};
 }  // namespace stringsearch
 }  // namespace node
 
@@ -34,6 +34,11 @@
 
 #include <cstdlib>
 
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
+
 
 namespace node {
 
@@ -88,6 +93,7 @@ void TCPWrap::Initialize(Local<Object> target,
   env->SetProtoMethod(t, "open", Open);
   env->SetProtoMethod(t, "bind", Bind);
   env->SetProtoMethod(t, "listen", Listen);
+  env->SetProtoMethod(t, "setAcceptBatchSize", SetAcceptBatchSize);
   env->SetProtoMethod(t, "connect", Connect);
   env->SetProtoMethod(t, "bind6", Bind6);
   env->SetProtoMethod(t, "connect6", Connect6);
@@ -97,6 +103,8 @@ void TCPWrap::Initialize(Local<Object> target,
                       GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
   env->SetProtoMethod(t, "setNoDelay", SetNoDelay);
   env->SetProtoMethod(t, "setKeepAlive", SetKeepAlive);
+  env->SetProtoMethod(t, "setZeroCopyThreshold", SetZeroCopyThreshold);
+  env->SetProtoMethod(t, "attachReusePortCPUFilter", AttachReusePortCPUFilter);
 
 #ifdef _WIN32
   env->SetProtoMethod(t, "setSimultaneousAccepts", SetSimultaneousAccepts);
@@ -116,6 +124,7 @@ void TCPWrap::Initialize(Local<Object> target,
   NODE_DEFINE_CONSTANT(constants, SOCKET);
   NODE_DEFINE_CONSTANT(constants, SERVER);
   NODE_DEFINE_CONSTANT(constants, UV_TCP_IPV6ONLY);
+  NODE_DEFINE_CONSTANT(constants, UV_TCP_REUSEPORT);
   target->Set(context,
               env->constants_string(),
               constants).Check();
@@ -126,6 +135,7 @@ void TCPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Open);
   registry->Register(Bind);
   registry->Register(Listen);
+  registry->Register(SetAcceptBatchSize);
   registry->Register(Connect);
   registry->Register(Bind6);
   registry->Register(Connect6);
@@ -134,6 +144,8 @@ void TCPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
   registry->Register(SetNoDelay);
   registry->Register(SetKeepAlive);
+  registry->Register(SetZeroCopyThreshold);
+  registry->Register(AttachReusePortCPUFilter);
 #ifdef _WIN32
   registry->Register(SetSimultaneousAccepts);
 #endif
@@ -199,6 +211,66 @@ void TCPWrap::SetKeepAlive(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Writes of at least `threshold` bytes are sent with MSG_ZEROCOPY, so the
+// kernel transmits straight from the Buffer instead of copying it. libuv only
+// completes such a write once the kernel has released the Buffer, so OnDone()
+// and the JS oncomplete callback, which keep it alive until then, are
+// deferred accordingly. A threshold of 0 turns zero-copy sends off again.
+void TCPWrap::SetZeroCopyThreshold(const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+  CHECK(args[0]->IsUint32());
+  uint32_t threshold = args[0].As<Uint32>()->Value();
+  // A shared libuv may predate uv_tcp_zerocopy().
+#ifdef UV_HAVE_TCP_ZEROCOPY
+  int err = uv_tcp_zerocopy(&wrap->handle_, threshold);
+#else
+  int err = threshold == 0 ? 0 : UV_ENOTSUP;
+#endif
+  args.GetReturnValue().Set(err);
+}
+
+
+// Attaches a classic BPF program to the SO_REUSEPORT group of a socket that
+// was bound with UV_TCP_REUSEPORT, which makes the kernel hand each new
+// connection to the listener at the index of the CPU that received it
+// (listeners are numbered in the order in which they were bound). With one
+// listener per CPU, and with each listener's thread or process pinned to its
+// CPU, connections are then accepted on the CPU whose cache already holds
+// their state. If there are fewer listeners than CPUs, the kernel falls back
+// to its default hash-based distribution for the CPUs without one.
+void TCPWrap::AttachReusePortCPUFilter(
+    const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap,
+                          args.Holder(),
+                          args.GetReturnValue().Set(UV_EBADF));
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&wrap->handle_), &fd);
+  if (err == 0) {
+    sock_filter code[] = {
+      // A = the id of the CPU that processes the packet
+      { BPF_LD | BPF_W | BPF_ABS, 0, 0,
+        static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+      // Return A as the index of the listener in the group.
+      { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    sock_fprog program = { arraysize(code), code };
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                   &program, sizeof(program)) != 0) {
+      err = uv_translate_sys_error(errno);
+    }
+  }
+  args.GetReturnValue().Set(err);
+#else
+  args.GetReturnValue().Set(UV_ENOTSUP);
+#endif
+}
+
+
 #ifdef _WIN32
 void TCPWrap::SetSimultaneousAccepts(const FunctionCallbackInfo<Value>& args) {
   TCPWrap* wrap;
@@ -243,7 +315,9 @@ void TCPWrap::Bind(
   int port;
   unsigned int flags = 0;
   if (!args[1]->Int32Value(env->context()).To(&port)) return;
-  if (family == AF_INET6 &&
+  // UV_TCP_IPV6ONLY is only valid for IPv6 addresses, UV_TCP_REUSEPORT
+  // applies to both families.
+  if ((family == AF_INET6 || !args[2]->IsUndefined()) &&
       !args[2]->Uint32Value(env->context()).To(&flags)) {
     return;
   }
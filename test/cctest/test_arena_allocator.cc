@@ -0,0 +1,154 @@
+#include "node_internals.h"
+#include "node_page_allocator.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef __POSIX__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using node::ArenaArrayBufferAllocator;
+
+static constexpr size_t kMin = ArenaArrayBufferAllocator::kMinArenaSize;
+static constexpr size_t kMax = ArenaArrayBufferAllocator::kMaxArenaSize;
+
+static bool IsZeroFilled(const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    if (bytes[i] != 0) return false;
+  }
+  return true;
+}
+
+TEST(ArenaArrayBufferAllocatorTest, AllocateAndFree) {
+  ArenaArrayBufferAllocator allocator;
+
+  const size_t sizes[] = { kMin, kMin + 1, 1000, 4096, 100000, kMax };
+  std::vector<void*> blocks;
+  for (size_t size : sizes) {
+    void* data = allocator.Allocate(size);
+    ASSERT_NE(data, nullptr) << size;
+    EXPECT_TRUE(IsZeroFilled(data, size)) << size;
+    memset(data, 0xab, size);
+    blocks.push_back(data);
+  }
+  EXPECT_EQ(allocator.total_mem_usage(),
+            kMin + kMin + 1 + 1000 + 4096 + 100000 + kMax);
+
+  // No two live blocks overlap.
+  void* a = allocator.AllocateUninitialized(1000);
+  void* b = allocator.AllocateUninitialized(1000);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_GE(static_cast<size_t>(std::abs(static_cast<char*>(a) -
+                                         static_cast<char*>(b))),
+            1000u);
+
+  allocator.Free(a, 1000);
+  allocator.Free(b, 1000);
+  for (size_t i = 0; i < blocks.size(); i++)
+    allocator.Free(blocks[i], sizes[i]);
+  EXPECT_EQ(allocator.total_mem_usage(), 0u);
+}
+
+TEST(ArenaArrayBufferAllocatorTest, ReusesFreedBlocks) {
+  ArenaArrayBufferAllocator allocator;
+
+  void* data = allocator.Allocate(1000);
+  ASSERT_NE(data, nullptr);
+  memset(data, 0xab, 1000);
+  allocator.Free(data, 1000);
+
+  // The thread cache hands back the block that was freed last, for any
+  // size in the same class, and it is zero-filled again when asked for.
+  void* again = allocator.Allocate(900);
+  EXPECT_EQ(again, data);
+  EXPECT_TRUE(IsZeroFilled(again, 900));
+  allocator.Free(again, 900);
+
+  // Churn on one size does not grow the memory in use.
+  for (int i = 0; i < 10000; i++) {
+    void* block = allocator.AllocateUninitialized(4096);
+    ASSERT_NE(block, nullptr);
+    allocator.Free(block, 4096);
+  }
+  EXPECT_EQ(allocator.total_mem_usage(), 0u);
+
+  // Blocks outlive the allocator that handed them out, since the arenas
+  // are shared by all instances.
+  ArenaArrayBufferAllocator other;
+  EXPECT_EQ(other.Allocate(1000), data);
+  other.Free(data, 1000);
+}
+
+TEST(ArenaArrayBufferAllocatorTest, Reallocate) {
+  ArenaArrayBufferAllocator allocator;
+
+  char* data = static_cast<char*>(allocator.Allocate(1000));
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < 1000; i++) data[i] = static_cast<char>(i);
+
+  // Sizes in the same class are resized in place.
+  EXPECT_EQ(allocator.Reallocate(data, 1000, 1024), data);
+  EXPECT_EQ(allocator.total_mem_usage(), 1024u);
+
+  // Other sizes move the contents, whether they go to another class, to
+  // malloc() or to a mapping of their own.
+  const size_t sizes[] = {
+    5000, kMin - 1, kMax + 1, 1000, node::kHugePageSize
+  };
+  for (size_t size : sizes) {
+    char* moved = static_cast<char*>(
+        allocator.Reallocate(data, allocator.total_mem_usage(), size));
+    ASSERT_NE(moved, nullptr) << size;
+    for (size_t i = 0; i < std::min<size_t>(size, kMin - 1); i++)
+      ASSERT_EQ(moved[i], static_cast<char>(i)) << size;
+    EXPECT_EQ(allocator.total_mem_usage(), size);
+    data = moved;
+  }
+  allocator.Free(data, node::kHugePageSize);
+  EXPECT_EQ(allocator.total_mem_usage(), 0u);
+}
+
+TEST(ArenaArrayBufferAllocatorTest, FallsBackOutsideTheArenas) {
+  ArenaArrayBufferAllocator allocator;
+
+  // Small sizes, and sizes between the largest class and the smallest
+  // mapping, go through malloc().
+  const size_t sizes[] = { 0, 1, kMin - 1, kMax + 1, node::kHugePageSize - 1 };
+  for (size_t size : sizes) {
+    void* data = allocator.Allocate(size);
+    ASSERT_TRUE(data != nullptr || size == 0) << size;
+    EXPECT_TRUE(IsZeroFilled(data, size)) << size;
+    EXPECT_EQ(allocator.total_mem_usage(), size);
+    allocator.Free(data, size);
+    EXPECT_EQ(allocator.total_mem_usage(), 0u);
+  }
+
+  // Large sizes are mapped directly, and unmapped when freed.
+  const size_t size = 3 * node::kHugePageSize + 1;
+  void* data = allocator.AllocateUninitialized(size);
+  ASSERT_NE(data, nullptr);
+  EXPECT_TRUE(IsZeroFilled(data, size));
+  EXPECT_EQ(allocator.total_mem_usage(), size);
+#ifdef __POSIX__
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % page_size, 0u);
+  memset(data, 0xab, size);
+  allocator.Free(data, size);
+  // mincore() fails with ENOMEM for pages that are not mapped.
+  std::vector<unsigned char> resident(size / page_size + 1);
+  EXPECT_EQ(mincore(data, page_size, resident.data()), -1);
+  EXPECT_EQ(errno, ENOMEM);
+#else
+  allocator.Free(data, size);
+#endif
+  EXPECT_EQ(allocator.total_mem_usage(), 0u);
+}
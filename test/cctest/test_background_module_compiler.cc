@@ -0,0 +1,139 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "memory_tracker-inl.h"
+#include "module_wrap.h"
+#include "node_test_fixture.h"
+
+#ifndef _WIN32
+
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using node::loader::BackgroundModuleCompiler;
+
+class BackgroundModuleCompilerTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    uv_fs_t req;
+    std::string templ = "/tmp/node-esm-compile-XXXXXX";
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, templ.c_str(), nullptr), 0);
+    dir_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    for (const std::string& file : files_) remove(file.c_str());
+    rmdir(dir_.c_str());
+    EnvironmentTestFixture::TearDown();
+  }
+
+  // Returns the URL of a module `name`, with `source` unless it is null, in
+  // which case the file is not created.
+  std::string Module(const std::string& name, const char* source) {
+    std::string path = dir_ + "/" + name;
+    if (source != nullptr) {
+      FILE* f = fopen(path.c_str(), "w");
+      EXPECT_NE(f, nullptr);
+      fputs(source, f);
+      fclose(f);
+      files_.push_back(path);
+    }
+    return "file://" + path;
+  }
+
+  // Hands `source` to the compiler the way ModuleWrap::New does.
+  bool Finish(BackgroundModuleCompiler* compiler,
+              const std::string& url,
+              const char* source,
+              v8::MaybeLocal<v8::Module>* module) {
+    v8::Local<v8::String> url_string =
+        v8::String::NewFromUtf8(isolate_, url.c_str()).ToLocalChecked();
+    v8::ScriptOrigin origin(isolate_, url_string, 0, 0, true, -1,
+                            v8::Local<v8::Value>(), false, false, true);
+    return compiler->Finish(
+        url,
+        v8::String::NewFromUtf8(isolate_, source).ToLocalChecked(),
+        origin,
+        module);
+  }
+
+  std::string dir_;
+  std::vector<std::string> files_;
+};
+
+static const char kSource[] = "import './dep.mjs';\nexport const a = 1;\n";
+
+TEST_F(BackgroundModuleCompilerTest, PrefetchedModuleIsConsumed) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  BackgroundModuleCompiler compiler(*env);
+
+  std::string url = Module("a.mjs", kSource);
+  compiler.Enqueue(url);
+  EXPECT_EQ(compiler.pending_jobs(), 1u);
+
+  v8::MaybeLocal<v8::Module> maybe_module;
+  ASSERT_TRUE(Finish(&compiler, url, kSource, &maybe_module));
+  v8::Local<v8::Module> module;
+  ASSERT_TRUE(maybe_module.ToLocal(&module));
+  EXPECT_EQ(module->GetModuleRequests()->Length(), 1);
+  // The job is freed as soon as its result is taken.
+  EXPECT_EQ(compiler.pending_jobs(), 0u);
+
+  // The loader does not ask for the same URL again, so it is not compiled
+  // again either.
+  compiler.Enqueue(url);
+  EXPECT_EQ(compiler.pending_jobs(), 0u);
+}
+
+TEST_F(BackgroundModuleCompilerTest, UnusedJobsAreFreed) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  BackgroundModuleCompiler compiler(*env);
+
+  // The loader changed the source, e.g. through a hook.
+  std::string changed = Module("changed.mjs", kSource);
+  compiler.Enqueue(changed);
+  v8::MaybeLocal<v8::Module> module;
+  EXPECT_FALSE(Finish(&compiler, changed, "export {};", &module));
+  EXPECT_TRUE(module.IsEmpty());
+  EXPECT_EQ(compiler.pending_jobs(), 0u);
+
+  // The loader used the code cache instead.
+  std::string cached = Module("cached.mjs", kSource);
+  compiler.Enqueue(cached);
+  EXPECT_FALSE(Finish(&compiler, cached, kSource, nullptr));
+  EXPECT_EQ(compiler.pending_jobs(), 0u);
+  // Unless a worker thread was compiling it at that moment.
+  EXPECT_LE(compiler.retired_jobs(), 1u);
+}
+
+TEST_F(BackgroundModuleCompilerTest, OldestJobIsDroppedAtLimit) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  BackgroundModuleCompiler compiler(*env);
+
+  std::string first = Module("first.mjs", kSource);
+  compiler.Enqueue(first);
+  // Imports that the loader resolved differently, and never asks for.
+  for (size_t i = 0; i < BackgroundModuleCompiler::kMaxJobs; i++)
+    compiler.Enqueue(Module("missing" + std::to_string(i) + ".mjs", nullptr));
+  EXPECT_EQ(compiler.pending_jobs(), BackgroundModuleCompiler::kMaxJobs);
+  std::string last = Module("last.mjs", kSource);
+  compiler.Enqueue(last);
+  EXPECT_EQ(compiler.pending_jobs(), BackgroundModuleCompiler::kMaxJobs);
+
+  v8::MaybeLocal<v8::Module> module;
+  EXPECT_FALSE(Finish(&compiler, first, kSource, &module));
+  EXPECT_TRUE(Finish(&compiler, last, kSource, &module));
+  EXPECT_FALSE(module.IsEmpty());
+  EXPECT_EQ(compiler.pending_jobs(), BackgroundModuleCompiler::kMaxJobs - 1);
+}
+
+#endif  // _WIN32
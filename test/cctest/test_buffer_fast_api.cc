@@ -0,0 +1,264 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+// Calls each Buffer binding that has a fast API implementation from code
+// that V8 has optimized, and checks that it returns, throws and writes
+// exactly what the unoptimized call, which always takes the slow path, does.
+class BufferFastApiTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    v8::V8::SetFlagsFromString("--allow-natives-syntax --turbo-fast-api-calls");
+  }
+
+  std::string GetResult(const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name("result")).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return "";
+    v8::String::Utf8Value value(
+        isolate_,
+        result.As<v8::Object>()->Get(context, name(field)).ToLocalChecked());
+    return *value == nullptr ? "" : *value;
+  }
+};
+
+static const char kScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const binding = internalBinding('buffer');
+
+const UTF8 = 1;
+const UCS2 = 3;
+
+// Views on an ArrayBuffer of their own; small typed arrays created
+// directly live on the JS heap, which the fast calls leave to the slow path.
+function bytes(...values) {
+  const view = new Uint8Array(new ArrayBuffer(values.length));
+  view.set(values);
+  return view;
+}
+
+// Each binding is wrapped in a function with its exact arity, which is
+// what lets V8 replace the call with a fast one.
+const wrappers = {
+  copy(source, target, targetStart, sourceStart, sourceEnd) {
+    return binding.copy(source, target, targetStart, sourceStart, sourceEnd);
+  },
+  fill(buffer, value, start, end, encoding) {
+    return binding.fill(buffer, value, start, end, encoding);
+  },
+  compare(a, b) {
+    return binding.compare(a, b);
+  },
+  compareOffset(source, target, targetStart, sourceStart, targetEnd,
+                sourceEnd) {
+    return binding.compareOffset(source, target, targetStart, sourceStart,
+                                 targetEnd, sourceEnd);
+  },
+  indexOfBuffer(haystack, needle, offset, encoding, isForward) {
+    return binding.indexOfBuffer(haystack, needle, offset, encoding,
+                                 isForward);
+  },
+  indexOfNumber(buffer, needle, offset, isForward) {
+    return binding.indexOfNumber(buffer, needle, offset, isForward);
+  },
+};
+
+// Returns what `fn` returned or threw for the arguments that `makeArgs`
+// creates, along with the contents of the views among them afterwards.
+function run(fn, makeArgs) {
+  const args = makeArgs();
+  let returned;
+  try {
+    returned = fn(...args);
+  } catch (err) {
+    returned = err.code;
+  }
+  const views = args.filter((arg) => ArrayBuffer.isView(arg));
+  return JSON.stringify([returned, views.map((view) => Array.from(view))]);
+}
+
+const cases = {
+  copy: [
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 0, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 1, 1, 3],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0), 0, 0, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 1.5, 0.5, 3.9],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), NaN, NaN, NaN],
+    // Zero lengths.
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 2, 2],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 3, 1],
+    () => [bytes(), bytes(0, 0, 0, 0), 0, 0, 0],
+    () => [bytes(1, 2, 3, 4), bytes(), 0, 0, 4],
+    // Out-of-range offsets.
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 4, 0, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 10, 0, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 6, 8],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 2, 100],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), -1, 0, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, -1, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 0, 0, 0), 0, 0, 2 ** 53],
+    // Overlapping copies, in both directions.
+    () => {
+      const all = bytes(0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+      return [all.subarray(0, 8), all.subarray(2), 0, 0, 8];
+    },
+    () => {
+      const all = bytes(0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+      return [all.subarray(2), all.subarray(0, 8), 0, 0, 8];
+    },
+    () => {
+      const all = bytes(0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+      return [all, all, 1, 0, 9];
+    },
+    // A target on the JS heap.
+    () => [bytes(1, 2, 3, 4), new Uint8Array(4), 0, 0, 4],
+  ],
+  fill: [
+    () => [bytes(0, 0, 0, 0), 7, 0, 4, undefined],
+    () => [bytes(0, 0, 0, 0), 7, 1, 3, undefined],
+    () => [bytes(0, 0, 0, 0), 257, 0, 4, undefined],
+    () => [bytes(0, 0, 0, 0), -1, 0, 4, undefined],
+    () => [bytes(0, 0, 0, 0), 1.5, 0, 4, undefined],
+    () => [bytes(0, 0, 0, 0), -300.5, 0, 4, undefined],
+    () => [bytes(0, 0, 0, 0), 1e20, 0, 4, undefined],
+    () => [bytes(9, 9, 9, 9), NaN, 0, 4, undefined],
+    () => [bytes(9, 9, 9, 9), Infinity, 0, 4, undefined],
+    () => [bytes(9, 9, 9, 9), -Infinity, 0, 4, undefined],
+    // Zero lengths.
+    () => [bytes(0, 0, 0, 0), 7, 2, 2, undefined],
+    () => [bytes(0, 0, 0, 0), 7, 4, 4, undefined],
+    () => [bytes(), 7, 0, 0, undefined],
+    // Out-of-range offsets.
+    () => [bytes(0, 0, 0, 0), 7, 3, 1, undefined],
+    () => [bytes(0, 0, 0, 0), 7, 0, 5, undefined],
+    () => [bytes(0, 0, 0, 0), 7, 5, 6, undefined],
+    () => [bytes(0, 0, 0, 0), 7, -1, 4, undefined],
+    () => [bytes(0, 0, 0, 0), 7, 0, 2 ** 53, undefined],
+    // Values that are not numbers, and a target on the JS heap.
+    () => [bytes(0, 0, 0, 0), 'ab', 0, 4, 'utf8'],
+    () => [bytes(0, 0, 0, 0), bytes(1, 2), 0, 4, undefined],
+    () => [new Uint8Array(4), 7, 0, 4, undefined],
+  ],
+  compare: [
+    () => [bytes(1, 2, 3), bytes(1, 2, 3)],
+    () => [bytes(1, 2, 3), bytes(1, 2, 4)],
+    () => [bytes(1, 2, 4), bytes(1, 2, 3)],
+    () => [bytes(1, 2), bytes(1, 2, 3)],
+    () => [bytes(1, 2, 3), bytes(1, 2)],
+    () => [bytes(), bytes()],
+    () => [bytes(), bytes(0)],
+    () => [bytes(0), bytes()],
+    () => [new Uint8Array([1, 2]), bytes(1, 2)],
+    () => [bytes(1, 2, 3), 'abc'],
+  ],
+  compareOffset: [
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, 0, 4, 4],
+    () => [bytes(1, 2, 3, 4), bytes(0, 2, 3, 0), 1, 1, 3, 3],
+    () => [bytes(1, 2, 3, 4), bytes(0, 2, 3, 0), 0, 0, 3, 3],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, 0, 2, 3],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, 0, 3, 2],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), NaN, NaN, 4, 4],
+    // Zero lengths.
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 2, 2, 2, 2],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 4, 0, 4, 1],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, 4, 1, 4],
+    () => [bytes(), bytes(), 0, 0, 0, 0],
+    // Out-of-range offsets.
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, 5, 4, 6],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 5, 0, 6, 4],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), -1, 0, 4, 4],
+    () => [bytes(1, 2, 3, 4), bytes(1, 2, 3, 4), 0, -1, 4, 4],
+  ],
+  indexOfBuffer: [
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 0, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 2, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 5, UTF8, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 3, UTF8, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 1.5, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(4), 0, UTF8, true],
+    // Negative byteOffsets, inside and before the start of the buffer.
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -2, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -5, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -2, UTF8, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -100, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -100, UTF8, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), -(2 ** 53), UTF8, true],
+    // Out-of-range offsets.
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 5, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 100, UTF8, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 100, UTF8, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), bytes(2, 3), 2 ** 53, UTF8, true],
+    // Zero lengths.
+    () => [bytes(1, 2, 3), bytes(), 1, UTF8, true],
+    () => [bytes(1, 2, 3), bytes(), 100, UTF8, true],
+    () => [bytes(1, 2, 3), bytes(), -100, UTF8, false],
+    () => [bytes(), bytes(1), 0, UTF8, true],
+    () => [bytes(), bytes(), 0, UTF8, true],
+    () => [bytes(1), bytes(1, 2), 0, UTF8, true],
+    // UCS-2 matches only at even offsets.
+    () => [bytes(0, 1, 0, 1, 0), bytes(1, 0), 0, UCS2, true],
+    () => [bytes(1, 0, 1, 0), bytes(1, 0), -2, UCS2, false],
+    () => [bytes(1, 0, 1), bytes(1), 0, UCS2, true],
+  ],
+  indexOfNumber: [
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 0, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 2, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 3, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), 4, 0, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 258, 0, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 1.5, true],
+    // Negative byteOffsets, inside and before the start of the buffer.
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, -1, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, -3, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, -100, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, -100, false],
+    // Out-of-range offsets.
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 6, true],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 100, false],
+    () => [bytes(1, 2, 3, 1, 2, 3), 2, 2 ** 53, true],
+    // Zero lengths.
+    () => [bytes(), 0, 0, true],
+    () => [bytes(), 0, -1, false],
+  ],
+};
+
+const result = { checked: 0, mismatches: [] };
+for (const [name, list] of Object.entries(cases)) {
+  const fn = wrappers[name];
+  for (let i = 0; i < list.length; i++) {
+    const slow = run(fn, list[i]);
+    // Optimize the wrapper anew for every case, since a call that fell
+    // back to the slow path may have deoptimized it.
+    %PrepareFunctionForOptimization(fn);
+    run(fn, list[0]);
+    %OptimizeFunctionOnNextCall(fn);
+    run(fn, list[0]);
+    const fast = run(fn, list[i]);
+    if (fast !== slow)
+      result.mismatches.push(`${name}[${i}]: ${fast} !== ${slow}`);
+    result.checked++;
+  }
+}
+result.mismatches = result.mismatches.join('\n');
+globalThis.result = result;
+)";
+
+TEST_F(BufferFastApiTest, MatchesSlowPath) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kScript).ToLocalChecked();
+
+  EXPECT_EQ(GetResult("checked"), "105");
+  EXPECT_EQ(GetResult("mismatches"), "");
+}
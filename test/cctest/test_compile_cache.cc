@@ -0,0 +1,116 @@
+#include "compile_cache.h"
+#include "env-inl.h"
+#include "fs_tree.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+#ifndef _WIN32
+
+#include <memory>
+#include <string>
+
+using node::CachedCodeType;
+using node::CompileCacheEntry;
+using node::CompileCacheHandler;
+using node::fs::TreeOperation;
+
+static constexpr CachedCodeType kType = CachedCodeType::kCommonJS;
+
+class CompileCacheTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    uv_fs_t req;
+    std::string templ = "/tmp/node-compile-cache-XXXXXX";
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, templ.c_str(), nullptr), 0);
+    dir_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    ASSERT_EQ(uv_fs_lstat(nullptr, &req, dir_.c_str(), nullptr), 0);
+    TreeOperation remove(TreeOperation::Kind::kRemove, dir_);
+    remove.Begin(&req.statbuf);
+    uv_fs_req_cleanup(&req);
+    remove.Work();
+    EnvironmentTestFixture::TearDown();
+  }
+
+  v8::Local<v8::String> String(const char* str) {
+    return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+  }
+
+  // Compiles `code` as a function body, consuming the cache in `entry` if
+  // there is one. Sets `rejected` if V8 did not accept it.
+  v8::Local<v8::Function> Compile(const char* code,
+                                  CompileCacheEntry* entry,
+                                  bool* rejected) {
+    v8::ScriptOrigin origin(isolate_, String("/app/main.js"));
+    v8::ScriptCompiler::CachedData* cached_data = entry->CopyCache();
+    v8::ScriptCompiler::Source source(String(code), origin, cached_data);
+    v8::Local<v8::Function> fn =
+        v8::ScriptCompiler::CompileFunction(
+            isolate_->GetCurrentContext(),
+            &source,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            cached_data == nullptr ? v8::ScriptCompiler::kNoCompileOptions
+                                   : v8::ScriptCompiler::kConsumeCodeCache)
+            .ToLocalChecked();
+    *rejected = cached_data != nullptr && source.GetCachedData()->rejected;
+    return fn;
+  }
+
+  // Looks `code` up in a fresh handler, the way a new process would, then
+  // compiles it and writes out the cache.
+  bool Run(node::Environment* env, const char* code) {
+    CompileCacheHandler handler(env);
+    EXPECT_TRUE(handler.InitializeDirectory(dir_));
+    CompileCacheEntry* entry =
+        handler.GetOrInsert(String(code), "/app/main.js", kType);
+    bool hit = entry->data != nullptr;
+    EXPECT_NE(hit, entry->refresh);
+    bool rejected;
+    v8::Local<v8::Function> fn = Compile(code, entry, &rejected);
+    EXPECT_FALSE(rejected);
+    handler.MaybeSave(entry, fn, rejected);
+    handler.Persist();
+    return hit;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(CompileCacheTest, HitMissAndInvalidation) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  const char* code = "function add(a, b) { return a + b; }\nreturn add(1, 2);";
+  // The same length, which is all that V8 checks.
+  const char* edited =
+      "function add(a, b) { return a - b; }\nreturn add(1, 2);";
+
+  EXPECT_FALSE(Run(*env, code));
+  EXPECT_TRUE(Run(*env, code));
+
+  // Editing the module invalidates its cache, and replaces it.
+  EXPECT_FALSE(Run(*env, edited));
+  EXPECT_TRUE(Run(*env, edited));
+  EXPECT_FALSE(Run(*env, code));
+
+  // Within a process, the entry is reused for the same source only.
+  CompileCacheHandler handler(*env);
+  ASSERT_TRUE(handler.InitializeDirectory(dir_));
+  CompileCacheEntry* entry =
+      handler.GetOrInsert(String(code), "/app/main.js", kType);
+  EXPECT_NE(entry->data, nullptr);
+  EXPECT_EQ(handler.GetOrInsert(String(code), "/app/main.js", kType), entry);
+  EXPECT_NE(handler.GetOrInsert(String(edited), "/app/main.js", kType),
+            entry);
+}
+
+#endif  // _WIN32
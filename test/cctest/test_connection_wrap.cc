@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+
+class ConnectionWrapTest : public EnvironmentTestFixture {
+ protected:
+  int64_t GetResult(const char* mode, const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name(mode)).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return -1;
+    return result.As<v8::Object>()
+        ->Get(context, name(field))
+        .ToLocalChecked()
+        ->IntegerValue(context)
+        .FromJust();
+  }
+};
+
+// Accepts kConnections connections on a server with an accept batch size,
+// once with onconnectionbatch installed and once without it, and records
+// how the connections were delivered.
+static const char kAcceptScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const { TCP, TCPConnectWrap, constants } = internalBinding('tcp_wrap');
+const kConnections = 8;
+
+function run(useBatches, done) {
+  const server = new TCP(constants.SERVER);
+  if (server.bind('127.0.0.1', 0) !== 0) throw new Error('bind');
+  const address = {};
+  server.getsockname(address);
+  server.setAcceptBatchSize(kConnections);
+
+  const result = { batches: 0, connections: 0 };
+  const accepted = [];
+  const clients = [];
+  const onAccepted = (handles) => {
+    accepted.push(...handles);
+    result.connections += handles.length;
+    if (result.connections < kConnections) return;
+    for (const handle of accepted.concat(clients)) handle.close();
+    server.close();
+    done(result);
+  };
+  server.onconnection = (status, handle) => {
+    if (status !== 0) throw new Error(`accept: ${status}`);
+    onAccepted([handle]);
+  };
+  if (useBatches) {
+    server.onconnectionbatch = (handles) => {
+      result.batches++;
+      onAccepted(handles);
+    };
+  }
+  if (server.listen(511) !== 0) throw new Error('listen');
+
+  for (let i = 0; i < kConnections; i++) {
+    const client = new TCP(constants.SOCKET);
+    const req = new TCPConnectWrap();
+    req.oncomplete = () => {};
+    client.connect(req, '127.0.0.1', address.port);
+    clients.push(client);
+  }
+}
+
+run(true, (batched) => {
+  globalThis.batched = batched;
+  run(false, (unbatched) => { globalThis.unbatched = unbatched; });
+});
+)";
+
+TEST_F(ConnectionWrapTest, DeliversAcceptedConnectionsInBatches) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kAcceptScript).ToLocalChecked();
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  EXPECT_EQ(GetResult("batched", "connections"), 8);
+  // libuv may spread the connections over several wakeups.
+  EXPECT_GE(GetResult("batched", "batches"), 1);
+  EXPECT_LE(GetResult("batched", "batches"), 8);
+
+  // Without onconnectionbatch, every connection still reaches onconnection.
+  EXPECT_EQ(GetResult("unbatched", "connections"), 8);
+  EXPECT_EQ(GetResult("unbatched", "batches"), 0);
+}
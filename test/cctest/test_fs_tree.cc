@@ -0,0 +1,233 @@
+#include "fs_tree.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+#ifndef _WIN32
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using node::fs::TreeOperation;
+
+class FSTreeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    uv_fs_t req;
+    std::string templ = "/tmp/node-fs-tree-XXXXXX";
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, templ.c_str(), nullptr), 0);
+    root_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    TreeOperation remove(TreeOperation::Kind::kRemove, root_);
+    Run(&remove, root_);
+  }
+
+  static int Run(TreeOperation* operation, const std::string& path) {
+    uv_fs_t req;
+    int err;
+    if (operation->kind() == TreeOperation::Kind::kScan)
+      err = uv_fs_stat(nullptr, &req, path.c_str(), nullptr);
+    else
+      err = uv_fs_lstat(nullptr, &req, path.c_str(), nullptr);
+    EXPECT_EQ(err, 0);
+    if (err == 0)
+      operation->Begin(&req.statbuf);
+    uv_fs_req_cleanup(&req);
+    return err == 0 ? operation->Work() : err;
+  }
+
+  static void WriteFile(const std::string& path, const char* contents) {
+    FILE* f = fopen(path.c_str(), "w");
+    ASSERT_NE(f, nullptr);
+    fputs(contents, f);
+    fclose(f);
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    char buf[64] = {};
+    FILE* f = fopen(path.c_str(), "r");
+    EXPECT_NE(f, nullptr);
+    if (f == nullptr)
+      return "";
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    return std::string(buf, len);
+  }
+
+  static bool Exists(const std::string& path) {
+    struct stat s;
+    return lstat(path.c_str(), &s) == 0;
+  }
+
+  // Creates a/, a/b/, a/b/c/ with two files each and a symlink in a/.
+  std::string MakeTree() {
+    std::string tree = root_ + "/tree";
+    std::string dir = tree;
+    EXPECT_EQ(mkdir(tree.c_str(), 0755), 0);
+    for (const char* name : { "a", "b", "c" }) {
+      dir += std::string("/") + name;
+      EXPECT_EQ(mkdir(dir.c_str(), 0755), 0);
+      WriteFile(dir + "/one", name);
+      WriteFile(dir + "/two", name);
+    }
+    EXPECT_EQ(symlink("b/c", (tree + "/a/link").c_str()), 0);
+    return tree;
+  }
+
+  std::string root_;
+};
+
+TEST_F(FSTreeTest, CopyTree) {
+  std::string src = MakeTree();
+  std::string dest = root_ + "/copy";
+
+  TreeOperation copy(TreeOperation::Kind::kCopy, src, dest);
+  Run(&copy, src);
+  EXPECT_EQ(copy.error_count(), 0u);
+  // tree/, 3 directories, 6 files and a symlink.
+  EXPECT_EQ(copy.entries(), 11u);
+
+  EXPECT_EQ(ReadFile(dest + "/a/b/c/two"), "c");
+  char target[16] = {};
+  ASSERT_EQ(readlink((dest + "/a/link").c_str(), target, sizeof(target) - 1),
+            3);
+  EXPECT_STREQ(target, "b/c");
+}
+
+TEST_F(FSTreeTest, CopyTreeExclusive) {
+  std::string src = MakeTree();
+  std::string dest = root_ + "/copy";
+
+  TreeOperation first(TreeOperation::Kind::kCopy, src, dest);
+  Run(&first, src);
+  ASSERT_EQ(first.error_count(), 0u);
+
+  TreeOperation second(
+      TreeOperation::Kind::kCopy, src, dest, UV_FS_COPYFILE_EXCL);
+  Run(&second, src);
+  EXPECT_EQ(second.error_count(), 7u);
+  ASSERT_EQ(second.errors().size(), 7u);
+  EXPECT_EQ(second.errors()[0].code, UV_EEXIST);
+}
+
+TEST_F(FSTreeTest, CopyTreeIntoItself) {
+  std::string src = MakeTree();
+
+  for (const std::string& dest : { src,
+                                   src + "/",
+                                   src + "/a/copy",
+                                   src + "/a/b/../copy",
+                                   src + "/a/link/copy" }) {
+    TreeOperation copy(TreeOperation::Kind::kCopy, src, dest);
+    EXPECT_EQ(Run(&copy, src), UV_EINVAL) << dest;
+    EXPECT_EQ(copy.entries(), 0u) << dest;
+  }
+  EXPECT_FALSE(Exists(src + "/a/copy"));
+
+  // A sibling that only shares a prefix is fine.
+  TreeOperation copy(TreeOperation::Kind::kCopy, src, src + "-copy");
+  EXPECT_EQ(Run(&copy, src), 0);
+  EXPECT_EQ(copy.error_count(), 0u);
+  EXPECT_TRUE(Exists(src + "-copy/a/b/c/two"));
+}
+
+TEST_F(FSTreeTest, CopyTreeRestoresModesAfterFailures) {
+  std::string src = root_ + "/readonly";
+  std::string dest = root_ + "/copy";
+  ASSERT_EQ(mkdir(src.c_str(), 0755), 0);
+  WriteFile(src + "/file", "contents");
+  // FIFOs are not copied.
+  ASSERT_EQ(mkfifo((src + "/fifo").c_str(), 0644), 0);
+  ASSERT_EQ(chmod(src.c_str(), 0555), 0);
+
+  TreeOperation copy(TreeOperation::Kind::kCopy, src, dest);
+  Run(&copy, src);
+  EXPECT_EQ(copy.error_count(), 1u);
+  EXPECT_TRUE(Exists(dest + "/file"));
+  struct stat s;
+  ASSERT_EQ(stat(dest.c_str(), &s), 0);
+  EXPECT_EQ(s.st_mode & 07777, 0555u);
+
+  ASSERT_EQ(chmod(src.c_str(), 0755), 0);
+  ASSERT_EQ(chmod(dest.c_str(), 0755), 0);
+}
+
+TEST_F(FSTreeTest, RemoveTree) {
+  std::string tree = MakeTree();
+
+  TreeOperation remove(
+      TreeOperation::Kind::kRemove, tree, std::string(), 0, 4);
+  Run(&remove, tree);
+  EXPECT_EQ(remove.error_count(), 0u);
+  EXPECT_EQ(remove.entries(), 11u);
+  EXPECT_FALSE(Exists(tree));
+}
+
+TEST_F(FSTreeTest, RemoveTreeRunAsync) {
+  std::string tree = MakeTree();
+  uv_loop_t loop;
+  ASSERT_EQ(uv_loop_init(&loop), 0);
+
+  // More workers than the threadpool has threads. They must not wait for
+  // each other, or this would never finish.
+  TreeOperation remove(
+      TreeOperation::Kind::kRemove, tree, std::string(), 0, 64);
+  uv_fs_t req;
+  ASSERT_EQ(uv_fs_lstat(nullptr, &req, tree.c_str(), nullptr), 0);
+  remove.Begin(&req.statbuf);
+  uv_fs_req_cleanup(&req);
+
+  req.result = -1;
+  ASSERT_EQ(remove.RunAsync(&loop, &req, [](uv_fs_t* req) {}), 0);
+  ASSERT_EQ(uv_run(&loop, UV_RUN_DEFAULT), 0);
+  EXPECT_EQ(req.result, 0);
+  EXPECT_EQ(remove.error_count(), 0u);
+  EXPECT_EQ(remove.entries(), 11u);
+  EXPECT_FALSE(Exists(tree));
+  ASSERT_EQ(uv_loop_close(&loop), 0);
+}
+
+TEST_F(FSTreeTest, ScanTree) {
+  std::string tree = MakeTree();
+
+  TreeOperation scan(TreeOperation::Kind::kScan, tree);
+  scan.set_max_depth(1);
+  Run(&scan, tree);
+  EXPECT_EQ(scan.error_count(), 0u);
+
+  std::vector<std::string> names;
+  for (const TreeOperation::ScanEntry& entry : scan.scanned()) {
+    names.push_back(entry.name);
+    if (entry.name == "a/one") {
+      EXPECT_TRUE(S_ISREG(entry.stat.st_mode));
+      EXPECT_EQ(entry.stat.st_size, 1u);
+    } else if (entry.name == "a/link") {
+      EXPECT_TRUE(S_ISLNK(entry.stat.st_mode));
+    }
+  }
+  std::sort(names.begin(), names.end());
+  const std::vector<std::string> expected = {
+      "a", "a/b", "a/link", "a/one", "a/two" };
+  EXPECT_EQ(names, expected);
+  EXPECT_EQ(scan.entries(), expected.size());
+}
+
+TEST_F(FSTreeTest, RemoveFile) {
+  std::string file = root_ + "/file";
+  WriteFile(file, "contents");
+
+  TreeOperation remove(TreeOperation::Kind::kRemove, file);
+  Run(&remove, file);
+  EXPECT_EQ(remove.error_count(), 0u);
+  EXPECT_EQ(remove.entries(), 1u);
+  EXPECT_FALSE(Exists(file));
+}
+
+#endif  // _WIN32
@@ -0,0 +1,121 @@
+#include "heap_snapshot_writer.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+
+using node::heap::HeapSnapshotFileWriter;
+
+class HeapSnapshotFileWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpdir[1024];
+    size_t size = sizeof(tmpdir);
+    ASSERT_EQ(uv_os_tmpdir(tmpdir, &size), 0);
+    path_ = std::string(tmpdir) + "/node-heap-snapshot-writer-" +
+            std::to_string(uv_os_getpid());
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    uv_fs_unlink(nullptr, &req, path_.c_str(), nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+
+  uv_file Open(int flags) {
+    uv_fs_t req;
+    int fd = uv_fs_open(nullptr, &req, path_.c_str(), flags, 0644, nullptr);
+    uv_fs_req_cleanup(&req);
+    EXPECT_GE(fd, 0);
+    return fd;
+  }
+
+  std::string ReadFile() {
+    uv_file fd = Open(O_RDONLY);
+    std::string contents;
+    char buf[4096];
+    for (;;) {
+      uv_fs_t req;
+      uv_buf_t iov = uv_buf_init(buf, sizeof(buf));
+      int nread = uv_fs_read(nullptr, &req, fd, &iov, 1, -1, nullptr);
+      uv_fs_req_cleanup(&req);
+      EXPECT_GE(nread, 0);
+      if (nread <= 0) break;
+      contents.append(buf, nread);
+    }
+    uv_fs_t req;
+    uv_fs_close(nullptr, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    return contents;
+  }
+
+  // Writes the chunks "chunk 0" to "chunk 999" and returns what was written.
+  static std::string WriteChunks(HeapSnapshotFileWriter* writer) {
+    std::string expected;
+    for (int i = 0; i < 1000; i++) {
+      std::string chunk = "chunk " + std::to_string(i) + "\n";
+      expected += chunk;
+      EXPECT_EQ(writer->WriteAsciiChunk(&chunk[0], chunk.size()),
+                v8::OutputStream::kContinue);
+    }
+    writer->Close();
+    return expected;
+  }
+
+  std::string path_;
+};
+
+TEST_F(HeapSnapshotFileWriterTest, WritesChunksInOrder) {
+  std::atomic<int> done {0};
+  HeapSnapshotFileWriter writer(
+      Open(O_WRONLY | O_CREAT | O_TRUNC), false, [&]() { done++; });
+  const char* syscall = nullptr;
+  ASSERT_EQ(writer.Start(&syscall), 0);
+  std::string expected = WriteChunks(&writer);
+  EXPECT_EQ(writer.Join(), 0);
+  EXPECT_EQ(done, 1);
+  EXPECT_EQ(ReadFile(), expected);
+}
+
+TEST_F(HeapSnapshotFileWriterTest, Compresses) {
+  HeapSnapshotFileWriter writer(
+      Open(O_WRONLY | O_CREAT | O_TRUNC), true, []() {});
+  const char* syscall = nullptr;
+  ASSERT_EQ(writer.Start(&syscall), 0);
+  std::string expected = WriteChunks(&writer);
+  EXPECT_EQ(writer.Join(), 0);
+
+  std::string compressed = ReadFile();
+  std::string inflated(expected.size() + 1, '\0');
+  z_stream stream = {};
+  ASSERT_EQ(inflateInit2(&stream, 16 + MAX_WBITS), Z_OK);
+  stream.next_in = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_in = compressed.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&inflated[0]);
+  stream.avail_out = inflated.size();
+  EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+  inflated.resize(stream.total_out);
+  inflateEnd(&stream);
+  EXPECT_EQ(inflated, expected);
+}
+
+TEST_F(HeapSnapshotFileWriterTest, ReportsWriteErrors) {
+  uv_fs_t req;
+  uv_fs_close(nullptr, &req, Open(O_WRONLY | O_CREAT | O_TRUNC), nullptr);
+  uv_fs_req_cleanup(&req);
+  std::atomic<int> done {0};
+  // Writing to a read-only descriptor fails with EBADF.
+  HeapSnapshotFileWriter writer(Open(O_RDONLY), false, [&]() { done++; });
+  const char* syscall = nullptr;
+  ASSERT_EQ(writer.Start(&syscall), 0);
+  char chunk[] = "chunk";
+  writer.WriteAsciiChunk(chunk, sizeof(chunk) - 1);
+  writer.Close();
+  EXPECT_EQ(writer.Join(), UV_EBADF);
+  EXPECT_EQ(done, 1);
+  // Further chunks are refused, so that V8 stops serializing.
+  EXPECT_EQ(writer.WriteAsciiChunk(chunk, sizeof(chunk) - 1),
+            v8::OutputStream::kAbort);
+}
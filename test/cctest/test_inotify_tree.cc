@@ -0,0 +1,122 @@
+#include "inotify_tree.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+
+#include <ftw.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <map>
+#include <string>
+
+using node::fs::InotifyTree;
+
+class InotifyTreeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char templ[] = "/tmp/node-inotify-tree-XXXXXX";
+    ASSERT_NE(mkdtemp(templ), nullptr);
+    root_ = templ;
+  }
+
+  void TearDown() override {
+    auto remove_entry = [](const char* path,
+                           const struct stat*,
+                           int,
+                           struct FTW*) { return remove(path); };
+    ASSERT_EQ(nftw(root_.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS), 0);
+  }
+
+  static void WriteFile(const std::string& path, const char* contents) {
+    FILE* f = fopen(path.c_str(), "a");
+    ASSERT_NE(f, nullptr);
+    fputs(contents, f);
+    fclose(f);
+  }
+
+  // Reads until nothing more arrives for a little while, and returns the
+  // events by path.
+  static std::map<std::string, int> Drain(InotifyTree* tree) {
+    struct pollfd fds = { tree->fd(), POLLIN, 0 };
+    while (poll(&fds, 1, 100) == 1)
+      EXPECT_EQ(tree->ReadEvents(), 0);
+    std::map<std::string, int> events;
+    for (const InotifyTree::Event& event : tree->TakeEvents())
+      events[event.path] = event.events;
+    EXPECT_FALSE(tree->has_events());
+    return events;
+  }
+
+  std::string root_;
+};
+
+TEST_F(InotifyTreeTest, WatchesSubdirectories) {
+  ASSERT_EQ(mkdir((root_ + "/a").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((root_ + "/a/b").c_str(), 0755), 0);
+
+  InotifyTree tree(root_);
+  ASSERT_EQ(tree.Start(), 0);
+  EXPECT_EQ(tree.watch_count(), 3u);
+
+  for (int i = 0; i < 10; i++)
+    WriteFile(root_ + "/a/b/file", "x");
+
+  std::map<std::string, int> events = Drain(&tree);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events["a/b/file"], UV_RENAME | UV_CHANGE);
+}
+
+TEST_F(InotifyTreeTest, FollowsNewDirectories) {
+  InotifyTree tree(root_);
+  ASSERT_EQ(tree.Start(), 0);
+  EXPECT_EQ(tree.watch_count(), 1u);
+
+  ASSERT_EQ(mkdir((root_ + "/new").c_str(), 0755), 0);
+  WriteFile(root_ + "/new/early", "x");
+  std::map<std::string, int> events = Drain(&tree);
+  EXPECT_EQ(tree.watch_count(), 2u);
+  EXPECT_EQ(events["new"] & UV_RENAME, UV_RENAME);
+  // Either seen by the new watch or found when the directory was listed.
+  EXPECT_EQ(events["new/early"] & UV_RENAME, UV_RENAME);
+
+  WriteFile(root_ + "/new/late", "x");
+  events = Drain(&tree);
+  EXPECT_EQ(events["new/late"] & UV_RENAME, UV_RENAME);
+
+  ASSERT_EQ(unlink((root_ + "/new/early").c_str()), 0);
+  ASSERT_EQ(unlink((root_ + "/new/late").c_str()), 0);
+  ASSERT_EQ(rmdir((root_ + "/new").c_str()), 0);
+  events = Drain(&tree);
+  EXPECT_EQ(events["new"] & UV_RENAME, UV_RENAME);
+  EXPECT_EQ(tree.watch_count(), 1u);
+}
+
+TEST_F(InotifyTreeTest, DropsDirectoriesMovedAway) {
+  ASSERT_EQ(mkdir((root_ + "/tree").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((root_ + "/tree/a").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((root_ + "/tree/a/b").c_str(), 0755), 0);
+
+  InotifyTree tree(root_ + "/tree");
+  ASSERT_EQ(tree.Start(), 0);
+  EXPECT_EQ(tree.watch_count(), 3u);
+
+  ASSERT_EQ(rename((root_ + "/tree/a").c_str(), (root_ + "/a").c_str()), 0);
+  std::map<std::string, int> events = Drain(&tree);
+  EXPECT_EQ(events["a"], UV_RENAME);
+  EXPECT_EQ(tree.watch_count(), 1u);
+
+  WriteFile(root_ + "/a/b/file", "x");
+  EXPECT_TRUE(Drain(&tree).empty());
+}
+
+TEST_F(InotifyTreeTest, NotADirectory) {
+  WriteFile(root_ + "/file", "x");
+  InotifyTree tree(root_ + "/file");
+  EXPECT_EQ(tree.Start(), UV_ENOTDIR);
+}
+
+#endif  // __linux__
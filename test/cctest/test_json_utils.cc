@@ -24,3 +24,40 @@ TEST(JSONUtilsTest, EscapeJsonChars) {
     EXPECT_EQ("a" + expected[i], EscapeJsonChars("a" + input));
   }
 }
+
+TEST(JSONUtilsTest, ExtractJSONFields) {
+  using node::ExtractJSONFields;
+  const std::vector<std::string_view> keys = {"main", "exports", "type"};
+  std::vector<std::string_view> values;
+
+  EXPECT_TRUE(ExtractJSONFields(
+      "{\"name\": \"pkg\", \"main\": \"./index.js\",\n"
+      " \"dependencies\": {\"main\": \"1.0.0\", \"x\": [1, {\"}\": \"]\"}]},\n"
+      " \"exports\" : { \".\": \"./lib/\\\"quoted\\\".js\" } }",
+      keys,
+      &values));
+  ASSERT_EQ(3u, values.size());
+  EXPECT_EQ("\"./index.js\"", values[0]);
+  EXPECT_EQ("{ \".\": \"./lib/\\\"quoted\\\".js\" }", values[1]);
+  EXPECT_EQ(nullptr, values[2].data());
+
+  // The last occurrence of a key wins.
+  EXPECT_TRUE(ExtractJSONFields(
+      "{\"type\":\"commonjs\",\"type\":\"module\",\"main\":false}",
+      keys,
+      &values));
+  EXPECT_EQ("false", values[0]);
+  EXPECT_EQ(nullptr, values[1].data());
+  EXPECT_EQ("\"module\"", values[2]);
+
+  EXPECT_TRUE(ExtractJSONFields(" {} ", keys, &values));
+  EXPECT_EQ(nullptr, values[0].data());
+
+  EXPECT_FALSE(ExtractJSONFields("", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("[]", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("{\"main\": }", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("{\"main\": \"x}", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("{\"main\": {\"a\": 1}", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("{\"main\": 1} x", keys, &values));
+  EXPECT_FALSE(ExtractJSONFields("{\"m\\u0061in\": 1}", keys, &values));
+}
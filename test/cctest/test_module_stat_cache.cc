@@ -0,0 +1,234 @@
+#include "env-inl.h"
+#include "fs_tree.h"
+#include "gtest/gtest.h"
+#include "memory_tracker-inl.h"
+#include "module_stat_cache.h"
+#include "node_test_fixture.h"
+
+#ifndef _WIN32
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using node::fs::ModuleStatCache;
+using node::fs::TreeOperation;
+
+class ModuleStatCacheTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    uv_fs_t req;
+    std::string templ = "/tmp/node-module-stat-cache-XXXXXX";
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, templ.c_str(), nullptr), 0);
+    dir_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    ASSERT_EQ(uv_fs_lstat(nullptr, &req, dir_.c_str(), nullptr), 0);
+    TreeOperation remove(TreeOperation::Kind::kRemove, dir_);
+    remove.Begin(&req.statbuf);
+    uv_fs_req_cleanup(&req);
+    remove.Work();
+    EnvironmentTestFixture::TearDown();
+  }
+
+  static void WriteFile(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    ASSERT_NE(f, nullptr);
+    fclose(f);
+  }
+
+  static void MakeDirectory(const std::string& path) {
+    uv_fs_t req;
+    ASSERT_EQ(uv_fs_mkdir(nullptr, &req, path.c_str(), 0755, nullptr), 0);
+    uv_fs_req_cleanup(&req);
+  }
+
+  // Runs the event loop until `path` is no longer cached, or a second has
+  // passed. The watchers do not keep the loop alive, so a timer does.
+  static bool WaitForInvalidation(const ModuleStatCache& cache,
+                                  const std::string& path) {
+    uv_timer_t timer;
+    bool timed_out = false;
+    uv_timer_init(&current_loop, &timer);
+    timer.data = &timed_out;
+    uv_timer_start(&timer, [](uv_timer_t* timer) {
+      *static_cast<bool*>(timer->data) = true;
+    }, 1000, 0);
+    while (cache.LookupStat(path) != nullptr && !timed_out)
+      uv_run(&current_loop, UV_RUN_ONCE);
+    uv_close(reinterpret_cast<uv_handle_t*>(&timer), nullptr);
+    uv_run(&current_loop, UV_RUN_NOWAIT);
+    return cache.LookupStat(path) == nullptr;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(ModuleStatCacheTest, Hit) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  ModuleStatCache cache(*env);
+
+  const std::string file = dir_ + "/index.js";
+  WriteFile(file);
+  EXPECT_EQ(cache.LookupStat(file), nullptr);
+  cache.InsertStat(file, 0);
+  cache.InsertStat(dir_, 1);
+  ASSERT_NE(cache.LookupStat(file), nullptr);
+  EXPECT_EQ(*cache.LookupStat(file), 0);
+  ASSERT_NE(cache.LookupStat(dir_), nullptr);
+  EXPECT_EQ(*cache.LookupStat(dir_), 1);
+
+  // Both kinds of entries are kept for the same path.
+  const std::string package_json = dir_ + "/package.json";
+  cache.InsertStat(package_json, UV_ENOENT);
+  EXPECT_EQ(cache.LookupPackageJSON(package_json), nullptr);
+  cache.InsertPackageJSON(package_json, node::fs::PackageJSONEntry());
+  ASSERT_NE(cache.LookupPackageJSON(package_json), nullptr);
+  EXPECT_FALSE(cache.LookupPackageJSON(package_json)->found);
+  ASSERT_NE(cache.LookupStat(package_json), nullptr);
+  EXPECT_EQ(*cache.LookupStat(package_json), UV_ENOENT);
+
+  cache.Clear();
+  EXPECT_EQ(cache.LookupStat(file), nullptr);
+  EXPECT_EQ(cache.watcher_count(), 0u);
+}
+
+TEST_F(ModuleStatCacheTest, InvalidatedByCreateAndDelete) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  ModuleStatCache cache(*env);
+
+  // A file created next to a cached path drops everything cached for the
+  // directory.
+  const std::string file = dir_ + "/a.js";
+  const std::string other = dir_ + "/b.js";
+  cache.InsertStat(file, UV_ENOENT);
+  cache.InsertStat(other, UV_ENOENT);
+  EXPECT_EQ(cache.watcher_count(), 1u);
+  WriteFile(file);
+  EXPECT_TRUE(WaitForInvalidation(cache, file));
+  EXPECT_EQ(cache.LookupStat(other), nullptr);
+  EXPECT_EQ(cache.watcher_count(), 0u);
+
+  // So does deleting one.
+  cache.InsertStat(file, 0);
+  EXPECT_EQ(cache.watcher_count(), 1u);
+  uv_fs_t req;
+  ASSERT_EQ(uv_fs_unlink(nullptr, &req, file.c_str(), nullptr), 0);
+  uv_fs_req_cleanup(&req);
+  EXPECT_TRUE(WaitForInvalidation(cache, file));
+}
+
+// Paths in directories that do not exist are cached against the nearest
+// existing ancestor, which sees the directories being created.
+TEST_F(ModuleStatCacheTest, NegativeEntriesInMissingDirectories) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  ModuleStatCache cache(*env);
+
+  const std::string file = dir_ + "/node_modules/pkg/index.js";
+  cache.InsertStat(file, UV_ENOENT);
+  ASSERT_NE(cache.LookupStat(file), nullptr);
+  EXPECT_EQ(*cache.LookupStat(file), UV_ENOENT);
+  EXPECT_EQ(cache.watcher_count(), 1u);
+
+  MakeDirectory(dir_ + "/node_modules");
+  EXPECT_TRUE(WaitForInvalidation(cache, file));
+
+  // Now one level further down.
+  cache.InsertStat(file, UV_ENOENT);
+  ASSERT_NE(cache.LookupStat(file), nullptr);
+  MakeDirectory(dir_ + "/node_modules/pkg");
+  EXPECT_TRUE(WaitForInvalidation(cache, file));
+
+  // And in the directory itself.
+  cache.InsertStat(file, UV_ENOENT);
+  ASSERT_NE(cache.LookupStat(file), nullptr);
+  WriteFile(file);
+  EXPECT_TRUE(WaitForInvalidation(cache, file));
+}
+
+TEST_F(ModuleStatCacheTest, WatcherLimit) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  ModuleStatCache cache(*env);
+
+  auto path_in = [&](size_t i) {
+    return dir_ + "/" + std::to_string(i) + "/index.js";
+  };
+  for (size_t i = 0; i <= ModuleStatCache::kMaxWatchers; i++)
+    MakeDirectory(dir_ + "/" + std::to_string(i));
+  for (size_t i = 0; i < ModuleStatCache::kMaxWatchers; i++) {
+    cache.InsertStat(path_in(i), UV_ENOENT);
+    ASSERT_NE(cache.LookupStat(path_in(i)), nullptr) << i;
+  }
+  EXPECT_EQ(cache.watcher_count(), ModuleStatCache::kMaxWatchers);
+
+  // Paths in directories that are not watched yet are no longer cached,
+  // while those in watched ones still are.
+  const std::string last = path_in(ModuleStatCache::kMaxWatchers);
+  cache.InsertStat(last, UV_ENOENT);
+  EXPECT_EQ(cache.LookupStat(last), nullptr);
+  const std::string sibling = dir_ + "/0/package.json";
+  cache.InsertStat(sibling, UV_ENOENT);
+  EXPECT_NE(cache.LookupStat(sibling), nullptr);
+  EXPECT_EQ(cache.watcher_count(), ModuleStatCache::kMaxWatchers);
+
+  // A watcher that stops makes room for another one.
+  WriteFile(path_in(0));
+  EXPECT_TRUE(WaitForInvalidation(cache, path_in(0)));
+  EXPECT_EQ(cache.watcher_count(), ModuleStatCache::kMaxWatchers - 1);
+  cache.InsertStat(last, UV_ENOENT);
+  EXPECT_NE(cache.LookupStat(last), nullptr);
+  EXPECT_EQ(cache.watcher_count(), ModuleStatCache::kMaxWatchers);
+}
+
+// internalModuleStatBatch() goes through the cache, so it keeps returning
+// what it cached until flushModuleStatCache() or the next turn of the loop.
+TEST_F(ModuleStatCacheTest, StatBatchAndFlush) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+  (*env)->options()->experimental_module_stat_cache = true;
+
+  const std::string script = R"(
+'use strict';
+const fs = require('fs');
+const { internalBinding } = require('internal/test/binding');
+const { internalModuleStatBatch, flushModuleStatCache } =
+    internalBinding('fs');
+
+const dir = )" + std::string("'") + dir_ + R"(';
+fs.writeFileSync(`${dir}/a.js`, '');
+const paths = [`${dir}/a.js`, dir, `${dir}/b.js`];
+const before = internalModuleStatBatch(paths);
+fs.writeFileSync(`${dir}/b.js`, '');
+const cached = internalModuleStatBatch(paths);
+flushModuleStatCache();
+const after = internalModuleStatBatch(paths);
+globalThis.result = `${before}|${cached}|${after}`;
+)";
+  node::LoadEnvironment(*env, script.c_str()).ToLocalChecked();
+
+  v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+  v8::Local<v8::Value> result =
+      context->Global()
+          ->Get(context,
+                v8::String::NewFromUtf8(isolate_, "result").ToLocalChecked())
+          .ToLocalChecked();
+  v8::String::Utf8Value value(isolate_, result);
+  const std::string enoent = std::to_string(UV_ENOENT);
+  EXPECT_EQ(std::string(*value),
+            "0,1," + enoent + "|0,1," + enoent + "|0,1,0");
+}
+
+#endif  // _WIN32
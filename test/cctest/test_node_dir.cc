@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+#include "uv.h"
+
+#include <string>
+
+class DirHandleTest : public EnvironmentTestFixture {
+ protected:
+  std::string GetResult(const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name("result")).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return "";
+    v8::String::Utf8Value value(
+        isolate_,
+        result.As<v8::Object>()->Get(context, name(field)).ToLocalChecked());
+    return *value == nullptr ? "" : *value;
+  }
+};
+
+// Lists a directory of 42 entries, one of them with a non-ASCII name, with
+// readPacked() batches that start at one entry, then checks that read(),
+// overlapping readPacked() calls and close() during a readPacked() are
+// refused.
+static const char kReadPackedScript[] = R"(
+'use strict';
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { internalBinding } = require('internal/test/binding');
+const { opendir } = internalBinding('fs_dir');
+const { FSReqCallback } = internalBinding('fs');
+
+const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'node-dir-'));
+const expected = ['ü', 'sub'];
+fs.mkdirSync(path.join(dir, 'sub'));
+fs.writeFileSync(path.join(dir, 'ü'), '');
+for (let i = 0; i < 40; i++) {
+  expected.push(`file${i}`);
+  fs.writeFileSync(path.join(dir, `file${i}`), '');
+}
+
+const check = (ctx) => {
+  if (ctx.errno !== undefined) throw new Error(`${ctx.syscall}: ${ctx.errno}`);
+};
+const ctx = {};
+const handle = opendir(dir, 'utf8', undefined, ctx);
+check(ctx);
+
+const result = { batches: [], names: [], bufferBatches: 0 };
+for (;;) {
+  const batch = handle.readPacked('utf8', 1, undefined, ctx);
+  check(ctx);
+  if (batch === null) break;
+  const [names, offsets, types] = batch;
+  if (typeof names !== 'string') result.bufferBatches++;
+  result.batches.push(types.length);
+  for (let i = 0; i < types.length; i++) {
+    result.names.push(typeof names === 'string' ?
+      names.slice(offsets[i], offsets[i + 1]) :
+      names.toString('utf8', offsets[i], offsets[i + 1]));
+  }
+}
+result.names.sort();
+result.expected = expected.sort();
+result.afterEnd = `${handle.readPacked('utf8', 1, undefined, ctx)}`;
+
+const readCtx = {};
+handle.read('utf8', 32, undefined, readCtx);
+result.read = `${readCtx.syscall}:${readCtx.errno}`;
+
+const errors = [];
+const first = new FSReqCallback();
+const closeErrors = [];
+first.oncomplete = (err) => {
+  errors.push(err ? err.errno : 0);
+  result.overlapping = errors.join(',');
+  result.closeWhileReading = closeErrors.join(',');
+  handle.close(undefined, ctx);
+  check(ctx);
+  fs.rmSync(dir, { recursive: true });
+  globalThis.result = result;
+};
+handle.readPacked('utf8', 1, first);
+const second = new FSReqCallback();
+second.oncomplete = (err) => errors.push(err.errno);
+handle.readPacked('utf8', 1, second);
+
+const closeCtx = {};
+handle.close(undefined, closeCtx);
+closeErrors.push(`${closeCtx.syscall}:${closeCtx.errno}`);
+const close = new FSReqCallback();
+close.oncomplete = (err) => closeErrors.push(`${err.syscall}:${err.errno}`);
+handle.close(close);
+)";
+
+TEST_F(DirHandleTest, ReadPacked) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kReadPackedScript).ToLocalChecked();
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  // Every entry but . and .. is returned once.
+  EXPECT_EQ(GetResult("names"), GetResult("expected"));
+  // Batches double until the directory runs out, and then stay empty.
+  EXPECT_EQ(GetResult("batches"), "1,2,4,8,16,11");
+  EXPECT_EQ(GetResult("afterEnd"), "null");
+  // Byte offsets don't match character offsets for the batch with the
+  // non-ASCII name, so its names come back as a Buffer.
+  EXPECT_EQ(GetResult("bufferBatches"), "1");
+
+  // read() would miss the entries that readPacked() has read ahead.
+  EXPECT_EQ(GetResult("read"), "readdir:" + std::to_string(UV_EINVAL));
+  // The second call is refused while the first is in progress.
+  EXPECT_EQ(GetResult("overlapping"), std::to_string(UV_EBUSY) + ",0");
+  // So is close(), which would free the directory under the reading thread.
+  const std::string busy = "closedir:" + std::to_string(UV_EBUSY);
+  EXPECT_EQ(GetResult("closeWhileReading"), busy + "," + busy);
+}
@@ -0,0 +1,210 @@
+#include "node_internals.h"
+#include "node_options.h"
+#include "node_page_allocator.h"
+
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+using v8::PageAllocator;
+
+static constexpr size_t kMB = 1024 * 1024;
+
+// Whether the kernel supports transparent huge pages at all. If it does
+// not, the huge page advice is refused, and everything has to work without.
+static bool HasTransparentHugePages() {
+  return access("/sys/kernel/mm/transparent_hugepage/enabled", F_OK) == 0;
+}
+
+// Returns whether the mapping that contains `address` is advised to use
+// transparent huge pages, according to /proc/self/smaps.
+static bool HasHugePageAdvice(const void* address) {
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(address);
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool in_mapping = false;
+  while (std::getline(smaps, line)) {
+    uintptr_t start;
+    uintptr_t end;
+    if (sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2) {
+      in_mapping = start <= addr && addr < end;
+    } else if (in_mapping && line.compare(0, 8, "VmFlags:") == 0) {
+      return (line + " ").find(" hg ") != std::string::npos;
+    }
+  }
+  ADD_FAILURE() << "no mapping contains " << address;
+  return false;
+}
+
+static bool IsMapped(void* address, size_t page_size) {
+  unsigned char resident;
+  if (mincore(address, page_size, &resident) == 0) return true;
+  EXPECT_EQ(errno, ENOMEM);
+  return false;
+}
+
+static bool IsZeroFilled(const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    if (bytes[i] != 0) return false;
+  }
+  return true;
+}
+
+class PageAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    thp_ = HasTransparentHugePages();
+  }
+
+  size_t page_size_;
+  bool thp_;
+};
+
+TEST_F(PageAllocatorTest, MapAnonymousMemory) {
+  for (bool huge_pages : { false, true }) {
+    const size_t size = 4 * kMB;
+    void* data = node::MapAnonymousMemory(size, huge_pages);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % page_size_, 0u);
+    EXPECT_TRUE(IsZeroFilled(data, size));
+    memset(data, 0xab, size);
+    EXPECT_EQ(HasHugePageAdvice(data), huge_pages && thp_);
+    node::UnmapAnonymousMemory(data, size);
+    EXPECT_FALSE(IsMapped(data, page_size_));
+  }
+}
+
+// With --heap-huge-pages, large ArrayBuffers get mappings of their own.
+TEST_F(PageAllocatorTest, ArrayBufferAllocator) {
+  const bool heap_huge_pages = node::per_process::cli_options->heap_huge_pages;
+  node::per_process::cli_options->heap_huge_pages = true;
+  node::NodeArrayBufferAllocator allocator;
+  node::per_process::cli_options->heap_huge_pages = heap_huge_pages;
+
+  const size_t size = 4 * kMB + 1;
+  void* data = allocator.Allocate(size);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % page_size_, 0u);
+  EXPECT_TRUE(IsZeroFilled(data, size));
+  EXPECT_EQ(HasHugePageAdvice(data), thp_);
+
+  // Growing and shrinking keeps the contents.
+  memset(data, 0xab, size);
+  data = allocator.Reallocate(data, size, 8 * kMB);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(static_cast<unsigned char*>(data)[size - 1], 0xab);
+  data = allocator.Reallocate(data, 8 * kMB, 64 * 1024);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(static_cast<unsigned char*>(data)[64 * 1024 - 1], 0xab);
+  EXPECT_EQ(allocator.total_mem_usage(), 64u * 1024);
+
+  allocator.Free(data, 64 * 1024);
+  EXPECT_EQ(allocator.total_mem_usage(), 0u);
+}
+
+TEST_F(PageAllocatorTest, HugePageAllocator) {
+  PageAllocator* allocator = node::GetHugePageAllocator();
+  ASSERT_NE(allocator, nullptr);
+  EXPECT_EQ(node::GetHugePageAllocator(), allocator);
+  EXPECT_EQ(allocator->AllocatePageSize(), page_size_);
+  EXPECT_EQ(allocator->CommitPageSize(), page_size_);
+
+  // Reservations are aligned as requested, with or without a hint.
+  const size_t alignments[] = { page_size_, 256 * 1024, 2 * kMB, 32 * kMB };
+  for (size_t alignment : alignments) {
+    for (void* hint : { static_cast<void*>(nullptr),
+                        allocator->GetRandomMmapAddr() }) {
+      void* data = allocator->AllocatePages(
+          hint, 4 * kMB, alignment, PageAllocator::kNoAccess);
+      ASSERT_NE(data, nullptr) << alignment;
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % alignment, 0u);
+      EXPECT_TRUE(allocator->FreePages(data, 4 * kMB));
+      EXPECT_FALSE(IsMapped(data, page_size_));
+    }
+  }
+}
+
+TEST_F(PageAllocatorTest, HugePageAdvice) {
+  PageAllocator* allocator = node::GetHugePageAllocator();
+  ASSERT_NE(allocator, nullptr);
+
+  // Data reservations of at least a huge page get the advice, if the
+  // kernel supports it. Small ones and code do not.
+  char* data = static_cast<char*>(allocator->AllocatePages(
+      nullptr, 8 * kMB, 2 * kMB, PageAllocator::kNoAccess));
+  char* small = static_cast<char*>(allocator->AllocatePages(
+      nullptr, kMB, page_size_, PageAllocator::kReadWrite));
+  char* jit = static_cast<char*>(allocator->AllocatePages(
+      nullptr, 8 * kMB, 2 * kMB, PageAllocator::kNoAccessWillJitLater));
+  char* code = static_cast<char*>(allocator->AllocatePages(
+      nullptr, 4 * kMB, page_size_, PageAllocator::kReadExecute));
+  ASSERT_NE(data, nullptr);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(jit, nullptr);
+  ASSERT_NE(code, nullptr);
+  EXPECT_EQ(HasHugePageAdvice(data), thp_);
+  EXPECT_FALSE(HasHugePageAdvice(small));
+  EXPECT_FALSE(HasHugePageAdvice(jit));
+  EXPECT_FALSE(HasHugePageAdvice(code));
+
+  // Committed pages are zero-filled, and are again after being
+  // decommitted. Decommitting keeps the advice for data only.
+  char* page = data + 3 * kMB;
+  ASSERT_TRUE(allocator->SetPermissions(
+      page, 256 * 1024, PageAllocator::kReadWrite));
+  EXPECT_TRUE(IsZeroFilled(page, 256 * 1024));
+  memset(page, 0xab, 256 * 1024);
+  ASSERT_TRUE(allocator->DecommitPages(page, 256 * 1024));
+  EXPECT_EQ(HasHugePageAdvice(page), thp_);
+  ASSERT_TRUE(allocator->SetPermissions(
+      page, 256 * 1024, PageAllocator::kReadWrite));
+  EXPECT_TRUE(IsZeroFilled(page, 256 * 1024));
+  EXPECT_TRUE(allocator->DiscardSystemPages(page, 256 * 1024));
+
+  ASSERT_TRUE(allocator->SetPermissions(
+      jit, 256 * 1024, PageAllocator::kReadWrite));
+  ASSERT_TRUE(allocator->DecommitPages(jit, 256 * 1024));
+  EXPECT_FALSE(HasHugePageAdvice(jit));
+
+  // Releasing the tail of a reservation unmaps it, and the rest keeps the
+  // advice.
+  ASSERT_TRUE(allocator->ReleasePages(data, 8 * kMB, 4 * kMB));
+  EXPECT_FALSE(IsMapped(data + 4 * kMB, page_size_));
+  EXPECT_TRUE(IsMapped(data, page_size_));
+  ASSERT_TRUE(allocator->DecommitPages(data, 256 * 1024));
+  EXPECT_EQ(HasHugePageAdvice(data), thp_);
+
+  EXPECT_TRUE(allocator->FreePages(data, 4 * kMB));
+  EXPECT_TRUE(allocator->FreePages(small, kMB));
+  EXPECT_TRUE(allocator->FreePages(jit, 8 * kMB));
+  EXPECT_TRUE(allocator->FreePages(code, 4 * kMB));
+  EXPECT_FALSE(IsMapped(data, page_size_));
+}
+
+#else  // !__linux__
+
+TEST(PageAllocatorTest, MapAnonymousMemory) {
+  const size_t size = 4 * 1024 * 1024;
+  void* data = node::MapAnonymousMemory(size, true);
+  ASSERT_NE(data, nullptr);
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t i = 0; i < size; i++) ASSERT_EQ(bytes[i], 0);
+  node::UnmapAnonymousMemory(data, size);
+}
+
+TEST(PageAllocatorTest, HugePageAllocator) {
+  EXPECT_EQ(node::GetHugePageAllocator(), nullptr);
+}
+
+#endif  // __linux__
@@ -3,17 +3,44 @@
 #include "gtest/gtest.h"
 #include "node_test_fixture.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 
 using node::native_module::NativeModuleLoader;
 using node::native_module::NativeModuleRecordMap;
+using v8::ScriptCompiler;
 
-class PerProcessTest : public ::testing::Test {
+class PerProcessTest : public NodeTestFixture {
  protected:
   static const NativeModuleRecordMap get_sources_for_test() {
     return NativeModuleLoader::instance_.source_;
   }
+
+  // Compiles the builtin `id` and returns whether the code cache was used.
+  static bool CompileWithCache(v8::Local<v8::Context> context,
+                               const char* id) {
+    NativeModuleLoader::Result result;
+    EXPECT_FALSE(NativeModuleLoader::instance_
+                     .CompileAsModule(context, id, &result)
+                     .IsEmpty());
+    return result == NativeModuleLoader::Result::kWithCache;
+  }
+
+  static const ScriptCompiler::CachedData* GetCodeCache(const char* id) {
+    return NativeModuleLoader::instance_.GetCodeCache(id);
+  }
+
+  static void SetCodeCache(const char* id,
+                           ScriptCompiler::CachedData* cached_data) {
+    NativeModuleLoader& loader = NativeModuleLoader::instance_;
+    node::Mutex::ScopedLock lock(loader.code_cache_mutex_);
+    if (cached_data == nullptr)
+      loader.code_cache_.erase(id);
+    else
+      loader.code_cache_[id].reset(cached_data);
+  }
 };
 
 namespace {
@@ -31,4 +58,59 @@ TEST_F(PerProcessTest, EmbeddedSources) {
       << "NativeModuleLoader::source_ should have some 16bit items";
 }
 
+// A code cache that V8 accepts is kept for the next compilation as-is.
+TEST_F(PerProcessTest, AcceptedCodeCacheIsKept) {
+  const v8::HandleScope handle_scope(isolate_);
+  v8::Local<v8::Context> context = v8::Context::New(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  SetCodeCache("path", nullptr);
+  EXPECT_FALSE(CompileWithCache(context, "path"));
+  const ScriptCompiler::CachedData* generated = GetCodeCache("path");
+  ASSERT_NE(generated, nullptr);
+  const uint8_t* data = generated->data;
+
+  EXPECT_TRUE(CompileWithCache(context, "path"));
+  EXPECT_EQ(GetCodeCache("path"), generated);
+  EXPECT_EQ(GetCodeCache("path")->data, data);
+}
+
+// An entry that does not own its buffer, like the embedded code cache, is
+// used from where it is without being copied, and only replaced when V8
+// rejects it.
+TEST_F(PerProcessTest, UnownedCodeCacheIsNotCopied) {
+  const v8::HandleScope handle_scope(isolate_);
+  v8::Local<v8::Context> context = v8::Context::New(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  SetCodeCache("path", nullptr);
+  CompileWithCache(context, "path");
+  ASSERT_NE(GetCodeCache("path"), nullptr);
+  const std::vector<uint8_t> embedded(
+      GetCodeCache("path")->data,
+      GetCodeCache("path")->data + GetCodeCache("path")->length);
+
+  SetCodeCache("path", new ScriptCompiler::CachedData(
+      embedded.data(), embedded.size(),
+      ScriptCompiler::CachedData::BufferNotOwned));
+  EXPECT_TRUE(CompileWithCache(context, "path"));
+  ASSERT_NE(GetCodeCache("path"), nullptr);
+  EXPECT_EQ(GetCodeCache("path")->data, embedded.data());
+  EXPECT_EQ(GetCodeCache("path")->buffer_policy,
+            ScriptCompiler::CachedData::BufferNotOwned);
+
+  const std::vector<uint8_t> garbage(embedded.size(), 0);
+  SetCodeCache("path", new ScriptCompiler::CachedData(
+      garbage.data(), garbage.size(),
+      ScriptCompiler::CachedData::BufferNotOwned));
+  EXPECT_FALSE(CompileWithCache(context, "path"));
+  ASSERT_NE(GetCodeCache("path"), nullptr);
+  EXPECT_NE(GetCodeCache("path")->data, garbage.data());
+  EXPECT_EQ(GetCodeCache("path")->buffer_policy,
+            ScriptCompiler::CachedData::BufferOwned);
+
+  // Do not leave entries that point into the buffers above behind.
+  SetCodeCache("path", nullptr);
+}
+
 }  // end namespace
@@ -0,0 +1,85 @@
+#include "pprof_utils.h"
+
+#include "gtest/gtest.h"
+#include "zlib.h"
+
+using node::pprof::GzipCompress;
+using node::pprof::ProfileBuilder;
+
+TEST(PprofUtilsTest, EmptyProfile) {
+  ProfileBuilder builder;
+  // Only the mandatory empty string table entry is emitted.
+  EXPECT_EQ(std::string("\x32\x00", 2), builder.Serialize());
+}
+
+TEST(PprofUtilsTest, InternString) {
+  ProfileBuilder builder;
+  EXPECT_EQ(0, builder.InternString(""));
+  EXPECT_EQ(1, builder.InternString("foo"));
+  EXPECT_EQ(2, builder.InternString("bar"));
+  EXPECT_EQ(1, builder.InternString("foo"));
+}
+
+TEST(PprofUtilsTest, DeduplicatesFunctionsAndLocations) {
+  ProfileBuilder builder;
+  uint64_t foo = builder.AddFunction("foo", "/a.js", 1);
+  uint64_t bar = builder.AddFunction("bar", "/a.js", 10);
+  EXPECT_EQ(1u, foo);
+  EXPECT_EQ(2u, bar);
+  EXPECT_EQ(foo, builder.AddFunction("foo", "/a.js", 1));
+  EXPECT_NE(foo, builder.AddFunction("foo", "/b.js", 1));
+
+  uint64_t loc = builder.AddLocation(foo, 3);
+  EXPECT_EQ(1u, loc);
+  EXPECT_EQ(loc, builder.AddLocation(foo, 3));
+  EXPECT_EQ(2u, builder.AddLocation(foo, 4));
+  EXPECT_EQ(3u, builder.AddLocation(bar, 3));
+}
+
+TEST(PprofUtilsTest, Serialize) {
+  ProfileBuilder builder;
+  builder.AddSampleType("samples", "count");
+  uint64_t function = builder.AddFunction("f", "", 0);
+  uint64_t location = builder.AddLocation(function, 300);
+  builder.AddSample({location}, {5});
+  builder.set_period(1000);
+
+  const char expected[] =
+      // sample_type { type: 1 unit: 2 }
+      "\x0a\x04\x08\x01\x10\x02"
+      // sample { location_id: [1] value: [5] }
+      "\x12\x06\x0a\x01\x01\x12\x01\x05"
+      // location { id: 1 line { function_id: 1 line: 300 } }
+      "\x22\x09\x08\x01\x22\x05\x08\x01\x10\xac\x02"
+      // function { id: 1 name: 3 system_name: 3 }
+      "\x2a\x06\x08\x01\x10\x03\x18\x03"
+      // string_table: "", "samples", "count", "f"
+      "\x32\x00"
+      "\x32\x07samples"
+      "\x32\x05" "count"
+      "\x32\x01" "f"
+      // period: 1000
+      "\x60\xe8\x07";
+  EXPECT_EQ(std::string(expected, sizeof(expected) - 1), builder.Serialize());
+}
+
+TEST(PprofUtilsTest, GzipCompress) {
+  std::string input(4096, 'x');
+  std::string compressed;
+  ASSERT_TRUE(GzipCompress(input, &compressed));
+  ASSERT_GT(compressed.size(), 2u);
+  EXPECT_LT(compressed.size(), input.size());
+  EXPECT_EQ('\x1f', compressed[0]);
+  EXPECT_EQ('\x8b', compressed[1]);
+
+  z_stream stream = {};
+  ASSERT_EQ(Z_OK, inflateInit2(&stream, 16 + MAX_WBITS));
+  std::string output(input.size(), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_in = compressed.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = output.size();
+  EXPECT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+  inflateEnd(&stream);
+  EXPECT_EQ(input, output);
+}
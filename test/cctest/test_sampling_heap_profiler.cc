@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+#include "v8-profiler.h"
+
+#include <memory>
+#include <string>
+
+class SamplingHeapProfilerTest : public EnvironmentTestFixture {
+ protected:
+  std::string GetResult(const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name("result")).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return "";
+    v8::String::Utf8Value value(
+        isolate_,
+        result.As<v8::Object>()->Get(context, name(field)).ToLocalChecked());
+    return *value == nullptr ? "" : *value;
+  }
+};
+
+static const char kStartStopScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const {
+  startSamplingHeapProfiler,
+  stopSamplingHeapProfiler,
+  getAllocationSites,
+} = internalBinding('heap_utils');
+
+const result = {};
+result.rejected = [0, -1, 1.5, NaN, Infinity, 2 ** 53].map((interval) => {
+  try {
+    startSamplingHeapProfiler(interval, 16);
+    return 'started';
+  } catch (err) {
+    return err.code;
+  }
+}).join(',');
+
+result.start = startSamplingHeapProfiler(1024, 16);
+result.startAgain = startSamplingHeapProfiler(1024, 16);
+globalThis.retained = Array.from({ length: 1e4 }, (_, i) => ({ i }));
+result.hasSites = getAllocationSites(10).length > 0;
+result.stop = stopSamplingHeapProfiler();
+result.stopAgain = stopSamplingHeapProfiler();
+result.sitesAfterStop = `${getAllocationSites(10)}`;
+globalThis.result = result;
+)";
+
+TEST_F(SamplingHeapProfilerTest, StartStop) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kStartStopScript).ToLocalChecked();
+
+  const std::string out_of_range = "ERR_OUT_OF_RANGE";
+  EXPECT_EQ(GetResult("rejected"),
+            out_of_range + "," + out_of_range + "," + out_of_range + "," +
+            out_of_range + "," + out_of_range + "," + out_of_range);
+  EXPECT_EQ(GetResult("start"), "true");
+  EXPECT_EQ(GetResult("startAgain"), "false");
+  EXPECT_EQ(GetResult("hasSites"), "true");
+  EXPECT_EQ(GetResult("stop"), "true");
+  EXPECT_EQ(GetResult("stopAgain"), "false");
+  EXPECT_EQ(GetResult("sitesAfterStop"), "undefined");
+}
+
+static const char kForeignSessionScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const {
+  startSamplingHeapProfiler,
+  stopSamplingHeapProfiler,
+} = internalBinding('heap_utils');
+
+globalThis.result = {
+  start: startSamplingHeapProfiler(1024, 16),
+  stop: stopSamplingHeapProfiler(),
+};
+)";
+
+// A session that was started elsewhere, as --heap-prof does, is left alone.
+TEST_F(SamplingHeapProfilerTest, LeavesForeignSessionRunning) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  v8::HeapProfiler* profiler = isolate_->GetHeapProfiler();
+  ASSERT_TRUE(profiler->StartSamplingHeapProfiler(1024, 16));
+
+  node::LoadEnvironment(*env, kForeignSessionScript).ToLocalChecked();
+
+  EXPECT_EQ(GetResult("start"), "false");
+  EXPECT_EQ(GetResult("stop"), "false");
+  std::unique_ptr<v8::AllocationProfile> profile(
+      profiler->GetAllocationProfile());
+  EXPECT_NE(profile, nullptr);
+  profiler->StopSamplingHeapProfiler();
+}
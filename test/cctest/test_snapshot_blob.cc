@@ -0,0 +1,114 @@
+#include "env.h"
+#include "node_version.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <string>
+
+using node::PropInfo;
+using node::SnapshotData;
+
+class SnapshotBlobTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    blob_ = "not really a V8 snapshot";
+    data_.blob.data = blob_.data();
+    data_.blob.raw_size = static_cast<int>(blob_.size());
+    data_.isolate_data_indices = { 1, 2, 3 };
+    data_.env_info.bindings.push_back(PropInfo { "fs", 4, 5 });
+    data_.env_info.native_modules = { "fs", "http" };
+    data_.env_info.persistent_values.push_back(PropInfo { "url", 6, 7 });
+    data_.env_info.context = 8;
+  }
+
+  // Writes `data_` to a blob and returns its contents.
+  std::string Write() {
+    FILE* file = tmpfile();
+    EXPECT_NE(file, nullptr);
+    if (file == nullptr) return "";
+    EXPECT_TRUE(data_.ToBlob(file));
+    std::string contents(static_cast<size_t>(ftell(file)), '\0');
+    rewind(file);
+    EXPECT_EQ(fread(&contents[0], 1, contents.size(), file), contents.size());
+    fclose(file);
+    return contents;
+  }
+
+  // Reads a blob with the given contents into `out`.
+  static bool Read(const std::string& contents, SnapshotData* out) {
+    FILE* file = tmpfile();
+    EXPECT_NE(file, nullptr);
+    if (file == nullptr) return false;
+    fwrite(contents.data(), 1, contents.size(), file);
+    rewind(file);
+    bool ok = SnapshotData::FromBlob(out, file);
+    fclose(file);
+    return ok;
+  }
+
+  std::string blob_;
+  SnapshotData data_;
+};
+
+TEST_F(SnapshotBlobTest, RoundTrip) {
+  SnapshotData out;
+  ASSERT_TRUE(Read(Write(), &out));
+
+  ASSERT_EQ(out.blob.raw_size, static_cast<int>(blob_.size()));
+  EXPECT_EQ(std::string(out.blob.data, out.blob.raw_size), blob_);
+  EXPECT_EQ(out.isolate_data_indices, data_.isolate_data_indices);
+  ASSERT_EQ(out.env_info.bindings.size(), 1u);
+  EXPECT_EQ(out.env_info.bindings[0].name, "fs");
+  EXPECT_EQ(out.env_info.bindings[0].id, 4u);
+  EXPECT_EQ(out.env_info.bindings[0].index, 5u);
+  EXPECT_EQ(out.env_info.native_modules, data_.env_info.native_modules);
+  ASSERT_EQ(out.env_info.persistent_values.size(), 1u);
+  EXPECT_EQ(out.env_info.persistent_values[0].name, "url");
+  EXPECT_EQ(out.env_info.context, 8u);
+  delete[] out.blob.data;
+}
+
+TEST_F(SnapshotBlobTest, RejectsForeignVersion) {
+  std::string contents = Write();
+  size_t pos = contents.find(NODE_VERSION);
+  ASSERT_NE(pos, std::string::npos);
+  // Same length, so that only the version check can catch it.
+  contents[pos + 1] = contents[pos + 1] == '9' ? '8' : '9';
+
+  SnapshotData out;
+  EXPECT_FALSE(Read(contents, &out));
+  EXPECT_EQ(out.blob.data, nullptr);
+}
+
+TEST_F(SnapshotBlobTest, RejectsCorruptBlobs) {
+  const std::string contents = Write();
+  SnapshotData out;
+
+  EXPECT_FALSE(Read("", &out));
+  EXPECT_FALSE(Read("NSNP", &out));
+
+  std::string bad_magic = contents;
+  bad_magic[0] ^= 1;
+  EXPECT_FALSE(Read(bad_magic, &out));
+
+  // Every truncation fails, including one that cuts a length field short.
+  for (size_t size = 0; size < contents.size(); size += 7)
+    EXPECT_FALSE(Read(contents.substr(0, size), &out)) << size;
+  EXPECT_FALSE(Read(contents.substr(0, contents.size() - 1), &out));
+
+  // So does trailing garbage.
+  EXPECT_FALSE(Read(contents + '\0', &out));
+
+  // A length that points past the end of the file is not allocated.
+  std::string huge = contents;
+  size_t pos = huge.find(blob_);
+  ASSERT_NE(pos, std::string::npos);
+  ASSERT_GE(pos, sizeof(size_t));
+  size_t size = static_cast<size_t>(-1) / 2;
+  memcpy(&huge[pos - sizeof(size)], &size, sizeof(size));
+  EXPECT_FALSE(Read(huge, &out));
+
+  EXPECT_EQ(out.blob.data, nullptr);
+}
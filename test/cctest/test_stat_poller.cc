@@ -0,0 +1,114 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+#include "stat_poller.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using node::fs::StatPoller;
+
+class StatPollerTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    char tmpdir[1024];
+    size_t size = sizeof(tmpdir);
+    ASSERT_EQ(uv_os_tmpdir(tmpdir, &size), 0);
+    uv_fs_t req;
+    std::string templ = std::string(tmpdir) + "/node-stat-poller-XXXXXX";
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, templ.c_str(), nullptr), 0);
+    dir_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    for (const char* name : { "/changed", "/unchanged" }) {
+      uv_fs_unlink(nullptr, &req, (dir_ + name).c_str(), nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+    EXPECT_EQ(uv_fs_rmdir(nullptr, &req, dir_.c_str(), nullptr), 0);
+    uv_fs_req_cleanup(&req);
+    EnvironmentTestFixture::TearDown();
+  }
+
+  static void RunFor(uint64_t ms) {
+    uv_update_time(&current_loop);
+    const uint64_t start = uv_now(&current_loop);
+    while (uv_now(&current_loop) - start < ms)
+      uv_run(&current_loop, UV_RUN_ONCE);
+  }
+
+  static void WriteFile(const std::string& path, const char* contents) {
+    FILE* f = fopen(path.c_str(), "ab");
+    ASSERT_NE(f, nullptr);
+    fputs(contents, f);
+    fclose(f);
+  }
+
+  struct Changes {
+    int count = 0;
+    int status = 0;
+    uint64_t prev_size = 0;
+    uint64_t size = 0;
+  };
+
+  static void OnChange(void* data,
+                       int status,
+                       const uv_stat_t* prev,
+                       const uv_stat_t* curr) {
+    Changes* changes = static_cast<Changes*>(data);
+    changes->count++;
+    changes->status = status;
+    changes->prev_size = prev->st_size;
+    changes->size = curr->st_size;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(StatPollerTest, ReportsOnlyChanges) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  // Destroyed after the Environment, which waits for the poller's batches
+  // and timers to finish.
+  std::unique_ptr<StatPoller> poller;
+  Env env {handle_scope, argv};
+  poller = std::make_unique<StatPoller>(*env);
+
+  WriteFile(dir_ + "/changed", "a");
+  WriteFile(dir_ + "/unchanged", "a");
+
+  Changes changed, unchanged, missing;
+  StatPoller::Watch* watches[] = {
+    poller->Add(dir_ + "/changed", 10, OnChange, &changed),
+    poller->Add(dir_ + "/unchanged", 10, OnChange, &unchanged),
+    poller->Add(dir_ + "/missing", 10, OnChange, &missing),
+  };
+
+  // Only the error is reported for the first round of stat()s.
+  RunFor(100);
+  EXPECT_EQ(changed.count, 0);
+  EXPECT_EQ(unchanged.count, 0);
+  EXPECT_EQ(missing.count, 1);
+  EXPECT_EQ(missing.status, UV_ENOENT);
+
+  WriteFile(dir_ + "/changed", "bc");
+  RunFor(100);
+  EXPECT_EQ(changed.count, 1);
+  EXPECT_EQ(changed.status, 0);
+  EXPECT_EQ(changed.prev_size, 1u);
+  EXPECT_EQ(changed.size, 3u);
+  EXPECT_EQ(unchanged.count, 0);
+  // The same error is not reported again.
+  EXPECT_EQ(missing.count, 1);
+
+  EXPECT_TRUE(StatPoller::HasRef(watches[0]));
+  poller->SetRef(watches[0], false);
+  EXPECT_FALSE(StatPoller::HasRef(watches[0]));
+
+  for (StatPoller::Watch* watch : watches)
+    poller->Remove(watch);
+}
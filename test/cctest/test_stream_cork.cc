@@ -0,0 +1,234 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+#include "uv.h"
+
+#include <string>
+
+class StreamCorkTest : public EnvironmentTestFixture {
+ protected:
+  v8::Local<v8::Value> GetResult(const char* test, const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name(test)).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return v8::Undefined(isolate_);
+    return result.As<v8::Object>()
+        ->Get(context, name(field))
+        .ToLocalChecked();
+  }
+
+  int64_t GetInteger(const char* test, const char* field) {
+    return GetResult(test, field)
+        ->IntegerValue(isolate_->GetCurrentContext())
+        .FromJust();
+  }
+
+  std::string GetString(const char* test, const char* field) {
+    v8::String::Utf8Value value(isolate_, GetResult(test, field));
+    return *value == nullptr ? "" : *value;
+  }
+};
+
+// Each test case connects a corked client to a fresh server and stores what
+// it observed in a global of the same name.
+static const char kCorkScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const { TCP, TCPConnectWrap, constants } = internalBinding('tcp_wrap');
+const {
+  ShutdownWrap,
+  WriteWrap,
+  kArrayBufferOffset,
+  kLastWriteWasAsync,
+  kReadBytesOrError,
+  streamBaseState,
+} = internalBinding('stream_wrap');
+const { HTTPParser } = internalBinding('http_parser');
+
+function connect(cb) {
+  const server = new TCP(constants.SERVER);
+  if (server.bind('127.0.0.1', 0) !== 0) throw new Error('bind');
+  const address = {};
+  server.getsockname(address);
+  if (server.listen(1) !== 0) throw new Error('listen');
+
+  const client = new TCP(constants.SOCKET);
+  let peer;
+  let pending = 2;
+  const done = () => { if (--pending === 0) cb(client, peer); };
+  server.onconnection = (status, handle) => {
+    if (status !== 0) throw new Error(`accept: ${status}`);
+    peer = handle;
+    server.close();
+    done();
+  };
+  const req = new TCPConnectWrap();
+  req.oncomplete = (status) => {
+    if (status !== 0) throw new Error(`connect: ${status}`);
+    done();
+  };
+  client.connect(req, '127.0.0.1', address.port);
+}
+
+// Writes `string` and records the status it completes with in `statuses`.
+function write(handle, string, statuses, oncomplete = () => {}) {
+  const req = new WriteWrap();
+  req.oncomplete = (status) => {
+    statuses.push(`${string}:${status}`);
+    oncomplete();
+  };
+  const err = handle.writeLatin1String(req, string);
+  if (err !== 0) throw new Error(`write: ${err}`);
+  return streamBaseState[kLastWriteWasAsync] === 1;
+}
+
+// The peer doesn't read, so writes pile up in libuv once the socket buffers
+// are full, and the write queue shows what has been flushed. Returns the size
+// of the queue.
+function fill(handle) {
+  const req = new WriteWrap();
+  req.oncomplete = () => {};
+  req.buffer = Buffer.alloc(64 * 1024 * 1024);
+  handle.writeBuffer(req, req.buffer);
+  return handle.writeQueueSize;
+}
+
+function flushOnThreshold(done) {
+  connect((client, peer) => {
+    const queued = fill(client);
+    const result = { queued, statuses: [] };
+
+    client.setCork(16);
+    result.async = write(client, 'aaaaaaaaaa', result.statuses);
+    result.afterFirst = client.writeQueueSize - queued;
+    write(client, 'bbbbbbbbbb', result.statuses);
+    result.afterSecond = client.writeQueueSize - queued;
+    // Neither flush gets out before the handle is closed.
+    client.close(() => {
+      peer.close();
+      done(result);
+    });
+  });
+}
+
+function flushOnClose(done) {
+  connect((client, peer) => {
+    const result = { statuses: [], received: '' };
+    client.setCork(1024);
+    write(client, 'hello', result.statuses);
+    client.close();
+
+    peer.onread = (buf) => {
+      const nread = streamBaseState[kReadBytesOrError];
+      if (nread > 0) {
+        const offset = streamBaseState[kArrayBufferOffset];
+        result.received +=
+          Buffer.from(buf, offset, nread).toString('latin1');
+        return;
+      }
+      peer.close(() => done(result));
+    };
+    peer.readStart();
+  });
+}
+
+function flushError(done) {
+  connect((client, peer) => {
+    const result = { statuses: [] };
+    const shutdown = new ShutdownWrap();
+    shutdown.oncomplete = () => {};
+    client.shutdown(shutdown);
+
+    // The flush fails because the write side is shut down already.
+    client.setCork(1024);
+    let pending = 2;
+    const oncomplete = () => {
+      if (--pending > 0) return;
+      client.close();
+      peer.close();
+      done(result);
+    };
+    write(client, 'x', result.statuses, oncomplete);
+    write(client, 'y', result.statuses, oncomplete);
+  });
+}
+
+function parserCork(done) {
+  connect((client, peer) => {
+    const queued = fill(client);
+    const result = { statuses: [] };
+    const parser = new HTTPParser();
+    parser.initialize(HTTPParser.REQUEST, {});
+
+    parser.consume(client, true);
+    result.async = write(client, 'corked', result.statuses);
+    result.corked = client.writeQueueSize - queued;
+    parser.unconsume();
+    result.unconsumed = client.writeQueueSize - queued;
+
+    // Without the flag, nothing is corked.
+    parser.consume(client);
+    write(client, 'plain', result.statuses);
+    result.plain = client.writeQueueSize - queued;
+    parser.unconsume();
+
+    client.close(() => {
+      peer.close();
+      done(result);
+    });
+  });
+}
+
+flushOnThreshold((result) => {
+  globalThis.flushOnThreshold = result;
+  flushOnClose((result) => {
+    globalThis.flushOnClose = result;
+    flushError((result) => {
+      globalThis.flushError = result;
+      parserCork((result) => { globalThis.parserCork = result; });
+    });
+  });
+});
+)";
+
+TEST_F(StreamCorkTest, CorkedWrites) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kCorkScript).ToLocalChecked();
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  const std::string canceled = std::to_string(UV_ECANCELED);
+  const std::string epipe = std::to_string(UV_EPIPE);
+
+  // A corked write stays in the cork buffer until the next one would
+  // overflow it, and completes with the write that carries it out.
+  EXPECT_GT(GetInteger("flushOnThreshold", "queued"), 0);
+  EXPECT_TRUE(GetResult("flushOnThreshold", "async")->IsTrue());
+  EXPECT_EQ(GetInteger("flushOnThreshold", "afterFirst"), 0);
+  EXPECT_EQ(GetInteger("flushOnThreshold", "afterSecond"), 10);
+  EXPECT_EQ(GetString("flushOnThreshold", "statuses"),
+            "aaaaaaaaaa:" + canceled + ",bbbbbbbbbb:" + canceled);
+
+  // Closing the handle writes out the cork buffer first.
+  EXPECT_EQ(GetString("flushOnClose", "received"), "hello");
+  EXPECT_EQ(GetString("flushOnClose", "statuses"), "hello:0");
+
+  // When the flush fails, every write it covers gets the error.
+  EXPECT_EQ(GetString("flushError", "statuses"),
+            "x:" + epipe + ",y:" + epipe);
+
+  // An HTTP parser that consumes a socket with corking enabled corks it,
+  // and writes out the corked data when it lets go of the socket.
+  EXPECT_TRUE(GetResult("parserCork", "async")->IsTrue());
+  EXPECT_EQ(GetInteger("parserCork", "corked"), 0);
+  EXPECT_EQ(GetInteger("parserCork", "unconsumed"), 6);
+  EXPECT_EQ(GetInteger("parserCork", "plain"), 11);
+  EXPECT_EQ(GetString("parserCork", "statuses"),
+            "corked:" + canceled + ",plain:" + canceled);
+}
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+class StreamIdleTimeoutTest : public EnvironmentTestFixture {
+ protected:
+  int64_t GetInteger(const char* test, const char* field) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    auto name = [&](const char* str) {
+      return v8::String::NewFromUtf8(isolate_, str).ToLocalChecked();
+    };
+    v8::Local<v8::Value> result =
+        context->Global()->Get(context, name(test)).ToLocalChecked();
+    EXPECT_TRUE(result->IsObject());
+    if (!result->IsObject()) return -1;
+    return result.As<v8::Object>()
+        ->Get(context, name(field))
+        .ToLocalChecked()
+        ->IntegerValue(context)
+        .FromJust();
+  }
+};
+
+// Each test case connects a client to a fresh server and stores what it
+// observed in a global of the same name. Both ends read, which keeps the
+// loop alive while the tracker waits.
+static const char kIdleTimeoutScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const { TCP, TCPConnectWrap, constants } = internalBinding('tcp_wrap');
+const { WriteWrap, setIdleTimeoutCallback } = internalBinding('stream_wrap');
+
+function connect(cb) {
+  const server = new TCP(constants.SERVER);
+  if (server.bind('127.0.0.1', 0) !== 0) throw new Error('bind');
+  const address = {};
+  server.getsockname(address);
+  if (server.listen(1) !== 0) throw new Error('listen');
+
+  const client = new TCP(constants.SOCKET);
+  let peer;
+  let pending = 2;
+  const done = () => {
+    if (--pending > 0) return;
+    client.readStart();
+    peer.readStart();
+    cb(client, peer);
+  };
+  server.onconnection = (status, handle) => {
+    if (status !== 0) throw new Error(`accept: ${status}`);
+    peer = handle;
+    server.close();
+    done();
+  };
+  const req = new TCPConnectWrap();
+  req.oncomplete = (status) => {
+    if (status !== 0) throw new Error(`connect: ${status}`);
+    done();
+  };
+  client.connect(req, '127.0.0.1', address.port);
+}
+
+function write(handle, string) {
+  const req = new WriteWrap();
+  req.oncomplete = () => {};
+  const err = handle.writeLatin1String(req, string);
+  if (err !== 0) throw new Error(`write: ${err}`);
+}
+
+function now() {
+  return Number(process.hrtime.bigint() / 1000000n);
+}
+
+let onIdle = () => {};
+setIdleTimeoutCallback((handles) => onIdle(handles));
+
+// The timeout fires once per idle period.
+function fires(done) {
+  connect((client, peer) => {
+    const result = { timeouts: 0, elapsed: -1 };
+    const start = now();
+    onIdle = (handles) => {
+      if (!handles.includes(client)) return;
+      if (result.timeouts++ === 0) result.elapsed = now() - start;
+    };
+    client.setIdleTimeout(50);
+    setTimeout(() => {
+      client.close();
+      peer.close();
+      done(result);
+    }, 400);
+  });
+}
+
+// Reads and writes each reset the timeout on their own: every phase lasts
+// longer than the timeout, but has activity more often.
+function resetByActivity(done) {
+  connect((client, peer) => {
+    const result = { timeoutsWhileActive: 0, idle: -1 };
+    let active = true;
+    let last;
+    onIdle = (handles) => {
+      if (!handles.includes(client)) return;
+      if (active)
+        result.timeoutsWhileActive++;
+      else
+        result.idle = now() - last;
+    };
+    client.setIdleTimeout(100);
+
+    let ticks = 0;
+    const interval = setInterval(() => {
+      // First the client only reads, then it only writes.
+      write(ticks < 10 ? peer : client, 'x');
+      last = now();
+      if (++ticks < 20) return;
+      clearInterval(interval);
+      active = false;
+      setTimeout(() => {
+        client.close();
+        peer.close();
+        done(result);
+      }, 400);
+    }, 30);
+  });
+}
+
+// Closing a stream, or setting its timeout to 0, disarms it.
+function disarm(done) {
+  connect((client, peer) => {
+    const result = { timeouts: 0 };
+    onIdle = (handles) => { result.timeouts += handles.length; };
+    client.setIdleTimeout(20);
+    peer.setIdleTimeout(20);
+    peer.setIdleTimeout(0);
+    client.close();
+    setTimeout(() => {
+      peer.close();
+      done(result);
+    }, 200);
+  });
+}
+
+fires((result) => {
+  globalThis.fires = result;
+  resetByActivity((result) => {
+    globalThis.resetByActivity = result;
+    disarm((result) => { globalThis.disarm = result; });
+  });
+});
+)";
+
+TEST_F(StreamIdleTimeoutTest, IdleTimeouts) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  node::LoadEnvironment(*env, kIdleTimeoutScript).ToLocalChecked();
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  // The sweep may run up to a quarter of the timeout late, and the loop
+  // time that the tracker uses lags the wall clock by a few milliseconds.
+  EXPECT_EQ(GetInteger("fires", "timeouts"), 1);
+  EXPECT_GE(GetInteger("fires", "elapsed"), 45);
+  EXPECT_LT(GetInteger("fires", "elapsed"), 400);
+
+  EXPECT_EQ(GetInteger("resetByActivity", "timeoutsWhileActive"), 0);
+  EXPECT_GE(GetInteger("resetByActivity", "idle"), 95);
+  EXPECT_LT(GetInteger("resetByActivity", "idle"), 400);
+
+  EXPECT_EQ(GetInteger("disarm", "timeouts"), 0);
+}
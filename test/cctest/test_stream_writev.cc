@@ -0,0 +1,196 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+#include <cstring>
+#include <string>
+
+class StreamWritevTest : public EnvironmentTestFixture {
+ protected:
+  class ExternalOneByte : public v8::String::ExternalOneByteStringResource {
+   public:
+    explicit ExternalOneByte(const char* data)
+        : data_(data), length_(strlen(data)) {}
+    const char* data() const override { return data_; }
+    size_t length() const override { return length_; }
+
+   private:
+    const char* data_;
+    size_t length_;
+  };
+
+  class ExternalTwoByte : public v8::String::ExternalStringResource {
+   public:
+    explicit ExternalTwoByte(const char16_t* data)
+        : data_(reinterpret_cast<const uint16_t*>(data)),
+          length_(std::char_traits<char16_t>::length(data)) {}
+    const uint16_t* data() const override { return data_; }
+    size_t length() const override { return length_; }
+
+   private:
+    const uint16_t* data_;
+    size_t length_;
+  };
+
+  void SetGlobal(const char* name, v8::Local<v8::Value> value) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    context->Global()
+        ->Set(context,
+              v8::String::NewFromUtf8(isolate_, name).ToLocalChecked(),
+              value)
+        .Check();
+  }
+
+  std::string GetString(const char* name) {
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    v8::Local<v8::Value> value =
+        context->Global()
+            ->Get(context,
+                  v8::String::NewFromUtf8(isolate_, name).ToLocalChecked())
+            .ToLocalChecked();
+    v8::String::Utf8Value utf8(isolate_, value);
+    return *utf8 == nullptr ? "" : *utf8;
+  }
+};
+
+// Writes the same mix of Buffers, external strings and ordinary strings a
+// few times with writev(), and stores the bytes that arrive at the other
+// end, and those that were expected, as hex.
+static const char kWritevScript[] = R"(
+'use strict';
+const { internalBinding } = require('internal/test/binding');
+const { TCP, TCPConnectWrap, constants } = internalBinding('tcp_wrap');
+const {
+  WriteWrap,
+  kArrayBufferOffset,
+  kReadBytesOrError,
+  streamBaseState,
+} = internalBinding('stream_wrap');
+
+function connect(cb) {
+  const server = new TCP(constants.SERVER);
+  if (server.bind('127.0.0.1', 0) !== 0) throw new Error('bind');
+  const address = {};
+  server.getsockname(address);
+  if (server.listen(1) !== 0) throw new Error('listen');
+
+  const client = new TCP(constants.SOCKET);
+  let peer;
+  let pending = 2;
+  const done = () => { if (--pending === 0) cb(client, peer); };
+  server.onconnection = (status, handle) => {
+    if (status !== 0) throw new Error(`accept: ${status}`);
+    peer = handle;
+    server.close();
+    done();
+  };
+  const req = new TCPConnectWrap();
+  req.oncomplete = (status) => {
+    if (status !== 0) throw new Error(`connect: ${status}`);
+    done();
+  };
+  client.connect(req, '127.0.0.1', address.port);
+}
+
+function writev(handle, chunks) {
+  const req = new WriteWrap();
+  req.oncomplete = () => {};
+  const err = handle.writev(req, chunks, false);
+  if (err !== 0) throw new Error(`writev: ${err}`);
+}
+
+const chunks = [
+  'plain ', 'utf8',
+  externalAscii, 'utf8',
+  Buffer.from(' buffer '), 'buffer',
+  externalLatin1, 'latin1',
+  // Not written from the string, since it takes more bytes in UTF-8.
+  externalLatin1, 'utf8',
+  externalLatin1, 'ascii',
+  externalTwoByte, 'ucs2',
+  // Not written from the string, since it is not in UCS-2.
+  externalTwoByte, 'utf8',
+  'café ☃', 'utf8',
+  'café', 'latin1',
+  'c2hvcnQ=', 'base64',
+];
+const expected = [];
+for (let i = 0; i < chunks.length; i += 2) {
+  expected.push(Buffer.isBuffer(chunks[i]) ?
+    chunks[i] : Buffer.from(chunks[i], chunks[i + 1]));
+}
+const once = Buffer.concat(expected);
+
+connect((client, peer) => {
+  const received = [];
+  let length = 0;
+  peer.onread = (buf) => {
+    const nread = streamBaseState[kReadBytesOrError];
+    if (nread <= 0) return;
+    const offset = streamBaseState[kArrayBufferOffset];
+    received.push(Buffer.from(buf, offset, nread));
+    length += nread;
+    if (length < once.length * 3) return;
+    globalThis.received = Buffer.concat(received).toString('hex');
+    client.close();
+    peer.close();
+  };
+  peer.readStart();
+
+  // Later writes reuse the storage that the first one encoded into.
+  writev(client, chunks);
+  writev(client, chunks);
+  writev(client, chunks);
+
+  // A writev() that fails after taking the pooled storage returns it, which
+  // the test checks once the loop is done.
+  let gets = 0;
+  const failing = ['abc', 'utf8'];
+  Object.defineProperty(failing, 0, {
+    get() {
+      if (++gets === 2) throw new Error('second access');
+      return 'abc';
+    },
+  });
+  try {
+    writev(client, failing);
+  } catch (err) {
+    globalThis.failed = err.message;
+  }
+});
+
+globalThis.expected = Buffer.concat([once, once, once]).toString('hex');
+)";
+
+TEST_F(StreamWritevTest, MixedChunks) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  v8::Local<v8::String> ascii =
+      v8::String::NewExternalOneByte(
+          isolate_, new ExternalOneByte(" external ascii "))
+          .ToLocalChecked();
+  v8::Local<v8::String> latin1 =
+      v8::String::NewExternalOneByte(
+          isolate_, new ExternalOneByte(" external caf\xe9 "))
+          .ToLocalChecked();
+  v8::Local<v8::String> two_byte =
+      v8::String::NewExternalTwoByte(
+          isolate_, new ExternalTwoByte(u" external ☃ "))
+          .ToLocalChecked();
+  ASSERT_TRUE(ascii->IsExternalOneByte());
+  ASSERT_TRUE(latin1->IsExternalOneByte());
+  ASSERT_TRUE(two_byte->IsExternalTwoByte());
+  SetGlobal("externalAscii", ascii);
+  SetGlobal("externalLatin1", latin1);
+  SetGlobal("externalTwoByte", two_byte);
+
+  node::LoadEnvironment(*env, kWritevScript).ToLocalChecked();
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  EXPECT_EQ(GetString("failed"), "second access");
+  EXPECT_NE((*env)->stream_write_storage(), nullptr);
+  EXPECT_FALSE(GetString("expected").empty());
+  EXPECT_EQ(GetString("received"), GetString("expected"));
+}
@@ -0,0 +1,94 @@
+#include "string_search.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::stringsearch::MultiStringSearch;
+using node::stringsearch::Vector;
+
+namespace {
+
+size_t Find(const std::string& haystack,
+            const std::string& needle,
+            size_t start_index = 0,
+            bool is_forward = true) {
+  return node::SearchString(
+      reinterpret_cast<const uint8_t*>(haystack.data()),
+      haystack.size(),
+      reinterpret_cast<const uint8_t*>(needle.data()),
+      needle.size(),
+      start_index,
+      is_forward);
+}
+
+Vector<const uint8_t> MakeVector(const std::string& str) {
+  return Vector<const uint8_t>(
+      reinterpret_cast<const uint8_t*>(str.data()), str.size(), true);
+}
+
+}  // anonymous namespace
+
+TEST(StringSearchTest, ShortNeedles) {
+  const std::string haystack =
+      "--boundary\r\nContent-Type: text/plain\r\n\r\nhello\r\n--boundary--";
+  EXPECT_EQ(haystack.find("\r\n\r\n"), Find(haystack, "\r\n\r\n"));
+  EXPECT_EQ(haystack.find("\r\n", 20), Find(haystack, "\r\n", 20));
+  EXPECT_EQ(haystack.rfind("\r\n"),
+            Find(haystack, "\r\n", haystack.size(), false));
+  EXPECT_EQ(haystack.size(), Find(haystack, "\r\n\n"));
+
+  // Candidates at every position where the first and last bytes match, but
+  // the middle does not.
+  std::string repeated(100, 'a');
+  EXPECT_EQ(repeated.size(), Find(repeated, "abba"));
+  repeated += "abba";
+  EXPECT_EQ(100u, Find(repeated, "abba"));
+  EXPECT_EQ(100u, Find(repeated, "abba", 100));
+  EXPECT_EQ(repeated.size(), Find(repeated, "abba", 101));
+
+  // Matches around the boundaries of the 16-byte blocks.
+  for (size_t i = 0; i + 3 <= 40; i++) {
+    std::string subject(40, '.');
+    subject.replace(i, 3, "xyz");
+    EXPECT_EQ(i, Find(subject, "xyz"));
+  }
+}
+
+TEST(StringSearchTest, MultiStringSearch) {
+  const std::vector<std::string> patterns = {"ERROR", "WARN", "ERR", "FATAL"};
+  std::vector<Vector<const uint8_t>> vectors;
+  for (const std::string& pattern : patterns)
+    vectors.push_back(MakeVector(pattern));
+  MultiStringSearch search(vectors);
+
+  const std::string log =
+      "[INFO] started\n[WARN] slow\n[ERROR] failed\n[FATAL] bye\n";
+  size_t index;
+  EXPECT_EQ(log.find("WARN"), search.Search(MakeVector(log), 0, &index));
+  EXPECT_EQ(1u, index);
+
+  // The longest of the patterns that match at the same position wins.
+  size_t pos = log.find("ERROR");
+  EXPECT_EQ(pos, search.Search(MakeVector(log), log.find("WARN") + 1, &index));
+  EXPECT_EQ(0u, index);
+
+  EXPECT_EQ(log.find("FATAL"), search.Search(MakeVector(log), pos + 1, &index));
+  EXPECT_EQ(3u, index);
+
+  const std::string clean = "[INFO] nothing to see here\n";
+  EXPECT_EQ(clean.size(), search.Search(MakeVector(clean), 0, &index));
+
+  // A shorter pattern that ends first does not hide a longer one that
+  // starts earlier.
+  const std::vector<std::string> overlapping = {"bcd", "abcde"};
+  vectors.clear();
+  for (const std::string& pattern : overlapping)
+    vectors.push_back(MakeVector(pattern));
+  MultiStringSearch overlapping_search(vectors);
+  EXPECT_EQ(1u, overlapping_search.Search(MakeVector("xabcdef"), 0, &index));
+  EXPECT_EQ(1u, index);
+  EXPECT_EQ(2u, overlapping_search.Search(MakeVector("xabcdx"), 0, &index));
+  EXPECT_EQ(0u, index);
+}